@@ -0,0 +1,565 @@
+/* <inv_con/skip_list.h>
+
+   Classes for maintaining an invasive, ordered, double-linked list indexed by a skip list.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <base/class_traits.h>
+#include <inv_con/cursor.h>
+
+namespace InvCon {
+
+  /* Classes for maintaining an invasive, ordered, double-linked list with O(log n) insertion and seek.
+
+     The bottom level of the skip list is an ordinary double-linked list, so cursors walk it exactly
+     as they would an OrderedList.  Each membership also carries a randomly-sized tower of forward
+     links which the collection uses to find insertion points and seek targets without walking from
+     the head.  Members with equal keys are kept in insertion order, the same as OrderedList.
+
+     Keys must provide operator<=. */
+  namespace SkipList {
+
+    /* Forward declarations of base classes. */
+    template <typename TCollector, typename TMember, typename TKey>
+    class TCollection;
+    template <typename TMember, typename TCollector, typename TKey>
+    class TMembership;
+
+    /* Forward declarations of final classes. */
+    namespace Impl {
+      template <typename TCollector, typename TMember, typename TKey>
+      class TCollection;
+      template <typename TMember, typename TCollector, typename TKey>
+      class TMembership;
+    }
+
+    /* The maximum height of a tower.  With a branching factor of 4 this comfortably covers 4^15 members. */
+    static constexpr size_t MaxHeight = 16;
+
+    /* The 'one' side of the one-to-many. */
+    template <typename TCollector, typename TMember, typename TKey>
+    class TCollection {
+      NO_COPY(TCollection);
+      public:
+
+      /* Our corresponding 'many' class. */
+      typedef TMembership<TMember, TCollector,TKey> TTypedMembership;
+
+      /* The final version of this class. */
+      typedef Impl::TCollection<TCollector, TMember, TKey> TImpl;
+
+      /* Our cursor class. */
+      typedef InvCon::Impl::TCursor<TCollector, TCollection, TMember, TTypedMembership> TCursor;
+
+      /* The collector which owns us.  Never null. */
+      TCollector *GetCollector() const {
+        assert(this);
+        return Collector;
+      }
+
+      /* The first member of the collection,
+         or null if the collection is empty. */
+      TMember *TryGetFirstMember() const {
+        assert(this);
+        return FirstMembership ? FirstMembership->Member : 0;
+      }
+
+      /* The first member of the collection which matches the given key,
+         or null if the collection contains no match. */
+      TMember *TryGetFirstMember(const TKey &key) const {
+        assert(this);
+        TTypedMembership *membership = TryGetFirstMembership(key);
+        return membership ? membership->GetMember() : 0;
+      }
+
+      /* The first membership of the collection,
+         or null if the collection is empty. */
+      TTypedMembership *TryGetFirstMembership() const {
+        assert(this);
+        return FirstMembership;
+      }
+
+      /* The first membership of the collection which matches the given key,
+         or null if the collection contains no match. */
+      TTypedMembership *TryGetFirstMembership(const TKey &key) const {
+        assert(this);
+        TTypedMembership *membership = TryGetFirstMembershipNotBefore([&key](const TMember &, const TKey &that) {
+          return !(key <= that);
+        });
+        return (membership && membership->Key <= key) ? membership : 0;
+      }
+
+      /* The first membership for which the given predicate returns false, or null if there is no such membership.
+         The predicate is called as is_before(member, key) and must return true for a prefix of the collection
+         and false for the remainder; that is, it must agree with the order of the collection.
+         This is how a caller seeks to a position using a search key of a different type than our own. */
+      template <typename TIsBefore>
+      TTypedMembership *TryGetFirstMembershipNotBefore(const TIsBefore &is_before) const {
+        assert(this);
+        TTypedMembership *pred = 0;
+        for (size_t level = Height; level > 0; --level) {
+          for (TTypedMembership *next = GetNext(pred, level - 1); next && is_before(*(next->Member), next->Key); next = GetNext(pred, level - 1)) {
+            pred = next;
+          }
+        }
+        return pred ? pred->NextMembership : FirstMembership;
+      }
+
+      /* The last member of the collection,
+         or null if the collection is empty. */
+      TMember *TryGetLastMember() const {
+        assert(this);
+        return LastMembership ? LastMembership->Member : 0;
+      }
+
+      /* The last membership of the collection,
+         or null if the collection is empty. */
+      TTypedMembership *TryGetLastMembership() const {
+        assert(this);
+        return LastMembership;
+      }
+
+      /* TODO */
+      bool IsEmpty() const {
+        assert(this);
+        return FirstMembership == 0;
+      }
+
+      protected:
+
+      /* Pass in a non-null pointer to the collector which owns us. */
+      TCollection(TCollector *collector)
+          : Collector(collector), FirstMembership(0), LastMembership(0), Height(1), Seed(reinterpret_cast<uintptr_t>(this) | 1) {
+        assert(collector);
+        for (size_t level = 0; level < MaxHeight - 1; ++level) {
+          Heads[level] = 0;
+          Tails[level] = 0;
+        }
+      }
+
+      /* Remove each member from the collection upon destruction. */
+      virtual ~TCollection() {
+        assert(this);
+        RemoveEachMember();
+      }
+
+      /* Delete each member. */
+      void DeleteEachMember() {
+        assert(this);
+        while (FirstMembership) {
+          TMember *member = FirstMembership->Member;
+          FirstMembership->Remove();
+          delete member;
+        }
+      }
+
+      /* Insert the given membership at the correct position.
+         If the membership in a different collection, remove it from that collection before inserting. */
+      void Insert(TTypedMembership *membership) {
+        assert(this);
+        assert(membership);
+        membership->Insert(this);
+      }
+
+      /* Same as Insert().  Kept for parity with OrderedList; appending at the tail is O(1) either way. */
+      void ReverseInsert(TTypedMembership *membership) {
+        assert(this);
+        assert(membership);
+        membership->ReverseInsert(this);
+      }
+
+      /* Remove each member from the collection but don't delete them.
+         This unlinks in a single pass without consulting the towers. */
+      void RemoveEachMember() {
+        assert(this);
+        for (TTypedMembership *membership = FirstMembership; membership;) {
+          TTypedMembership *next_membership = membership->NextMembership;
+          membership->FreeTower();
+          membership->ZeroLinkage();
+          membership = next_membership;
+        }
+        FirstMembership = 0;
+        LastMembership = 0;
+        for (size_t level = 0; level < MaxHeight - 1; ++level) {
+          Heads[level] = 0;
+          Tails[level] = 0;
+        }
+        Height = 1;
+      }
+
+      private:
+
+      /* The link out of the given membership at the given level.  A null membership means the head. */
+      TTypedMembership *&GetNext(TTypedMembership *membership, size_t level) {
+        assert(this);
+        assert(level < MaxHeight);
+        if (!level) {
+          return membership ? membership->NextMembership : FirstMembership;
+        }
+        assert(!membership || level < membership->Height);
+        return membership ? membership->Tower[level - 1] : Heads[level - 1];
+      }
+
+      /* Const version of the above. */
+      TTypedMembership *GetNext(TTypedMembership *membership, size_t level) const {
+        assert(this);
+        return const_cast<TCollection *>(this)->GetNext(membership, level);
+      }
+
+      /* Pick a height for a new tower.  Each level is 1/4 as likely as the one below it. */
+      size_t NewHeight() {
+        assert(this);
+        /* xorshift64 */
+        Seed ^= Seed << 13;
+        Seed ^= Seed >> 7;
+        Seed ^= Seed << 17;
+        size_t height = 1;
+        for (uint64_t bits = Seed; height < MaxHeight && (bits & 3) == 0; bits >>= 2) {
+          ++height;
+        }
+        return height;
+      }
+
+      /* See accessor. */
+      TCollector *const Collector;
+
+      /* See accessors. */
+      TTypedMembership *FirstMembership, *LastMembership;
+
+      /* The first and last memberships at each level above the bottom. */
+      TTypedMembership *Heads[MaxHeight - 1], *Tails[MaxHeight - 1];
+
+      /* The number of levels currently in use, including the bottom. */
+      size_t Height;
+
+      /* State for NewHeight(). */
+      uint64_t Seed;
+
+      /* For Collector, FirstMembership, LastMembership and the towers. */
+      friend class TMembership<TMember, TCollector, TKey>;
+
+    };  // TCollection<TCollector, TMember>
+
+    /* The 'many' side of the one-to-many. */
+    template <typename TMember, typename TCollector, typename TKey>
+    class TMembership {
+      NO_COPY(TMembership);
+      public:
+
+      /* Our corresponding 'one' class. */
+      typedef TCollection<TCollector, TMember, TKey> TTypedCollection;
+
+      /* The final version of this class. */
+      typedef Impl::TMembership<TMember, TCollector, TKey> TImpl;
+
+      /* Get our key. */
+      const TKey &GetKey() const {
+        assert(this);
+        return Key;
+      }
+
+      /* The member which owns us.  Never null. */
+      TMember *GetMember() const {
+        assert(this);
+        return Member;
+      }
+
+      /* The collection we're in, if any. */
+      TTypedCollection *TryGetCollection() const {
+        assert(this);
+        return Collection;
+      }
+
+      /* The collector whose collection we're in, if any. */
+      TCollector *TryGetCollector() const {
+        assert(this);
+        return Collection ? Collection->Collector : 0;
+      }
+
+      /* The member before us in our collection.
+         A null here means either we're first in our collection or we're not in a collection. */
+      TMember *TryGetPrevMember() const {
+        assert(this);
+        return PrevMembership ? PrevMembership->Member : 0;
+      }
+
+      /* The membership before us in our collection.
+         A null here means either we're first in our collection or we're not in a collection. */
+      TMembership *TryGetPrevMembership() const {
+        assert(this);
+        return PrevMembership;
+      }
+
+      /* The member after us in our collection.
+         A null here means either we're last in our collection or we're not in a collection. */
+      TMember *TryGetNextMember() const {
+        assert(this);
+        return NextMembership ? NextMembership->Member : 0;
+      }
+
+      /* The membership after us in our collection.
+         A null here means either we're last in our collection or we're not in a collection. */
+      TMembership *TryGetNextMembership() const {
+        assert(this);
+        return NextMembership;
+      }
+
+      protected:
+
+      /* Pass in a non-null pointer to the member which owns us. */
+      TMembership(TMember *member)
+          : Member(member), Tower(0), Height(0) {
+        assert(member);
+        ZeroLinkage();
+      }
+
+      /* Pass in a non-null pointer to the member which owns us, a value for our key,
+         and an an optional pointer to a collection to insert into. */
+      TMembership(TMember *member, const TKey &key, TTypedCollection *collection = 0)
+          : Member(member), Key(key), Tower(0), Height(0) {
+        assert(member);
+        ZeroLinkage();
+        if (collection) {
+          Insert(collection);
+        }
+      }
+
+      /* Automatically removes us from our collection (if any) before destruction. */
+      virtual ~TMembership() {
+        assert(this);
+        Remove();
+      }
+
+      /* Insert us into the given collection at the correct position, after any members with an equal key.
+         If we're already in a collection, remove us from that collection before inserting. */
+      void Insert(TTypedCollection *collection) {
+        assert(this);
+        assert(collection);
+        Remove();
+        const size_t height = collection->NewHeight();
+        TMembership *preds[MaxHeight];
+        if (!collection->LastMembership || collection->LastMembership->Key <= Key) {
+          /* Appending is the common case when importing an already-sorted layer; don't search for it. */
+          preds[0] = collection->LastMembership;
+          for (size_t level = 1; level < height; ++level) {
+            preds[level] = collection->Tails[level - 1];
+          }
+        } else {
+          TMembership *pred = 0;
+          for (size_t level = std::max(height, collection->Height); level > 0; --level) {
+            if (level - 1 < collection->Height) {
+              for (TMembership *next = collection->GetNext(pred, level - 1); next && next->Key <= Key; next = collection->GetNext(pred, level - 1)) {
+                pred = next;
+              }
+            }
+            if (level - 1 < height) {
+              preds[level - 1] = pred;
+            }
+          }
+        }
+        Link(collection, preds, height);
+      }
+
+      /* Same as Insert(). */
+      void ReverseInsert(TTypedCollection *collection) {
+        assert(this);
+        Insert(collection);
+      }
+
+      /* Remove us from our collection.
+         If we're not in a collection, this function does nothing. */
+      void Remove() {
+        assert(this);
+        if (Collection) {
+          if (Height > 1) {
+            TMembership *preds[MaxHeight];
+            if (!PrevMembership) {
+              /* We're first, so the head is our predecessor at every level. */
+              for (size_t level = 1; level < Height; ++level) {
+                preds[level] = 0;
+              }
+            } else {
+              TMembership *pred = 0;
+              for (size_t level = Collection->Height; level > 1; --level) {
+                TMembership *next = Collection->GetNext(pred, level - 1);
+                for (; next && !(Key <= next->Key); next = Collection->GetNext(pred, level - 1)) {
+                  pred = next;
+                }
+                if (level - 1 < Height) {
+                  /* Step over any members with a key equal to ours which were inserted before us. */
+                  for (; next != this; next = Collection->GetNext(pred, level - 1)) {
+                    assert(next);
+                    pred = next;
+                  }
+                  preds[level - 1] = pred;
+                }
+              }
+            }
+            for (size_t level = 1; level < Height; ++level) {
+              Collection->GetNext(preds[level], level) = Tower[level - 1];
+              if (Collection->Tails[level - 1] == this) {
+                Collection->Tails[level - 1] = preds[level];
+              }
+            }
+            while (Collection->Height > 1 && !Collection->Heads[Collection->Height - 2]) {
+              --Collection->Height;
+            }
+          }
+          /* Fixup the pointers on either side of us to point around us,
+             then go back to the unlinked state. */
+          (PrevMembership ? PrevMembership->NextMembership : Collection->FirstMembership) = NextMembership;
+          (NextMembership ? NextMembership->PrevMembership : Collection->LastMembership ) = PrevMembership;
+          FreeTower();
+          ZeroLinkage();
+        }
+      }
+
+      private:
+
+      /* Link us in after the given predecessors, one per level of our new tower. */
+      void Link(TTypedCollection *collection, TMembership **preds, size_t height) {
+        assert(this);
+        assert(collection);
+        assert(!Collection);
+        assert(height > 0 && height <= MaxHeight);
+        Collection = collection;
+        Height = height;
+        if (height > 1) {
+          Tower = new TMembership *[height - 1];
+        }
+        PrevMembership = preds[0];
+        NextMembership = preds[0] ? preds[0]->NextMembership : collection->FirstMembership;
+        (NextMembership ? NextMembership->PrevMembership : collection->LastMembership ) = this;
+        (PrevMembership ? PrevMembership->NextMembership : collection->FirstMembership) = this;
+        for (size_t level = 1; level < height; ++level) {
+          TMembership *&link = collection->GetNext(preds[level], level);
+          Tower[level - 1] = link;
+          link = this;
+          if (!Tower[level - 1]) {
+            collection->Tails[level - 1] = this;
+          }
+        }
+        if (height > collection->Height) {
+          collection->Height = height;
+        }
+      }
+
+      /* Release our tower, if we have one. */
+      void FreeTower() {
+        assert(this);
+        delete [] Tower;
+        Tower = 0;
+        Height = 0;
+      }
+
+      /* Reset all pointers to null.
+         This function does no unlinking so make sure we're unlinked first. */
+      void ZeroLinkage() {
+        assert(this);
+        Collection = 0;
+        NextMembership = 0;
+        PrevMembership = 0;
+      }
+
+      /* See accessor. */
+      TMember *const Member;
+
+      /* See accessor. */
+      TKey Key;
+
+      /* See accessor. */
+      TTypedCollection *Collection;
+
+      /* See accessors. */
+      TMembership *PrevMembership, *NextMembership;
+
+      /* Our forward links above the bottom level, Height - 1 of them; null if Height <= 1. */
+      TMembership **Tower;
+
+      /* The number of levels we're linked into, or 0 if we're not in a collection. */
+      size_t Height;
+
+      /* For ~TMembership(), Insert(), Remove(), Member and the towers. */
+      friend class TCollection<TCollector, TMember, TKey>;
+
+    };  // TMembership<TMember, TCollector>
+
+    /* The final versions of the 'one' and 'many' classes. */
+    namespace Impl {
+
+      /* The final 'one'. */
+      template <typename TCollector, typename TMember, typename TKey>
+      class TCollection
+          : public SkipList::TCollection<TCollector, TMember, TKey> {
+        public:
+
+        /* Our base type. */
+        typedef SkipList::TCollection<TCollector, TMember, TKey> TBase;
+
+        /* Do-little. */
+        TCollection(TCollector *collector)
+            : TBase(collector) {}
+
+        /* Do-little. */
+        virtual ~TCollection() {}
+
+        /* Make our base's protected mutators public. */
+        using TBase::DeleteEachMember;
+        using TBase::IsEmpty;
+        using TBase::Insert;
+        using TBase::ReverseInsert;
+        using TBase::RemoveEachMember;
+
+      };  // TCollection
+
+      /* The final 'many'. */
+      template <typename TMember, typename TCollector, typename TKey>
+      class TMembership
+          : public SkipList::TMembership<TMember, TCollector, TKey> {
+        public:
+
+        /* Our base type. */
+        typedef SkipList::TMembership<TMember, TCollector, TKey> TBase;
+
+        /* Do-little. */
+        TMembership(TMember *member)
+            : TBase(member) {}
+
+        /* Do-little. */
+        TMembership(TMember *member, const TKey &key, typename TBase::TTypedCollection *collection = 0)
+            : TBase(member, key, collection) {}
+
+        /* Do-little. */
+        virtual ~TMembership() {}
+
+        /* Make our base's protected mutators public. */
+        using TBase::Insert;
+        using TBase::ReverseInsert;
+        using TBase::Remove;
+
+      };  // TMembership
+
+    }  // Impl
+
+  }  // SkipList
+
+}  // InvCon
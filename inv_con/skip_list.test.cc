@@ -0,0 +1,236 @@
+/* <inv_con/skip_list.test.cc>
+
+   Unit test for <inv_con/skip_list.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <inv_con/skip_list.h>
+
+#include <cstdlib>
+#include <map>
+
+#include <base/class_traits.h>
+#include <test/kit.h>
+
+class TTeam;
+class TPlayer;
+
+class TTeam {
+  NO_COPY(TTeam);
+  public:
+
+  typedef InvCon::SkipList::TCollection<TTeam, TPlayer, int> TPlayerCollection;
+
+  TTeam()
+      : PlayerCollection(this) {}
+
+  ~TTeam() {
+    assert(this);
+    PlayerCollection.DeleteEachMember();
+  }
+
+  void DeleteEachMember() {
+    assert(this);
+    PlayerCollection.DeleteEachMember();
+  }
+
+  TPlayerCollection *GetPlayerCollection() const {
+    assert(this);
+    return &PlayerCollection;
+  }
+
+  void Insert(TPlayerCollection::TImpl::TTypedMembership *membership) {
+    PlayerCollection.Insert(membership);
+  }
+
+  void RemoveEachMember() {
+    PlayerCollection.RemoveEachMember();
+  }
+
+  private:
+
+  mutable TPlayerCollection::TImpl PlayerCollection;
+
+};  // TTeam
+
+class TPlayer {
+  NO_COPY(TPlayer);
+  public:
+
+  typedef InvCon::SkipList::TMembership<TPlayer, TTeam, int> TTeamMembership;
+
+  TPlayer(TTeam *team, int number)
+      : TeamMembership(this, number, team->GetPlayerCollection()) {}
+
+  TPlayer(int number) : TeamMembership(this, number) {}
+
+  int GetNumber() const {
+    assert(this);
+    return TeamMembership.GetKey();
+  }
+
+  void Insert(TTeam *team) {
+    assert(this);
+    TeamMembership.Insert(team->GetPlayerCollection());
+  }
+
+  void Remove() {
+    assert(this);
+    TeamMembership.Remove();
+  }
+
+  TTeamMembership *GetTeamMembership() {
+    assert(this);
+    return &TeamMembership;
+  }
+
+  private:
+
+  TTeamMembership::TImpl TeamMembership;
+
+};  // TPlayer
+
+/* Checks that the team holds exactly the expected players, in order, and that a seek to each finds it. */
+static void CheckTeam(const TTeam &team, const std::multimap<int, TPlayer *> &expected) {
+  auto iter = expected.begin();
+  const TPlayer *prev = nullptr;
+  for (TTeam::TPlayerCollection::TCursor csr(team.GetPlayerCollection()); csr; ++csr, ++iter) {
+    if (!EXPECT_TRUE(iter != expected.end())) {
+      return;
+    }
+    EXPECT_EQ(&*csr, iter->second);
+    EXPECT_EQ(csr->GetTeamMembership()->TryGetPrevMember(), prev);
+    prev = &*csr;
+  }
+  EXPECT_TRUE(iter == expected.end());
+  EXPECT_EQ(team.GetPlayerCollection()->TryGetLastMember(), prev);
+  for (const auto &item : expected) {
+    TPlayer *player = team.GetPlayerCollection()->TryGetFirstMember(item.first);
+    EXPECT_EQ(player, expected.lower_bound(item.first)->second);
+  }
+}
+
+FIXTURE(Typical) {
+  static const size_t player_count = 5;
+  static int number_array[player_count] = { 103, 101, 105, 104, 102 };
+  TTeam team;
+  for (size_t i = 0; i < player_count; ++i) {
+    new TPlayer(&team, number_array[i]);
+  }
+  int expected = 101;
+  for (TTeam::TPlayerCollection::TCursor csr(team.GetPlayerCollection()); csr; ++csr) {
+    EXPECT_EQ(csr->GetNumber(), expected);
+    ++expected;
+  }
+  EXPECT_EQ(expected, 106);
+  expected = 105;
+  for (TTeam::TPlayerCollection::TCursor csr(team.GetPlayerCollection(), InvCon::Rev); csr; ++csr) {
+    EXPECT_EQ(csr->GetNumber(), expected);
+    --expected;
+  }
+  EXPECT_EQ(expected, 100);
+  for (int i = 101; i <= 105; ++i) {
+    TPlayer *p = team.GetPlayerCollection()->TryGetFirstMember(i);
+    EXPECT_EQ(p->GetNumber(), i);
+  }
+  EXPECT_FALSE(team.GetPlayerCollection()->TryGetFirstMember(100));
+  EXPECT_FALSE(team.GetPlayerCollection()->TryGetFirstMember(106));
+}
+
+FIXTURE(CollectionImpl) {
+  TTeam team;
+  TPlayer *player1 = new TPlayer(&team, 101);
+  TPlayer *player2 = new TPlayer(&team, 102);
+  EXPECT_EQ(team.GetPlayerCollection()->TryGetFirstMember(), player1);
+  team.RemoveEachMember();
+  EXPECT_FALSE(team.GetPlayerCollection()->TryGetFirstMember());
+  EXPECT_FALSE(player1->GetTeamMembership()->TryGetCollection());
+  team.Insert(player2->GetTeamMembership());
+  EXPECT_EQ(team.GetPlayerCollection()->TryGetFirstMember(), player2);
+  team.Insert(player1->GetTeamMembership());
+  EXPECT_EQ(team.GetPlayerCollection()->TryGetFirstMember(), player1);
+  team.DeleteEachMember();
+  EXPECT_FALSE(team.GetPlayerCollection()->TryGetFirstMember());
+}
+
+FIXTURE(EqualKeys) {
+  TTeam team;
+  TPlayer *player1 = new TPlayer(&team, 101);
+  TPlayer *player2 = new TPlayer(&team, 101);
+  TPlayer *player0 = new TPlayer(&team, 100);
+  TPlayer *player3 = new TPlayer(&team, 101);
+  TTeam::TPlayerCollection::TCursor csr(team.GetPlayerCollection());
+  EXPECT_EQ(&*csr, player0);
+  EXPECT_EQ(&*++csr, player1);
+  EXPECT_EQ(&*++csr, player2);
+  EXPECT_EQ(&*++csr, player3);
+  EXPECT_EQ(team.GetPlayerCollection()->TryGetFirstMember(101), player1);
+  player2->Remove();
+  delete player2;
+  csr = TTeam::TPlayerCollection::TCursor(team.GetPlayerCollection());
+  EXPECT_EQ(&*++csr, player1);
+  EXPECT_EQ(&*++csr, player3);
+}
+
+FIXTURE(Seek) {
+  TTeam team;
+  for (int i = 0; i < 1000; i += 10) {
+    new TPlayer(&team, i);
+  }
+  for (int i = -5; i < 1005; ++i) {
+    TTeam::TPlayerCollection::TTypedMembership *membership =
+        team.GetPlayerCollection()->TryGetFirstMembershipNotBefore([i](const TPlayer &, int key) {
+          return key < i;
+        });
+    if (i > 990) {
+      EXPECT_FALSE(membership);
+    } else if (EXPECT_TRUE(membership)) {
+      EXPECT_EQ(membership->GetKey(), ((i + 9) / 10) * 10);
+    }
+  }
+}
+
+FIXTURE(Random) {
+  TTeam team;
+  std::multimap<int, TPlayer *> expected;
+  srand(0);
+  for (size_t i = 0; i < 5000; ++i) {
+    int number = rand() % 1000;
+    expected.insert(std::make_pair(number, new TPlayer(&team, number)));
+  }
+  CheckTeam(team, expected);
+  /* Remove every third player, from wherever they happen to be. */
+  size_t i = 0;
+  for (auto iter = expected.begin(); iter != expected.end(); ++i) {
+    if (i % 3 == 0) {
+      delete iter->second;
+      iter = expected.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  CheckTeam(team, expected);
+  /* Move the remainder to another team and back. */
+  TTeam team2;
+  for (const auto &item : expected) {
+    item.second->Insert(&team2);
+  }
+  EXPECT_FALSE(team.GetPlayerCollection()->TryGetFirstMember());
+  CheckTeam(team2, expected);
+  for (const auto &item : expected) {
+    item.second->Insert(&team);
+  }
+  CheckTeam(team, expected);
+}
@@ -38,6 +38,22 @@ namespace Orly {
 
       void WriteExpr(TCppPrinter &out) const;
 
+      /* Used when spotting patterns, as in a reduce which is really a sum. */
+      TOp GetOp() const {
+        assert(this);
+        return Op;
+      }
+
+      const TInline::TPtr &GetLhs() const {
+        assert(this);
+        return Lhs;
+      }
+
+      const TInline::TPtr &GetRhs() const {
+        assert(this);
+        return Rhs;
+      }
+
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
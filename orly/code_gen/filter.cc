@@ -31,7 +31,12 @@ TFilter::TPtr TFilter::New(
   return TPtr(new TFilter(package, ret_type, seq, func));
 }
 
-void TFilter::WriteExpr(TCppPrinter &out) const {
+TInline::TPtr TFilter::TryGetPipeSeq() const {
+  assert(this);
+  return Seq;
+}
+
+void TFilter::WriteGenerator(TCppPrinter &out) const {
   assert(this);
   assert(&out);
   out << "TFilterGenerator<" << Type::UnwrapSequence(GetReturnType()) << ">::New(";
@@ -39,8 +44,16 @@ void TFilter::WriteExpr(TCppPrinter &out) const {
   out << ", " << Seq << ')';
 }
 
+void TFilter::WriteStageOpen(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  out << "Pipe::Filter(";
+  Func->WriteName(out);
+  out << ", ";
+}
+
 TFilter::TFilter(const L0::TPackage *package,
                  const Type::TType &ret_type,
                  const TInline::TPtr &seq,
                  const TFunction::TPtr &func)
-    : TInline(package, ret_type), Func(func), Seq(seq) {}
\ No newline at end of file
+    : TPipeStage(package, ret_type), Func(func), Seq(seq) {}
\ No newline at end of file
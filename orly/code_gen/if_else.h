@@ -41,6 +41,22 @@ namespace Orly {
 
       void WriteExpr(TCppPrinter &out) const;
 
+      /* Used when spotting patterns, as in a reduce which is really a running min. */
+      const TInline::TPtr &GetPredicate() const {
+        assert(this);
+        return Predicate;
+      }
+
+      const TInlineScope::TPtr &GetTrue() const {
+        assert(this);
+        return True;
+      }
+
+      const TInlineScope::TPtr &GetFalse() const {
+        assert(this);
+        return False;
+      }
+
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
@@ -37,6 +37,12 @@ namespace Orly {
 
       void WriteExpr(TCppPrinter &out) const;
 
+      /* The expression the scope yields. */
+      const TInline::TPtr &GetBody() const {
+        assert(this);
+        return Body;
+      }
+
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
@@ -37,6 +37,19 @@ TKeys::TKeys(const L0::TPackage *package,
 void TKeys::WriteExpr(TCppPrinter &out) const {
   assert(this);
   assert(&out);
+  WriteNew(out, nullptr);
+}
+
+void TKeys::WriteLimited(TCppPrinter &out, const TInline::TPtr &limit) const {
+  assert(this);
+  assert(&out);
+  assert(limit);
+  WriteNew(out, limit);
+}
+
+void TKeys::WriteNew(TCppPrinter &out, const TInline::TPtr &limit) const {
+  assert(this);
+  assert(&out);
 
   #if 0
   out << "ctx.New<" << Type::UnwrapSequence(GetReturnType()) << ">(ctx.GetFlux(), Var::TVar::Addr({";
@@ -118,5 +131,9 @@ void TKeys::WriteExpr(TCppPrinter &out) const {
               }
               out << "(" << it.second << ")";
             })
-    << "))";
+    << ')';
+  if (limit) {
+    out << ", " << limit;
+  }
+  out << ')';
 }
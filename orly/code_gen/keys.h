@@ -40,6 +40,9 @@ namespace Orly {
 
       void WriteExpr(TCppPrinter &out) const;
 
+      /* Writes a generator which yields at most the first 'limit' of our keys, then stops walking the index. */
+      void WriteLimited(TCppPrinter &out, const TInline::TPtr &limit) const;
+
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
@@ -50,6 +53,10 @@ namespace Orly {
       }
 
       private:
+
+      /* Writes the generator, with a limit if we're given one. */
+      void WriteNew(TCppPrinter &out, const TInline::TPtr &limit) const;
+
       TAddrElems AddrElems;
 
       Type::TType ValType;
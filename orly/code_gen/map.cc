@@ -36,11 +36,16 @@ TMap::TMap(const L0::TPackage *package,
            const Type::TType &ret,
            const TSeqs &seqs,
            const TImplicitFunc::TPtr &func)
-    : TInline(package, ret),
+    : TPipeStage(package, ret),
       Func(func),
       Seqs(seqs) {}
 
-void TMap::WriteExpr(TCppPrinter &out) const {
+TInline::TPtr TMap::TryGetPipeSeq() const {
+  assert(this);
+  return Seqs.size() == 1 ? *Seqs.begin() : nullptr;
+}
+
+void TMap::WriteGenerator(TCppPrinter &out) const {
   assert(this);
   assert(&out);
   if(Seqs.size() != 1) {
@@ -53,6 +58,14 @@ void TMap::WriteExpr(TCppPrinter &out) const {
   out  << ", " << *Seqs.begin() << ')';
 }
 
+void TMap::WriteStageOpen(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  out << "Pipe::Map<" << Type::UnwrapSequence(GetReturnType()) << ">(";
+  Func->WriteName(out);
+  out << ", ";
+}
+
 void TMap::AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const {
   assert(this);
   for (const auto &iter : Seqs) {
@@ -18,7 +18,7 @@
 
 #pragma once
 
-#include <orly/code_gen/inline.h>
+#include <orly/code_gen/pipe_stage.h>
 
 #include <unordered_set>
 
@@ -28,7 +28,7 @@ namespace Orly {
 
     class TImplicitFunc;
 
-    class TMap : public TInline {
+    class TMap : public TPipeStage {
       NO_COPY(TMap);
       public:
 
@@ -38,11 +38,18 @@ namespace Orly {
 
       static TMap::TPtr New(const L0::TPackage *package, const Type::TType &ret, const TSeqs &seqs, const TFuncPtr &func);
 
-      void WriteExpr(TCppPrinter &out) const;
-
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override;
 
+      protected:
+
+      /* See TPipeStage. */
+      virtual TInline::TPtr TryGetPipeSeq() const override;
+
+      virtual void WriteGenerator(TCppPrinter &out) const override;
+
+      virtual void WriteStageOpen(TCppPrinter &out) const override;
+
       private:
       TMap(const L0::TPackage *package, const Type::TType &ret, const TSeqs &seqs, const TFuncPtr &func);
       TFuncPtr Func;
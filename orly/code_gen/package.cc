@@ -172,9 +172,9 @@ void TPackage::Emit(const Jhm::TTree &out_dir) const {;
         Exported function signatures
         The core package API (GetPackageInfo)
      cc // Core implementation code of external interfaces
+       Include for the orly Rt environment (first, so it can come from a precompiled header)
        Include for all the package interfaces we need
        Include for all the objects we need
-       Include for the flux api, orly Rt environment
        Forward declare internal function signatures (I don't think there are any...)
        Define all the EffectBindingSets and AssertionPredicateMaps we need
        Define all the implementation functions
@@ -184,6 +184,7 @@ void TPackage::Emit(const Jhm::TTree &out_dir) const {;
         Define GetPackageInfo()
 
      link.cc // TLinkInfo class, GetApiVesion function.
+       Include for the orly Rt environment
        Include header for every module in the link
        Define all the API Functions
        Define all the test functions
@@ -228,12 +229,9 @@ void TPackage::WriteStartingComment(TCppPrinter &out, const TRelPath &path) cons
 }
 
 void TPackage::WriteHeader(TCppPrinter &out, const TRelPath &path) const {
-  //TODO: Reduce number of needed includes.
   WriteStartingComment(out, path);
   out << "#pragma once" << Eol
-      << "#include <orly/package/api.h>" << Eol
-      << "#include <orly/package/rt.h>" << Eol
-      << "#include <orly/rt.h>" << Eol;
+      << "#include <orly/package/runtime.h>" << Eol;
 
   //TODO: Reduce to only objects needed by the export set.
   for(const auto &object: Objects) {
@@ -263,6 +261,9 @@ void TPackage::WriteHeader(TCppPrinter &out, const TRelPath &path) const {
 void TPackage::WriteCc(TCppPrinter &out, const TRelPath &rel_path) const {
 
   WriteStartingComment(out, rel_path);
+  //The runtime comes first, so the compiler can use its precompiled header.
+  out << "#include <orly/package/runtime.h>" << Eol
+      << Eol;
   WriteInclude(out);
 
   //Include for all the package interfaces we need
@@ -274,10 +275,7 @@ void TPackage::WriteCc(TCppPrinter &out, const TRelPath &rel_path) const {
     GenObjInclude(object, out);
   }
 
-  //Include for the flux api, orly Rt environment
   out << Eol
-      << "#include <orly/var/mutation.h>" << Eol
-      << Eol
       << "using namespace Orly;" << Eol
       << "using namespace Orly::Rt;" << Eol
       << Eol;
@@ -424,13 +422,7 @@ void TPackage::WriteCc(TCppPrinter &out, const TRelPath &rel_path) const {
 
 void TPackage::WriteLink(TCppPrinter &out, const TRelPath &path) const {
   WriteStartingComment(out, path);
-  out << "#include <unordered_map>" << Eol
-      << "#include <utility>" << Eol
-      << Eol
-      << "#include <base/uuid.h>" << Eol
-      << "#include <orly/rt.h>" << Eol
-      << "#include <orly/shared_enum.h>" << Eol
-      << "#include <orly/type/impl.h>" << Eol
+  out << "#include <orly/package/runtime.h>" << Eol
       << Eol;
   // Include header for every module in the link
   WriteInclude(out);
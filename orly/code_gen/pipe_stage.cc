@@ -0,0 +1,62 @@
+/* <orly/code_gen/pipe_stage.cc>
+
+   Implements <orly/code_gen/pipe_stage.h>
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/code_gen/pipe_stage.h>
+
+#include <orly/type/unwrap.h>
+
+using namespace Orly::CodeGen;
+
+void TPipeStage::WriteExpr(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  if (TryGetInner()) {
+    out << "Pipe::Run(";
+    WritePipe(out);
+    out << ')';
+  } else {
+    WriteGenerator(out);
+  }
+}
+
+TPipeStage::TPipeStage(const L0::TPackage *package, const Type::TType &ret_type)
+    : TInline(package, ret_type) {}
+
+const TPipeStage *TPipeStage::TryGetInner() const {
+  assert(this);
+  auto seq = TryGetPipeSeq();
+  if (!seq || seq->HasId()) {
+    return nullptr;
+  }
+  auto inner = dynamic_cast<const TPipeStage *>(seq.get());
+  return (inner && inner->TryGetPipeSeq()) ? inner : nullptr;
+}
+
+void TPipeStage::WritePipe(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  WriteStageOpen(out);
+  auto inner = TryGetInner();
+  if (inner) {
+    inner->WritePipe(out);
+  } else {
+    auto seq = TryGetPipeSeq();
+    out << "Pipe::Source<" << Type::UnwrapSequence(seq->GetReturnType()) << ">(" << seq << ')';
+  }
+  out << ')';
+}
@@ -0,0 +1,65 @@
+/* <orly/code_gen/pipe_stage.h>
+
+   A filter, map, take, skip or while over a sequence, which fuses with the stages below it.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <orly/code_gen/inline.h>
+
+namespace Orly {
+
+  namespace CodeGen {
+
+    /* The base for the inlines which read one sequence and produce another, item by item.
+
+       When the sequence a stage reads is itself written by another such stage (and hasn't been hoisted into a variable by
+       common subexpression elimination), we write the whole chain as a single <orly/rt/pipe.h> pipe, so its stages don't
+       each go through a virtual cursor.  A lone stage is written as the generator of its own, as before. */
+    class TPipeStage
+        : public TInline {
+      NO_COPY(TPipeStage);
+      public:
+
+      /* Writes either a pipe or a generator, as above. */
+      virtual void WriteExpr(TCppPrinter &out) const override final;
+
+      protected:
+
+      TPipeStage(const L0::TPackage *package, const Type::TType &ret_type);
+
+      /* The sequence we read item by item, or null if we don't read just one that way, and so can't be a stage of a pipe. */
+      virtual TInline::TPtr TryGetPipeSeq() const = 0;
+
+      /* Writes this stage as a generator of its own. */
+      virtual void WriteGenerator(TCppPrinter &out) const = 0;
+
+      /* Writes the start of this stage as a pipe stage, up to where the stage below it goes, such as 'Pipe::Take(n, '. */
+      virtual void WriteStageOpen(TCppPrinter &out) const = 0;
+
+      private:
+
+      /* The stage below us, if we can fuse with it. */
+      const TPipeStage *TryGetInner() const;
+
+      /* Writes this stage and all the stages below it as a pipe, without running it. */
+      void WritePipe(TCppPrinter &out) const;
+
+    };  // TPipeStage
+
+  }  // CodeGen
+
+}  // Orly
@@ -18,8 +18,13 @@
 
 #include <orly/code_gen/reduce.h>
 
+#include <orly/code_gen/binary.h>
+#include <orly/code_gen/if_else.h>
 #include <orly/code_gen/implicit_func.h>
+#include <orly/code_gen/literal.h>
+#include <orly/type/impl.h>
 
+using namespace Orly;
 using namespace Orly::CodeGen;
 
 
@@ -34,11 +39,92 @@ TReduce::TPtr TReduce::New(const L0::TPackage *package,
 void TReduce::WriteExpr(TCppPrinter &out) const {
   assert(&out);
 
+  if (TryWriteKernel(out)) {
+    return;
+  }
   out << "Reduce" << '(' << Seq << ", ";
   Func->WriteName(out);
   out << ", " << Start << ')';
 }
 
+bool TReduce::TryWriteKernel(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  Type::TType type = GetReturnType();
+  if (type != Type::TInt::Get() && type != Type::TReal::Get()) {
+    return false;
+  }
+  const TInline *carry = Func->GetArg("carry").get();
+  const TInline *that = Func->GetArg("that").get();
+  if (carry->GetReturnType() != type || that->GetReturnType() != type || Start->GetReturnType() != type) {
+    return false;
+  }
+  const TInline *body = Func->GetBody().get();
+  /* carry + that, that + carry, or carry + <int literal> */
+  auto binary = dynamic_cast<const TBinary *>(body);
+  if (binary) {
+    if (binary->GetOp() != TBinary::Add) {
+      return false;
+    }
+    const TInline *lhs = binary->GetLhs().get(), *rhs = binary->GetRhs().get();
+    if ((lhs == carry && rhs == that) || (lhs == that && rhs == carry)) {
+      out << "ReduceSum<" << type << ">(" << Seq << ", " << Start << ')';
+      return true;
+    }
+    if (type == Type::TInt::Get() && lhs == carry && dynamic_cast<const TLiteral *>(rhs)) {
+      out << "ReduceCount<" << type << ">(" << Seq << ", " << Start << ", ";
+      /* Not Write(), as the literal may have been given a name which only means something inside the reduce function. */
+      rhs->WriteExpr(out);
+      out << ')';
+      return true;
+    }
+    return false;
+  }
+  /* carry if carry <op> that else that, or that if that <op> carry else carry */
+  auto if_else = dynamic_cast<const TIfElse *>(body);
+  if (if_else) {
+    auto predicate = dynamic_cast<const TBinary *>(if_else->GetPredicate().get());
+    if (!predicate) {
+      return false;
+    }
+    const char *compare;
+    switch (predicate->GetOp()) {
+      case TBinary::Lt: {
+        compare = "std::less";
+        break;
+      }
+      case TBinary::LtEq: {
+        compare = "std::less_equal";
+        break;
+      }
+      case TBinary::Gt: {
+        compare = "std::greater";
+        break;
+      }
+      case TBinary::GtEq: {
+        compare = "std::greater_equal";
+        break;
+      }
+      default: {
+        return false;
+      }
+    }
+    const TInline *lhs = predicate->GetLhs().get(), *rhs = predicate->GetRhs().get();
+    const TInline *on_true = if_else->GetTrue()->GetBody().get(), *on_false = if_else->GetFalse()->GetBody().get();
+    const char *kernel;
+    if (lhs == carry && rhs == that && on_true == carry && on_false == that) {
+      kernel = "ReduceKeepCarry";
+    } else if (lhs == that && rhs == carry && on_true == that && on_false == carry) {
+      kernel = "ReduceTakeThat";
+    } else {
+      return false;
+    }
+    out << kernel << '<' << type << ", " << compare << '<' << type << ">>(" << Seq << ", " << Start << ')';
+    return true;
+  }
+  return false;
+}
+
 TReduce::TReduce(const L0::TPackage *package,
                  const Type::TType &ret_type,
                  const TInline::TPtr &seq,
@@ -51,6 +51,9 @@ namespace Orly {
               const TInline::TPtr &start,
               const TFuncPtr &reduce_func);
 
+      /* If the reduce is one of the simple ones <orly/rt/reduce.h> has a kernel for, write a call to it and return true. */
+      bool TryWriteKernel(TCppPrinter &out) const;
+
       TFuncPtr Func;
       TInline::TPtr Seq, Start;
     }; // TReduce
@@ -0,0 +1,150 @@
+/* <orly/code_gen/reduce.test.cc>
+
+   Unit test for <orly/code_gen/reduce.h>
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/code_gen/reduce.h>
+
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+
+#include <orly/code_gen/package.h>
+#include <orly/expr/add.h>
+#include <orly/expr/comp_ops.h>
+#include <orly/expr/if_else.h>
+#include <orly/expr/list.h>
+#include <orly/expr/literal.h>
+#include <orly/expr/mult.h>
+#include <orly/expr/reduce.h>
+#include <orly/expr/sequence_of.h>
+#include <orly/expr/start.h>
+#include <orly/expr/sub.h>
+#include <orly/expr/that.h>
+#include <orly/symbol/package.h>
+#include <orly/symbol/result_def.h>
+#include <orly/type/type_czar.h>
+#include <util/path.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly;
+
+static const char *TestDir = "/tmp/reduce_test";
+
+/* A literal int. */
+static Expr::TExpr::TPtr Int(int64_t val) {
+  return Expr::TLiteral::New(Var::TVar(val), TPosRange());
+}
+
+/* Builds a fresh carry or that each time it is called, as an expression has only one parent. */
+typedef function<Expr::TExpr::TPtr ()> TMaker;
+
+/* Emits a package whose only function is '**[3, 1, 2] reduce (start <start>, <body>)', with the body built by the given
+   callback out of the carry and that, and returns the generated implementation. */
+static string EmitReduce(int64_t start, const function<Expr::TExpr::TPtr (const TMaker &carry, const TMaker &that)> &body) {
+  Type::TTypeCzar type_czar;
+  auto p_sym = Symbol::TPackage::New({{"test"}}, "test", 1);
+  auto foo = Symbol::TFunction::New(p_sym, "foo", TPosRange());
+  Symbol::TResultDef::New(foo, "bar", TPosRange());
+  auto seq = Expr::TSequenceOf::New(Expr::TList::New({Int(3), Int(1), Int(2)}, TPosRange()), TPosRange());
+  auto reduce = Expr::TReduce::New(seq, TPosRange());
+  /* The first 'start' is the one which gives the initial value, any others just refer to the carry. */
+  auto first = Expr::TStart::New(Int(start), TPosRange());
+  reduce->SetStart(first);
+  bool used_first = false;
+  auto carry = [&]() -> Expr::TExpr::TPtr {
+    if (!used_first) {
+      used_first = true;
+      return first;
+    }
+    return Expr::TStart::New(Int(start), TPosRange());
+  };
+  auto that = [&]() -> Expr::TExpr::TPtr {
+    return Expr::TThat::New(reduce, TPosRange());
+  };
+  reduce->SetRhs(body(carry, that));
+  foo->SetExpr(reduce);
+  CodeGen::TPackage(p_sym).Emit(Jhm::TTree(TestDir));
+  ifstream strm(string(TestDir) + "/test.cc");
+  ostringstream out;
+  out << strm.rdbuf();
+  Util::EnsureDirIsGone(TestDir);
+  return out.str();
+}
+
+static bool Contains(const string &code, const char *text) {
+  return code.find(text) != string::npos;
+}
+
+FIXTURE(Sum) {
+  string code = EmitReduce(0, [](const TMaker &carry, const TMaker &that) {
+    return Expr::TAdd::New(carry(), that(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "ReduceSum<"));
+  EXPECT_FALSE(Contains(code, "Reduce("));
+  code = EmitReduce(0, [](const TMaker &carry, const TMaker &that) {
+    return Expr::TAdd::New(that(), carry(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "ReduceSum<"));
+  EXPECT_FALSE(Contains(code, "Reduce("));
+}
+
+FIXTURE(Count) {
+  string code = EmitReduce(0, [](const TMaker &carry, const TMaker &) {
+    return Expr::TAdd::New(carry(), Int(1), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "ReduceCount<"));
+  EXPECT_FALSE(Contains(code, "Reduce("));
+}
+
+FIXTURE(KeepCarry) {
+  string code = EmitReduce(100, [](const TMaker &carry, const TMaker &that) {
+    auto predicate = Expr::TLt::New(carry(), that(), TPosRange());
+    return Expr::TIfElse::New(carry(), predicate, that(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "ReduceKeepCarry<"));
+  EXPECT_FALSE(Contains(code, "Reduce("));
+}
+
+FIXTURE(NotAdd) {
+  string code = EmitReduce(0, [](const TMaker &carry, const TMaker &that) {
+    return Expr::TSub::New(carry(), that(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "Reduce("));
+  EXPECT_FALSE(Contains(code, "ReduceSum<"));
+  EXPECT_FALSE(Contains(code, "ReduceCount<"));
+}
+
+FIXTURE(OtherUseOfThat) {
+  /* start + that * that, which adds to the carry, but not that itself. */
+  string code = EmitReduce(0, [](const TMaker &carry, const TMaker &that) {
+    return Expr::TAdd::New(carry(), Expr::TMult::New(that(), that(), TPosRange()), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "Reduce("));
+  EXPECT_FALSE(Contains(code, "ReduceSum<"));
+  EXPECT_FALSE(Contains(code, "ReduceCount<"));
+  /* start if that < start else that, which compares the other way round from the arm it keeps. */
+  code = EmitReduce(100, [](const TMaker &carry, const TMaker &that) {
+    auto predicate = Expr::TLt::New(that(), carry(), TPosRange());
+    return Expr::TIfElse::New(carry(), predicate, that(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "Reduce("));
+  EXPECT_FALSE(Contains(code, "ReduceKeepCarry<"));
+  EXPECT_FALSE(Contains(code, "ReduceTakeThat<"));
+}
@@ -31,7 +31,12 @@ TSkip::TPtr TSkip::New(
   return TPtr(new TSkip(package, ret_type, seq, count));
 }
 
-void TSkip::WriteExpr(TCppPrinter &out) const {
+TInline::TPtr TSkip::TryGetPipeSeq() const {
+  assert(this);
+  return Seq;
+}
+
+void TSkip::WriteGenerator(TCppPrinter &out) const {
   assert(this);
   assert(&out);
   out
@@ -39,9 +44,15 @@ void TSkip::WriteExpr(TCppPrinter &out) const {
     << Count << ", " << Seq << ')';
 }
 
+void TSkip::WriteStageOpen(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  out << "Pipe::Skip(" << Count << ", ";
+}
+
 TSkip::TSkip(
     const L0::TPackage *package,
     const Type::TType &ret_type,
     const TInline::TPtr &seq,
     const TInline::TPtr &count)
-      : TInline(package, ret_type), Count(count), Seq(seq) {}
\ No newline at end of file
+      : TPipeStage(package, ret_type), Count(count), Seq(seq) {}
\ No newline at end of file
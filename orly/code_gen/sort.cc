@@ -18,8 +18,11 @@
 
 #include <orly/code_gen/sort.h>
 
+#include <orly/code_gen/binary.h>
 #include <orly/code_gen/implicit_func.h>
+#include <orly/type/impl.h>
 
+using namespace Orly;
 using namespace Orly::CodeGen;
 
 TSort::TPtr TSort::New(const L0::TPackage *package,
@@ -33,11 +36,38 @@ void TSort::WriteExpr(TCppPrinter &out) const {
   assert(this);
   assert(&out);
 
+  if (TryWriteNatural(out)) {
+    return;
+  }
   out << "Sort(" << Container << ", ";
   Func->WriteName(out);
   out << ')';
 }
 
+bool TSort::TryWriteNatural(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  const TInline *lhs = Func->GetArg("lhs").get();
+  const TInline *rhs = Func->GetArg("rhs").get();
+  Type::TType type = lhs->GetReturnType();
+  if ((type != Type::TInt::Get() && type != Type::TReal::Get()) || rhs->GetReturnType() != type) {
+    return false;
+  }
+  /* lhs < rhs, lhs > rhs, or either with the args swapped */
+  auto binary = dynamic_cast<const TBinary *>(Func->GetBody().get());
+  if (!binary || (binary->GetOp() != TBinary::Lt && binary->GetOp() != TBinary::Gt)) {
+    return false;
+  }
+  bool ascending = binary->GetOp() == TBinary::Lt;
+  if (binary->GetLhs().get() == rhs && binary->GetRhs().get() == lhs) {
+    ascending = !ascending;
+  } else if (binary->GetLhs().get() != lhs || binary->GetRhs().get() != rhs) {
+    return false;
+  }
+  out << "SortNatural<" << type << ">(" << Container << ", " << (ascending ? "true" : "false") << ')';
+  return true;
+}
+
 TSort::TSort(const L0::TPackage *package,
              const Type::TType &ret_type,
              const TInline::TPtr &container,
@@ -49,6 +49,9 @@ namespace Orly {
             const TInline::TPtr &container,
             const TImplicitFuncPtr &func);
 
+      /* If we sort a list of int or real by its natural order, one way or the other, write a call to SortNatural() and return true. */
+      bool TryWriteNatural(TCppPrinter &out) const;
+
       TInline::TPtr Container;
       TImplicitFuncPtr Func;
     }; // TSort
@@ -0,0 +1,117 @@
+/* <orly/code_gen/sort.test.cc>
+
+   Unit test for <orly/code_gen/sort.h>
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/code_gen/sort.h>
+
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+
+#include <orly/code_gen/package.h>
+#include <orly/expr/comp_ops.h>
+#include <orly/expr/lhs_and_rhs.h>
+#include <orly/expr/list.h>
+#include <orly/expr/literal.h>
+#include <orly/expr/sign.h>
+#include <orly/expr/sort.h>
+#include <orly/symbol/package.h>
+#include <orly/symbol/result_def.h>
+#include <orly/type/type_czar.h>
+#include <util/path.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly;
+
+static const char *TestDir = "/tmp/sort_test";
+
+/* A literal int. */
+static Expr::TExpr::TPtr Int(int64_t val) {
+  return Expr::TLiteral::New(Var::TVar(val), TPosRange());
+}
+
+/* Builds a fresh lhs or rhs each time it is called, as an expression has only one parent. */
+typedef function<Expr::TExpr::TPtr ()> TMaker;
+
+/* Emits a package whose only function is '[3, 1, 2] sort (<predicate>)', with the predicate built by the given callback
+   out of the lhs and rhs, and returns the generated implementation. */
+static string EmitSort(const function<Expr::TExpr::TPtr (const TMaker &lhs, const TMaker &rhs)> &predicate) {
+  Type::TTypeCzar type_czar;
+  auto p_sym = Symbol::TPackage::New({{"test"}}, "test", 1);
+  auto foo = Symbol::TFunction::New(p_sym, "foo", TPosRange());
+  Symbol::TResultDef::New(foo, "bar", TPosRange());
+  auto sort = Expr::TSort::New(Expr::TList::New({Int(3), Int(1), Int(2)}, TPosRange()), TPosRange());
+  auto lhs = [&]() -> Expr::TExpr::TPtr {
+    return Expr::TLhs::New(sort, TPosRange());
+  };
+  auto rhs = [&]() -> Expr::TExpr::TPtr {
+    return Expr::TRhs::New(sort, TPosRange());
+  };
+  sort->SetRhs(predicate(lhs, rhs));
+  foo->SetExpr(sort);
+  CodeGen::TPackage(p_sym).Emit(Jhm::TTree(TestDir));
+  ifstream strm(string(TestDir) + "/test.cc");
+  ostringstream out;
+  out << strm.rdbuf();
+  Util::EnsureDirIsGone(TestDir);
+  return out.str();
+}
+
+static bool Contains(const string &code, const char *text) {
+  return code.find(text) != string::npos;
+}
+
+FIXTURE(Ascending) {
+  string code = EmitSort([](const TMaker &lhs, const TMaker &rhs) {
+    return Expr::TLt::New(lhs(), rhs(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, ", true)"));
+  EXPECT_TRUE(Contains(code, "SortNatural<"));
+  EXPECT_FALSE(Contains(code, "Sort("));
+  code = EmitSort([](const TMaker &lhs, const TMaker &rhs) {
+    return Expr::TGt::New(rhs(), lhs(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "SortNatural<"));
+  EXPECT_FALSE(Contains(code, "Sort("));
+}
+
+FIXTURE(Descending) {
+  string code = EmitSort([](const TMaker &lhs, const TMaker &rhs) {
+    return Expr::TGt::New(lhs(), rhs(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "SortNatural<"));
+  EXPECT_TRUE(Contains(code, ", false)"));
+  EXPECT_FALSE(Contains(code, "Sort("));
+}
+
+FIXTURE(CustomKey) {
+  /* -lhs < -rhs, which orders by a key rather than by the elements themselves. */
+  string code = EmitSort([](const TMaker &lhs, const TMaker &rhs) {
+    return Expr::TLt::New(Expr::TNegative::New(lhs(), TPosRange()), Expr::TNegative::New(rhs(), TPosRange()), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "Sort("));
+  EXPECT_FALSE(Contains(code, "SortNatural<"));
+  /* lhs <= rhs, which isn't a strict weak order, so can't be handed to the natural sort. */
+  code = EmitSort([](const TMaker &lhs, const TMaker &rhs) {
+    return Expr::TLtEq::New(lhs(), rhs(), TPosRange());
+  });
+  EXPECT_TRUE(Contains(code, "Sort("));
+  EXPECT_FALSE(Contains(code, "SortNatural<"));
+}
@@ -31,19 +31,41 @@ TTake::TPtr TTake::New(
   return TPtr(new TTake(package, ret_type, seq, count));
 }
 
-void TTake::WriteExpr(TCppPrinter &out) const {
+TInline::TPtr TTake::TryGetPipeSeq() const {
+  assert(this);
+  return TryGetKeys() ? nullptr : Seq;
+}
+
+void TTake::WriteGenerator(TCppPrinter &out) const {
   assert(this);
   assert(&out);
+  auto keys = TryGetKeys();
+  if (keys) {
+    keys->WriteLimited(out, Count);
+    return;
+  }
   out
     << "TTakeGenerator<" << Type::UnwrapSequence(GetReturnType()) << ">::New("
     << Count << ", " << Seq << ')';
 }
 
+void TTake::WriteStageOpen(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  out << "Pipe::Take(" << Count << ", ";
+}
+
+const TKeys *TTake::TryGetKeys() const {
+  assert(this);
+  /* If common subexpression elimination hoisted the keys, someone else reads them too, and wants all of them. */
+  return Seq->HasId() ? nullptr : dynamic_cast<const TKeys *>(Seq.get());
+}
+
 TTake::TTake(
     const L0::TPackage *package,
     const Type::TType &ret_type,
     const TInline::TPtr &seq,
     const TInline::TPtr &count)
-    : TInline(package, ret_type),
+    : TPipeStage(package, ret_type),
       Count(count),
       Seq(seq) {}
\ No newline at end of file
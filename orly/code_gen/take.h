@@ -19,14 +19,15 @@
 #pragma once
 
 #include <orly/code_gen/function.h>
-#include <orly/code_gen/inline.h>
+#include <orly/code_gen/keys.h>
+#include <orly/code_gen/pipe_stage.h>
 
 namespace Orly {
 
   namespace CodeGen {
 
     class TTake
-        : public TInline {
+        : public TPipeStage {
       NO_COPY(TTake);
       public:
 
@@ -38,8 +39,6 @@ namespace Orly {
           const TInline::TPtr &seq,
           const TInline::TPtr &count);
 
-      void WriteExpr(TCppPrinter &out) const;
-
       /* Dependency graph */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
@@ -49,6 +48,15 @@ namespace Orly {
         Seq->AppendDependsOn(dependency_set);
       }
 
+      protected:
+
+      /* See TPipeStage. */
+      virtual TInline::TPtr TryGetPipeSeq() const override;
+
+      virtual void WriteGenerator(TCppPrinter &out) const override;
+
+      virtual void WriteStageOpen(TCppPrinter &out) const override;
+
       private:
 
       TTake(const L0::TPackage *package,
@@ -56,6 +64,9 @@ namespace Orly {
             const TInline::TPtr &seq,
             const TInline::TPtr &count);
 
+      /* The keys we read, if we read them straight from the index, in which case we pass our count down as the generator's limit. */
+      const TKeys *TryGetKeys() const;
+
       TInline::TPtr Count;
 
       TInline::TPtr Seq;
@@ -31,7 +31,12 @@ TWhile::TPtr TWhile::New(
   return TPtr(new TWhile(package, ret_type, seq, func));
 }
 
-void TWhile::WriteExpr(TCppPrinter &out) const {
+TInline::TPtr TWhile::TryGetPipeSeq() const {
+  assert(this);
+  return Seq;
+}
+
+void TWhile::WriteGenerator(TCppPrinter &out) const {
   assert(this);
   assert(&out);
   out << "TWhileGenerator<" << Type::UnwrapSequence(GetReturnType()) << ">::New(";
@@ -39,8 +44,16 @@ void TWhile::WriteExpr(TCppPrinter &out) const {
   out << ", " << Seq << ')';
 }
 
+void TWhile::WriteStageOpen(TCppPrinter &out) const {
+  assert(this);
+  assert(&out);
+  out << "Pipe::While(";
+  Func->WriteName(out);
+  out << ", ";
+}
+
 TWhile::TWhile(const L0::TPackage *package,
                const Type::TType &ret_type,
                const TInline::TPtr &seq,
                const TFunction::TPtr &func)
-    : TInline(package, ret_type), Func(func), Seq(seq) {}
\ No newline at end of file
+    : TPipeStage(package, ret_type), Func(func), Seq(seq) {}
\ No newline at end of file
@@ -19,14 +19,14 @@
 #pragma once
 
 #include <orly/code_gen/function.h>
-#include <orly/code_gen/inline.h>
+#include <orly/code_gen/pipe_stage.h>
 
 namespace Orly {
 
   namespace CodeGen {
 
     class TWhile
-        : public TInline {
+        : public TPipeStage {
       NO_COPY(TWhile);
       public:
 
@@ -38,8 +38,6 @@ namespace Orly {
           const TInline::TPtr &seq,
           const TFunction::TPtr &func);
 
-      void WriteExpr(TCppPrinter &out) const;
-
       /* TODO */
       virtual void AppendDependsOn(std::unordered_set<TInline::TPtr> &dependency_set) const override {
         assert(this);
@@ -49,6 +47,15 @@ namespace Orly {
         Func->GetBody()->AppendDependsOn(dependency_set);
       }
 
+      protected:
+
+      /* See TPipeStage. */
+      virtual TInline::TPtr TryGetPipeSeq() const override;
+
+      virtual void WriteGenerator(TCppPrinter &out) const override;
+
+      virtual void WriteStageOpen(TCppPrinter &out) const override;
+
       private:
 
       TWhile(const L0::TPackage *package,
@@ -18,14 +18,33 @@
 
 #include <orly/compiler.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <unordered_map>
+#include <utime.h>
 
 #include <base/as_str.h>
+#include <base/dir_iter.h>
+#include <base/dir_walker.h>
+#include <base/fd.h>
+#include <base/murmur.h>
 #include <base/split.h>
 #include <base/source_root.h>
 #include <base/subprocess.h>
@@ -33,6 +52,8 @@
 #include <orly/orly.package.cst.h>
 #include <orly/synth/context.h>
 #include <orly/synth/package.h>
+#include <util/error.h>
+#include <util/path.h>
 
 using namespace Base;
 using namespace std;
@@ -114,6 +135,197 @@ class TPackageBuilder {
 };  // TPackageBuilder
 
 
+/* Runs the given commands, as many at a time as we have cores.  Returns true iff. they all succeeded.  If echo is set, we echo the output
+   of any which failed. */
+static bool RunAll(const vector<vector<string>> &cmds, bool echo) {
+  TPump pump;
+  const size_t max_running = max(thread::hardware_concurrency(), 1U);
+  vector<unique_ptr<TSubprocess>> subprocs(cmds.size());
+  bool success = true;
+  auto wait = [&subprocs, &success, echo](size_t idx) {
+    if (subprocs[idx]->Wait()) {
+      if (echo) {
+        EchoOutput(subprocs[idx]->TakeStdOutFromChild());
+        EchoOutput(subprocs[idx]->TakeStdErrFromChild());
+      }
+      success = false;
+    }
+    subprocs[idx].reset();
+  };
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    if (i >= max_running) {
+      wait(i - max_running);
+    }
+    subprocs[i] = TSubprocess::New(pump, cmds[i]);
+  }
+  for (size_t i = cmds.size() > max_running ? cmds.size() - max_running : 0; i < cmds.size(); ++i) {
+    wait(i);
+  }
+  return success;
+}
+
+/* The number of hex digits in a Digest(). */
+static const size_t DigestSize = 32;
+
+/* The directory, within the output tree, which holds the precompiled runtime header, one subdirectory per digest. */
+static const string PchRootName = ".pch";
+
+/* A 128-bit digest of the given bytes, in hex.  Unlike std::hash, this comes out the same from one build of the compiler to the next,
+   so it's fit to name things we keep on disk. */
+static string Digest(const string &bytes) {
+  /* pad out to whole words and finish with the length, so trailing zeros still count */
+  vector<uint64_t> words((bytes.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t) + 1, 0);
+  memcpy(words.data(), bytes.data(), bytes.size());
+  words.back() = bytes.size();
+  ostringstream strm;
+  strm << hex << setfill('0');
+  for (uint64_t seed : {0x6f726c7963636865UL, 0x636f6d70696c6572UL}) {
+    strm << setw(16) << Murmur(words.data(), words.size(), seed);
+  }
+  return strm.str();
+}
+
+/* The digest of the given file's contents, chained onto the seed. */
+static string DigestFile(const string &path, const string &seed) {
+  ifstream in(path);
+  ostringstream contents;
+  contents << seed << '\0' << in.rdbuf();
+  return Digest(contents.str());
+}
+
+/* True iff. the name ends with the given suffix. */
+static bool EndsWith(const string &name, const string &suffix) {
+  return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/* True iff. the name ends with a digest, set off from anything before it by a dot. */
+static bool EndsWithDigest(const string &name) {
+  if (name.size() < DigestSize) {
+    return false;
+  }
+  const auto digest = name.end() - DigestSize;
+  return (digest == name.begin() || *(digest - 1) == '.') && all_of(digest, name.end(), [](char c) { return isxdigit(c); });
+}
+
+/* True iff. the name is that of an object in the cache, <src>.<digest>.o. */
+static bool IsCachedObjectName(const string &name) {
+  return EndsWith(name, ".o") && name.size() > DigestSize + 2 && EndsWithDigest(name.substr(0, name.size() - 2));
+}
+
+/* If the name is that of something a build writes on its way into the cache -- <src>.<pid>.ii, <src>.<digest>.o.tmp.<pid> or, within
+   the PCH root, <digest>.tmp.<pid> -- the pid of the build writing it; otherwise, 0. */
+static pid_t TryGetBuilderPid(const string &name) {
+  string stem = name;
+  const bool is_preprocessed = EndsWith(stem, ".ii");
+  if (is_preprocessed) {
+    stem.resize(stem.size() - 3);
+  }
+  const auto dot = stem.rfind('.');
+  if (dot == string::npos || dot + 1 == stem.size() || stem.size() - dot > 10 ||
+      !all_of(stem.begin() + dot + 1, stem.end(), [](char c) { return isdigit(c); })) {
+    return 0;
+  }
+  const pid_t pid = stoi(stem.substr(dot + 1));
+  stem.resize(dot);
+  if (is_preprocessed) {
+    return EndsWith(stem, ".cc") || stem == PchRootName ? pid : 0;
+  }
+  if (!EndsWith(stem, ".tmp")) {
+    return 0;
+  }
+  stem.resize(stem.size() - 4);
+  return IsCachedObjectName(stem) || (stem.size() == DigestSize && EndsWithDigest(stem)) ? pid : 0;
+}
+
+/* True iff. the build with the given pid is still running, in which case what it's writing is none of our business.  (If its pid
+   has since gone to some other process, we just leave its leftovers a while longer.) */
+static bool IsBuilderRunning(pid_t pid) {
+  return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+
+/* The header which the generated code includes first, and which we precompile. */
+static const char *RuntimeHdr = "orly/package/runtime.h";
+
+/* The time the given path was last modified, or 0 if there's no such path. */
+static time_t TryGetTimeModified(const string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+/* Takes a lock on the cache in the given output tree and holds it for as long as the fd stays open.  A build shares the lock from
+   the time it decides to reuse what's in the cache until it's done linking; PruneCache() takes it exclusively, so it never removes
+   something a build is counting on. */
+static TFd LockCache(const string &out_tree, int operation) {
+  TFd fd(open((out_tree + "/.cache.lock").c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0644));
+  Util::IfLt0(flock(fd, operation));
+  return fd;
+}
+
+void Orly::Compiler::PruneCache(const TTree &out_tree, chrono::seconds max_idle) {
+  class TPruner final : public TDirWalker {
+    NO_COPY(TPruner);
+    public:
+
+    explicit TPruner(time_t cutoff)
+        : Cutoff(cutoff) {}
+
+    virtual TAction OnDirBegin(const TEntry &entry) override {
+      if (entry.Depth != 1 || entry.Name != PchRootName) {
+        return Enter;
+      }
+      /* Each precompiled runtime goes with its own digest's directory, whole.  The build touches the header when it uses it, so that's
+         our time of last use; failing that, the directory's own.  A directory a build is still putting together is left to it. */
+      vector<string> pch_dirs;
+      for (TDirIter iter(entry.AccessPath); iter; ++iter) {
+        const string name = iter.GetName();
+        if (name.size() == DigestSize && EndsWithDigest(name)) {
+          time_t last_used = TryGetTimeModified(string(entry.AccessPath) + '/' + name + '/' + RuntimeHdr + ".gch");
+          if (!last_used) {
+            last_used = TryGetTimeModified(string(entry.AccessPath) + '/' + name);
+          }
+          if (last_used < Cutoff) {
+            pch_dirs.emplace_back(string(entry.AccessPath) + '/' + name);
+          }
+        } else {
+          const pid_t pid = TryGetBuilderPid(name);
+          if (pid && !IsBuilderRunning(pid)) {
+            pch_dirs.emplace_back(string(entry.AccessPath) + '/' + name);
+          }
+        }
+      }
+      for (const auto &pch_dir : pch_dirs) {
+        Util::EnsureDirIsGone(pch_dir.c_str());
+      }
+      return Skip;
+    }
+
+    virtual bool OnFile(const TEntry &entry) override {
+      /* A build touches each cached object it uses, so the modification time is the time of last use.  What a build is still
+         writing, we leave alone until the build is gone. */
+      if (IsCachedObjectName(entry.Name)) {
+        if (entry.TimeModified < Cutoff) {
+          unlink(entry.AccessPath);
+        }
+      } else {
+        const pid_t pid = TryGetBuilderPid(entry.Name);
+        if (pid && !IsBuilderRunning(pid)) {
+          unlink(entry.AccessPath);
+        }
+      }
+      return true;
+    }
+
+    private:
+
+    const time_t Cutoff;
+
+  };  // TPruner
+  const string root = AsStr(out_tree);
+  TFd lock = LockCache(root, LOCK_EX);
+  TPruner(time(nullptr) - max_idle.count()).Walk(root.c_str());
+}
+
 //Note: This should probably be promted to a compile management class.
 //TODO: Reintroduce machine mode, not saving cc. Also reintroduce syntax check only and semantic check only compilation.
 /* Returns the versioned package name of the final build target. */
@@ -221,42 +433,128 @@ Package::TVersionedName Orly::Compiler::Compile(
       out_strm << "MM_NOTICE: Compiling C++" << endl;
     }
 
+    auto fail = [&out_strm]() {
+      //NOTE: use '-d' to get the error messages.
+      out_strm << "Error while compiling an Intermediate Representation. See a Orly team member with your Orly code for support" << endl;
+      throw TCompileFailure(HERE, "Compiling C++ and linking");
+    };
+
     // TODO: Check these compile flags.
-    vector<string> gcc_cmd{"g++", "-std=c++1y", "-xc++", "-I" + GetSrcRoot(), "-fPIC", "-shared", "-o",
-                           AsStr(out_tree.GetAbsPath(SwapExtension(
-                               TPath(core_rel.Path), {to_string(packages[core_rel]->GetVersion()), "so"}))),
-                           "-iquote", AsStr(out_tree),
-                           AsStr(out_tree.GetAbsPath(SwapExtension(TPath(core_rel.Path), {"link", "cc"})))};
-    // Take all the packages needed directly or indirectly by the compilation and link  them together in one swoop.
-    for (const auto &package : packages) {
-      gcc_cmd.emplace_back(AsStr(out_tree.GetAbsPath(SwapExtension(TPath(package.first.Path), {"cc"}))));
-    }
+    vector<string> gcc_flags{"g++", "-std=c++1y", "-xc++", "-I" + GetSrcRoot(), "-fPIC", "-iquote", AsStr(out_tree)};
     if (debug_cc) {
       const char *debug_args[] = {"-g",      "-Wno-unused-variable", "-Wno-type-limits",
                                   "-Werror", "-Wno-parentheses",     "-Wall",
                                   "-Wextra", "-Wno-unused-parameter"};
       for (auto &arg : debug_args) {
-        gcc_cmd.emplace_back(arg);
+        gcc_flags.emplace_back(arg);
       }
     } else {
       // TODO: Better optimization flags.
       // TODO: vector append
-      gcc_cmd.push_back("-O2");
-      gcc_cmd.push_back("-DNDEBUG");
+      gcc_flags.push_back("-O2");
+      gcc_flags.push_back("-DNDEBUG");
     }
+    ostringstream flags_strm;
+    for (const auto &flag : gcc_flags) {
+      flags_strm << flag << '\0';
+    }
+    /* the compiler's version goes into every digest, so an upgraded compiler doesn't pick up what the old one built */ {
+      TPump pump;
+      auto subproc = TSubprocess::New(pump, {"g++", "-dumpfullversion", "-dumpversion"});
+      if (subproc->Wait()) {
+        fail();
+      }
+      flags_strm << ReadAll(subproc->TakeStdOutFromChild());
+    }
+    const string flags_digest = Digest(flags_strm.str());
 
-    TPump pump;
-    auto subproc = TSubprocess::New(pump, gcc_cmd);
-    auto status = subproc->Wait();
-    if (status || failed) {
-      if (debug_cc) {
-        EchoOutput(subproc->TakeStdOutFromChild());
-        EchoOutput(subproc->TakeStdErrFromChild());
+    // Every package needed directly or indirectly by the compilation, plus the link unit, each compiled to its own object.
+    vector<string> src_vec{AsStr(out_tree.GetAbsPath(SwapExtension(TPath(core_rel.Path), {"link", "cc"})))};
+    for (const auto &package : packages) {
+      src_vec.emplace_back(AsStr(out_tree.GetAbsPath(SwapExtension(TPath(package.first.Path), {"cc"}))));
+    }
+
+    /* An object is named for the digest of its preprocessed source and our flags, so a package whose code (or whose headers) didn't
+       change since we last built it costs us only the preprocessing.  Every variant stays in the cache, so switching back and forth
+       between versions (or between debug and release) doesn't rebuild anything; PruneCache() clears out the ones nobody uses. */
+    /* Another build of the same package may be running alongside us, so everything we write on the way to the cache carries our pid,
+       and only goes into the cache, whole, by rename. */
+    const string tmp_suffix = '.' + to_string(getpid());
+    vector<vector<string>> cmd_vec;
+    for (const auto &src : src_vec) {
+      cmd_vec.emplace_back(gcc_flags);
+      cmd_vec.back().insert(cmd_vec.back().end(), {"-E", "-o", src + tmp_suffix + ".ii", src});
+    }
+    /* The generated code includes the runtime first, by way of a single header, which we precompile.  It's keyed the same way as the
+       objects, and lives in a directory of its own which we search ahead of the source root, where the compiler will look for it.
+       Builds with other flags (or another runtime) have their own directories alongside ours. */
+    const string pch_root = AsStr(out_tree) + '/' + PchRootName;
+    const string runtime_preprocessed = pch_root + tmp_suffix + ".ii";
+    cmd_vec.emplace_back(gcc_flags);
+    cmd_vec.back().insert(cmd_vec.back().end(), {"-E", "-o", runtime_preprocessed, "-include", RuntimeHdr, "/dev/null"});
+    if (!RunAll(cmd_vec, debug_cc)) {
+      for (const auto &src : src_vec) {
+        unlink((src + tmp_suffix + ".ii").c_str());
+      }
+      unlink(runtime_preprocessed.c_str());
+      fail();
+    }
+    cmd_vec.clear();
+    const string pch_dir = pch_root + '/' + DigestFile(runtime_preprocessed, flags_digest);
+    const string pch = pch_dir + '/' + RuntimeHdr + ".gch";
+    unlink(runtime_preprocessed.c_str());
+    vector<string> compile_flags(gcc_flags);
+    compile_flags.insert(find(compile_flags.begin(), compile_flags.end(), "-I" + GetSrcRoot()), "-I" + pch_dir);
+    TFd cache_lock = LockCache(AsStr(out_tree), LOCK_SH);
+    vector<string> obj_vec;
+    vector<string> new_obj_vec;
+    for (const auto &src : src_vec) {
+      const string preprocessed = src + tmp_suffix + ".ii";
+      obj_vec.emplace_back(src + '.' + DigestFile(preprocessed, flags_digest) + ".o");
+      unlink(preprocessed.c_str());
+      const string &obj = obj_vec.back();
+      /* touching an object we already have marks it as used, which keeps PruneCache() off it */
+      if (utime(obj.c_str(), nullptr) != 0) {
+        /* compile to a temp name and move it into place, so an interrupted compile can't leave a bad object in the cache */
+        cmd_vec.emplace_back(compile_flags);
+        cmd_vec.back().insert(cmd_vec.back().end(), {"-c", "-o", obj + ".tmp" + tmp_suffix, src});
+        new_obj_vec.emplace_back(obj);
       }
+    }
+    /* touching the precompiled runtime marks it as used, as with the objects */
+    if (!cmd_vec.empty() && utime(pch.c_str(), nullptr) != 0) {
+      /* Build it in a directory of our own and rename that into place whole, so no other build ever sees it half made.  If another
+         build beat us to it, the rename fails and we drop ours.  If we can't build it at all, the compiler just reads the runtime the
+         long way. */
+      const string tmp_pch_dir = pch_dir + ".tmp" + tmp_suffix;
+      const string tmp_pch = tmp_pch_dir + '/' + RuntimeHdr + ".gch";
+      Util::EnsureDirExists(tmp_pch.c_str(), true);
+      vector<string> pch_cmd(gcc_flags);
+      *find(pch_cmd.begin(), pch_cmd.end(), "-xc++") = "-xc++-header";
+      pch_cmd.insert(pch_cmd.end(), {"-include", RuntimeHdr, "-o", tmp_pch, "/dev/null"});
+      if (!RunAll({pch_cmd}, debug_cc) || rename(tmp_pch_dir.c_str(), pch_dir.c_str()) != 0) {
+        Util::EnsureDirIsGone(tmp_pch_dir.c_str());
+      }
+    }
+    const bool compiled = RunAll(cmd_vec, debug_cc);
+    for (const auto &new_obj : new_obj_vec) {
+      const string tmp_obj = new_obj + ".tmp" + tmp_suffix;
+      if (compiled) {
+        Util::IfLt0(rename(tmp_obj.c_str(), new_obj.c_str()));
+      } else {
+        unlink(tmp_obj.c_str());
+      }
+    }
+    if (!compiled) {
+      fail();
+    }
 
-      //NOTE: use '-d' to get the error messages.
-      out_strm << "Error while compiling an Intermediate Representation. See a Orly team member with your Orly code for support" << endl;
-      throw TCompileFailure(HERE, "Compiling C++ and linking");
+    vector<string> link_cmd{"g++", "-shared", "-o",
+                            AsStr(out_tree.GetAbsPath(SwapExtension(
+                                TPath(core_rel.Path), {to_string(packages[core_rel]->GetVersion()), "so"})))};
+    link_cmd.insert(link_cmd.end(), obj_vec.begin(), obj_vec.end());
+    if (!RunAll({link_cmd}, debug_cc)) {
+      fail();
     }
   }
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <iostream>
 #include <string>
 
@@ -41,6 +42,11 @@ namespace Orly {
         bool semantic_only,
         std::ostream &out_strm = std::cout);
 
+    /* Compile() keeps every object and precompiled header it builds in the output tree, so nothing ever gets built twice.  This
+       removes the ones no build has used in the given time.  It waits for any builds in progress to finish with the cache, and holds off any new ones while it
+       works, so never call it from inside a build. */
+    void PruneCache(const Jhm::TTree &out_tree, std::chrono::seconds max_idle);
+
   }  // Compiler
 
 }  // Orly
@@ -0,0 +1,94 @@
+/* <orly/indy/compaction_planner.cc>
+
+   Implements <orly/indy/compaction_planner.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/compaction_planner.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <orly/indy/disk/util/hash_util.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy;
+
+constexpr size_t TCompactionPlanner::DefaultMinWidth;
+constexpr size_t TCompactionPlanner::DefaultMaxWidth;
+constexpr size_t TCompactionPlanner::DefaultMaxReadLayers;
+
+TCompactionPlanner::TCompactionPlanner(size_t min_width, size_t max_width, size_t max_read_layers)
+    : MinWidth(min_width), MaxWidth(max_width), MaxReadLayers(max_read_layers) {
+  if (MinWidth < 2UL || MaxWidth < MinWidth) {
+    throw invalid_argument("compaction widths must satisfy 2 <= min <= max");
+  }
+}
+
+TOpt<TCompactionPlanner::TPlan> TCompactionPlanner::Plan(const vector<TLayer> &layers) const {
+  assert(this);
+  assert(&layers);
+  const size_t size = layers.size();
+  vector<size_t> tiers(size);
+  size_t num_disk = 0UL;
+  for (size_t i = 0; i < size; ++i) {
+    tiers[i] = GetTier(layers[i].NumKeys);
+    num_disk += layers[i].IsDisk ? 1UL : 0UL;
+  }
+  /* an older layer in a lower tier than its newer neighbor */
+  for (size_t i = 0; i + 1 < size; ++i) {
+    if (layers[i].IsAvailable && layers[i + 1].IsAvailable && tiers[i] < tiers[i + 1]) {
+      return TPlan{i, i + 2};
+    }
+  }
+  /* the lowest tier with a run of at least MinWidth layers */
+  TOpt<TPlan> best;
+  for (size_t begin = 0; begin < size;) {
+    if (!layers[begin].IsAvailable) {
+      ++begin;
+      continue;
+    }
+    size_t end = begin + 1;
+    for (; end < size && layers[end].IsAvailable && tiers[end] == tiers[begin]; ++end);
+    if (end - begin >= MinWidth && (!best || tiers[begin] < tiers[best->Begin])) {
+      best = TPlan{begin, begin + min(end - begin, MaxWidth)};
+    }
+    begin = end;
+  }
+  if (best || num_disk <= MaxReadLayers) {
+    return best;
+  }
+  /* too many layers for reads to bear; the run costing the fewest keys per layer removed */
+  double best_cost = 0.0;
+  for (size_t begin = 0; begin < size; ++begin) {
+    size_t num_keys = 0UL;
+    for (size_t end = begin; end < size && end - begin < MaxWidth && layers[end].IsAvailable; ++end) {
+      num_keys += layers[end].NumKeys;
+      if (end > begin) {
+        const double cost = static_cast<double>(num_keys) / (end - begin);
+        if (!best || cost < best_cost) {
+          best = TPlan{begin, end + 1};
+          best_cost = cost;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+size_t TCompactionPlanner::GetTier(size_t num_keys) {
+  return Disk::Util::SuggestGeneration(num_keys);
+}
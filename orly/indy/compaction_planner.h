@@ -0,0 +1,104 @@
+/* <orly/indy/compaction_planner.h>
+
+   Chooses which disk layers of a repo to merge next.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <base/opt.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    /* The layers of a repo run oldest to newest, and a merge has to take a run of adjacent ones.  We tier them by key count (see
+       Disk::Util::SuggestGeneration()) and merge a run of at least MinWidth untaken layers of one tier, at most MaxWidth at a time,
+       lowest tier first.  Only merging layers of like size means a key is rewritten about once per tier rather than once per
+       merge.  An older layer in a lower tier than the newer one beside it is folded into it right away, since that's cheap.
+
+       A burst of writes can pile up layers faster than the tiers fill, and a read has to look at every one of them.  So once a repo
+       has more than MaxReadLayers disk layers, we merge regardless of tier, picking the run which writes the fewest keys per layer it
+       gets rid of. */
+    class TCompactionPlanner {
+      public:
+
+      /* What we need to know about one layer of a repo's mapping. */
+      struct TLayer {
+
+        /* The number of keys in the layer. */
+        size_t NumKeys;
+
+        /* True iff. it's a disk layer. */
+        bool IsDisk;
+
+        /* True iff. it's a disk layer which no merge has taken yet. */
+        bool IsAvailable;
+
+      };  // TLayer
+
+      /* A merge of the layers in [Begin, End). */
+      struct TPlan {
+        size_t Begin;
+        size_t End;
+      };  // TPlan
+
+      /* Defaults for the constructor. */
+      static constexpr size_t DefaultMinWidth = 4UL;
+      static constexpr size_t DefaultMaxWidth = 8UL;
+      static constexpr size_t DefaultMaxReadLayers = 12UL;
+
+      /* A merge must take at least 2 layers. */
+      TCompactionPlanner(size_t min_width = DefaultMinWidth,
+                         size_t max_width = DefaultMaxWidth,
+                         size_t max_read_layers = DefaultMaxReadLayers);
+
+      /* The merge to do next, if any. */
+      Base::TOpt<TPlan> Plan(const std::vector<TLayer> &layers) const;
+
+      /* The tier of a layer with the given number of keys. */
+      static size_t GetTier(size_t num_keys);
+
+      size_t GetMinWidth() const {
+        assert(this);
+        return MinWidth;
+      }
+
+      size_t GetMaxWidth() const {
+        assert(this);
+        return MaxWidth;
+      }
+
+      size_t GetMaxReadLayers() const {
+        assert(this);
+        return MaxReadLayers;
+      }
+
+      private:
+
+      /* See accessors. */
+      size_t MinWidth;
+      size_t MaxWidth;
+      size_t MaxReadLayers;
+
+    };  // TCompactionPlanner
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,104 @@
+/* <orly/indy/compaction_planner.test.cc>
+
+   Unit test for <orly/indy/compaction_planner.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/compaction_planner.h>
+
+#include <stdexcept>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy;
+
+using TLayer = TCompactionPlanner::TLayer;
+
+static TLayer Disk(size_t num_keys) {
+  return TLayer{num_keys, true, true};
+}
+
+static TLayer Taken(size_t num_keys) {
+  return TLayer{num_keys, true, false};
+}
+
+static TLayer Mem(size_t num_keys) {
+  return TLayer{num_keys, false, false};
+}
+
+FIXTURE(Typical) {
+  TCompactionPlanner planner(4, 6, 12);
+  /* nothing to do */
+  EXPECT_FALSE(planner.Plan({}));
+  EXPECT_FALSE(planner.Plan({Disk(100000), Disk(5000), Disk(5000), Disk(5000), Mem(10)}));
+  /* the fourth of a tier fills it */
+  auto plan = planner.Plan({Disk(100000), Disk(5000), Disk(5000), Disk(5000), Disk(5000), Mem(10)});
+  if (EXPECT_TRUE(plan)) {
+    EXPECT_EQ(plan->Begin, 1UL);
+    EXPECT_EQ(plan->End, 5UL);
+  }
+  /* no wider than the max */
+  plan = planner.Plan({Disk(10), Disk(10), Disk(10), Disk(10), Disk(10), Disk(10), Disk(10), Disk(10)});
+  if (EXPECT_TRUE(plan)) {
+    EXPECT_EQ(plan->Begin, 0UL);
+    EXPECT_EQ(plan->End, 6UL);
+  }
+  /* lowest tier first */
+  plan = planner.Plan({Disk(5000), Disk(5000), Disk(5000), Disk(5000), Disk(10), Disk(10), Disk(10), Disk(10)});
+  if (EXPECT_TRUE(plan)) {
+    EXPECT_EQ(plan->Begin, 4UL);
+    EXPECT_EQ(plan->End, 8UL);
+  }
+}
+
+FIXTURE(TakenLayersBreakRuns) {
+  TCompactionPlanner planner(4, 6, 12);
+  EXPECT_FALSE(planner.Plan({Disk(10), Disk(10), Taken(10), Disk(10), Disk(10)}));
+  auto plan = planner.Plan({Taken(10), Taken(10), Disk(10), Disk(10), Disk(10), Disk(10)});
+  if (EXPECT_TRUE(plan)) {
+    EXPECT_EQ(plan->Begin, 2UL);
+    EXPECT_EQ(plan->End, 6UL);
+  }
+}
+
+FIXTURE(SmallBeforeBig) {
+  TCompactionPlanner planner(4, 6, 12);
+  auto plan = planner.Plan({Disk(100000), Disk(10), Disk(5000), Mem(10)});
+  if (EXPECT_TRUE(plan)) {
+    EXPECT_EQ(plan->Begin, 1UL);
+    EXPECT_EQ(plan->End, 3UL);
+  }
+}
+
+FIXTURE(TooManyLayersToRead) {
+  TCompactionPlanner planner(2, 3, 4);
+  /* every layer in a tier of its own, biggest first, so nothing qualifies by tier */
+  vector<TLayer> layers{Disk(10000000), Disk(1000000), Disk(100000), Disk(10000), Disk(1000)};
+  auto plan = planner.Plan(layers);
+  if (EXPECT_TRUE(plan)) {
+    /* the cheapest run is the newest two */
+    EXPECT_EQ(plan->Begin, 3UL);
+    EXPECT_EQ(plan->End, 5UL);
+  }
+  layers.pop_back();
+  EXPECT_FALSE(planner.Plan(layers));
+}
+
+FIXTURE(BadWidths) {
+  EXPECT_THROW(invalid_argument, []() { TCompactionPlanner(1, 4, 12); });
+  EXPECT_THROW(invalid_argument, []() { TCompactionPlanner(4, 3, 12); });
+}
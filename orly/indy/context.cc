@@ -28,7 +28,7 @@ using namespace Orly::Indy;
 auto KeyCursorCollector = Fiber::MakeFiberLocal<TContext::TKeyCursorCollector>();
 
 TContext::TContext(const Indy::L0::TManager::TPtr<TRepo> &private_repo, Atom::TCore::TExtensibleArena *arena)
-    : TContextBase(arena), WalkerCount(0UL) {
+    : TContextBase(arena), WalkerCount(0UL), ReadSet(nullptr) {
   assert(KeyCursorCollector->KeyCursorCollection.IsEmpty());
   Indy::L0::TManager::TPtr<L0::TManager::TRepo> cur_repo = private_repo;
   RepoTree.push_back(make_pair(private_repo, make_unique<TRepo::TView>(private_repo)));
@@ -43,9 +43,28 @@ TContext::~TContext() {
 }
 
 Indy::TKey TContext::operator[](const Indy::TIndexKey &index_key) {
+  auto val = TryGet(index_key);
+  /* We return an empty var here because in the case of an optional type being returned, the result is "empty" not a throw.
+     A wrapper promotes empty -> throw if we need to end up as not an optional. */
+  return val ? *val : Indy::TKey(Atom::TCore(), nullptr);
+}
+
+bool TContext::Exists(const Indy::TIndexKey &key) {
+  if (ReadSet) {
+    ReadSet->KeyHashes.insert(key.GetHash());
+  }
+  ++WalkerCount;
+  TPresentWalker walker(this, RepoTree, key);
+  return static_cast<bool>(walker);
+}
+
+Base::TOpt<Indy::TKey> TContext::TryGet(const Indy::TIndexKey &index_key) {
   /* check to see if any of our current key cursors are on this key.
      We're doing this as a quick fix to the fact that we've lost which cursor (if any) this key
      originated from in the code gen. (loss of information). */
+  if (ReadSet) {
+    ReadSet->KeyHashes.insert(index_key.GetHash());
+  }
   const auto &key = index_key.GetKey();
   for (TKeyCursorCollection::TCursor csr(&KeyCursorCollector->KeyCursorCollection); csr; ++csr) {
     const Indy::TPresentWalker::TItem &cur_item = csr->GetVal();
@@ -63,15 +82,7 @@ Indy::TKey TContext::operator[](const Indy::TIndexKey &index_key) {
     const Indy::TPresentWalker::TItem &item = *walker;
     return Indy::TKey(Atom::TCore(GetArena(), alloca(Sabot::State::GetMaxStateSize()), item.OpArena, item.Op), GetArena());
   }
-  /* We return an empty var here because in the case of an optional type being returned, the result is "empty" not a throw.
-     A wrapper promotes empty -> throw if we need to end up as not an optional. */
-  return Indy::TKey(Atom::TCore(), nullptr);
-}
-
-bool TContext::Exists(const Indy::TIndexKey &key) {
-  ++WalkerCount;
-  TPresentWalker walker(this, RepoTree, key);
-  return static_cast<bool>(walker);
+  return Base::TOpt<Indy::TKey>::GetUnknown();
 }
 
 TContext::TPresentWalker::TPresentWalker(TContext *ctx, const TRepoTree &repo_tree, const TIndexKey &key)
@@ -153,6 +164,9 @@ TContext::TKeyCursor::TKeyCursor(TContext *context, const Indy::TIndexKey &patte
       Cached(false),
       Csr(context, context->RepoTree, Key),
       ContextMembership(this) {
+  if (context->ReadSet) {
+    context->ReadSet->IndexIds.insert(pattern.GetIndexId());
+  }
   ++(context->WalkerCount);
 }
 
@@ -164,6 +178,10 @@ TContext::TKeyCursor::TKeyCursor(TContext *context, const Indy::TIndexKey &from,
       Cached(false),
       Csr(context, context->RepoTree, Key, To),
       ContextMembership(this) {
+  if (context->ReadSet) {
+    context->ReadSet->IndexIds.insert(from.GetIndexId());
+    context->ReadSet->IndexIds.insert(to.GetIndexId());
+  }
   ++(context->WalkerCount);
 }
 
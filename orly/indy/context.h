@@ -23,6 +23,7 @@
 #include <base/chrono.h>
 #include <base/class_traits.h>
 #include <base/no_throw.h>
+#include <base/opt.h>
 #include <base/uuid.h>
 #include <orly/atom/suprena.h>
 #include <orly/context_base.h>
@@ -164,6 +165,30 @@ namespace Orly {
 
       };  // TKeyCursor
 
+      /* What a context has read, if asked to keep track.  A point read is kept as the hash of its key, and a cursor taints its whole
+         index, so we may claim to have read more than we did, but never less. */
+      class TReadSet {
+        public:
+
+        /* True iff. we may have read the given key. */
+        bool MayHaveRead(const Indy::TIndexKey &key) const {
+          assert(this);
+          return IndexIds.find(key.GetIndexId()) != IndexIds.end() || KeyHashes.find(key.GetHash()) != KeyHashes.end();
+        }
+
+        private:
+
+        /* The hashes of the keys read directly. */
+        std::unordered_set<size_t> KeyHashes;
+
+        /* The indices we've walked with a cursor. */
+        std::unordered_set<Base::TUuid> IndexIds;
+
+        /* For adding to our sets. */
+        friend class TContext;
+
+      };  // TReadSet
+
       /* TODO */
       TContext(const Indy::L0::TManager::TPtr<TRepo> &private_repo, Atom::TCore::TExtensibleArena *arena);
 
@@ -176,6 +201,16 @@ namespace Orly {
       /* TODO */
       virtual bool Exists(const Indy::TIndexKey &key) override;
 
+      /* The value at the given key, or unknown if the key isn't there.  Use this rather than Exists() followed by operator[], which
+         walks the repo tree twice to do the same thing. */
+      Base::TOpt<Indy::TKey> TryGet(const Indy::TIndexKey &key);
+
+      /* Note what we read from here on in the given set.  Pass null to stop.  The set must outlive us or the next call. */
+      void SetReadSet(TReadSet *read_set) {
+        assert(this);
+        ReadSet = read_set;
+      }
+
       /* TODO */
       inline size_t GetWalkerCount() const {
         assert(this);
@@ -208,6 +243,9 @@ namespace Orly {
       /* TODO */
       size_t WalkerCount;
 
+      /* See SetReadSet().  Usually null. */
+      TReadSet *ReadSet;
+
       /* TODO */
       Base::TTimer PresentWalkConsTimer;
 
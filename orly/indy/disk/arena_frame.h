@@ -0,0 +1,375 @@
+/* <orly/indy/disk/arena_frame.h>
+
+   Compressed arenas.
+
+   The notes of an arena are written as one long run of bytes, and cores refer to them by their offset into that run.  When an arena
+   is compressed, the run is cut into frames of about ArenaFrameSize bytes and each frame is compressed on its own.  The frames are
+   laid end to end in the file, followed by a frame index which maps note offsets to frames.  Readers find the frame holding a note,
+   inflate it (or find it already inflated in the ArenaFrameCache), and point into it.
+
+   A frame which doesn't get any smaller for being compressed is stored as-is; the frame index tells the two apart by size.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <syslog.h>
+
+#include <snappy.h>
+
+#include <base/class_traits.h>
+#include <orly/indy/disk/util/frame_cache.h>
+#include <orly/indy/disk/util/volume_manager.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      /* How the arenas of a data file are stored.  Recorded in the file's metadata. */
+      enum class TArenaCodec : size_t {
+        None = 0UL,
+        Snappy = 1UL
+      };
+
+      /* The codec of the given name, as accepted on the command line. */
+      inline const char *GetArenaCodecName(TArenaCodec codec) {
+        switch (codec) {
+          case TArenaCodec::None: {
+            return "none";
+          }
+          case TArenaCodec::Snappy: {
+            return "snappy";
+          }
+        }
+        throw std::logic_error("unhandled arena codec");
+      }
+
+      /* The codec with the given name.  Throws if there isn't one. */
+      inline TArenaCodec ParseArenaCodec(const std::string &name) {
+        for (TArenaCodec codec : {TArenaCodec::None, TArenaCodec::Snappy}) {
+          if (name == GetArenaCodecName(codec)) {
+            return codec;
+          }
+        }
+        syslog(LOG_ERR, "unknown arena codec [%s]", name.c_str());
+        throw std::invalid_argument("unknown arena codec");
+      }
+
+      /* The number of note bytes we collect before compressing them as a frame. */
+      static constexpr size_t ArenaFrameSize = Util::LogicalBlockSize;
+
+      /* The decompressed frames of every compressed arena share this cache. */
+      extern Util::TFrameCache ArenaFrameCache;
+
+      /* Where each frame of a compressed arena starts, both among the notes and in the file. */
+      class TArenaFrameIndex {
+        NO_COPY(TArenaFrameIndex);
+        public:
+
+        /* An index with no frames yet. */
+        explicit TArenaFrameIndex(TArenaCodec codec);
+
+        /* Drops our frames from the ArenaFrameCache. */
+        ~TArenaFrameIndex();
+
+        /* Add a frame of the given number of note bytes, which took up the given number of bytes in the file. */
+        void Append(size_t num_note_bytes, size_t num_stored_bytes) {
+          assert(this);
+          Entries.emplace_back(Entries.back().first + num_note_bytes, Entries.back().second + num_stored_bytes);
+        }
+
+        /* The frame holding the note byte at the given offset. */
+        size_t Find(size_t offset) const {
+          assert(this);
+          assert(offset < GetNumNoteBytes());
+          auto pos = std::upper_bound(Entries.begin(), Entries.end(), offset, [](size_t lhs, const std::pair<size_t, size_t> &rhs) {
+            return lhs < rhs.first;
+          });
+          assert(pos != Entries.begin());
+          return (pos - Entries.begin()) - 1UL;
+        }
+
+        /* The offset among the notes at which the given frame starts. */
+        size_t GetNoteOffset(size_t frame_idx) const {
+          assert(this);
+          assert(frame_idx < GetNumFrames());
+          return Entries[frame_idx].first;
+        }
+
+        /* The number of note bytes in the given frame. */
+        size_t GetNumNoteBytes(size_t frame_idx) const {
+          assert(this);
+          assert(frame_idx < GetNumFrames());
+          return Entries[frame_idx + 1UL].first - Entries[frame_idx].first;
+        }
+
+        /* The offset, relative to the start of the arena, at which the given frame is stored. */
+        size_t GetStoredOffset(size_t frame_idx) const {
+          assert(this);
+          assert(frame_idx < GetNumFrames());
+          return Entries[frame_idx].second;
+        }
+
+        /* The number of bytes the given frame takes up in the file. */
+        size_t GetNumStoredBytes(size_t frame_idx) const {
+          assert(this);
+          assert(frame_idx < GetNumFrames());
+          return Entries[frame_idx + 1UL].second - Entries[frame_idx].second;
+        }
+
+        /* The number of frames. */
+        size_t GetNumFrames() const {
+          assert(this);
+          return Entries.size() - 1UL;
+        }
+
+        /* The number of note bytes across all frames. */
+        size_t GetNumNoteBytes() const {
+          assert(this);
+          return Entries.back().first;
+        }
+
+        /* The number of bytes all frames take up in the file, not counting this index. */
+        size_t GetNumStoredBytes() const {
+          assert(this);
+          return Entries.back().second;
+        }
+
+        /* The number of bytes this index takes up in the file. */
+        size_t GetNumBytesOfIndex() const {
+          assert(this);
+          return GetNumBytesOfIndex(Entries.size());
+        }
+
+        /* The codec the frames were written with. */
+        TArenaCodec GetCodec() const {
+          assert(this);
+          return Codec;
+        }
+
+        /* The decompressed frame, with a reference held for the caller.  If the frame isn't cached, we read it from the given stream,
+           in which the arena starts at the given offset. */
+        template <typename TInStream>
+        Util::TFrameCache::TFrame *AcquireFrame(size_t frame_idx, TInStream &in_stream, size_t arena_offset) const;
+
+        /* Write this index out. */
+        template <typename TOutStream>
+        void Write(TOutStream &out_stream) const;
+
+        /* Read an index from the current position of the given stream. */
+        template <typename TInStream>
+        static std::unique_ptr<TArenaFrameIndex> Read(TInStream &in_stream, TArenaCodec codec);
+
+        /* An upper bound on the bytes an arena of the given number of note bytes will take up in the file, frame index and all.
+           The writer may be flushed early the given number of times. */
+        static size_t GetMaxNumStoredBytes(size_t num_note_bytes, size_t num_flushes) {
+          return num_note_bytes + GetNumBytesOfIndex((num_note_bytes / ArenaFrameSize) + num_flushes + 2UL);
+        }
+
+        private:
+
+        /* The number of bytes an index of the given number of entries takes up in the file. */
+        static size_t GetNumBytesOfIndex(size_t num_entries) {
+          return sizeof(size_t) + (num_entries * sizeof(size_t) * 2UL);
+        }
+
+        /* See accessor. */
+        TArenaCodec Codec;
+
+        /* The (note offset, stored offset) at which each frame starts, plus one more entry marking the end of the last frame. */
+        std::vector<std::pair<size_t, size_t>> Entries;
+
+      };  // TArenaFrameIndex
+
+      /* Writes arena notes to a stream, compressing them into frames if asked to. */
+      template <typename TOutStream>
+      class TArenaOutStream {
+        NO_COPY(TArenaOutStream);
+        public:
+
+        /* Notes go to the given stream, starting at its current offset. */
+        TArenaOutStream(TOutStream &out_stream, TArenaCodec codec)
+            : OutStream(out_stream),
+              ArenaOffset(out_stream.GetOffset()),
+              NumBytes(0UL) {
+          if (codec != TArenaCodec::None) {
+            Frames.reset(new TArenaFrameIndex(codec));
+            Buf.reserve(ArenaFrameSize * 2UL);
+          }
+        }
+
+        /* Append note bytes. */
+        void Write(const void *data, size_t size) {
+          assert(this);
+          NumBytes += size;
+          if (!Frames) {
+            OutStream.Write(data, size);
+            return;
+          }
+          Buf.insert(Buf.end(), reinterpret_cast<const char *>(data), reinterpret_cast<const char *>(data) + size);
+          if (Buf.size() >= ArenaFrameSize) {
+            Flush();
+          }
+        }
+
+        /* Close off the frame in progress, so that everything written so far can be read back through GetFrameIndex(). */
+        void Flush();
+
+        /* Flush, then write out the frame index.  Returns the byte offset of the index, or 0 if the arena isn't compressed. */
+        size_t Finish();
+
+        /* The number of note bytes written so far. */
+        size_t GetNumBytes() const {
+          assert(this);
+          return NumBytes;
+        }
+
+        /* The frames written so far, or null if the arena isn't compressed. */
+        const TArenaFrameIndex *GetFrameIndex() const {
+          assert(this);
+          return Frames.get();
+        }
+
+        /* Hand off the frame index, once we're finished. */
+        std::unique_ptr<TArenaFrameIndex> ReleaseFrameIndex() {
+          assert(this);
+          assert(Buf.empty());
+          return std::move(Frames);
+        }
+
+        private:
+
+        /* See constructor. */
+        TOutStream &OutStream;
+
+        /* The byte offset at which the arena starts. */
+        const size_t ArenaOffset;
+
+        /* See accessor. */
+        size_t NumBytes;
+
+        /* The frames written so far.  Null if we're not compressing. */
+        std::unique_ptr<TArenaFrameIndex> Frames;
+
+        /* The notes of the frame in progress, and scratch space for compressing them. */
+        std::vector<char> Buf, CompressedBuf;
+
+      };  // TArenaOutStream
+
+      /*** Inline ***/
+
+      template <typename TInStream>
+      Util::TFrameCache::TFrame *TArenaFrameIndex::AcquireFrame(size_t frame_idx, TInStream &in_stream, size_t arena_offset) const {
+        assert(this);
+        Util::TFrameCache::TFrame *frame = ArenaFrameCache.TryAcquire(this, frame_idx);
+        if (frame) {
+          return frame;
+        }
+        const size_t num_note_bytes = GetNumNoteBytes(frame_idx);
+        const size_t num_stored_bytes = GetNumStoredBytes(frame_idx);
+        frame = new Util::TFrameCache::TFrame(num_note_bytes);
+        try {
+          in_stream.GoTo(arena_offset + GetStoredOffset(frame_idx));
+          if (num_stored_bytes == num_note_bytes) {  // stored as-is
+            in_stream.Read(frame->GetData(), num_note_bytes);
+          } else {
+            std::unique_ptr<char[]> compressed(new char[num_stored_bytes]);
+            in_stream.Read(compressed.get(), num_stored_bytes);
+            size_t uncompressed_length;
+            if (!snappy::GetUncompressedLength(compressed.get(), num_stored_bytes, &uncompressed_length) ||
+                uncompressed_length != num_note_bytes ||
+                !snappy::RawUncompress(compressed.get(), num_stored_bytes, frame->GetData())) {
+              syslog(LOG_ERR, "corrupt arena frame [%ld] at [%ld]", frame_idx, arena_offset + GetStoredOffset(frame_idx));
+              throw std::runtime_error("corrupt arena frame");
+            }
+          }
+        } catch (...) {
+          frame->Release();
+          throw;
+        }
+        return ArenaFrameCache.Insert(this, frame_idx, frame);
+      }
+
+      template <typename TOutStream>
+      void TArenaFrameIndex::Write(TOutStream &out_stream) const {
+        assert(this);
+        out_stream << Entries.size();
+        for (const auto &entry : Entries) {
+          out_stream << entry.first << entry.second;
+        }
+      }
+
+      template <typename TInStream>
+      std::unique_ptr<TArenaFrameIndex> TArenaFrameIndex::Read(TInStream &in_stream, TArenaCodec codec) {
+        std::unique_ptr<TArenaFrameIndex> frames(new TArenaFrameIndex(codec));
+        size_t num_entries;
+        in_stream.Read(num_entries);
+        assert(num_entries);
+        frames->Entries.resize(num_entries);
+        for (auto &entry : frames->Entries) {
+          in_stream.Read(entry.first);
+          in_stream.Read(entry.second);
+        }
+        return frames;
+      }
+
+      template <typename TOutStream>
+      void TArenaOutStream<TOutStream>::Flush() {
+        assert(this);
+        if (!Frames || Buf.empty()) {
+          return;
+        }
+        CompressedBuf.resize(snappy::MaxCompressedLength(Buf.size()));
+        size_t compressed_length;
+        snappy::RawCompress(Buf.data(), Buf.size(), CompressedBuf.data(), &compressed_length);
+        if (compressed_length < Buf.size()) {
+          OutStream.Write(CompressedBuf.data(), compressed_length);
+          Frames->Append(Buf.size(), compressed_length);
+        } else {
+          OutStream.Write(Buf.data(), Buf.size());
+          Frames->Append(Buf.size(), Buf.size());
+        }
+        Buf.clear();
+        assert(OutStream.GetOffset() == ArenaOffset + Frames->GetNumStoredBytes());
+      }
+
+      template <typename TOutStream>
+      size_t TArenaOutStream<TOutStream>::Finish() {
+        assert(this);
+        if (!Frames) {
+          return 0UL;
+        }
+        Flush();
+        const size_t index_offset = OutStream.GetOffset();
+        Frames->Write(OutStream);
+        return index_offset;
+      }
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
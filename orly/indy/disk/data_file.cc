@@ -21,6 +21,7 @@
 #include <orly/indy/disk/in_file.h>
 #include <orly/indy/disk/indy_util_reporter.h>
 #include <orly/indy/disk/read_file.h>
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/hash_util.h>
 
 using namespace std;
@@ -172,7 +173,10 @@ class TIndexFile
         #ifndef NDEBUG
         WrittenBlockSet(written_block_set),
         #endif
-        UpdateCollector(nullptr) {
+        ByteOffsetOfKeyFilter(0UL),
+        NumKeyFilterWords(0UL),
+        ByteOffsetOfArenaFrameIndex(0UL),
+        KeyOffsetByEntry(nullptr) {
     KeyRemapper = std::bind(&TIndexFile::RemapKey, this, std::placeholders::_1);
     ValRemapper = std::bind(&TIndexFile::RemapVal, this, std::placeholders::_1);
     NumHashTables = *(ExampleKey.GetCore().TryGetElemCount());
@@ -203,6 +207,9 @@ class TIndexFile
       meta_stream << NumHistKeys;  // # History Keys
       meta_stream << ByteOffsetOfKeyIndex;  // Current Key Offset
       meta_stream << NumHashTables;  // # of hash indexes (n)
+      meta_stream << ByteOffsetOfKeyFilter;  // Key Filter Offset
+      meta_stream << NumKeyFilterWords;  // # of key filter words
+      meta_stream << ByteOffsetOfArenaFrameIndex;  // Arena Frame Index Offset
 
       #if 0
       stringstream ss;
@@ -245,9 +252,9 @@ class TIndexFile
     KeyTrigger.Wait();
   }
 
-  void ConstructArena(TDataFile::TBlockVec &block_vec);
+  void ConstructArena(TDataFile::TBlockVec &block_vec, TArenaCodec arena_codec);
 
-  void PrepKeyRange(TDataFile::TUpdateCollector *update_collector, TDataFile::TBlockVec *block_vec);
+  void PrepKeyRange(TDataFile::TKeyOffsetByEntry *key_offset_by_entry, TDataFile::TBlockVec *block_vec);
 
   void PushKey(TUpdate::TEntry *entry);
   Base::TOpt<Indy::TKey> PrevKeyWritten;
@@ -321,7 +328,13 @@ class TIndexFile
 
   std::vector<std::pair<size_t, size_t>> NumHashFieldsByOffset;
 
-  TDataFile::TUpdateCollector *UpdateCollector;
+  size_t ByteOffsetOfKeyFilter;
+
+  size_t NumKeyFilterWords;
+
+  size_t ByteOffsetOfArenaFrameIndex;
+
+  TDataFile::TKeyOffsetByEntry *KeyOffsetByEntry;
 
   /*
      Offset of Arena
@@ -332,6 +345,9 @@ class TIndexFile
      # History Keys
      Current Key Offset
      # of hash indexes (n)
+     Key Filter Offset
+     # of key filter words
+     Arena Frame Index Offset
 
      (n) (size_t) -> (size_t) hash index offset -> num hash fields pairings
   */
@@ -370,6 +386,7 @@ class TIndexFile
 size_t MakeArena(Disk::Util::TEngine *engine,
                  Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed,
                  DiskPriority priority,
+                 TArenaCodec codec,
                  TIndexFile::TOrderedNoteIndex &note_index,
                  TDataFile::TRemapIndex &remap_index,
                  TDataFile::TBlockVec &block_vec,
@@ -379,7 +396,8 @@ size_t MakeArena(Disk::Util::TEngine *engine,
                  TDataFile::TTypeBoundaryOffsetVec &type_boundary_vec,
                  size_t max_total_note_bytes,
                  size_t &num_note_out,
-                 size_t &num_bytes_out);
+                 size_t &num_bytes_out,
+                 size_t &frame_index_offset_out);
 
 void TIndexFile::EmplaceOrderedNotes(TOrderedNoteIndex &note_index, TSuprena *arena, size_t &total_bytes, TCore::TOffset offset) {
   const TCore::TNote *const note = reinterpret_cast<const TCore::TNote *>(offset);
@@ -389,19 +407,19 @@ void TIndexFile::EmplaceOrderedNotes(TOrderedNoteIndex &note_index, TSuprena *ar
   note->ForOffset(std::bind(EmplaceOrderedNotes, ref(note_index), arena, ref(total_bytes), std::placeholders::_1));
 }
 
-void TIndexFile::PrepKeyRange(TDataFile::TUpdateCollector *update_collector, TDataFile::TBlockVec *block_vec) {
+void TIndexFile::PrepKeyRange(TDataFile::TKeyOffsetByEntry *key_offset_by_entry, TDataFile::TBlockVec *block_vec) {
   assert(this);
   assert(MaxKeyCount);
-  assert(!UpdateCollector);
+  assert(!KeyOffsetByEntry);
   BlockVec = block_vec;
-  UpdateCollector = update_collector;
+  KeyOffsetByEntry = key_offset_by_entry;
   ByteOffsetOfHistory = 0UL;
   NumHistoryElem = 0UL;
   const size_t num_tuple_fields = *ExampleKey.GetCore().TryGetElemCount();
   for (size_t i = 0; i < num_tuple_fields; ++i) {
     HashCollectorVec.emplace_back(new THashCollector(HERE, Source::DataFileHashIndex, TempFileConsolThresh, StorageSpeed, Engine, true));
   }
-  const size_t bytes_of_metadata = (TData::NumMetaFields * sizeof(size_t)) + (NumHashTables * sizeof(size_t) * 2UL) + (ArenaTypeBoundaryOffsetVec.size() * sizeof(size_t));
+  const size_t bytes_of_metadata = (NumMetaFields * sizeof(size_t)) + (NumHashTables * sizeof(size_t) * 2UL) + (ArenaTypeBoundaryOffsetVec.size() * sizeof(size_t));
   if (bytes_of_metadata >= Disk::Util::LogicalBlockSize) {
     throw std::runtime_error("Index metadata >= 1 block");
   }
@@ -448,10 +466,11 @@ Atom::TCore::TOffset TIndexFile::RemapVal(Atom::TCore::TOffset offset) {
   return pos->NewKey;
 }
 
-void TIndexFile::ConstructArena(TDataFile::TBlockVec &block_vec) {
+void TIndexFile::ConstructArena(TDataFile::TBlockVec &block_vec, TArenaCodec arena_codec) {
   ArenaByteOffset = MakeArena(Engine,
                               StorageSpeed,
                               Priority,
+                              arena_codec,
                               *ArenaNoteIndex,
                               ArenaRemapIndex,
                               block_vec,
@@ -461,12 +480,13 @@ void TIndexFile::ConstructArena(TDataFile::TBlockVec &block_vec) {
                               ArenaTypeBoundaryOffsetVec,
                               MaxArenaBytes,
                               NumArenaNotes,
-                              NumArenaBytes);
+                              NumArenaBytes,
+                              ByteOffsetOfArenaFrameIndex);
 }
 
 void TIndexFile::PushKey(TUpdate::TEntry *entry) {
   assert(this);
-  assert(UpdateCollector);
+  assert(KeyOffsetByEntry);
   const TKey &key = entry->GetKey();
   #ifndef NDEBUG
   void *lhs_type_alloc = alloca(Sabot::Type::GetMaxTypeSize() * 2);
@@ -546,12 +566,11 @@ void TIndexFile::PushKey(TUpdate::TEntry *entry) {
       }
 
     } while (prefix_core.TryTruncateTuple());
-    UpdateCollector->Emplace(seq_num, entry->GetMetadata(), entry->GetId(), CurKeyOffset, true, IndexId);
+    KeyOffsetByEntry->emplace(entry, CurKeyOffset);
 
   } else {  // History Key
     ++NumHistKeys;
     HistKeys.push_back(entry);
-    UpdateCollector->Emplace(entry->GetSequenceNumber(), entry->GetMetadata(), entry->GetId(), ByteOffsetOfHistory + NumHistoryElem * TDataFile::KeyHistorySize, false, IndexId);
     ++NumHistoryElem;
   }
 }
@@ -564,6 +583,7 @@ void TIndexFile::FlushHistory() {
   }
   ByteOffsetOfHistory = stream.GetOffset();
   for (const TUpdate::TEntry *entry : HistKeys) {
+    KeyOffsetByEntry->emplace(entry, stream.GetOffset());
     const TSequenceNumber seq_num = entry->GetSequenceNumber();
     const TKey &key = entry->GetKey();
     const TCore &val = entry->GetOp();
@@ -584,7 +604,9 @@ void TIndexFile::FlushHashes() {
   size_t total_bytes_required = 0UL;
   unordered_map<size_t, shared_ptr<const TBufBlock>> collision_map {};
   size_t hash_index_byte_offset = BlockVec->Size() * Disk::Util::LogicalBlockSize;
+  size_t num_filter_keys = 0UL;
   for (const auto &collection : HashCollectorVec) {
+    num_filter_keys += collection->GetSize();
     /* collision at beginning of this hash index */
     auto ret = collision_map.insert(make_pair((hash_index_byte_offset + total_bytes_required) / Disk::Util::LogicalBlockSize, nullptr));
     if (ret.second) { // fresh insert
@@ -602,6 +624,18 @@ void TIndexFile::FlushHashes() {
     }
   }
   assert(NumHashFieldsByOffset.size() == NumHashTables);
+  /* the key filter follows the last hash index. It holds the hashes of every key prefix we index, so that readers can skip the hash
+     probe for keys we don't have. */
+  Disk::Util::TBloomFilter key_filter(num_filter_keys);
+  ByteOffsetOfKeyFilter = hash_index_byte_offset + total_bytes_required;
+  NumKeyFilterWords = key_filter.GetWords().size();
+  total_bytes_required += key_filter.GetNumBytes();
+  if ((hash_index_byte_offset + total_bytes_required) % Disk::Util::LogicalBlockSize != 0) {
+    auto ret = collision_map.insert(make_pair((hash_index_byte_offset + total_bytes_required) / Disk::Util::LogicalBlockSize, nullptr));
+    if (ret.second) { // fresh insert
+      ret.first->second = std::shared_ptr<const TBufBlock>(new TBufBlock());
+    }
+  }
   size_t max_blocks_required = ceil(static_cast<double>(total_bytes_required) / Disk::Util::LogicalBlockSize);
 
   Engine->AppendReserveBlocks(StorageSpeed, max_blocks_required, *BlockVec);
@@ -613,6 +647,7 @@ void TIndexFile::FlushHashes() {
     for (THashCollector::TCursor orig_csr(collection.get(), 32UL); orig_csr; ++orig_csr) {
       const THashObj &obj = *orig_csr;
       modded_hash_collector.Emplace(obj.Core, obj.Hash % num_hash_fields, obj.Offset);
+      key_filter.Insert(obj.Hash);
     }
     THashCollector::TCursor hash_csr(&modded_hash_collector, 32UL);
     /* do the first pass over the hash map */ {
@@ -732,6 +767,26 @@ void TIndexFile::FlushHashes() {
     }
     hash_index_byte_offset += num_hash_fields * TDataFile::HashEntrySize;
   }
+  /* write the key filter */ {
+    assert(hash_index_byte_offset == ByteOffsetOfKeyFilter);
+    if (!key_filter.IsEmpty()) {
+      TDataFile::TDataOutStream stream(HERE,
+                                       Source::DataFileKeyFilter,
+                                       Engine->GetVolMan(),
+                                       ByteOffsetOfKeyFilter,
+                                       *BlockVec,
+                                       collision_map,
+                                       completion_trigger,
+                                       Priority,
+                                       true
+                                       #ifndef NDEBUG
+                                       ,WrittenBlockSet
+                                       #endif
+                                       );
+      stream.Write(key_filter.GetWords().data(), key_filter.GetNumBytes());
+      FileSize = stream.GetOffset();
+    }
+  }
   /* flush collision blocks */ {
     for (auto iter : collision_map) {
       assert(iter.first < BlockVec->Size());
@@ -759,21 +814,25 @@ TDataFile::TDataFile(Util::TEngine *engine,
                      size_t gen_id,
                      size_t temp_file_consol_thresh,
                      TSequenceNumber /*release_up_to*/,
-                     DiskPriority priority)
+                     DiskPriority priority,
+                     TArenaCodec arena_codec)
     : Engine(engine),
       StorageSpeed(storage_speed),
       Priority(priority),
       NumUpdates(0UL),
+      ArenaCodec(arena_codec),
       MainArenaByteOffset(0UL),
+      MainArenaFrameIndexOffset(0UL),
       NumKeys(0UL),
       TempFileConsolThresh(temp_file_consol_thresh),
-      UpdateCollector(HERE, Source::DataFileUpdateIndex, TempFileConsolThresh, StorageSpeed, Engine, true) {
+      FileLength(0UL) {
   assert(this);
   try {
     auto main_arena_note_index = make_unique<TIndexFile::TOrderedNoteIndex>(
         HERE, Source::DataFileNoteIndex, TempFileConsolThresh, StorageSpeed, Engine, true);
     std::unordered_map<Base::TUuid, std::unique_ptr<TIndexFile> > index_map;
     size_t main_arena_max_bytes = 0UL;
+    size_t num_entries = 0UL;
     /* compute the number of updates */ {
       for (TMemoryLayer::TUpdateCollection::TCursor csr(memory_layer->GetUpdateCollection()); csr; ++csr) {
         ++NumUpdates;
@@ -839,6 +898,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
           }
         }
         ++max_key_count;
+        ++num_entries;
         prev_entry = &*csr;
       }
       if (prev_index_id) {
@@ -862,10 +922,11 @@ TDataFile::TDataFile(Util::TEngine *engine,
         index_file.MaxKeyCount = max_key_count;
       }
     }  // done generating the arena index
+    KeyOffsetByEntry.reserve(num_entries);
     for (const auto &iter : index_map) {
       TIndexFile &index_file = *iter.second;
       if (index_file.MaxArenaBytes) {
-        index_file.ConstructArena(BlockVec);
+        index_file.ConstructArena(BlockVec, ArenaCodec);
       }
     }
     /* write out the main arena */
@@ -875,6 +936,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
       MainArenaByteOffset = MakeArena(Engine,
                                       StorageSpeed,
                                       Priority,
+                                      ArenaCodec,
                                       *main_arena_note_index,
                                       MainArenaRemapIndex,
                                       BlockVec,
@@ -884,7 +946,8 @@ TDataFile::TDataFile(Util::TEngine *engine,
                                       MainArenaTypeBoundaryOffsetVec,
                                       main_arena_max_bytes,
                                       num_main_arena_notes,
-                                      num_main_arena_bytes);
+                                      num_main_arena_bytes,
+                                      MainArenaFrameIndexOffset);
     }
     /* write the in-order key indexes */ {
       Base::TOpt<Base::TUuid> prev_index_id;
@@ -912,7 +975,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
           auto ret = index_map.find(cur_idx_id);
           assert(ret != index_map.end());
           cur_index_file = ret->second.get();
-          cur_index_file->PrepKeyRange(&UpdateCollector, &BlockVec);
+          cur_index_file->PrepKeyRange(&KeyOffsetByEntry, &BlockVec);
           prev_index_id = cur_idx_id;
         }
         cur_index_file->CurArena = &csr->GetSuprena();
@@ -942,7 +1005,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
     }
 
     TCompletionTrigger completion_trigger;
-    const size_t num_bytes_required_for_update_idx = (NumUpdates * UpdateBucketEntrySize) + (UpdateCollector.GetSize() * UpdateKeyPtrSize);
+    const size_t num_bytes_required_for_update_idx = (NumUpdates * UpdateBucketEntrySize) + (KeyOffsetByEntry.size() * UpdateKeyPtrSize);
     const size_t byte_offset_of_update_entries = BlockVec.Size() * Disk::Util::LogicalBlockSize;
     const size_t byte_offset_of_bucket_entries = byte_offset_of_update_entries + (NumUpdates * UpdateBucketEntrySize);
     /* write out the update index */ {
@@ -980,44 +1043,31 @@ TDataFile::TDataFile(Util::TEngine *engine,
                                   ,WrittenBlockSet
                                   #endif
                                   );
-        TUpdateCollector::TCursor update_csr(&UpdateCollector, 32UL);
+        /* the memory layer keeps its updates in sequence order, so we can write each bucket as we come to it */
+        TMemoryLayer::TUpdateCollection::TCursor update_csr(memory_layer->GetUpdateCollection());
         assert(update_csr);
-        TSequenceNumber cur_seq_num = (*update_csr).SequenceNumber;
-        TCore cur_meta, cur_id;
         size_t bucket_ptr = byte_offset_of_bucket_entries;
-        size_t num_accum = 0U;
-        LowestSeq = (*update_csr).SequenceNumber;
-        while (update_csr) {
-          const TUpdateObj &obj = *update_csr;
-          if (obj.SequenceNumber != cur_seq_num) {
-            seq_stream << cur_seq_num;  // Sequence Number
-            seq_stream.Write(&cur_meta, sizeof(cur_meta));  // Metadata
-            seq_stream.Write(&cur_id, sizeof(cur_id));  // Id
-            seq_stream << bucket_ptr;  // Byte offset of bucket
-            seq_stream << num_accum;  // number of key ptrs in bucket
-
-
-            cur_seq_num = obj.SequenceNumber;
-            cur_meta = obj.Metadata;
-            cur_id = obj.Id;
-            bucket_ptr += num_accum * TData::UpdateKeyPtrSize;
-            num_accum = 0U;
-          }
-          if (obj.IsCurrent) {  /* current key, NO need to re-adjust offset */
-            ptr_stream << obj.Offset;  // key_ptr
-          } else {  /* history key, need to re-adjust offset */
-            ptr_stream << static_cast<size_t>(index_map[obj.IndexId]->ByteOffsetOfHistory + obj.Offset);
+        LowestSeq = update_csr->GetSequenceNumber();
+        for (; update_csr; ++update_csr) {
+          const TSequenceNumber seq_num = update_csr->GetSequenceNumber();
+          const TCore &meta = update_csr->GetMetadata();
+          const TCore &id = update_csr->GetId();
+          size_t num_key_ptrs = 0UL;
+          for (TUpdate::TEntryCollection::TCursor entry_csr(update_csr->GetEntryCollection()); entry_csr; ++entry_csr) {
+            auto pos = KeyOffsetByEntry.find(&*entry_csr);
+            assert(pos != KeyOffsetByEntry.end());
+            ptr_stream << pos->second;  // key_ptr
+            ++num_key_ptrs;
           }
-          ++num_accum;
-          ++update_csr;
+          seq_stream << seq_num;  // Sequence Number
+          seq_stream.Write(&meta, sizeof(meta));  // Metadata
+          seq_stream.Write(&id, sizeof(id));  // Id
+          seq_stream << bucket_ptr;  // Byte offset of bucket
+          seq_stream << num_key_ptrs;  // number of key ptrs in bucket
+          bucket_ptr += num_key_ptrs * TData::UpdateKeyPtrSize;
+          HighestSeq = seq_num;
         }
-        HighestSeq = cur_seq_num;
         assert(HighestSeq >= LowestSeq);
-        seq_stream << cur_seq_num;  // Sequence Number
-        seq_stream.Write(&cur_meta, sizeof(cur_meta));  // Metadata
-        seq_stream.Write(&cur_id, sizeof(cur_id));  // Id
-        seq_stream << bucket_ptr;  // Byte offset of bucket
-        seq_stream << num_accum;  // number of key ptrs in bucket
       }
       /* flush collision blocks */ {
         for (auto iter : collision_map) {
@@ -1051,6 +1101,8 @@ TDataFile::TDataFile(Util::TEngine *engine,
         # of arena bytes
         offset of main arena
         offset of update index
+        arena codec
+        offset of main arena frame index
 
         n (size_t) metablock block_id(s)
         m (size_t) -> (size_t) #block -> starting_block_id pairings
@@ -1103,6 +1155,8 @@ TDataFile::TDataFile(Util::TEngine *engine,
       stream << MainArenaTypeBoundaryOffsetVec.size();  // # of arena type boundaries
       stream << MainArenaByteOffset;  // byte offset of main arena
       stream << byte_offset_of_update_entries;  // offset of update index
+      stream << static_cast<size_t>(ArenaCodec);  // arena codec
+      stream << MainArenaFrameIndexOffset;  // offset of main arena frame index
       assert((stream.GetOffset() - start_of_meta_data) / sizeof(size_t) == TData::NumMetaFields);
 
       assert(stream.GetOffset() == start_of_meta_data + (TData::NumMetaFields * sizeof(size_t)));
@@ -1190,6 +1244,7 @@ TDataFile::TDataFile(Util::TEngine *engine,
 size_t MakeArena(Disk::Util::TEngine *engine,
                  Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed,
                  DiskPriority priority,
+                 TArenaCodec codec,
                  TIndexFile::TOrderedNoteIndex &note_index,
                  TDataFile::TRemapIndex &remap_index,
                  TDataFile::TBlockVec &block_vec,
@@ -1199,7 +1254,8 @@ size_t MakeArena(Disk::Util::TEngine *engine,
                  TDataFile::TTypeBoundaryOffsetVec &type_boundary_vec,
                  size_t max_total_note_bytes,
                  size_t &num_notes_out,
-                 size_t &num_bytes_out) {
+                 size_t &num_bytes_out,
+                 size_t &frame_index_offset_out) {
   assert(remap_index.empty());
   Atom::TCore::TArena *cur_arena = nullptr;
   auto remapper = [&remap_index, &cur_arena](TCore::TOffset off) {
@@ -1214,7 +1270,7 @@ size_t MakeArena(Disk::Util::TEngine *engine,
   TCore::TOffset cur_disk_offset = 0UL;
   TCore::TOffset prev_disk_offset = cur_disk_offset;
 
-  size_t max_blocks_required = ceil(static_cast<double>(max_total_note_bytes) / Disk::Util::LogicalBlockSize);
+  size_t max_blocks_required = ceil(static_cast<double>(TArenaFrameIndex::GetMaxNumStoredBytes(max_total_note_bytes, 0UL)) / Disk::Util::LogicalBlockSize);
 
   engine->AppendReserveBlocks(storage_speed, max_blocks_required, block_vec);
   #ifndef NDEBUG
@@ -1228,6 +1284,7 @@ size_t MakeArena(Disk::Util::TEngine *engine,
 
   TCompletionTrigger completion_trigger;
   unordered_map<size_t, shared_ptr<const TBufBlock>> arena_collision_map {};
+  size_t end_of_stream;
   /* arena stream life time */ {
     TDataFile::TDataOutStream arena_stream(HERE,
                                            Source::DataFileArena,
@@ -1242,6 +1299,7 @@ size_t MakeArena(Disk::Util::TEngine *engine,
                                            ,written_block_set
                                            #endif
                                            );
+    TArenaOutStream<TDataFile::TDataOutStream> arena_out(arena_stream, codec);
     type_boundary_vec.push_back(cur_disk_offset);
 
     void *lhs_type_alloc = alloca(Sabot::Type::GetMaxTypeSize() * 2);
@@ -1284,7 +1342,7 @@ size_t MakeArena(Disk::Util::TEngine *engine,
               memcpy(temp_note, note, note_size);
               cur_arena = ordered_note.Arena;
               temp_note->Remap(remapper);
-              arena_stream.Write(temp_note, note_size);
+              arena_out.Write(temp_note, note_size);
               prev_note = ordered_note;
               remap_index.emplace(arena, reinterpret_cast<TCore::TOffset>(note), cur_disk_offset);
               ++num_notes_out;
@@ -1302,13 +1360,15 @@ size_t MakeArena(Disk::Util::TEngine *engine,
       temp_note = nullptr;
       throw;
     }
+    assert(arena_out.GetNumBytes() == cur_disk_offset);
+    frame_index_offset_out = arena_out.Finish();
+    end_of_stream = arena_stream.GetOffset();
   }  // done arena stream
   num_bytes_out = cur_disk_offset;
   /* wait for the arena to flush */ {
     completion_trigger.Wait();
   }
   /* now that we know exactly how many bytes we actually used, we can shrink the block vec to free the unused blocks. */
-  const size_t end_of_stream = arena_byte_offset + num_bytes_out;
   const size_t actual_blocks_required = ((end_of_stream - 1UL) / Disk::Util::LogicalBlockSize) + 1UL;
 
   const size_t num_to_remove = block_vec.Size() - actual_blocks_required;
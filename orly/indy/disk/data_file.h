@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include <base/class_traits.h>
 #include <orly/atom/kit2.h>
+#include <orly/indy/disk/arena_frame.h>
 #include <orly/indy/disk/in_file.h>
 #include <orly/indy/disk/out_stream.h>
 #include <orly/indy/disk/util/cache.h>
@@ -112,48 +116,9 @@ namespace Orly {
         using TDataInStream = TStream<Disk::Util::LogicalBlockSize, Disk::Util::LogicalBlockSize, Disk::Util::PhysicalBlockSize, Disk::Util::PageCheckedBlock, LocalCacheSize>;
         typedef TOutStream<Disk::Util::LogicalPageSize, Disk::Util::LogicalBlockSize, Disk::Util::PhysicalBlockSize, Disk::Util::PageCheckedBlock> TDataOutStream;
 
-        /* TODO */
-        class TUpdateObj {
-          public:
-
-          /* TODO */
-          TUpdateObj(TSequenceNumber seq_num, const Atom::TCore &metadata, const Atom::TCore &id, size_t offset, bool is_current, const Base::TUuid &index_id)
-              : SequenceNumber(seq_num),
-                Metadata(metadata),
-                Id(id),
-                Offset(offset),
-                IsCurrent(is_current),
-                IndexId(index_id) {}
-
-          /* TODO */
-          bool operator<(const TUpdateObj &that) const {
-            assert(this);
-            assert(&that);
-            return SequenceNumber < that.SequenceNumber;
-          }
-
-          /* TODO */
-          TSequenceNumber SequenceNumber;
-
-          /* TODO */
-          Atom::TCore Metadata;
-
-          /* TODO */
-          Atom::TCore Id;
-
-          /* TODO */
-          size_t Offset;
-
-          /* TODO */
-          bool IsCurrent;
-
-          /* TODO */
-          Base::TUuid IndexId;
-
-        };  // TUpdateObj
-
-        /* TODO */
-        typedef Disk::Util::TIndexManager<TUpdateObj, Util::SortBufSize, Util::SortBufMinParallelSize> TUpdateCollector;
+        /* Where, in the file, we wrote each entry of the memory layer.  The memory layer already holds its updates in sequence order,
+           so this is all we need to write the update index straight from it, rather than sorting the updates all over again. */
+        typedef std::unordered_map<const TUpdate::TEntry *, size_t> TKeyOffsetByEntry;
         typedef std::unordered_set<TRemapObj> TRemapIndex;
         typedef Indy::Util::TBlockVec TBlockVec;
         typedef std::vector<size_t> TTypeBoundaryOffsetVec;
@@ -182,7 +147,7 @@ namespace Orly {
         */
         //static const size_t NumMetaFields = 10UL;
 
-        /* TODO */
+        /* Writes out the memory layer.  The arenas are stored with the given codec; the repo manager's, when it's flushing. */
         TDataFile(Util::TEngine *engine,
                   Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed,
                   TMemoryLayer *memory_layer,
@@ -190,7 +155,8 @@ namespace Orly {
                   size_t gen_id,
                   size_t temp_file_consol_thresh,
                   TSequenceNumber release_up_to,
-                  DiskPriority priority);
+                  DiskPriority priority,
+                  TArenaCodec arena_codec = TArenaCodec::None);
 
         /* TODO */
         inline size_t GetNumKeys() const {
@@ -210,6 +176,12 @@ namespace Orly {
           return HighestSeq;
         }
 
+        /* The number of bytes we wrote, in whole blocks. */
+        inline size_t GetFileLength() const {
+          assert(this);
+          return FileLength;
+        }
+
         private:
 
         /* TODO */
@@ -224,8 +196,12 @@ namespace Orly {
         /* TODO */
         size_t NumUpdates;
 
+        /* TODO */
+        TArenaCodec ArenaCodec;
+
         /* TODO */
         size_t MainArenaByteOffset;
+        size_t MainArenaFrameIndexOffset;
         TRemapIndex MainArenaRemapIndex;
         TTypeBoundaryOffsetVec MainArenaTypeBoundaryOffsetVec;
 
@@ -249,8 +225,8 @@ namespace Orly {
         /* TODO */
         TBlockVec BlockVec;
 
-        /* TODO */
-        TUpdateCollector UpdateCollector;
+        /* See TKeyOffsetByEntry. */
+        TKeyOffsetByEntry KeyOffsetByEntry;
 
         /* TODO */
         #ifndef NDEBUG
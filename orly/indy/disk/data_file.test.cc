@@ -327,3 +327,142 @@ FIXTURE(History) {
     cond.notify_one();
   });
 }
+
+FIXTURE(KeyFilter) {
+  Fiber::TFiberTestRunner runner([](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &) {
+    const TScheduler::TPolicy scheduler_policy(4, 10, milliseconds(10));
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    TScheduler scheduler;
+    scheduler.SetPolicy(scheduler_policy);
+
+    Sim::TMemEngine mem_engine(&scheduler,
+                               256 /* disk space: 256MB */,
+                               256 /* slow disk space: 256MB */,
+                               16384 /* page cache slots: 64MB */,
+                               1 /* num page lru */,
+                               1024 /* block cache slots: 64MB */,
+                               1 /* num block lru */);
+
+    Base::TUuid file_id(TUuid::Best);
+    TSequenceNumber seq_num = 0U;
+    TUuid int_int_idx(TUuid::Twister);
+    const int64_t num_keys = 1000L;
+    /* Make a data file */ {
+      TSuprena arena;
+      TMockMem mem_layer;
+      /* insert <[int64_t, int64_t]> for the even numbers only */ {
+        for (int64_t i = 0; i < num_keys; ++i) {
+          Insert(mem_layer, ++seq_num, int_int_idx, i, i % 10L, i * 2L);
+        }
+      }
+      size_t data_gen_id = 1;
+      TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, data_gen_id, 20UL, 0U, Medium);
+      TReader reader(HERE, mem_engine.GetEngine(), file_id, data_gen_id);
+      TReader::TIndexFile idx_file(&reader, int_int_idx, RealTime);
+      TReader::TArena idx_arena(&idx_file, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+      TStream<Orly::Indy::Disk::Util::LogicalBlockSize, Orly::Indy::Disk::Util::LogicalBlockSize, Orly::Indy::Disk::Util::PhysicalBlockSize, Orly::Indy::Disk::Util::PageCheckedBlock, 0UL> in_stream(HERE, Source::PresentWalk, RealTime, &reader, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), 0);
+      EXPECT_FALSE(idx_file.GetKeyFilter().IsEmpty());
+      size_t out_offset;
+      /* every key we wrote, and every prefix of one, must get past the filter */
+      size_t found = 0UL;
+      for (int64_t i = 0; i < num_keys; ++i) {
+        found += idx_file.FindInHash(TKey(make_tuple(i % 10L, i * 2L), &arena, state_alloc), out_offset, in_stream, &idx_arena) ? 1UL : 0UL;
+      }
+      EXPECT_EQ(found, static_cast<size_t>(num_keys));
+      for (int64_t i = 0; i < 10L; ++i) {
+        EXPECT_TRUE(idx_file.FindInHash(TKey(make_tuple(i, Native::TFree<int64_t>()), &arena, state_alloc), out_offset, in_stream, &idx_arena));
+      }
+      /* almost all of the keys we didn't write should be turned away by the filter, without a hash probe */
+      ExchangeKeyFilterNegativeCount();
+      ExchangeKeyFilterFalsePositiveCount();
+      found = 0UL;
+      for (int64_t i = 0; i < num_keys; ++i) {
+        found += idx_file.FindInHash(TKey(make_tuple(i % 10L, i * 2L + 1L), &arena, state_alloc), out_offset, in_stream, &idx_arena) ? 1UL : 0UL;
+      }
+      EXPECT_EQ(found, 0UL);
+      const size_t num_negative = ExchangeKeyFilterNegativeCount();
+      const size_t num_false_positive = ExchangeKeyFilterFalsePositiveCount();
+      EXPECT_EQ(num_negative + num_false_positive, static_cast<size_t>(num_keys));
+      EXPECT_GT(num_negative, static_cast<size_t>(num_keys * 9L / 10L));
+    }
+    GracefullShutdown();
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  });
+}
+
+FIXTURE(ArenaCompression) {
+  Fiber::TFiberTestRunner runner([](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &) {
+    const TScheduler::TPolicy scheduler_policy(4, 10, milliseconds(10));
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    TScheduler scheduler;
+    scheduler.SetPolicy(scheduler_policy);
+
+    Sim::TMemEngine mem_engine(&scheduler,
+                               256 /* disk space: 256MB */,
+                               256 /* slow disk space: 256MB */,
+                               16384 /* page cache slots: 64MB */,
+                               1 /* num page lru */,
+                               1024 /* block cache slots: 64MB */,
+                               1 /* num block lru */);
+
+    Base::TUuid file_id(TUuid::Best);
+    TSequenceNumber seq_num = 0U;
+    TUuid int_str_idx(TUuid::Twister);
+    const int64_t num_keys = 2000L;
+    /* strings long enough to spill out of their cores and into the arenas, and repetitive enough to compress */
+    auto make_str = [](int64_t i, size_t len) {
+      return string(len, static_cast<char>('a' + (i % 26L))) + to_string(i);
+    };
+    /* compressed and uncompressed arenas must read back the same */
+    for (TArenaCodec codec : {TArenaCodec::Snappy, TArenaCodec::None}) {
+      TSuprena arena;
+      TMockMem mem_layer;
+      /* insert <[int64_t, string]> with a string value */ {
+        TSuprena suprena;
+        for (int64_t i = 0; i < num_keys; ++i) {
+          Insert(mem_layer, ++seq_num, int_str_idx, TKey(make_str(i, 500UL), &suprena, state_alloc),
+                 i, make_str(i, 100UL));
+        }
+      }
+      size_t data_gen_id = static_cast<size_t>(codec) + 1UL;
+      TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, data_gen_id, 20UL, 0U, Medium, codec);
+      TReader reader(HERE, mem_engine.GetEngine(), file_id, data_gen_id);
+      TReader::TArena main_arena(&reader, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+      TReader::TIndexFile idx_file(&reader, int_str_idx, RealTime);
+      TReader::TArena idx_arena(&idx_file, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+      EXPECT_TRUE(reader.GetArenaCodec() == codec);
+      if (codec == TArenaCodec::None) {
+        EXPECT_FALSE(reader.GetArenaFrameIndex());
+        EXPECT_FALSE(idx_file.GetArenaFrameIndex());
+      } else if (EXPECT_TRUE(reader.GetArenaFrameIndex()) && EXPECT_TRUE(idx_file.GetArenaFrameIndex())) {
+        const TArenaFrameIndex *main_frames = reader.GetArenaFrameIndex();
+        EXPECT_GT(main_frames->GetNumFrames(), 1UL);
+        EXPECT_EQ(main_frames->GetNumNoteBytes(), reader.GetNumBytesOfArena());
+        EXPECT_LT(main_frames->GetNumStoredBytes(), main_frames->GetNumNoteBytes());
+        const TArenaFrameIndex *idx_frames = idx_file.GetArenaFrameIndex();
+        EXPECT_EQ(idx_frames->GetNumNoteBytes(), idx_file.GetNumBytesOfArena());
+        EXPECT_LT(idx_frames->GetNumStoredBytes(), idx_frames->GetNumNoteBytes());
+      }
+      int64_t seen = 0L;
+      for (TReader::TIndexFile::TKeyCursor cur_key_csr(&idx_file); cur_key_csr; ++cur_key_csr, ++seen) {
+        const TReader::TIndexFile::TKeyItem &item = *cur_key_csr;
+        EXPECT_EQ(TKey(item.Key, &idx_arena), TKey(make_tuple(seen, make_str(seen, 100UL)), &arena, state_alloc));
+        EXPECT_EQ(TKey(item.Value, &main_arena), TKey(make_str(seen, 500UL), &arena, state_alloc));
+      }
+      EXPECT_EQ(seen, num_keys);
+    }
+    GracefullShutdown();
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  });
+}
+
+FIXTURE(ParseArenaCodec) {
+  EXPECT_TRUE(ParseArenaCodec("none") == TArenaCodec::None);
+  EXPECT_TRUE(ParseArenaCodec("snappy") == TArenaCodec::Snappy);
+  EXPECT_EQ(string(GetArenaCodecName(TArenaCodec::Snappy)), "snappy");
+  EXPECT_THROW(invalid_argument, []() { ParseArenaCodec("zstd"); });
+}
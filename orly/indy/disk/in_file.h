@@ -54,7 +54,7 @@ namespace Orly {
         static const size_t UpdateKeyPtrSize = sizeof(size_t);
 
         /* TODO */
-        static const size_t NumMetaFields = 10U;
+        static const size_t NumMetaFields = 12U;
         /*
            1.  # of blocks
            2.  # of meta-blocks (n)
@@ -66,11 +66,13 @@ namespace Orly {
            8.  # of arena type boundaries
            9.  offset of main arena
            10.  offset of update index
+           11.  arena codec
+           12.  offset of main arena frame index (0 if the main arena isn't compressed)
 
         */
 
         /* TODO */
-        static const size_t NumIndexMetaFields = 8U;
+        static const size_t NumIndexMetaFields = 11U;
         /*
            Offset of Arena
            # arena notes
@@ -80,6 +82,9 @@ namespace Orly {
            # History Keys
            Current Key Offset
            # of hash indexes (n)
+           Key Filter Offset
+           # of key filter words
+           Arena Frame Index Offset (0 if the arena isn't compressed)
 
            (n) (size_t) -> (size_t) hash index offset -> num hash fields pairings
         */
@@ -138,11 +143,12 @@ namespace Orly {
         static constexpr size_t PhysicalCachePageSize = PhysicalBlockSize / (BlockSize / CachePageSize);
 
         /* TODO */
-        TStream(const Base::TCodeLocation &code_location /* DEBUG */, uint8_t util_src, DiskPriority priority, const TInFile *file, Util::TCache<PhysicalCachePageSize> *cache, size_t byte_offset/*, bool scan_ahead_allowed = true*/)
-            : TStream(code_location, util_src, priority, file->GetFileLength(), file, cache, byte_offset/*, scan_ahead_allowed*/) {}
+        TStream(const Base::TCodeLocation &code_location /* DEBUG */, uint8_t util_src, DiskPriority priority, const TInFile *file, Util::TCache<PhysicalCachePageSize> *cache, size_t byte_offset/*, bool scan_ahead_allowed = true*/, bool no_pollute = false)
+            : TStream(code_location, util_src, priority, file->GetFileLength(), file, cache, byte_offset/*, scan_ahead_allowed*/, no_pollute) {}
 
-        /* TODO */
-        TStream(const Base::TCodeLocation &code_location /* DEBUG */, uint8_t util_src, DiskPriority priority, size_t end_of_stream, const TInFile *file, Util::TCache<PhysicalCachePageSize> *cache, size_t byte_offset/*, bool scan_ahead_allowed = true*/)
+        /* If 'no_pollute', we're only passing through (a merge or a file sync, say), so the pages we read shouldn't push anyone else's
+           out of the cache. */
+        TStream(const Base::TCodeLocation &code_location /* DEBUG */, uint8_t util_src, DiskPriority priority, size_t end_of_stream, const TInFile *file, Util::TCache<PhysicalCachePageSize> *cache, size_t byte_offset/*, bool scan_ahead_allowed = true*/, bool no_pollute = false)
             : File(file),
               Cache(cache),
               EndOfStream(end_of_stream),
@@ -159,7 +165,8 @@ namespace Orly {
               DiskResult(Success),
               DiskErrStr(nullptr),
               CodeLocation(code_location),
-              UtilSrc(util_src) {
+              UtilSrc(util_src),
+              NoPollute(no_pollute) {
           assert(File);
           assert(ByteOffset <= EndOfStream);
           if (ByteOffset < EndOfStream) {
@@ -466,7 +473,7 @@ namespace Orly {
                   ++num_consec;
                 } else {
                   if (num_consec > 0UL) {
-                    Cache->AsyncMultiGet(CodeLocation, Priority, Cache, BufKind, UtilSrc, consec_starting_page_id, num_consec, true, AsyncTrigger);
+                    Cache->AsyncMultiGet(CodeLocation, Priority, Cache, BufKind, UtilSrc, consec_starting_page_id, num_consec, true, AsyncTrigger, NoPollute);
                   }
                   /* this page does not follow logically, we'll have to do a separate request for this one */
                   num_consec = 0UL;
@@ -475,7 +482,7 @@ namespace Orly {
                 }
               }
               if (num_consec > 0UL) {
-                Cache->AsyncMultiGet(CodeLocation, Priority, Cache, BufKind, UtilSrc, consec_starting_page_id, num_consec, true, AsyncTrigger);
+                Cache->AsyncMultiGet(CodeLocation, Priority, Cache, BufKind, UtilSrc, consec_starting_page_id, num_consec, true, AsyncTrigger, NoPollute);
               }
             }
           }
@@ -505,7 +512,7 @@ namespace Orly {
               BufData = DataSlot->KnownGetData(Cache);
             } else {
               try {
-                MainSlot = Cache->Get(page_id, DataSlot);
+                MainSlot = Cache->Get(page_id, DataSlot, NoPollute);
                 BufData = DataSlot->SyncGetData(CodeLocation, Priority, Cache, BufKind, UtilSrc, page_id, SyncTrigger);
                 LocalBufCache.Emplace(std::forward_as_tuple(page_id), std::forward_as_tuple(page_id, Cache, MainSlot, DataSlot));
               } catch (const Disk::TDiskFailure &err) {
@@ -523,7 +530,7 @@ namespace Orly {
               Cache->Release(MainSlot, prev_loaded_page_id);
             }
             try {
-              MainSlot = Cache->Get(page_id, DataSlot);
+              MainSlot = Cache->Get(page_id, DataSlot, NoPollute);
               BufData = DataSlot->SyncGetData(CodeLocation, Priority, Cache, BufKind, UtilSrc, page_id, SyncTrigger);
             } catch (const Disk::TDiskFailure &err) {
               MainSlot = nullptr;
@@ -625,6 +632,9 @@ namespace Orly {
         const Base::TCodeLocation CodeLocation;
         const uint8_t UtilSrc;
 
+        /* See the constructor. */
+        const bool NoPollute;
+
       };  // TStream
 
     }  // Disk
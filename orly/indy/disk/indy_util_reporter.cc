@@ -106,6 +106,9 @@ const char *TIndyUtilReporter::GetName(uint8_t source) const {
     case DataFileKey: {
       return "DataFileKey";
     }
+    case DataFileKeyFilter: {
+      return "DataFileKeyFilter";
+    }
     case DataFileMeta: {
       return "DataFileMeta";
     }
@@ -181,6 +184,9 @@ const char *TIndyUtilReporter::GetName(uint8_t source) const {
     case MergeDataFileKey: {
       return "MergeDataFileKey";
     }
+    case MergeDataFileKeyFilter: {
+      return "MergeDataFileKeyFilter";
+    }
     case MergeDataFileMeta: {
       return "MergeDataFileMeta";
     }
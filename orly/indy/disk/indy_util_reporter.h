@@ -39,6 +39,7 @@ namespace Orly {
         DataFileHashIndex,
         DataFileHistory,
         DataFileKey,
+        DataFileKeyFilter,
         DataFileMeta,
         DataFileNoteIndex,
         DataFileOther,
@@ -64,6 +65,7 @@ namespace Orly {
         MergeDataFileHashIndex,
         MergeDataFileHistory,
         MergeDataFileKey,
+        MergeDataFileKeyFilter,
         MergeDataFileMeta,
         MergeDataFileOther,
         MergeDataFileRemapIndex,
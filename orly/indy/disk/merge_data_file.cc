@@ -18,7 +18,9 @@
 
 #include <orly/indy/disk/merge_data_file.h>
 
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/hash_util.h>
+#include <orly/indy/fiber/algorithm.h>
 #include <orly/indy/util/block_vec.h>
 #include <orly/indy/util/min_heap.h>
 
@@ -52,18 +54,23 @@ class TMergeDataFileImpl {
                      TSequenceNumber /*release_up_to*/,
                      DiskPriority priority,
                      size_t max_block_cache_read_slots_allowed,
-                     size_t temp_file_consol_thresh)
+                     size_t temp_file_consol_thresh,
+                     const std::vector<Fiber::TRunner *> &helper_runner_vec,
+                     TArenaCodec arena_codec)
       : Engine(engine),
         StorageSpeed(storage_speed),
         UpdateIndexStorageSpeed(TVolume::TDesc::TStorageSpeed::Slow),
         SorterStorageSpeed(TVolume::TDesc::TStorageSpeed::Slow),
         Priority(priority),
         MaxBlockCacheReadSlotsAllowed(max_block_cache_read_slots_allowed),
+        ArenaCodec(arena_codec),
         MainArenaByteOffset(0UL),
+        MainArenaFrameIndexOffset(0UL),
         NumUpdates(0UL),
         NumKeys(0UL),
         LowestSeq(0UL),
         HighestSeq(0UL),
+        FileLength(0UL),
         TempFileConsolThresh(temp_file_consol_thresh),
         UpdateCollector(HERE, Source::MergeDataFileUpdateIndex, TempFileConsolThresh, SorterStorageSpeed, Engine, true) {
     assert(!CanTailTombstones || gen_vec.size() == 1);
@@ -101,7 +108,7 @@ class TMergeDataFileImpl {
             remap_sorter_vec.push_back(make_unique<TRemapSorter>(HERE, Source::MergeDataFileRemapIndex, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
             idx_file_vec.emplace_back(new typename TReader::TIndexFile(std::get<0>(idx_f), idx.first, std::get<1>(idx_f), Priority));
             typename TReader::TIndexFile &idx_file = *idx_file_vec.back();
-            disk_arena_vec.emplace_back(new TDataDiskArena<true>(&idx_file, Engine->GetCache<TDataDiskArena<true>::PhysicalCachePageSize>(), Priority));
+            disk_arena_vec.emplace_back(new TDataDiskArena<true>(&idx_file, Engine->GetCache<TDataDiskArena<true>::PhysicalCachePageSize>(), Priority, true));
             type_boundary_offset_vec.emplace_back(idx_file.GetTypeBoundaryOffsetVec());
             max_arena_bytes += idx_file.GetNumBytesOfArena();
           }
@@ -224,7 +231,8 @@ class TMergeDataFileImpl {
           TMergeIndexFile &merge_idx_file = *idx_pair.second;
           try {
             merge_idx_file.ConstructArena(merge_idx_file.TypeBoundaryOffsetVec,
-                                          merge_idx_file.MaxArenaBytes);
+                                          merge_idx_file.MaxArenaBytes,
+                                          ArenaCodec);
           } catch (const std::exception &ex) {
             syslog(LOG_ERR, "MergeDataFile caught error [%s]", ex.what());
 
@@ -242,15 +250,17 @@ class TMergeDataFileImpl {
           size_t max_arena_bytes = 0UL;
           for (const auto &reader : ReadFileVec) {
             main_remap_sorter_vec.push_back(make_unique<TRemapSorter>(HERE, Source::MergeDataFileRemapIndex, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-            disk_arena_vec.emplace_back(new typename TReader::TArena(reader.get(), Engine->GetCache<TReader::PhysicalCachePageSize>(), Low));
+            disk_arena_vec.emplace_back(new typename TReader::TArena(reader.get(), Engine->GetCache<TReader::PhysicalCachePageSize>(), Low, true));
             type_boundary_offset_vec.emplace_back(reader->GetTypeBoundaryOffsetVec());
             max_arena_bytes += reader->GetNumBytesOfArena();
           }
           if (max_arena_bytes) {
+            std::unique_ptr<TArenaFrameIndex> main_arena_frames;
             MainArenaByteOffset = MakeArena(Engine,
                                             StorageSpeed,
                                             SorterStorageSpeed,
                                             Priority,
+                                            ArenaCodec,
                                             MaxBlockCacheReadSlotsAllowed,
                                             TempFileConsolThresh,
                                             disk_arena_vec,
@@ -264,7 +274,9 @@ class TMergeDataFileImpl {
                                             #endif
                                             max_arena_bytes,
                                             num_main_arena_notes,
-                                            num_main_arena_bytes);
+                                            num_main_arena_bytes,
+                                            MainArenaFrameIndexOffset,
+                                            main_arena_frames);
           }
         }
       } catch (const std::exception &ex) {
@@ -287,10 +299,8 @@ class TMergeDataFileImpl {
           Orly::Indy::Util::TMinHeap<TSortedKey, size_t> min_heap(source_file_vec.size() * 2);
           std::vector<TSortedKey> sorted_key_vec(source_file_vec.size() * 2);
 
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> key_access_sorter_vec;
           std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> key_resolved_sorter_vec;
           std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> key_resolved_sorter_cursor_vec;
-          std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapAccessSorter>> val_access_sorter_vec;
           std::vector<std::unique_ptr<TMergeDataFileImpl::TRemapResolvedSorter>> val_resolved_sorter_vec;
           std::vector<std::unique_ptr<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>> val_resolved_sorter_cursor_vec;
           std::vector<size_t> read_file_vec_pos_by_source_pos;
@@ -302,39 +312,28 @@ class TMergeDataFileImpl {
               }
             }
           }
-          size_t pos = 0;
-          /* build the key access pattern */ {
-            size_t max_block_cache_read_slot_per_sub_cursor = MaxBlockCacheReadSlotsAllowed / (source_file_vec.size() * 4UL);
-            for (const auto &source_file : source_file_vec) {
+          /* build the key access pattern.  Each source's scan and remap is independent of the others', so we spread them across the
+             helper runners and split the block cache read slots between however many run at once. */ {
+            const size_t num_sources = source_file_vec.size();
+            const size_t num_concurrent = std::max(1UL, std::min(num_sources, helper_runner_vec.size()));
+            const size_t max_block_cache_read_slots_per_resolve = std::max(2UL, MaxBlockCacheReadSlotsAllowed / num_concurrent);
+            key_resolved_sorter_vec.resize(num_sources * 2);
+            val_resolved_sorter_vec.resize(num_sources * 2);
+            for (size_t i = 0; i < num_sources * 2; ++i) {
+              key_resolved_sorter_vec[i] = make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+              val_resolved_sorter_vec[i] = make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+            }
+            Fiber::ForEach(helper_runner_vec, num_sources, [&](size_t source_pos) {
+              const auto &source_file = source_file_vec[source_pos];
+              TMergeDataFileImpl::TRemapSorter &key_remap_sorter = *idx_file.ArenaRemapSorterVec[source_pos];
+              TMergeDataFileImpl::TRemapSorter &val_remap_sorter = *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[source_pos]];
               /* current keys */ {
-                key_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                key_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                TMergeDataFileImpl::TRemapAccessSorter &key_access_sorter = *key_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &key_resolved_sorter = *key_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &key_remap_sorter = *idx_file.ArenaRemapSorterVec[pos / 2];
-                TMergeDataFileImpl::TRemapAccessSorter &val_access_sorter = *val_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &val_resolved_sorter = *val_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &val_remap_sorter = *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[pos / 2]];
+                TMergeDataFileImpl::TRemapAccessSorter key_access_sorter(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+                TMergeDataFileImpl::TRemapAccessSorter val_access_sorter(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
                 size_t idx = 0UL;
-                if (CanTail) {
-                  for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
-                    const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
-                    if (!CanTailTombstones || !item.Value.IsTombstone() || item.NumHistKeys > 0) {
-                      const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                      if (key_off) {
-                        key_access_sorter.Emplace(++idx, *key_off);
-                      }
-                      const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                      if (val_off) {
-                        val_access_sorter.Emplace(++idx, *val_off);
-                      }
-                    }
-                  }
-                } else {
-                  for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
-                    const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
+                for (typename TReader::TIndexFile::TKeyCursor key_cursor(source_file.get()); key_cursor; ++key_cursor) {
+                  const typename TReader::TIndexFile::TKeyItem &item = *key_cursor;
+                  if (!CanTailTombstones || !item.Value.IsTombstone() || item.NumHistKeys > 0) {
                     const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
                     if (key_off) {
                       key_access_sorter.Emplace(++idx, *key_off);
@@ -345,48 +344,18 @@ class TMergeDataFileImpl {
                     }
                   }
                 }
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, key_access_sorter, key_remap_sorter, key_resolved_sorter);
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, val_access_sorter, val_remap_sorter, val_resolved_sorter);
-                key_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                val_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                key_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&key_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-                val_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&val_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
+                TMergeDataFileImpl::ResolveRemap(max_block_cache_read_slots_per_resolve, key_access_sorter, key_remap_sorter, *key_resolved_sorter_vec[source_pos * 2]);
+                TMergeDataFileImpl::ResolveRemap(max_block_cache_read_slots_per_resolve, val_access_sorter, val_remap_sorter, *val_resolved_sorter_vec[source_pos * 2]);
               } /* finish access pattern for current keys */
-
-              ++pos;
-
               /* history keys */ {
-                key_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                key_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_access_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapAccessSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                val_resolved_sorter_vec.push_back(make_unique<TMergeDataFileImpl::TRemapResolvedSorter>(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true));
-                TMergeDataFileImpl::TRemapAccessSorter &key_access_sorter = *key_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &key_resolved_sorter = *key_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &key_remap_sorter = *idx_file.ArenaRemapSorterVec[pos / 2];
-                TMergeDataFileImpl::TRemapAccessSorter &val_access_sorter = *val_access_sorter_vec.back();
-                TMergeDataFileImpl::TRemapResolvedSorter &val_resolved_sorter = *val_resolved_sorter_vec.back();
-                TMergeDataFileImpl::TRemapSorter &val_remap_sorter = *main_remap_sorter_vec[read_file_vec_pos_by_source_pos[pos / 2]];
+                TMergeDataFileImpl::TRemapAccessSorter key_access_sorter(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
+                TMergeDataFileImpl::TRemapAccessSorter val_access_sorter(HERE, Source::MergeDataFileScan, TempFileConsolThresh, SorterStorageSpeed, Engine, true);
                 size_t idx = 0UL;
-                if (CanTail) {
-                  std::vector<bool> &hist_filter_vec = idx_file.HistoryKeeperFilterVec[pos / 2];
-                  assert(hist_filter_vec.size() == source_file->GetNumHistKeys());
-                  size_t cur_hist_offset = 0UL;
-                  for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor, ++cur_hist_offset) {
-                    assert(cur_hist_offset < hist_filter_vec.size());
-                    if (hist_filter_vec[cur_hist_offset]) {
-                      const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
-                      const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
-                      if (key_off) {
-                        key_access_sorter.Emplace(++idx, *key_off);
-                      }
-                      const Atom::TCore::TOffset *val_off = item.Value.TryGetOffset();
-                      if (val_off) {
-                        val_access_sorter.Emplace(++idx, *val_off);
-                      }
-                    }
-                  }
-                } else {
-                  for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor) {
+                const std::vector<bool> *hist_filter_vec = CanTail ? &idx_file.HistoryKeeperFilterVec[source_pos] : nullptr;
+                assert(!hist_filter_vec || hist_filter_vec->size() == source_file->GetNumHistKeys());
+                size_t cur_hist_offset = 0UL;
+                for (typename TReader::TIndexFile::THistoryKeyCursor history_cursor(source_file.get()); history_cursor; ++history_cursor, ++cur_hist_offset) {
+                  if (!hist_filter_vec || (*hist_filter_vec)[cur_hist_offset]) {
                     const typename TReader::TIndexFile::THistoryKeyItem &item = *history_cursor;
                     const Atom::TCore::TOffset *key_off = item.Key.TryGetOffset();
                     if (key_off) {
@@ -398,21 +367,20 @@ class TMergeDataFileImpl {
                     }
                   }
                 }
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, key_access_sorter, key_remap_sorter, key_resolved_sorter);
-                TMergeDataFileImpl::ResolveRemap(MaxBlockCacheReadSlotsAllowed, val_access_sorter, val_remap_sorter, val_resolved_sorter);
-                key_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                val_access_sorter_vec.back().reset(); /* reset the access sorter so we release the resources. */
-                key_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&key_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
-                val_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(&val_resolved_sorter, max_block_cache_read_slot_per_sub_cursor));
+                TMergeDataFileImpl::ResolveRemap(max_block_cache_read_slots_per_resolve, key_access_sorter, key_remap_sorter, *key_resolved_sorter_vec[source_pos * 2 + 1]);
+                TMergeDataFileImpl::ResolveRemap(max_block_cache_read_slots_per_resolve, val_access_sorter, val_remap_sorter, *val_resolved_sorter_vec[source_pos * 2 + 1]);
               } /* finish access pattern for history keys */
-
-              ++pos;
+            });
+            const size_t max_block_cache_read_slot_per_sub_cursor = MaxBlockCacheReadSlotsAllowed / (num_sources * 4UL);
+            for (size_t i = 0; i < num_sources * 2; ++i) {
+              key_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(key_resolved_sorter_vec[i].get(), max_block_cache_read_slot_per_sub_cursor));
+              val_resolved_sorter_cursor_vec.push_back(std::make_unique<typename TMergeDataFileImpl::TRemapResolvedSorter::TCursor>(val_resolved_sorter_vec[i].get(), max_block_cache_read_slot_per_sub_cursor));
             }
           }
           std::swap(idx_file.ResolvedKeySorterCursorVec, key_resolved_sorter_cursor_vec);
           std::swap(idx_file.ResolvedValSorterCursorVec, val_resolved_sorter_cursor_vec);
 
-          pos = 0;
+          size_t pos = 0;
           for (const auto &source_file : source_file_vec) {
             max_key_count += source_file->GetNumCurKeys();
             max_key_count += source_file->GetNumHistKeys();
@@ -691,6 +659,8 @@ class TMergeDataFileImpl {
           # of arena bytes
           offset of main arena
           offset of update index
+          arena codec
+          offset of main arena frame index
 
           n (size_t) metablock block_id(s)
           m (size_t) -> (size_t) #block -> starting_block_id pairings
@@ -744,6 +714,8 @@ class TMergeDataFileImpl {
         stream << MainArenaTypeBoundaryOffsetVec.size();  // # of arena type boundaries
         stream << MainArenaByteOffset;  // byte offset of main arena
         stream << byte_offset_of_update_entries;  // offset of update index
+        stream << static_cast<size_t>(ArenaCodec);  // arena codec
+        stream << MainArenaFrameIndexOffset;  // offset of main arena frame index
 
         /* write out the meta-block ids */
         for (size_t i = 0; i < num_meta_blocks; ++i) {
@@ -1111,12 +1083,13 @@ class TMergeDataFileImpl {
     NO_COPY(TMyMergeArena);
     public:
 
-    TMyMergeArena(TEngine *engine, const TBlockVec &block_vec, size_t arena_byte_offset, size_t arena_num_notes, size_t arena_num_bytes)
+    TMyMergeArena(TEngine *engine, const TBlockVec &block_vec, size_t arena_byte_offset, size_t arena_num_notes, size_t arena_num_bytes, const TArenaFrameIndex *frames)
         : Engine(engine),
           BlockVec(block_vec),
           ArenaByteOffset(arena_byte_offset),
           NumArenaNotes(arena_num_notes),
-          NumArenaBytes(arena_num_bytes) {}
+          NumArenaBytes(arena_num_bytes),
+          Frames(frames) {}
 
     virtual ~TMyMergeArena() {}
 
@@ -1155,11 +1128,17 @@ class TMergeDataFileImpl {
       return NumArenaBytes;
     }
 
+    virtual const TArenaFrameIndex *GetArenaFrameIndex() const override {
+      assert(this);
+      return Frames;
+    }
+
     TEngine *Engine;
     const TBlockVec &BlockVec;
     size_t ArenaByteOffset;
     size_t NumArenaNotes;
     size_t NumArenaBytes;
+    const TArenaFrameIndex *Frames;
 
   };
 
@@ -1306,6 +1285,7 @@ class TMergeDataFileImpl {
                           TVolume::TDesc::TStorageSpeed storage_speed,
                           TVolume::TDesc::TStorageSpeed sorter_storage_speed,
                           DiskPriority priority,
+                          TArenaCodec codec,
                           size_t max_block_cache_read_slots_allowed,
                           size_t temp_file_consol_thresh,
                           const std::vector<std::unique_ptr<TDataDiskArena<true>>> &disk_arena_vec,
@@ -1319,7 +1299,9 @@ class TMergeDataFileImpl {
                           #endif
                           size_t max_total_note_bytes,
                           size_t &num_notes_out,
-                          size_t &num_bytes_out) {
+                          size_t &num_bytes_out,
+                          size_t &frame_index_offset_out,
+                          std::unique_ptr<TArenaFrameIndex> &frame_index_out) {
     /* build a map from boundary to sorted keeper filter for each file */
     std::vector<std::map<size_t, std::unique_ptr<typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TArenaKeeperSorter>>> sorted_keeper_map_vec;
     if (CanTail) {
@@ -1374,7 +1356,12 @@ class TMergeDataFileImpl {
     assert(disk_arena_vec.size() == type_boundary_offset_vec_by_file.size());
     const size_t arena_byte_offset = block_vec.Size() * LogicalBlockSize;
 
-    size_t max_blocks_required = ceil(static_cast<double>(max_total_note_bytes) / LogicalBlockSize);
+    /* we flush the frame in progress at most once per type range */
+    size_t max_num_flushes = 0UL;
+    for (const auto &type_boundary_offset_vec : type_boundary_offset_vec_by_file) {
+      max_num_flushes += type_boundary_offset_vec.size();
+    }
+    size_t max_blocks_required = ceil(static_cast<double>(TArenaFrameIndex::GetMaxNumStoredBytes(max_total_note_bytes, max_num_flushes)) / LogicalBlockSize);
     const size_t total_blocks_required = block_vec.Size() + max_blocks_required;
     engine->AppendReserveBlocks(storage_speed, max_blocks_required, block_vec);
     #ifndef NDEBUG
@@ -1389,6 +1376,7 @@ class TMergeDataFileImpl {
 
     TCompletionTrigger completion_trigger;
     std::unordered_map<size_t, std::shared_ptr<const TBufBlock>> arena_collision_map {};
+    size_t end_of_stream;
     /* arena stream life-span */ {
       TDataOutStream arena_stream(HERE,
                                   Source::MergeDataFileArena,
@@ -1403,6 +1391,7 @@ class TMergeDataFileImpl {
                                   ,written_block_set
                                   #endif
                                   );
+      TArenaOutStream<TDataOutStream> arena_out(arena_stream, codec);
       Atom::TCore::TOffset cur_disk_offset = 0UL;
 
       /* let's get some information about what types are involved... */ {
@@ -1434,7 +1423,7 @@ class TMergeDataFileImpl {
           Sabot::Type::TAny::TWrapper type_wrapper(temp_core.GetType(prev_type->GetArena(), type_alloc));
           size_t type_depth = Sabot::GetDepth(*type_wrapper);
           if (type_depth == 0) {
-            MergeTypeRangeDepth0(arena_stream,
+            MergeTypeRangeDepth0(arena_out,
                                  max_block_cache_read_slots_allowed,
                                  disk_arena_vec,
                                  type_boundary_offset_vec_by_file,
@@ -1446,6 +1435,8 @@ class TMergeDataFileImpl {
                                  num_bytes_out);
           } else {
             if (num_notes_out > 0) {
+              /* close off the frame in progress so we can read back everything we've written */
+              arena_out.Flush();
               /* flush last collision block */ {
                 /* find the max block */
                 size_t max_block = 0UL;
@@ -1476,14 +1467,14 @@ class TMergeDataFileImpl {
                 throw;
               }
               arena_stream.MakeCurBlockCollisionBlock();
-              typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TMyMergeArena my_merge_arena(engine, block_vec, arena_byte_offset, num_notes_out, num_bytes_out);
-              TDataDiskArena<false> my_arena(&my_merge_arena, engine->GetCache<TDataDiskArena<false>::PhysicalCachePageSize>(), priority);
+              typename TMergeDataFileImpl<CanTail, CanTailTombstones>::TMyMergeArena my_merge_arena(engine, block_vec, arena_byte_offset, num_notes_out, num_bytes_out, arena_out.GetFrameIndex());
+              TDataDiskArena<false> my_arena(&my_merge_arena, engine->GetCache<TDataDiskArena<false>::PhysicalCachePageSize>(), priority, true);
               MergeTypeRange(engine,
                              storage_speed,
                              sorter_storage_speed,
                              max_block_cache_read_slots_allowed,
                              temp_file_consol_thresh,
-                             arena_stream,
+                             arena_out,
                              &my_arena,
                              disk_arena_vec,
                              type_boundary_offset_vec_by_file,
@@ -1499,7 +1490,7 @@ class TMergeDataFileImpl {
                              sorter_storage_speed,
                              max_block_cache_read_slots_allowed,
                              temp_file_consol_thresh,
-                             arena_stream,
+                             arena_out,
                              static_cast<TDataDiskArena<false> *const>(nullptr),
                              disk_arena_vec,
                              type_boundary_offset_vec_by_file,
@@ -1530,6 +1521,10 @@ class TMergeDataFileImpl {
           merge_func();
         }
       }
+      assert(arena_out.GetNumBytes() == cur_disk_offset);
+      frame_index_offset_out = arena_out.Finish();
+      frame_index_out = arena_out.ReleaseFrameIndex();
+      end_of_stream = arena_stream.GetOffset();
     }
     /* flush last collision block */ {
       /* find the max block */
@@ -1558,7 +1553,6 @@ class TMergeDataFileImpl {
       completion_trigger.Wait();
     }
     /* now that we know exactly how many bytes we actually used, we can shrink the block vec to free the unused blocks. */
-    const size_t end_of_stream = arena_byte_offset + num_bytes_out;
     const size_t actual_blocks_required = ((end_of_stream - 1UL) / Disk::Util::LogicalBlockSize) + 1UL;
     const size_t num_to_remove = block_vec.Size() - actual_blocks_required;
     /* let's make sure that the max_block that we just flushed isn't in the section that we're freeing... that would be a logic error :-) */
@@ -1572,7 +1566,7 @@ class TMergeDataFileImpl {
   }
 
   template <bool ScanAheadAllowed>
-  static void MergeTypeRangeDepth0(TDataOutStream &arena_stream,
+  static void MergeTypeRangeDepth0(TArenaOutStream<TDataOutStream> &arena_stream,
                                    size_t max_block_cache_read_slots_allowed,
                                    const std::vector<std::unique_ptr<TDataDiskArena<ScanAheadAllowed>>> &disk_arena_vec,
                                    const std::vector<std::vector<size_t>> &type_boundary_offset_vec_by_file,
@@ -1714,7 +1708,7 @@ class TMergeDataFileImpl {
                              TVolume::TDesc::TStorageSpeed sorter_storage_speed,
                              size_t max_block_cache_read_slots_allowed,
                              size_t temp_file_consol_thresh,
-                             TDataOutStream &arena_stream,
+                             TArenaOutStream<TDataOutStream> &arena_stream,
                              TDataDiskArena<MyArenaScanAheadAllowed> *const my_arena,
                              const std::vector<std::unique_ptr<TDataDiskArena<DiskArenaVecScanAheadAllowed>>> &disk_arena_vec,
                              const std::vector<std::vector<size_t>> &type_boundary_offset_vec_by_file,
@@ -1979,6 +1973,12 @@ class TMergeDataFileImpl {
     return HighestSeq;
   }
 
+  /* The number of bytes we wrote, in whole blocks. */
+  inline size_t GetFileLength() const {
+    assert(this);
+    return FileLength;
+  }
+
   private:
 
   /* TODO */
@@ -2121,6 +2121,9 @@ class TMergeDataFileImpl {
           ByteOffsetOfIndexMeta(0UL),
           ByteOffsetOfKeyIndex(0UL),
           FirstKey(true),
+          ByteOffsetOfKeyFilter(0UL),
+          NumKeyFilterWords(0UL),
+          ByteOffsetOfArenaFrameIndex(0UL),
           GenId(gen_id),
           #ifndef NDEBUG
           WrittenBlockSet(written_block_set),
@@ -2159,7 +2162,9 @@ class TMergeDataFileImpl {
         meta_stream << NumHistKeys;  // # History Keys
         meta_stream << ByteOffsetOfKeyIndex;  // Current Key Offset
         meta_stream << NumHashTables;  // # of hash indexes (n)
-
+        meta_stream << ByteOffsetOfKeyFilter;  // Key Filter Offset
+        meta_stream << NumKeyFilterWords;  // # of key filter words
+        meta_stream << ByteOffsetOfArenaFrameIndex;  // Arena Frame Index Offset
 
         for (const auto &hash_table : NumHashFieldsByOffset) {
           meta_stream << hash_table.first << hash_table.second;
@@ -2188,11 +2193,13 @@ class TMergeDataFileImpl {
     }
 
     void ConstructArena(const std::vector<std::vector<size_t>> &type_boundary_offset_vec,
-                        size_t max_total_note_bytes) {
+                        size_t max_total_note_bytes,
+                        TArenaCodec arena_codec) {
       ArenaByteOffset = MakeArena(Engine,
                                   StorageSpeed,
                                   SorterStorageSpeed,
                                   Priority,
+                                  arena_codec,
                                   MaxBlockCacheReadSlotsAllowed,
                                   TempFileConsolThresh,
                                   DiskArenaVec,
@@ -2206,9 +2213,11 @@ class TMergeDataFileImpl {
                                   #endif
                                   max_total_note_bytes,
                                   NumArenaNotes,
-                                  NumArenaBytes);
-      FileSize = ArenaByteOffset + NumArenaBytes;
-      MyArena = std::make_unique<TDataDiskArena<true>>(this, Engine->GetCache<TDataDiskArena<true>::PhysicalCachePageSize>(), Priority);
+                                  NumArenaBytes,
+                                  ByteOffsetOfArenaFrameIndex,
+                                  ArenaFrames);
+      FileSize = ArenaFrames ? ByteOffsetOfArenaFrameIndex + ArenaFrames->GetNumBytesOfIndex() : ArenaByteOffset + NumArenaBytes;
+      MyArena = std::make_unique<TDataDiskArena<true>>(this, Engine->GetCache<TDataDiskArena<true>::PhysicalCachePageSize>(), Priority, true);
     }
 
     void PrepKeyRange(size_t max_keys, TUpdateCollector *update_collector) {
@@ -2333,7 +2342,9 @@ class TMergeDataFileImpl {
       size_t total_bytes_required = 0UL;
       std::unordered_map<size_t, std::shared_ptr<const TBufBlock>> collision_map {};
       size_t hash_index_byte_offset = BlockVec->Size() * LogicalBlockSize;
+      size_t num_filter_keys = 0UL;
       for (const auto &collection : HashCollectorVec) {
+        num_filter_keys += collection->GetSize();
         /* collision at beginning of this hash index */
         auto ret = collision_map.insert(std::make_pair((hash_index_byte_offset + total_bytes_required) / LogicalBlockSize, nullptr));
         if (ret.second) { // fresh insert
@@ -2351,6 +2362,17 @@ class TMergeDataFileImpl {
         }
       }
       assert(NumHashFieldsByOffset.size() == NumHashTables);
+      /* the key filter follows the last hash index, just as in TDataFile */
+      Disk::Util::TBloomFilter key_filter(num_filter_keys);
+      ByteOffsetOfKeyFilter = hash_index_byte_offset + total_bytes_required;
+      NumKeyFilterWords = key_filter.GetWords().size();
+      total_bytes_required += key_filter.GetNumBytes();
+      if ((hash_index_byte_offset + total_bytes_required) % LogicalBlockSize != 0) {
+        auto ret = collision_map.insert(std::make_pair((hash_index_byte_offset + total_bytes_required) / LogicalBlockSize, nullptr));
+        if (ret.second) { // fresh insert
+          ret.first->second = std::shared_ptr<const TBufBlock>(new TBufBlock());
+        }
+      }
       size_t max_blocks_required = ceil(static_cast<double>(total_bytes_required) / LogicalBlockSize);
       const size_t total_num_blocks_required = BlockVec->Size() + max_blocks_required;
       Engine->AppendReserveBlocks(StorageSpeed, max_blocks_required, *BlockVec);
@@ -2369,6 +2391,7 @@ class TMergeDataFileImpl {
         for (typename THashCollector::TCursor orig_csr(collection.get(), MaxBlockCacheReadSlotsAllowed); orig_csr; ++orig_csr) {
           const THashObj &obj = *orig_csr;
           modded_hash_collector.Emplace(obj.Core, obj.Hash % num_hash_fields, obj.Offset);
+          key_filter.Insert(obj.Hash);
         }
         typename THashCollector::TCursor hash_csr(&modded_hash_collector, MaxBlockCacheReadSlotsAllowed);
         /* do the first pass over the hash map */ {
@@ -2482,6 +2505,26 @@ class TMergeDataFileImpl {
         }
         hash_index_byte_offset += num_hash_fields * TDataFile::HashEntrySize;
       }
+      /* write the key filter */ {
+        assert(hash_index_byte_offset == ByteOffsetOfKeyFilter);
+        if (!key_filter.IsEmpty()) {
+          TDataOutStream stream(HERE,
+                                Source::MergeDataFileKeyFilter,
+                                Engine->GetVolMan(),
+                                ByteOffsetOfKeyFilter,
+                                *BlockVec,
+                                collision_map,
+                                completion_trigger,
+                                Priority,
+                                true /* do_cache */
+                                #ifndef NDEBUG
+                                ,WrittenBlockSet
+                                #endif
+                                );
+          stream.Write(key_filter.GetWords().data(), key_filter.GetNumBytes());
+          FileSize = stream.GetOffset();
+        }
+      }
       /* flush collision blocks */ {
         for (auto iter : collision_map) {
           assert(iter.first < BlockVec->Size());
@@ -2567,6 +2610,7 @@ class TMergeDataFileImpl {
     std::vector<std::unique_ptr<TArenaKeeperSorter>> ArenaKeeperVec;
     std::vector<std::unique_ptr<TRemapSorter>> ArenaRemapSorterVec;
     TDataFile::TTypeBoundaryOffsetVec ArenaTypeBoundaryOffsetVec;
+    std::unique_ptr<TArenaFrameIndex> ArenaFrames;
     std::unique_ptr<TDataDiskArena<true>> MyArena;
 
     TRemapIndex &MainArenaRemapIndex;
@@ -2601,6 +2645,11 @@ class TMergeDataFileImpl {
 
     std::vector<std::pair<size_t, size_t>> NumHashFieldsByOffset;
 
+    size_t ByteOffsetOfKeyFilter;
+    size_t NumKeyFilterWords;
+
+    size_t ByteOffsetOfArenaFrameIndex;
+
     TUpdateCollector *UpdateCollector;
 
     size_t GenId;
@@ -2648,6 +2697,11 @@ class TMergeDataFileImpl {
       return NumArenaBytes;
     }
 
+    virtual const TArenaFrameIndex *GetArenaFrameIndex() const override {
+      assert(this);
+      return ArenaFrames.get();
+    }
+
     public:
 
     std::function<Atom::TCore::TOffset(Atom::TCore::TOffset)> KeyRemapper;
@@ -2675,8 +2729,12 @@ class TMergeDataFileImpl {
   /* TODO */
   TBlockVec BlockVec;
 
+  /* TODO */
+  TArenaCodec ArenaCodec;
+
   /* TODO */
   size_t MainArenaByteOffset;
+  size_t MainArenaFrameIndexOffset;
   TRemapIndex MainArenaRemapIndex;
   TTypeBoundaryOffsetVec MainArenaTypeBoundaryOffsetVec;
 
@@ -2726,24 +2784,29 @@ TMergeDataFile::TMergeDataFile(Util::TEngine *engine,
                                size_t max_block_cache_read_slots_allowed,
                                size_t temp_file_consol_thresh,
                                bool can_tail,
-                               bool can_tail_tombstone) {
+                               bool can_tail_tombstone,
+                               const std::vector<Fiber::TRunner *> &helper_runner_vec,
+                               TArenaCodec arena_codec) {
   if (can_tail) {
     if (can_tail_tombstone) {
-      TMergeDataFileImpl<true, true> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+      TMergeDataFileImpl<true, true> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, helper_runner_vec, arena_codec);
       NumKeys = merge_file.GetNumKeys();
       LowestSeq = merge_file.GetLowestSequence();
       HighestSeq = merge_file.GetHighestSequence();
+      FileLength = merge_file.GetFileLength();
     } else {
-      TMergeDataFileImpl<true, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+      TMergeDataFileImpl<true, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, helper_runner_vec, arena_codec);
       NumKeys = merge_file.GetNumKeys();
       LowestSeq = merge_file.GetLowestSequence();
       HighestSeq = merge_file.GetHighestSequence();
+      FileLength = merge_file.GetFileLength();
     }
   } else {
-    TMergeDataFileImpl<false, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh);
+    TMergeDataFileImpl<false, false> merge_file(engine, storage_speed, file_uuid, gen_vec, file_uid, gen_id, release_up_to, priority, max_block_cache_read_slots_allowed, temp_file_consol_thresh, helper_runner_vec, arena_codec);
     NumKeys = merge_file.GetNumKeys();
     LowestSeq = merge_file.GetLowestSequence();
     HighestSeq = merge_file.GetHighestSequence();
+    FileLength = merge_file.GetFileLength();
     assert(!can_tail_tombstone);
   }
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <orly/indy/disk/out_stream.h>
 #include <orly/indy/disk/read_file.h>
 #include <orly/indy/disk/util/index_manager.h>
+#include <orly/indy/fiber/fiber.h>
 #include <orly/indy/memory_layer.h>
 #include <orly/sabot/all.h>
 
@@ -42,7 +43,9 @@ namespace Orly {
         NO_COPY(TMergeDataFile);
         public:
 
-        /* TODO */
+        /* Each source file's key remapping is independent of the others', so given helper runners we spread that work across them.
+           The calling fiber waits for them, and does it all itself if there are none.
+           The merged file's arenas are stored with the given codec, whatever the source files used. */
         TMergeDataFile(Util::TEngine *engine,
                        Disk::Util::TVolume::TDesc::TStorageSpeed storage_speed,
                        const Base::TUuid &file_uuid,
@@ -54,7 +57,9 @@ namespace Orly {
                        size_t max_block_cache_read_slots_allowed,
                        size_t temp_file_consol_thresh,
                        bool can_tail,
-                       bool can_tail_tombstone);
+                       bool can_tail_tombstone,
+                       const std::vector<Fiber::TRunner *> &helper_runner_vec = std::vector<Fiber::TRunner *>(),
+                       TArenaCodec arena_codec = TArenaCodec::None);
 
         /* TODO */
         inline size_t GetNumKeys() const {
@@ -74,11 +79,18 @@ namespace Orly {
           return HighestSeq;
         }
 
+        /* The number of bytes we wrote, in whole blocks. */
+        inline size_t GetFileLength() const {
+          assert(this);
+          return FileLength;
+        }
+
         private:
 
         size_t NumKeys;
         TSequenceNumber LowestSeq;
         TSequenceNumber HighestSeq;
+        size_t FileLength;
 
       };  // TMergeDataFile
 
@@ -18,6 +18,8 @@
 
 #include <orly/indy/disk/merge_data_file.h>
 
+#include <thread>
+
 #include <valgrind/callgrind.h>
 
 #include <base/scheduler.h>
@@ -558,3 +560,65 @@ FIXTURE(JumpGrowingMainArena) {
     cond.notify_one();
   });
 }
+
+FIXTURE(HelperRunners) {
+  TFiberTestRunner runner([](std::mutex &mut, std::condition_variable &cond, bool &fin, Fiber::TRunner::TRunnerCons &runner_cons) {
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    TScheduler scheduler(TScheduler::TPolicy(10, 10, milliseconds(10)));
+
+    Sim::TMemEngine mem_engine(&scheduler,
+                               256 /* disk space: 256MB */,
+                               256 /* slow disk space: 256MB */,
+                               16384 /* page cache slots: 64MB */,
+                               1 /* num page lru */,
+                               1024 /* block cache slots: 64MB */,
+                               1 /* num block lru */);
+
+    Base::TUuid file_id(TUuid::TimeAndMAC);
+    TSuprena arena;
+    TSequenceNumber seq_num = 0U;
+    Base::TUuid int_idx(Base::TUuid::Twister);
+    /* three data files, each overwriting the last */
+    for (size_t gen_id = 1UL; gen_id <= 3UL; ++gen_id) {
+      TMockMem mem_layer;
+      for (int64_t i = 0; i < 12; ++i) {
+        Insert(mem_layer, ++seq_num, int_idx, TKey(i * 10 + static_cast<int64_t>(gen_id), &arena, state_alloc), i);
+      }
+      TDataFile data_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, &mem_layer, file_id, gen_id, 20UL, 0U, RealTime);
+    }
+    std::vector<std::unique_ptr<Fiber::TRunner>> helper_vec;
+    std::vector<Fiber::TRunner *> helper_ptr_vec;
+    std::vector<std::unique_ptr<std::thread>> thread_vec;
+    for (size_t i = 0; i < 2UL; ++i) {
+      helper_vec.emplace_back(new Fiber::TRunner(runner_cons));
+      helper_ptr_vec.push_back(helper_vec.back().get());
+      thread_vec.emplace_back(new std::thread([runner = helper_vec.back().get()]() { runner->Run(); }));
+    }
+    /* merge them, spreading the remapping across the helpers */ {
+      TMergeDataFile merge_file(mem_engine.GetEngine(), TVolume::TDesc::Fast, file_id, vector<size_t>{1UL, 2UL, 3UL}, file_id, 4UL, 0U, Low, 16384, 20UL, false, false, helper_ptr_vec);
+      EXPECT_EQ(merge_file.GetNumKeys(), 12UL);
+    }
+    for (auto &helper : helper_vec) {
+      helper->ShutDown();
+    }
+    for (auto &t : thread_vec) {
+      t->join();
+    }
+    /* the newest value of each key is current */ {
+      TReader reader(HERE, mem_engine.GetEngine(), file_id, 4UL);
+      TReader::TArena main_arena(&reader, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+      TReader::TIndexFile idx_file(&reader, int_idx, RealTime);
+      TReader::TArena index_arena(&idx_file, mem_engine.GetEngine()->GetCache<TReader::PhysicalCachePageSize>(), RealTime);
+      int64_t expected = 0L;
+      for (TReader::TIndexFile::TKeyCursor cur_key_csr(&idx_file); cur_key_csr; ++cur_key_csr, ++expected) {
+        const TReader::TIndexFile::TKeyItem &item = *cur_key_csr;
+        EXPECT_EQ(TKey(item.Key, &index_arena), TKey(make_tuple(expected), &arena, state_alloc));
+        EXPECT_EQ(TKey(item.Value, &main_arena), TKey(expected * 10 + 3L, &arena, state_alloc));
+      }
+      EXPECT_EQ(expected, 12L);
+    }
+    std::lock_guard<std::mutex> lock(mut);
+    fin = true;
+    cond.notify_one();
+  }, 2UL);
+}
@@ -73,6 +73,8 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
   size_t num_arena_type_boundaries;
   size_t main_arena_byte_offset;
   size_t byte_offset_of_update_entries;
+  size_t arena_codec;
+  size_t main_arena_frame_index_offset;
   in_stream.Read(block_vec_size);  // # of blocks
   in_stream.Read(old_num_meta_blocks);  // # of meta-blocks
   in_stream.Read(old_num_sequential_block_pairings);  // # of #block / block_id pairings
@@ -83,6 +85,8 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
   in_stream.Read(num_arena_type_boundaries);  // # of arena type boundaries
   in_stream.Read(main_arena_byte_offset);  // byte offset of main arena
   in_stream.Read(byte_offset_of_update_entries);  // offset of update index
+  in_stream.Read(arena_codec);  // arena codec
+  in_stream.Read(main_arena_frame_index_offset);  // offset of main arena frame index
   std::vector<size_t> main_arena_type_boundary_offset_vec;
   const size_t to_skip = (old_num_meta_blocks * sizeof(size_t)) + (old_num_sequential_block_pairings * 2UL * sizeof(size_t));
   in_stream.Skip(to_skip); /* meta blocks + sequential block pairings */
@@ -135,6 +139,8 @@ std::pair<size_t, size_t> TMetaRewriter::RewriteMetaData(Disk::Util::TEngine *en
     out << num_arena_type_boundaries;  // # of arena type boundaries
     out << main_arena_byte_offset;  // byte offset of main arena
     out << byte_offset_of_update_entries;  // offset of update index
+    out << arena_codec;  // arena codec
+    out << main_arena_frame_index_offset;  // offset of main arena frame index
     /* write out the meta-block ids */
     for (auto meta_block_id : meta_block_vec) {
       out << meta_block_id;
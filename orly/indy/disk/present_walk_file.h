@@ -139,10 +139,7 @@ namespace Orly {
                 Stream(HERE, Source::PresentWalk, RealTime, MyReadFile, engine->GetPageCache(), 0),
                 IndexStream(HERE, Source::PresentWalk, RealTime, MyReadFile, engine->GetPageCache(), 0),
                 Valid(true), Cached(false), LoaderObj(loader_obj), NextWalker(nullptr) {
-            auto pos = MyReadFile->GetIndexByIdMap().find(IndexId);
-            if (pos != MyReadFile->GetIndexByIdMap().end()) {
-              IndexFile = pos->second.get();
-            }
+            IndexFile = MyReadFile->TryGetIndexFile(IndexId);
             /* The unique ptr to index_file is a temporary solution. */
             if (IndexFile) {
               IndexArena = std::make_unique<TArena>(IndexFile, engine->GetCache<PhysicalCachePageSize>(), RealTime);
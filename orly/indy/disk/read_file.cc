@@ -18,9 +18,59 @@
 
 #include <orly/indy/disk/read_file.h>
 
+#include <mutex>
+#include <vector>
+
 using namespace Orly::Indy::Disk;
 using namespace Orly::Indy::Disk::Util;
 
+__thread TKeyFilterCounts *Orly::Indy::Disk::LocalKeyFilterCounts = nullptr;
+
+/* A thread's counts, padded out to a cache line of their own. */
+struct TLocalKeyFilterCounts {
+  TKeyFilterCounts Counts;
+  size_t Pad[6];
+};
+
+/* Guards the members below. */
+static std::mutex KeyFilterCountMutex;
+
+/* Every thread's counts, ever.  Threads don't outnumber cores by much, so we don't bother reclaiming these. */
+static std::vector<TLocalKeyFilterCounts *> KeyFilterCounts;
+
+/* The sums of the counts as of the last exchange of each. */
+static size_t NegativeCountTotal = 0UL, FalsePositiveCountTotal = 0UL;
+
+TKeyFilterCounts *Orly::Indy::Disk::NewLocalKeyFilterCounts() {
+  TLocalKeyFilterCounts *local = new TLocalKeyFilterCounts;
+  local->Counts.Negatives = 0UL;
+  local->Counts.FalsePositives = 0UL;
+  std::lock_guard<std::mutex> lock(KeyFilterCountMutex);
+  KeyFilterCounts.push_back(local);
+  return &local->Counts;
+}
+
+/* The total of the threads' counts of the given kind since the last call, which left off at the given total. */
+static size_t ExchangeKeyFilterCount(std::atomic<size_t> TKeyFilterCounts::*member, size_t &last_total) {
+  std::lock_guard<std::mutex> lock(KeyFilterCountMutex);
+  /* The counts only go up, so rather than reset them underneath their threads, we remember where we left off. */
+  size_t total = 0UL;
+  for (TLocalKeyFilterCounts *local : KeyFilterCounts) {
+    total += (local->Counts.*member).load(std::memory_order_relaxed);
+  }
+  const size_t delta = total - last_total;
+  last_total = total;
+  return delta;
+}
+
+size_t Orly::Indy::Disk::ExchangeKeyFilterNegativeCount() {
+  return ExchangeKeyFilterCount(&TKeyFilterCounts::Negatives, NegativeCountTotal);
+}
+
+size_t Orly::Indy::Disk::ExchangeKeyFilterFalsePositiveCount() {
+  return ExchangeKeyFilterCount(&TKeyFilterCounts::FalsePositives, FalsePositiveCountTotal);
+}
+
 template<>
 __thread size_t TReadFile<LogicalPageSize, LogicalBlockSize, PhysicalBlockSize, CheckedPage>::HashHitCount;
 
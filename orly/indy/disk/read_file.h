@@ -21,14 +21,18 @@
 #include <cassert>
 
 #include <algorithm>
+#include <atomic>
 #include <ostream>
 
 #include <base/class_traits.h>
+#include <base/likely.h>
 #include <inv_con/unordered_multimap.h>
 #include <server/daemonize.h>
 #include <orly/atom/kit2.h>
+#include <orly/indy/disk/arena_frame.h>
 #include <orly/indy/disk/in_file.h>
 #include <orly/indy/disk/indy_util_reporter.h>
+#include <orly/indy/disk/util/bloom_filter.h>
 #include <orly/indy/disk/util/cache.h>
 #include <orly/indy/disk/util/engine.h>
 #include <orly/indy/update.h>
@@ -119,6 +123,19 @@ namespace Orly {
         /* TODO */
         virtual Atom::TCore::TOffset GetNumBytesOfArena() const = 0;
 
+        /* The frames the arena is compressed in, or null if its notes are stored as-is. */
+        virtual const TArenaFrameIndex *GetArenaFrameIndex() const {
+          assert(this);
+          return nullptr;
+        }
+
+        /* The number of bytes the arena's notes take up in the file.  Fewer than GetNumBytesOfArena() if the arena is compressed. */
+        size_t GetNumStoredBytesOfArena() const {
+          assert(this);
+          const TArenaFrameIndex *frames = GetArenaFrameIndex();
+          return frames ? frames->GetNumStoredBytes() : GetNumBytesOfArena();
+        }
+
         protected:
 
         /* TODO */
@@ -132,6 +149,42 @@ namespace Orly {
       /* TODO */
       static constexpr size_t DiskArenaMaxCacheSize = 128;
 
+      /* The number of hash probes the per-index key filters have saved us, and the number they let through only for the probe to miss.
+         These are shared by every read file.  The server's reporter reads them, each call getting the counts since the last.
+         Both come on the hottest read path, so each thread counts its own.  A thread's counts live on their own cache line, registered
+         the first time the thread bumps one and never freed, so only the thread itself writes there. */
+      struct TKeyFilterCounts {
+
+        /* Keys the filter turned away. */
+        std::atomic<size_t> Negatives;
+
+        /* Keys the filter let through which the hash probe then missed. */
+        std::atomic<size_t> FalsePositives;
+
+      };  // TKeyFilterCounts
+
+      /* The calling thread's counts, or null if it hasn't bumped any yet. */
+      extern __thread TKeyFilterCounts *LocalKeyFilterCounts;
+
+      /* Register counts for the calling thread. */
+      TKeyFilterCounts *NewLocalKeyFilterCounts();
+
+      /* The total of the threads' negative counts since the last call. */
+      size_t ExchangeKeyFilterNegativeCount();
+
+      /* The total of the threads' false positive counts since the last call. */
+      size_t ExchangeKeyFilterFalsePositiveCount();
+
+      /* Count one against the calling thread's counts.  Nobody else writes them, so this needs no locked instruction. */
+      inline void BumpKeyFilterCount(std::atomic<size_t> TKeyFilterCounts::*member) {
+        TKeyFilterCounts *counts = LocalKeyFilterCounts;
+        if (unlikely(!counts)) {
+          LocalKeyFilterCounts = counts = NewLocalKeyFilterCounts();
+        }
+        std::atomic<size_t> &count = counts->*member;
+        count.store(count.load(std::memory_order_relaxed) + 1UL, std::memory_order_relaxed);
+      }
+
       /* TODO */
       template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t StreamLocalCacheSize, bool ScanAheadAllowed>
       class TDiskArena
@@ -257,15 +310,17 @@ namespace Orly {
 
         };  // TCursor
 
-        /* TODO */
-        TDiskArena(TArenaInFile *file, Util::TCache<PhysicalCachePageSize> *cache, DiskPriority priority)
+        /* If 'no_pollute', the notes we read are only passing through (to a merge, say); see TStream. */
+        TDiskArena(TArenaInFile *file, Util::TCache<PhysicalCachePageSize> *cache, DiskPriority priority, bool no_pollute = false)
             : TArena(true),
               File(file),
               Priority(priority),
               Cache(cache),
+              NoPollute(no_pollute),
               StartOffset(file->GetByteOffsetOfArena()),
-              Stream(HERE, Source::DiskArena, priority, StartOffset + file->GetNumBytesOfArena(), file, cache, StartOffset),
-              NumNotes(file->GetNumArenaNotes()) {
+              Stream(HERE, Source::DiskArena, priority, StartOffset + file->GetNumStoredBytesOfArena(), file, cache, StartOffset, no_pollute),
+              NumNotes(file->GetNumArenaNotes()),
+              Frames(file->GetArenaFrameIndex()) {
           assert(file);
         }
 
@@ -291,6 +346,13 @@ namespace Orly {
 
         private:
 
+        /* Pin a note of a compressed arena.  If the note lies within a single frame, we point into the decompressed frame and hold
+           it in data2; otherwise we assemble a copy of the note.  A note_size of zero means we don't know it yet. */
+        inline const Atom::TCore::TNote *TryAcquireFramedNote(Atom::TCore::TOffset offset, size_t note_size, void *&data1, void *&data2, void *&data3);
+
+        /* Copy note bytes out of a compressed arena, across as many frames as it takes. */
+        inline void ReadFramed(Atom::TCore::TOffset offset, void *out, size_t size);
+
         /* TODO */
         TArenaInFile *File;
 
@@ -300,6 +362,9 @@ namespace Orly {
         /* TODO */
         Util::TCache<PhysicalCachePageSize> *Cache;
 
+        /* See the constructor. */
+        bool NoPollute;
+
         /* TODO */
         TCompletionTrigger SyncTrigger;
 
@@ -312,6 +377,9 @@ namespace Orly {
         /* TODO */
         size_t NumNotes;
 
+        /* The frames of the arena, or null if it isn't compressed. */
+        const TArenaFrameIndex *Frames;
+
       };  // TDiskArena
 
       /* TODO */
@@ -358,6 +426,18 @@ namespace Orly {
           }
         }
 
+        /* The frames of the main arena, or null if it isn't compressed. */
+        inline virtual const TArenaFrameIndex *GetArenaFrameIndex() const override {
+          assert(this);
+          return MainArenaFrames.get();
+        }
+
+        /* How the arenas of this file are stored. */
+        inline TArenaCodec GetArenaCodec() const {
+          assert(this);
+          return ArenaCodec;
+        }
+
         /* TODO */
         static __thread size_t HashHitCount;
 
@@ -423,6 +503,8 @@ namespace Orly {
             # of arena type boundaries
             offset of main arena
             offset of update index
+            arena codec
+            offset of main arena frame index
           */
           in_stream.Read(NumBlocks);
           in_stream.Read(NumMetaBlocks);
@@ -434,6 +516,10 @@ namespace Orly {
           in_stream.Read(NumMainArenaTypeBoundaries);
           in_stream.Read(ByteOffsetOfMainArena);
           in_stream.Read(ByteOffsetOfUpdateIndex);
+          size_t arena_codec;
+          in_stream.Read(arena_codec);
+          ArenaCodec = static_cast<TArenaCodec>(arena_codec);
+          in_stream.Read(ByteOffsetOfMainArenaFrameIndex);
 
           /* meta block ids */
           size_t at_offset_block = NumBlocks - NumMetaBlocks;
@@ -460,14 +546,16 @@ namespace Orly {
             in_stream.Read(offset);
             //std::cout << "Index [" << index_id << "] @ [" << offset << "]" << std::endl;
             IndexOffsetById.emplace(index_id, offset);
-            auto idx_ptr = std::make_unique<TIndexFile>(this, index_id, offset, Priority);
-            IndexByOffset.insert(std::make_pair(offset, idx_ptr.get()));
-            IndexById.emplace(index_id, std::move(idx_ptr));
+            IndexIdByOffset.insert(std::make_pair(offset, index_id));
           }
           for (size_t i = 0; i < NumMainArenaTypeBoundaries; ++i) {
             in_stream.Read(offset);
             MainArenaTypeBoundaryOffsetVec.emplace_back(offset);
           }
+          if (ByteOffsetOfMainArenaFrameIndex) {
+            in_stream.GoTo(ByteOffsetOfMainArenaFrameIndex);
+            MainArenaFrames = TArenaFrameIndex::Read(in_stream, ArenaCodec);
+          }
         }
 
         protected:
@@ -541,21 +629,11 @@ namespace Orly {
           return ByteOffsetOfUpdateIndex;
         }
 
-        /* TODO */
-        void ForEachIndex(const std::function<void (const Base::TUuid &, size_t)> &cb) const {
-          for (const auto &idx : IndexOffsetById) {
-            cb(idx.first, idx.second);
-          }
-        }
-
         /* TODO */
         bool FindInHash(const Base::TUuid &index_id, const TKey &key, size_t &out_offset) const {
           assert(this);
-          auto ret = IndexById.find(index_id);
-          if (ret != IndexById.end()) {
-            return ret->second->FindInHash(key, out_offset);
-          }
-          return false;
+          const TIndexFile *index_file = TryGetIndexFile(index_id);
+          return index_file && index_file->FindInHash(key, out_offset);
         }
 
         public:
@@ -731,6 +809,9 @@ namespace Orly {
             in_stream.Read(NumHistKeys);
             in_stream.Read(ByteOffsetOfKeyIndex);
             in_stream.Read(NumHashTables);
+            in_stream.Read(ByteOffsetOfKeyFilter);
+            in_stream.Read(NumKeyFilterWords);
+            in_stream.Read(ByteOffsetOfArenaFrameIndex);
             assert(NumArenaBytes > 0UL);
 
             size_t offset, num_hash_fields;
@@ -744,6 +825,17 @@ namespace Orly {
               in_stream.Read(offset);
               ArenaTypeBoundaryByOffset.emplace_back(offset);
             }
+            /* keep the key filter in memory, so that a miss costs us no reads at all */
+            if (NumKeyFilterWords) {
+              std::vector<uint64_t> &words = KeyFilter.GetWords();
+              words.resize(NumKeyFilterWords);
+              in_stream.GoTo(ByteOffsetOfKeyFilter);
+              in_stream.Read(words.data(), NumKeyFilterWords * sizeof(uint64_t));
+            }
+            if (ByteOffsetOfArenaFrameIndex) {
+              in_stream.GoTo(ByteOffsetOfArenaFrameIndex);
+              ArenaFrames = TArenaFrameIndex::Read(in_stream, File->ArenaCodec);
+            }
           }
 
           /* TODO */
@@ -764,6 +856,10 @@ namespace Orly {
               const size_t byte_offset_of_hash_table = idx.first;
               const size_t num_hash_fields = idx.second;
               const size_t hash_to_look_for = key.GetHash();
+              if (!KeyFilter.MayContain(hash_to_look_for)) {
+                BumpKeyFilterCount(&TKeyFilterCounts::Negatives);
+                return false;
+              }
               const size_t modded_hash = hash_to_look_for % num_hash_fields;
 
               void *key_state_alloc = alloca(Sabot::State::GetMaxStateSize() * 2);
@@ -785,10 +881,10 @@ namespace Orly {
                       return true;
                     }
                   } else if (cur_hash % num_hash_fields > modded_hash) {
-                    return false;
+                    return OnHashMiss();
                   }
                 } else {
-                  return false;
+                  return OnHashMiss();
                 }
               }
               in_stream.GoTo(byte_offset_of_hash_table);
@@ -803,10 +899,10 @@ namespace Orly {
                       return true;
                     }
                   } else if (cur_hash % num_hash_fields > modded_hash) {
-                    return false;
+                    return OnHashMiss();
                   }
                 } else {
-                  return false;
+                  return OnHashMiss();
                 }
               }
               syslog(LOG_ERR, "TReadFile::TIndexFile::FindInHash() Should not happen, implies hash table is completely full, modded_hash = [%ld], num_hash_fields[%ld]", modded_hash, num_hash_fields);
@@ -877,6 +973,12 @@ namespace Orly {
             return NumArenaBytes;
           }
 
+          /* The frames of this index's arena, or null if it isn't compressed. */
+          inline virtual const TArenaFrameIndex *GetArenaFrameIndex() const override {
+            assert(this);
+            return ArenaFrames.get();
+          }
+
           /* TODO */
           inline const std::vector<size_t> &GetTypeBoundaryOffsetVec() const {
             assert(this);
@@ -919,8 +1021,23 @@ namespace Orly {
             return NumHashFieldsByOffset;
           }
 
+          /* TODO */
+          inline const Util::TBloomFilter &GetKeyFilter() const {
+            assert(this);
+            return KeyFilter;
+          }
+
           private:
 
+          /* The hash probe came up empty.  If the key filter let the key through, that was a false positive. */
+          bool OnHashMiss() const {
+            assert(this);
+            if (!KeyFilter.IsEmpty()) {
+              BumpKeyFilterCount(&TKeyFilterCounts::FalsePositives);
+            }
+            return false;
+          }
+
           /* TODO */
           inline virtual size_t GetByteOffsetOfArena() const override {
             assert(this);
@@ -976,19 +1093,47 @@ namespace Orly {
           size_t NumHistKeys;
           size_t ByteOffsetOfKeyIndex;
           size_t NumHashTables;
+          size_t ByteOffsetOfKeyFilter;
+          size_t NumKeyFilterWords;
+          size_t ByteOffsetOfArenaFrameIndex;
 
           /* TODO */
           std::vector<std::pair<size_t, size_t>> NumHashFieldsByOffset;
 
+          /* The hashes of every key prefix in this index.  Empty if the file has none, in which case it admits every key. */
+          Util::TBloomFilter KeyFilter;
+
           /* TODO */
           std::vector<size_t> ArenaTypeBoundaryByOffset;
 
+          /* The frames of this index's arena, or null if it isn't compressed. */
+          std::unique_ptr<TArenaFrameIndex> ArenaFrames;
+
         };  // TIndexFile
 
         /* TODO */
-        inline const std::unordered_map<Base::TUuid, std::unique_ptr<TIndexFile>> &GetIndexByIdMap() {
+        void ForEachIndex(const std::function<void (const Base::TUuid &, size_t)> &cb) const {
+          for (const auto &idx : IndexOffsetById) {
+            cb(idx.first, idx.second);
+          }
+        }
+
+        /* The given index of this file, or null if the file has none.  We read an index's meta data (and its key filter, which is the
+           bulk of it) only when the index is first asked for, so opening a file costs a single read of its header no matter how many
+           indices it holds. */
+        TIndexFile *TryGetIndexFile(const Base::TUuid &index_id) const {
           assert(this);
-          return IndexById;
+          auto pos = IndexById.find(index_id);
+          if (pos != IndexById.end()) {
+            return pos->second.get();
+          }
+          auto offset_pos = IndexOffsetById.find(index_id);
+          if (offset_pos == IndexOffsetById.end()) {
+            return nullptr;
+          }
+          /* loading may block this fiber, and another may load the same index meanwhile; the first one in wins */
+          auto index_file = std::make_unique<TIndexFile>(this, index_id, offset_pos->second, Priority);
+          return IndexById.emplace(index_id, std::move(index_file)).first->second.get();
         }
 
         protected:
@@ -1017,6 +1162,11 @@ namespace Orly {
         size_t NumMainArenaTypeBoundaries;
         size_t ByteOffsetOfMainArena;
         size_t ByteOffsetOfUpdateIndex;
+        TArenaCodec ArenaCodec;
+        size_t ByteOffsetOfMainArenaFrameIndex;
+
+        /* The frames of the main arena, or null if it isn't compressed. */
+        std::unique_ptr<TArenaFrameIndex> MainArenaFrames;
 
         /* TODO */
         static constexpr size_t MaxMetaCacheSize = 64;
@@ -1027,11 +1177,11 @@ namespace Orly {
         /* TODO */
         std::unordered_map<Base::TUuid, size_t> IndexOffsetById;
 
-        /* TODO */
-        std::unordered_map<Base::TUuid, std::unique_ptr<TIndexFile>> IndexById;
+        /* The indices we've loaded so far.  See TryGetIndexFile(). */
+        mutable std::unordered_map<Base::TUuid, std::unique_ptr<TIndexFile>> IndexById;
 
         /* TODO */
-        std::map<size_t, TIndexFile *> IndexByOffset;
+        std::map<size_t, Base::TUuid> IndexIdByOffset;
 
         /* TODO */
         std::vector<size_t> MainArenaTypeBoundaryOffsetVec;
@@ -1156,13 +1306,16 @@ namespace Orly {
       /*** Inline ***/
 
       template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t LocalCacheSize, bool ScanAheadAllowed>
-      inline void TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::ReleaseNote(const Atom::TCore::TNote *note, Atom::TCore::TOffset offset, void *data1, void */*data2*/, void *data3) {
+      inline void TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::ReleaseNote(const Atom::TCore::TNote *note, Atom::TCore::TOffset offset, void *data1, void *data2, void *data3) {
         assert(this);
         if (data1) { /* This data fit in the block, release the block. */
           Cache->Release(reinterpret_cast<typename Util::TCache<PhysicalCachePageSize>::TSlot *>(data1), reinterpret_cast<size_t>(data3));
           //File->GetService()->ReleaseBuf(reinterpret_cast<TPageCache::TObj *>(data));
+        } else if (data2) { /* This data fit in a decompressed frame, release the frame. */
+          assert(Frames);
+          reinterpret_cast<Util::TFrameCache::TFrame *>(data2)->Release();
         } else { /* the data did not fit in the block, free the buffer we allocated. */
-          assert(offset / DataChunkSize != (offset + note->GetRawSize() + sizeof(Atom::TCore::TNote)) / DataChunkSize);
+          assert(Frames || offset / DataChunkSize != (offset + note->GetRawSize() + sizeof(Atom::TCore::TNote)) / DataChunkSize);
           free(const_cast<Atom::TCore::TNote *>(note));
         }
       }
@@ -1170,6 +1323,9 @@ namespace Orly {
       template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t LocalCacheSize, bool ScanAheadAllowed>
       inline const Atom::TCore::TNote *TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::TryAcquireNote(Atom::TCore::TOffset offset, void *&data1, void *&data2, void *&data3) {
         assert(this);
+        if (Frames) {
+          return TryAcquireFramedNote(offset, 0UL, data1, data2, data3);
+        }
         const size_t note_offset = StartOffset + offset;
         assert(note_offset < File->GetFileLength());
         Stream.GoTo(note_offset);
@@ -1188,7 +1344,7 @@ namespace Orly {
         if (note_offset / DataChunkSize == (note_offset + note_size) / DataChunkSize) {
           try {
             typename Util::TCache<PhysicalCachePageSize>::TSlot *data_slot;
-            typename Util::TCache<PhysicalCachePageSize>::TSlot *const main_slot = Cache->Get(loaded_page_id, data_slot);
+            typename Util::TCache<PhysicalCachePageSize>::TSlot *const main_slot = Cache->Get(loaded_page_id, data_slot, NoPollute);
             data1 = main_slot;
             data2 = data_slot;
             data3 = reinterpret_cast<void *>(loaded_page_id);
@@ -1207,6 +1363,7 @@ namespace Orly {
           return ret;
         } else {
           data1 = nullptr;
+          data2 = nullptr;
           Atom::TCore::TNote *note_ptr = nullptr;
           if ((note_ptr = reinterpret_cast<Atom::TCore::TNote *>(malloc(note_size))) == 0) {
             syslog(LOG_EMERG, "bad alloc in TDiskArena::TryAcquireNote [%ld]", note_size);
@@ -1229,6 +1386,9 @@ namespace Orly {
       template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t LocalCacheSize, bool ScanAheadAllowed>
       inline const Atom::TCore::TNote *TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::TryAcquireNote(Atom::TCore::TOffset offset, const size_t note_size, void *&data1, void *&data2, void *&data3) {
         assert(this);
+        if (Frames) {
+          return TryAcquireFramedNote(offset, note_size, data1, data2, data3);
+        }
         const size_t note_offset = StartOffset + offset;
         Stream.GoTo(note_offset);
         #ifndef NDEBUG
@@ -1248,7 +1408,7 @@ namespace Orly {
           try {
             const size_t loaded_page_id = Stream.GetLoadedPageId();
             typename Util::TCache<PhysicalCachePageSize>::TSlot *data_slot;
-            typename Util::TCache<PhysicalCachePageSize>::TSlot *const main_slot = Cache->Get(loaded_page_id, data_slot);
+            typename Util::TCache<PhysicalCachePageSize>::TSlot *const main_slot = Cache->Get(loaded_page_id, data_slot, NoPollute);
             data1 = main_slot;
             data2 = data_slot;
             data3 = reinterpret_cast<void *>(loaded_page_id);
@@ -1264,6 +1424,7 @@ namespace Orly {
           return ret;
         } else {
           data1 = nullptr;
+          data2 = nullptr;
           Atom::TCore::TNote *note_ptr = nullptr;
           if ((note_ptr = reinterpret_cast<Atom::TCore::TNote *>(malloc(note_size))) == 0) {
             syslog(LOG_EMERG, "bad alloc in TDiskArena::TryAcquireNote [%ld]", note_size);
@@ -1283,6 +1444,68 @@ namespace Orly {
         throw;
       }
 
+      template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t LocalCacheSize, bool ScanAheadAllowed>
+      inline const Atom::TCore::TNote *TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::TryAcquireFramedNote(Atom::TCore::TOffset offset, size_t note_size, void *&data1, void *&data2, void *&data3) {
+        assert(this);
+        assert(Frames);
+        const size_t frame_idx = Frames->Find(offset);
+        Util::TFrameCache::TFrame *frame = Frames->AcquireFrame(frame_idx, Stream, StartOffset);
+        const size_t offset_in_frame = offset - Frames->GetNoteOffset(frame_idx);
+        if (!note_size) {
+          if (offset_in_frame + sizeof(Atom::TCore::TNote) <= frame->GetSize()) {
+            note_size = sizeof(Atom::TCore::TNote) + reinterpret_cast<const Atom::TCore::TNote *>(frame->GetData() + offset_in_frame)->GetRawSize();
+          } else {
+            Atom::TCore::TNote *temp_note = reinterpret_cast<Atom::TCore::TNote *>(alloca(sizeof(Atom::TCore::TNote)));
+            try {
+              ReadFramed(offset, temp_note, sizeof(Atom::TCore::TNote));
+            } catch (...) {
+              frame->Release();
+              throw;
+            }
+            note_size = sizeof(Atom::TCore::TNote) + temp_note->GetRawSize();
+          }
+        }
+        data1 = nullptr;
+        data3 = nullptr;
+        /* try to just point at the memory in the frame if the note is contiguous. */
+        if (offset_in_frame + note_size <= frame->GetSize()) {
+          data2 = frame;
+          return reinterpret_cast<const Atom::TCore::TNote *>(frame->GetData() + offset_in_frame);
+        }
+        frame->Release();
+        data2 = nullptr;
+        Atom::TCore::TNote *note_ptr = nullptr;
+        if ((note_ptr = reinterpret_cast<Atom::TCore::TNote *>(malloc(note_size))) == 0) {
+          syslog(LOG_EMERG, "bad alloc in TDiskArena::TryAcquireFramedNote [%ld]", note_size);
+          throw std::bad_alloc();
+        }
+        try {
+          ReadFramed(offset, note_ptr, note_size);
+        } catch (...) {
+          free(note_ptr);
+          throw;
+        }
+        return note_ptr;
+      }
+
+      template <size_t CachePageSize, size_t BlockSize, size_t PhysicalBlockSize, Util::TBufKind BufKind, size_t LocalCacheSize, bool ScanAheadAllowed>
+      inline void TDiskArena<CachePageSize, BlockSize, PhysicalBlockSize, BufKind, LocalCacheSize, ScanAheadAllowed>::ReadFramed(Atom::TCore::TOffset offset, void *out, size_t size) {
+        assert(this);
+        assert(Frames);
+        char *csr = reinterpret_cast<char *>(out);
+        while (size) {
+          const size_t frame_idx = Frames->Find(offset);
+          Util::TFrameCache::TFrame *frame = Frames->AcquireFrame(frame_idx, Stream, StartOffset);
+          const size_t offset_in_frame = offset - Frames->GetNoteOffset(frame_idx);
+          const size_t len = std::min(size, frame->GetSize() - offset_in_frame);
+          memcpy(csr, frame->GetData() + offset_in_frame, len);
+          frame->Release();
+          csr += len;
+          offset += len;
+          size -= len;
+        }
+      }
+
     }  // Disk
 
   }  // Indy
@@ -62,9 +62,9 @@ namespace Orly {
               BucketStream(HERE, Source::UpdateWalk, RealTime, this, engine->GetPageCache(), 0),
               EntryStream(HERE, Source::UpdateWalk, RealTime, this, engine->GetPageCache(), 0),
               Valid(true), Cached(false) {
-          for (const auto &idx_pair : IndexById) {
-            ArenaByIndexId.emplace(idx_pair.first, std::make_unique<TArena>(idx_pair.second.get(), engine->GetCache<PhysicalCachePageSize>(), RealTime));
-          }
+          ForEachIndex([this, engine](const Base::TUuid &index_id, size_t) {
+            ArenaByIndexId.emplace(index_id, std::make_unique<TArena>(TryGetIndexFile(index_id), engine->GetCache<PhysicalCachePageSize>(), RealTime));
+          });
           Refresh();
         }
 
@@ -125,14 +125,14 @@ namespace Orly {
               for (size_t i = 0; i < num_key_ptr; ++i) {
                 size_t offset_of_key;
                 BucketStream.Read(offset_of_key);
-                auto ret = IndexByOffset.upper_bound(offset_of_key);
+                auto ret = IndexIdByOffset.upper_bound(offset_of_key);
                 --ret; /* we're one past the file we're interested in */
-                assert(ArenaByIndexId.find(ret->second->GetIndexId()) != ArenaByIndexId.end());
-                Atom::TCore::TArena *const key_arena = ArenaByIndexId.find(ret->second->GetIndexId())->second.get();
+                assert(ArenaByIndexId.find(ret->second) != ArenaByIndexId.end());
+                Atom::TCore::TArena *const key_arena = ArenaByIndexId.find(ret->second)->second.get();
                 EntryStream.GoTo(offset_of_key + sizeof(TSequenceNumber));
                 EntryStream.Read(&key, sizeof(Atom::TCore));
                 EntryStream.Read(&val, sizeof(Atom::TCore));
-                Item.EntryVec.emplace_back(TIndexKey(ret->second->GetIndexId(), TKey(key, key_arena)), val);
+                Item.EntryVec.emplace_back(TIndexKey(ret->second, TKey(key, key_arena)), val);
               }
               Cached = true;
               ++NumScanned;
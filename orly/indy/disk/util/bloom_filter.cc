@@ -0,0 +1,35 @@
+/* <orly/indy/disk/util/bloom_filter.cc>
+
+   Implements <orly/indy/disk/util/bloom_filter.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/bloom_filter.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+constexpr size_t TBloomFilter::WordsPerBlock;
+constexpr size_t TBloomFilter::BitsPerBlock;
+constexpr size_t TBloomFilter::BitsPerKey;
+constexpr size_t TBloomFilter::NumProbes;
+
+TBloomFilter::TBloomFilter(size_t num_keys)
+    : Words(GetNumWordsForKeys(num_keys), 0UL) {}
+
+size_t TBloomFilter::GetNumWordsForKeys(size_t num_keys) {
+  const size_t num_blocks = (num_keys * BitsPerKey + BitsPerBlock - 1) / BitsPerBlock;
+  return num_blocks * WordsPerBlock;
+}
@@ -0,0 +1,159 @@
+/* <orly/indy/disk/util/bloom_filter.h>
+
+   A blocked Bloom filter over precomputed key hashes.
+
+   Each key sets a handful of bits within a single 512-bit block, so a probe touches exactly one cache line.  The filter is kept as
+   a flat vector of words so that it can be written into a data file as-is and read back the same way.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* A blocked Bloom filter over key hashes. */
+        class TBloomFilter {
+          NO_COPY(TBloomFilter);
+          public:
+
+          /* The number of 64-bit words in a block.  A block is one cache line. */
+          static constexpr size_t WordsPerBlock = 8UL;
+
+          /* The number of bits in a block. */
+          static constexpr size_t BitsPerBlock = WordsPerBlock * 64UL;
+
+          /* The number of filter bits we budget per key.  With NumProbes probes this gives a false positive rate of about 1%. */
+          static constexpr size_t BitsPerKey = 10UL;
+
+          /* The number of bits set per key. */
+          static constexpr size_t NumProbes = 6UL;
+
+          /* An empty filter, which admits every key. */
+          TBloomFilter() {}
+
+          /* A filter sized to hold the given number of keys.  If that number is zero, the filter is empty and admits every key. */
+          explicit TBloomFilter(size_t num_keys);
+
+          /* Move constructor. */
+          TBloomFilter(TBloomFilter &&that) = default;
+
+          /* Move assignment. */
+          TBloomFilter &operator=(TBloomFilter &&that) = default;
+
+          /* Add a key, by its hash, to the filter.  The filter must not be empty. */
+          void Insert(size_t hash) {
+            assert(this);
+            assert(!Words.empty());
+            uint64_t mixed = Mix(hash);
+            uint64_t *block = &Words[(mixed % GetNumBlocks()) * WordsPerBlock];
+            uint32_t bit = static_cast<uint32_t>(mixed >> 32);
+            const uint32_t delta = GetDelta(mixed);
+            for (size_t i = 0; i < NumProbes; ++i, bit += delta) {
+              block[(bit % BitsPerBlock) / 64UL] |= 1UL << (bit % 64UL);
+            }
+          }
+
+          /* False iff. the key with the given hash was definitely never inserted.  An empty filter admits every key. */
+          bool MayContain(size_t hash) const {
+            assert(this);
+            if (Words.empty()) {
+              return true;
+            }
+            uint64_t mixed = Mix(hash);
+            const uint64_t *block = &Words[(mixed % GetNumBlocks()) * WordsPerBlock];
+            uint32_t bit = static_cast<uint32_t>(mixed >> 32);
+            const uint32_t delta = GetDelta(mixed);
+            for (size_t i = 0; i < NumProbes; ++i, bit += delta) {
+              if (!(block[(bit % BitsPerBlock) / 64UL] & (1UL << (bit % 64UL)))) {
+                return false;
+              }
+            }
+            return true;
+          }
+
+          /* True iff. the filter has no bits and so admits every key. */
+          bool IsEmpty() const {
+            assert(this);
+            return Words.empty();
+          }
+
+          /* The bits of the filter, for writing to disk. */
+          const std::vector<uint64_t> &GetWords() const {
+            assert(this);
+            return Words;
+          }
+
+          /* The bits of the filter, for reading from disk.  The number of words must be a multiple of WordsPerBlock. */
+          std::vector<uint64_t> &GetWords() {
+            assert(this);
+            return Words;
+          }
+
+          /* The number of bytes the filter occupies on disk. */
+          size_t GetNumBytes() const {
+            assert(this);
+            return Words.size() * sizeof(uint64_t);
+          }
+
+          /* The number of words a filter holding the given number of keys will have. */
+          static size_t GetNumWordsForKeys(size_t num_keys);
+
+          private:
+
+          /* The number of blocks in the filter. */
+          size_t GetNumBlocks() const {
+            return Words.size() / WordsPerBlock;
+          }
+
+          /* Key hashes are often weak (small integers hash to themselves), so we run them through a 64-bit finalizer first. */
+          static uint64_t Mix(uint64_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdUL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53UL;
+            hash ^= hash >> 33;
+            return hash;
+          }
+
+          /* The stride between probes within a block.  Odd, so the probes don't collapse onto one another. */
+          static uint32_t GetDelta(uint64_t mixed) {
+            return (static_cast<uint32_t>(mixed >> 17) | 1U);
+          }
+
+          /* The filter bits, in blocks of WordsPerBlock words. */
+          std::vector<uint64_t> Words;
+
+        };  // TBloomFilter
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,91 @@
+/* <orly/indy/disk/util/bloom_filter.test.cc>
+
+   Unit test for <orly/indy/disk/util/bloom_filter.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/bloom_filter.h>
+
+#include <random>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+FIXTURE(Empty) {
+  TBloomFilter filter;
+  EXPECT_TRUE(filter.IsEmpty());
+  EXPECT_TRUE(filter.MayContain(0UL));
+  EXPECT_TRUE(filter.MayContain(101UL));
+  TBloomFilter zero_filter(0UL);
+  EXPECT_TRUE(zero_filter.IsEmpty());
+  EXPECT_TRUE(zero_filter.MayContain(101UL));
+}
+
+FIXTURE(Sizing) {
+  EXPECT_EQ(TBloomFilter::GetNumWordsForKeys(0UL), 0UL);
+  EXPECT_EQ(TBloomFilter::GetNumWordsForKeys(1UL), TBloomFilter::WordsPerBlock);
+  TBloomFilter filter(1000UL);
+  EXPECT_EQ(filter.GetWords().size() % TBloomFilter::WordsPerBlock, 0UL);
+  EXPECT_GE(filter.GetNumBytes() * 8UL, 1000UL * TBloomFilter::BitsPerKey);
+}
+
+FIXTURE(NoFalseNegatives) {
+  /* Small sequential integers are the worst case for the hashes we're handed, since they hash to themselves. */
+  const size_t num_keys = 10000UL;
+  TBloomFilter filter(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    filter.Insert(i);
+  }
+  size_t missed = 0UL;
+  for (size_t i = 0; i < num_keys; ++i) {
+    missed += filter.MayContain(i) ? 0UL : 1UL;
+  }
+  EXPECT_EQ(missed, 0UL);
+}
+
+FIXTURE(FalsePositiveRate) {
+  const size_t num_keys = 100000UL;
+  TBloomFilter filter(num_keys);
+  mt19937_64 engine(1);
+  for (size_t i = 0; i < num_keys; ++i) {
+    filter.Insert(i * 2UL);
+  }
+  size_t false_positives = 0UL;
+  for (size_t i = 0; i < num_keys; ++i) {
+    false_positives += filter.MayContain(i * 2UL + 1UL) ? 1UL : 0UL;
+  }
+  /* We budget for about 1%.  Allow twice that before calling it broken. */
+  EXPECT_LT(false_positives, num_keys / 50UL);
+  size_t random_false_positives = 0UL;
+  for (size_t i = 0; i < num_keys; ++i) {
+    random_false_positives += filter.MayContain(engine() | (1UL << 63)) ? 1UL : 0UL;
+  }
+  EXPECT_LT(random_false_positives, num_keys / 50UL);
+}
+
+FIXTURE(RoundTrip) {
+  const size_t num_keys = 500UL;
+  TBloomFilter filter(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    filter.Insert(i * 7919UL);
+  }
+  TBloomFilter copy;
+  copy.GetWords() = filter.GetWords();
+  for (size_t i = 0; i < num_keys; ++i) {
+    EXPECT_TRUE(copy.MayContain(i * 7919UL));
+  }
+}
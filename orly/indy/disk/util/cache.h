@@ -19,10 +19,13 @@
 #pragma once
 
 #include <sched.h>
+#include <syslog.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <stdexcept>
+#include <string>
 #include <iostream> /* TODO: GET RID OF */
 
 #include <base/class_traits.h>
@@ -41,6 +44,44 @@ namespace Orly {
 
       namespace Util {
 
+        /* How a TCache picks the page to give up when it needs room for another.
+
+           Lru: a page goes on the back of an LRU list when its last reference is released, and we reclaim from the front.  A page
+           loaded for a no-pollute reader, and not read by anyone else since, goes on a cold list instead, which we reclaim from first.
+
+           TwoQueue: a segmented LRU in the spirit of 2Q.  A newly loaded page is on probation.  It only joins the protected segment if
+           it's read again after sitting unreferenced for a while, so the back-to-back reads a scan makes of the notes in one page don't
+           count.  We reclaim from probation while it holds more than a quarter of the cache, so a scan can only push that much of the
+           working set out. */
+        enum class TCachePolicy {
+          Lru,
+          TwoQueue
+        };
+
+        /* The policy of the given name, as accepted on the command line. */
+        inline const char *GetCachePolicyName(TCachePolicy policy) {
+          switch (policy) {
+            case TCachePolicy::Lru: {
+              return "lru";
+            }
+            case TCachePolicy::TwoQueue: {
+              return "2q";
+            }
+          }
+          throw std::logic_error("unhandled cache policy");
+        }
+
+        /* The policy with the given name.  Throws if there isn't one. */
+        inline TCachePolicy ParseCachePolicy(const std::string &name) {
+          for (TCachePolicy policy : {TCachePolicy::Lru, TCachePolicy::TwoQueue}) {
+            if (name == GetCachePolicyName(policy)) {
+              return policy;
+            }
+          }
+          syslog(LOG_ERR, "unknown cache policy [%s]", name.c_str());
+          throw std::invalid_argument("unknown cache policy");
+        }
+
         /* TODO */
         template <size_t PageSize>
         class TCache {
@@ -73,7 +114,8 @@ namespace Orly {
 
             /* TODO */
             TSlot()
-                : PageId(EmptySlot), RefCount(0UL), BufAddr(0UL), LRUMembership(this), NextSlot(nullptr), MainSlot(nullptr) {}
+                : PageId(EmptySlot), RefCount(0UL), BufAddr(0UL), LRUMembership(this), NextSlot(nullptr), MainSlot(nullptr),
+                  ReleasedAt(0UL), Referenced(false), Hot(false), Scanned(false) {}
 
             /* This function assumes the data in the cache is already loaded! */
             inline const char *KnownGetData(TCache *cache) const {
@@ -222,6 +264,17 @@ namespace Orly {
             TSlot *NextSlot;
             TSlot *MainSlot;
 
+            /* What the replacement policy knows about our page.  Like the rest of the slot, these are only touched with the main slot
+               of the chain locked.
+               - ReleasedAt is the cache's Clock when our last reference was released
+               - Referenced is set once a regular reader has read the page since it was loaded
+               - Hot is set once the page has earned a place in the protected segment
+               - Scanned is set if the page was loaded for a no-pollute reader and no regular reader has read it since */
+            size_t ReleasedAt;
+            bool Referenced;
+            bool Hot;
+            bool Scanned;
+
             /* TODO */
             friend class TCache;
 
@@ -230,11 +283,16 @@ namespace Orly {
           /* TODO */
           TCache(TVolumeManager *volume_manager,
                  size_t max_cache_size,
-                 size_t num_lru)
+                 size_t num_lru,
+                 TCachePolicy policy = TCachePolicy::Lru)
               : VolumeManager(volume_manager),
                 MaxCacheSize(max_cache_size),
                 NumSlots(SuggestHashSize(MaxCacheSize)),
                 NumLRU(num_lru),
+                Policy(policy),
+                MaxNumProbation(MaxCacheSize / 4UL),
+                CorrelationWindow(std::max(MaxCacheSize / 64UL, 1UL)),
+                Clock(0UL),
                 SlotArray(new TSlot[NumSlots]),
                 LRUArray(new TLRU[NumLRU]),
                 PageData(nullptr) {
@@ -248,13 +306,15 @@ namespace Orly {
             memset(PageData.get(), 0, PageSize * MaxCacheSize);
             #endif
             /* we're going to init max_cache_size slots with DummyStartSlot with a valid
-               BuffAddr and put them in the LRU so they can be reclaimed using a unified strategy */
+               BuffAddr and put them in the LRU so they can be reclaimed using a unified strategy.
+               they hold nothing, so they go on the cold lists to be reclaimed first. */
             for (size_t i = 0; i < MaxCacheSize; ++i) {
               TSlot &slot = SlotArray[i];
               std::atomic_store(&slot.PageId, DummyStartSlot);
               std::atomic_store(&slot.BufAddr, i);
               TLRU &lru = LRUArray[i % NumLRU];
-              lru.SlotCollection.Insert(&slot.LRUMembership);
+              lru.ColdCollection.Insert(&slot.LRUMembership);
+              ++lru.NumCold;
               #ifdef PERF_STATS
               ++lru.NumBufInLRU;
               #endif
@@ -262,6 +322,44 @@ namespace Orly {
             TryRemoveSlotFunc = std::bind(&TCache::TryRemoveSlot, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
           }
 
+          /* The memory backing every page of the cache.  It lives as long as we do, so a disk controller can register it once. */
+          inline void *GetPageData() const {
+            assert(this);
+            return PageData.get();
+          }
+
+          /* The number of bytes at GetPageData(). */
+          inline size_t GetNumPageDataBytes() const {
+            assert(this);
+            return PageSize * MaxCacheSize;
+          }
+
+          /* The replacement policy we were built with. */
+          inline TCachePolicy GetPolicy() const {
+            assert(this);
+            return Policy;
+          }
+
+          /* The number of reads which found their page already in the cache since the last call. */
+          inline size_t ExchangeHitCount() {
+            assert(this);
+            size_t total = 0UL;
+            for (size_t i = 0; i < NumLRU; ++i) {
+              total += LRUArray[i].NumHits.exchange(0UL);
+            }
+            return total;
+          }
+
+          /* The number of reads which had to load their page since the last call. */
+          inline size_t ExchangeMissCount() {
+            assert(this);
+            size_t total = 0UL;
+            for (size_t i = 0; i < NumLRU; ++i) {
+              total += LRUArray[i].NumMisses.exchange(0UL);
+            }
+            return total;
+          }
+
           /* STATS */
           #ifdef PERF_STATS
           inline size_t GetMaxCacheSize() const {
@@ -290,8 +388,10 @@ namespace Orly {
             _mm_prefetch(reinterpret_cast<uint8_t *>(my_slot) + sizeof(TSlot), _MM_HINT_T0);
           }
 
-          /* Returns a pointer to the main slot object. Initializes the slot if it does not exist yet. Increments the reference count on the actual slot holding our page. */
-          inline TSlot *Get(size_t page_id, TSlot *&data_slot) {
+          /* Returns a pointer to the main slot object. Initializes the slot if it does not exist yet. Increments the reference count on the actual slot holding our page.
+             A no-pollute reader (a merge, say) is only passing through; its reads don't make the page look worth keeping.  A prefetch
+             isn't a read at all, so it neither counts as a hit or miss nor makes the page look worth keeping. */
+          inline TSlot *Get(size_t page_id, TSlot *&data_slot, bool no_pollute = false, bool prefetch = false) {
             assert(this);
             const size_t slot_num = page_id % NumSlots;
             TSlot &slot = SlotArray[slot_num];
@@ -327,6 +427,7 @@ namespace Orly {
                 ++slot.RefCount;
                 assert(slot.RefCount == 1);
                 assert(slot.NextSlot == nullptr);
+                OnMiss(slot, no_pollute, prefetch);
                 std::atomic_store(cur_slot, page_id);
                 data_slot = &slot;
                 return &slot;
@@ -346,12 +447,9 @@ namespace Orly {
                   const size_t prev_ref_count = slot.RefCount++;
                   assert(prev_ref_count == slot.RefCount - 1);
                   if (prev_ref_count == 0) {
-                    assert(slot.LRUMembership.TryGetCollector());
-                    #ifdef PERF_STATS
-                    --(slot.LRUMembership.TryGetCollector()->NumBufInLRU);
-                    #endif
-                    slot.LRUMembership.Remove();
+                    Unlist(slot);
                   }
+                  OnHit(slot, prev_ref_count, no_pollute, prefetch);
                   std::atomic_store(cur_slot, val);
                   data_slot = &slot;
                   return &slot;
@@ -372,28 +470,22 @@ namespace Orly {
                       const size_t prev_ref_count = (next_slot->RefCount)++;
                       assert(prev_ref_count == (next_slot->RefCount) - 1);
                       if (prev_ref_count == 0) {
-                        assert(next_slot->LRUMembership.TryGetCollector());
-                        #ifdef PERF_STATS
-                        --(next_slot->LRUMembership.TryGetCollector()->NumBufInLRU);
-                        #endif
-                        next_slot->LRUMembership.Remove();
+                        Unlist(*next_slot);
                       }
+                      OnHit(*next_slot, prev_ref_count, no_pollute, prefetch);
                       std::atomic_store(cur_slot, val);
                       data_slot = next_slot;
                       return &slot;
                     }
                   }
-                  /* if this main slot is empty, let's just replace it... */
-                  if (slot.RefCount == 0) {
+                  /* if this main slot is empty, and the policy wouldn't mind losing its page, let's just replace it... */
+                  if (slot.RefCount == 0 && IsExpendable(slot, no_pollute)) {
                     /* remove the high order bits from the reclaimed page. */
                     const size_t new_buf_addr = std::atomic_load(&slot.BufAddr) & All1But3HighestBits;
                     std::atomic_store(&slot.BufAddr, new_buf_addr);
                     ++slot.RefCount;
-                    assert(slot.LRUMembership.TryGetCollector());
-                    #ifdef PERF_STATS
-                    --(slot.LRUMembership.TryGetCollector()->NumBufInLRU);
-                    #endif
-                    slot.LRUMembership.Remove();
+                    Unlist(slot);
+                    OnMiss(slot, no_pollute, prefetch);
                     std::atomic_store(cur_slot, page_id);
                     data_slot = &slot;
                     return &slot;
@@ -418,6 +510,7 @@ namespace Orly {
                       std::atomic_store(&(new_slot->PageId), page_id);
                       /* the following should be no-throws... */
                       ++(new_slot->RefCount);
+                      OnMiss(*new_slot, no_pollute, prefetch);
                       prev_slot->NextSlot = new_slot;
                     } catch (...) {
                       DeleteSlot(new_slot);
@@ -470,12 +563,7 @@ namespace Orly {
                   const size_t new_ref_count = --slot.RefCount;
                   assert(new_ref_count == slot.RefCount);
                   if (new_ref_count == 0UL) {
-                    TLRU &lru = LRUArray[sched_getcpu() % NumLRU];
-                    assert(!slot.LRUMembership.TryGetCollector());
-                    lru.SlotCollection.Insert(&slot.LRUMembership);
-                    #ifdef PERF_STATS
-                    ++lru.NumBufInLRU;
-                    #endif
+                    List(slot);
                   }
                   std::atomic_store(cur_slot, val);
                   return;
@@ -491,12 +579,7 @@ namespace Orly {
                       const size_t new_ref_count = --(next_slot->RefCount);
                       assert(new_ref_count == (next_slot->RefCount));
                       if (new_ref_count == 0UL) {
-                        TLRU &lru = LRUArray[sched_getcpu() % NumLRU];
-                        assert(!next_slot->LRUMembership.TryGetCollector());
-                        lru.SlotCollection.Insert(&next_slot->LRUMembership);
-                        #ifdef PERF_STATS
-                        ++lru.NumBufInLRU;
-                        #endif
+                        List(*next_slot);
                       }
                       std::atomic_store(cur_slot, val);
                       return;
@@ -587,7 +670,7 @@ namespace Orly {
           /* TODO */
           inline void Replace(size_t page_id, void *buf) {
             TSlot *data_slot;
-            TSlot *main_slot = Get(page_id, data_slot);
+            TSlot *main_slot = Get(page_id, data_slot, false, true);
             /* assert that we are the only one referencing this block (refcount == 1) */
             assert(data_slot->RefCount == 1);
             /* copy the data from buf into the address referenced by BufAddr and set it as "successfully read" */
@@ -605,7 +688,7 @@ namespace Orly {
           /* TODO */
           inline bool AssertNoRefCount(size_t page_id) {
             TSlot *data_slot;
-            TSlot *main_slot = Get(page_id, data_slot);
+            TSlot *main_slot = Get(page_id, data_slot, false, true);
             bool ret = data_slot->RefCount == 1;
             Release(main_slot, page_id);
             if (!ret) {
@@ -623,14 +706,15 @@ namespace Orly {
                                     size_t page_id,
                                     size_t num_consec_pages,
                                     bool can_release,
-                                    TCompletionTrigger &async_trigger) {
+                                    TCompletionTrigger &async_trigger,
+                                    bool no_pollute = false) {
             assert(this);
             TSlot *main_slots[num_consec_pages];
             TSlot *data_slots[num_consec_pages];
             TSlot **main_slots_ptr = main_slots;
             TSlot **data_slots_ptr = data_slots;
             for (size_t i = 0; i < num_consec_pages; ++i) {
-              main_slots[i] = Get(page_id + i, data_slots[i]);
+              main_slots[i] = Get(page_id + i, data_slots[i], no_pollute, true);
             }
 
             auto load_range_func = [data_slots_ptr, main_slots_ptr, page_id, cache, &async_trigger, &code_location, buf_kind, util_src, can_release, priority](size_t from_page_id, size_t num_pages) {
@@ -762,15 +846,25 @@ namespace Orly {
             typedef InvCon::AtomicUnorderedList::TCollection<TLRU, TSlot> TSlotCollection;
 
             /* TODO */
-            TLRU() : SlotCollection(this)
+            TLRU() : SlotCollection(this), ColdCollection(this), NumCold(0UL), NumHits(0UL), NumMisses(0UL)
             #ifdef PERF_STATS
             , NumBufInLRU(0UL)
             #endif
             {}
 
-            /* TODO */
+            /* Under Lru, every page that isn't on the cold list.  Under TwoQueue, the protected segment. */
             mutable typename TSlotCollection::TImpl SlotCollection;
 
+            /* Under Lru, the pages only no-pollute readers have read.  Under TwoQueue, the probation segment. */
+            mutable typename TSlotCollection::TImpl ColdCollection;
+
+            /* The number of slots in ColdCollection. */
+            std::atomic<size_t> NumCold;
+
+            /* Reads made on this cpu; see ExchangeHitCount() and ExchangeMissCount(). */
+            std::atomic<size_t> NumHits;
+            std::atomic<size_t> NumMisses;
+
             /* Stats */
             #ifdef PERF_STATS
             std::atomic<size_t> NumBufInLRU;
@@ -778,8 +872,102 @@ namespace Orly {
 
           };  // TLRU
 
+          /* Take the given slot, which nobody references and whose chain we have locked, off whichever list it's on. */
+          inline void Unlist(TSlot &slot) {
+            assert(this);
+            TLRU *const lru = slot.LRUMembership.TryGetCollector();
+            assert(lru);
+            #ifdef PERF_STATS
+            --(lru->NumBufInLRU);
+            #endif
+            if (slot.LRUMembership.TryGetCollection() == &(lru->ColdCollection)) {
+              --(lru->NumCold);
+            }
+            slot.LRUMembership.Remove();
+          }
+
+          /* True iff the given slot, which nobody references and whose chain we have locked, may give up its page to a reader who
+             happens to hash to it rather than waiting its turn on the lists.  Under Lru, anybody but a no-pollute reader may take it. */
+          inline bool IsExpendable(const TSlot &slot, bool no_pollute) const {
+            assert(this);
+            const TLRU *const lru = slot.LRUMembership.TryGetCollector();
+            assert(lru);
+            return (Policy == TCachePolicy::Lru && !no_pollute) || slot.LRUMembership.TryGetCollection() == &(lru->ColdCollection);
+          }
+
+          /* Put the given slot, whose last reference was just released and whose chain we have locked, on this cpu's LRU. */
+          inline void List(TSlot &slot) {
+            assert(this);
+            TLRU &lru = LRUArray[sched_getcpu() % NumLRU];
+            assert(!slot.LRUMembership.TryGetCollector());
+            slot.ReleasedAt = std::atomic_load(&Clock);
+            if (Policy == TCachePolicy::Lru ? slot.Scanned : !slot.Hot) {
+              lru.ColdCollection.Insert(&slot.LRUMembership);
+              ++lru.NumCold;
+            } else {
+              lru.SlotCollection.Insert(&slot.LRUMembership);
+            }
+            #ifdef PERF_STATS
+            ++lru.NumBufInLRU;
+            #endif
+          }
+
+          /* Note that the given slot, whose chain we have locked, has just been given a page that wasn't in the cache. */
+          inline void OnMiss(TSlot &slot, bool no_pollute, bool prefetch) {
+            assert(this);
+            slot.Referenced = !no_pollute && !prefetch;
+            slot.Hot = false;
+            slot.Scanned = no_pollute;
+            ++Clock;
+            if (!prefetch) {
+              ++(LRUArray[sched_getcpu() % NumLRU].NumMisses);
+            }
+          }
+
+          /* Note that we've found the page of the given slot, whose chain we have locked, already in the cache. */
+          inline void OnHit(TSlot &slot, size_t prev_ref_count, bool no_pollute, bool prefetch) {
+            assert(this);
+            if (prefetch) {
+              return;
+            }
+            ++(LRUArray[sched_getcpu() % NumLRU].NumHits);
+            if (!no_pollute) {
+              /* a read only counts as a second one if the page has been sitting unreferenced for a while; otherwise it's most likely
+                 the same reader coming back for the next note on the page. */
+              if (slot.Referenced && prev_ref_count == 0UL && std::atomic_load(&Clock) - slot.ReleasedAt >= CorrelationWindow) {
+                slot.Hot = true;
+              }
+              slot.Referenced = true;
+              slot.Scanned = false;
+            }
+          }
+
           /* TODO */
           inline size_t NewPageBuf() {
+            assert(this);
+            bool cold_first = true;
+            if (Policy == TCachePolicy::TwoQueue) {
+              size_t num_cold = 0UL;
+              for (size_t i = 0; i < NumLRU; ++i) {
+                num_cold += std::atomic_load(&(LRUArray[i].NumCold));
+              }
+              cold_first = num_cold > MaxNumProbation;
+            }
+            size_t reclaimed_page_buf;
+            if (TryReclaimPageBuf(cold_first, reclaimed_page_buf) || TryReclaimPageBuf(!cold_first, reclaimed_page_buf)) {
+              return reclaimed_page_buf;
+            }
+            #ifdef PERF_STATS
+            syslog(LOG_INFO, "NewPageBuf ps=[%ld] Ran out of cache pages, num_free=[%ld]", PageSize, CountNumBufInLRU());
+            #else
+            syslog(LOG_INFO, "NewPageBuf ps=[%ld] Ran out of cache pages", PageSize);
+            #endif
+            throw std::runtime_error("Ran out of cache pages");
+          }
+
+          /* Reclaim the page buf of the least recently used slot on either the cold lists or the others, starting with this cpu's list
+             and moving on to our neighbors'.  Returns false if there was nothing to reclaim. */
+          inline bool TryReclaimPageBuf(bool cold, size_t &out_reclaimed_page_buf) {
             assert(this);
             int lru_start = sched_getcpu() % NumLRU;
             size_t stop_lru = NumLRU;
@@ -788,13 +976,9 @@ namespace Orly {
               size_t reclaimed_page_buf;
               size_t main_slot_page_id;
               TSlot *slot_to_remove = nullptr;
-              lru.SlotCollection.ForEach(TryRemoveSlotFunc, slot_to_remove, reclaimed_page_buf, main_slot_page_id);
+              (cold ? lru.ColdCollection : lru.SlotCollection).ForEach(TryRemoveSlotFunc, slot_to_remove, reclaimed_page_buf, main_slot_page_id);
               if (likely(slot_to_remove)) {
-                assert(slot_to_remove->LRUMembership.TryGetCollector());
-                #ifdef PERF_STATS
-                --(slot_to_remove->LRUMembership.TryGetCollector()->NumBufInLRU);
-                #endif
-                slot_to_remove->LRUMembership.Remove();
+                Unlist(*slot_to_remove);
                 if (slot_to_remove->MainSlot == nullptr) {
                   /* common case : this is a main slot */
                   std::atomic_store(&(slot_to_remove->PageId), EmptySlot);
@@ -811,14 +995,10 @@ namespace Orly {
                 }
                 continue;
               }
-              return reclaimed_page_buf;
+              out_reclaimed_page_buf = reclaimed_page_buf;
+              return true;
             }
-            #ifdef PERF_STATS
-            syslog(LOG_INFO, "NewPageBuf ps=[%ld] Ran out of cache pages, num_free=[%ld]", PageSize, CountNumBufInLRU());
-            #else
-            syslog(LOG_INFO, "NewPageBuf ps=[%ld] Ran out of cache pages", PageSize);
-            #endif
-            throw std::runtime_error("Ran out of cache pages");
+            return false;
           }
 
           /* TODO */
@@ -853,11 +1033,17 @@ namespace Orly {
                     TSlot &next_slot = *(slot.NextSlot);
                     if (next_slot.RefCount == 0) {
                       assert(slot.RefCount == 0);
-                      const_cast<TSlot &>(slot).NextSlot = next_slot.NextSlot;
+                      TSlot &mutable_slot = const_cast<TSlot &>(slot);
+                      mutable_slot.NextSlot = next_slot.NextSlot;
                       out_reclaimed_page_buf = std::atomic_load(&slot.BufAddr);
                       /* remove the high order bits from the reclaimed page. */
                       out_reclaimed_page_buf &= All1But3HighestBits;
-                      std::atomic_store(&const_cast<TSlot &>(slot).BufAddr, std::atomic_load(&(next_slot.BufAddr)));
+                      std::atomic_store(&mutable_slot.BufAddr, std::atomic_load(&(next_slot.BufAddr)));
+                      /* the next slot's page moves in with its history, though it keeps our place in the lists. */
+                      mutable_slot.ReleasedAt = next_slot.ReleasedAt;
+                      mutable_slot.Referenced = next_slot.Referenced;
+                      mutable_slot.Hot = next_slot.Hot;
+                      mutable_slot.Scanned = next_slot.Scanned;
                       main_slot_page_id = std::atomic_load(&next_slot.PageId);
                       slot_to_remove = const_cast<TSlot *>(&next_slot);
                       return false;
@@ -916,6 +1102,18 @@ namespace Orly {
           /* TODO */
           const size_t NumLRU;
 
+          /* See TCachePolicy. */
+          const TCachePolicy Policy;
+
+          /* Under TwoQueue, we reclaim from probation first while it holds more than this many slots. */
+          const size_t MaxNumProbation;
+
+          /* Under TwoQueue, a page has to sit unreferenced for this many ticks of the Clock before another read promotes it. */
+          const size_t CorrelationWindow;
+
+          /* Ticks once for every page we load. */
+          std::atomic<size_t> Clock;
+
           /* TODO */
           std::unique_ptr<TSlot[]> SlotArray;
 
@@ -60,3 +60,71 @@ FIXTURE(SingleThreadPressureLRU) {
     cache.Release(slot, page_id);
   }
 }
+
+/* Read the given page, and let it go. */
+static void Touch(TCache<4096> &cache, size_t page_id, bool no_pollute = false) {
+  TCache<4096>::TSlot *data_slot;
+  TCache<4096>::TSlot *slot = cache.Get(page_id, data_slot, no_pollute);
+  cache.Release(slot, page_id);
+}
+
+/* Warm a small working set into a cache, scan a lot of other pages through it, and return how many of the working set's pages were
+   still cached afterwards. */
+static size_t CountSurvivors(TCachePolicy policy, bool no_pollute_scan) {
+  const size_t cache_size = 256UL;
+  const size_t num_hot = 32UL;
+  const TScheduler::TPolicy scheduler_policy(4, 10, milliseconds(10));
+  TScheduler scheduler;
+  scheduler.SetPolicy(scheduler_policy);
+  Sim::TMemEngine mem_engine(&scheduler,
+                             64 /* disk space: 64 MB */,
+                             16,
+                             4096 /* page cache slots: 1GB */,
+                             1 /* num page lru */,
+                             16 /* block cache slots: 1GB */,
+                             1 /* num block lru */);
+  TCache<4096> cache(mem_engine.GetVolMan(), cache_size, 1UL, policy);
+  EXPECT_TRUE(cache.GetPolicy() == policy);
+  /* a few other pages between rounds, so the working set's pages have sat unreferenced for a while when we come back to them */
+  const size_t num_other = 8UL;
+  for (size_t round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < num_hot; ++i) {
+      Touch(cache, i);
+    }
+    for (size_t i = 0; i < num_other; ++i) {
+      Touch(cache, 500UL + (round * num_other) + i);
+    }
+  }
+  EXPECT_EQ(cache.ExchangeHitCount(), num_hot * 2);
+  EXPECT_EQ(cache.ExchangeMissCount(), num_hot + (num_other * 3));
+  for (size_t i = 0; i < cache_size * 4; ++i) {
+    Touch(cache, 1000UL + i, no_pollute_scan);
+  }
+  EXPECT_EQ(cache.ExchangeMissCount(), cache_size * 4);
+  for (size_t i = 0; i < num_hot; ++i) {
+    Touch(cache, i);
+  }
+  const size_t num_survivors = cache.ExchangeHitCount();
+  EXPECT_EQ(cache.ExchangeMissCount(), num_hot - num_survivors);
+  return num_survivors;
+}
+
+FIXTURE(ScanFlushesLRU) {
+  EXPECT_EQ(CountSurvivors(TCachePolicy::Lru, false), 0UL);
+}
+
+FIXTURE(ScanResistantTwoQueue) {
+  EXPECT_EQ(CountSurvivors(TCachePolicy::TwoQueue, false), 32UL);
+}
+
+FIXTURE(NoPolluteScan) {
+  EXPECT_EQ(CountSurvivors(TCachePolicy::Lru, true), 32UL);
+  EXPECT_EQ(CountSurvivors(TCachePolicy::TwoQueue, true), 32UL);
+}
+
+FIXTURE(ParsePolicy) {
+  EXPECT_TRUE(ParseCachePolicy("lru") == TCachePolicy::Lru);
+  EXPECT_TRUE(ParseCachePolicy("2q") == TCachePolicy::TwoQueue);
+  EXPECT_EQ(string(GetCachePolicyName(TCachePolicy::TwoQueue)), "2q");
+  EXPECT_THROW(invalid_argument, []() { ParseCachePolicy("clock"); });
+}
@@ -48,7 +48,10 @@ namespace Orly {
                       size_t num_block_lru,
                       size_t append_log_mb,
                       bool create = false,
-                      bool no_realtime = false)
+                      bool no_realtime = false,
+                      TDiskController::TBackend disk_backend = TDiskController::TBackend::Aio,
+                      TCachePolicy cache_policy = TCachePolicy::Lru,
+                      const TIoBudget::TConfig &io_budget_config = TIoBudget::TConfig())
             : Scheduler(scheduler),
               SystemBlockId(0UL),
               FileAppendLogBlocks((append_log_mb * 1024 * 1024) / Util::PhysicalBlockSize) {
@@ -124,7 +127,7 @@ namespace Orly {
                 }
               }
             };
-            DiskController = std::make_unique<TDiskController>();
+            DiskController = std::make_unique<TDiskController>(disk_backend, io_budget_config);
             DiskUtil = std::make_unique<TDiskUtil>(scheduler, DiskController.get(), instance_name, do_fsync, CacheCb, true);
             VolMan = DiskUtil->GetVolumeManager(instance_name);
             std::vector<std::vector<TPersistentDevice *>> device_vec;
@@ -141,8 +144,10 @@ namespace Orly {
             VolMan->MarkBlockRangeUsed(TBlockRange(0UL, 1UL));
             SystemBlockId = 0UL;
 
-            PageCache = std::make_unique<Util::TPageCache>(VolMan, page_cache_size, num_page_lru);
-            BlockCache = std::make_unique<Util::TBlockCache>(VolMan, block_cache_size, num_block_lru);
+            PageCache = std::make_unique<Util::TPageCache>(VolMan, page_cache_size, num_page_lru, cache_policy);
+            BlockCache = std::make_unique<Util::TBlockCache>(VolMan, block_cache_size, num_block_lru, cache_policy);
+            DiskController->RegisterBuffer(PageCache->GetPageData(), PageCache->GetNumPageDataBytes());
+            DiskController->RegisterBuffer(BlockCache->GetPageData(), BlockCache->GetNumPageDataBytes());
 
             std::unique_ptr<const TBufBlock> buf_block(new TBufBlock());
             memset(buf_block->GetData(), 0, PhysicalBlockSize);
@@ -0,0 +1,122 @@
+/* <orly/indy/disk/util/frame_cache.cc>
+
+   Implements <orly/indy/disk/util/frame_cache.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/frame_cache.h>
+
+#include <syslog.h>
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+TFrameCache::TFrame::TFrame(size_t size)
+    : RefCount(1UL), Size(size), Data(reinterpret_cast<char *>(malloc(size ? size : 1UL))) {
+  if (!Data) {
+    syslog(LOG_EMERG, "bad alloc in TFrameCache::TFrame [%ld]", size);
+    throw bad_alloc();
+  }
+}
+
+TFrameCache::TFrame::~TFrame() {
+  assert(this);
+  assert(RefCount == 0UL);
+  free(Data);
+}
+
+TFrameCache::TFrameCache(size_t max_bytes)
+    : MaxBytes(max_bytes), NumBytes(0UL), HitCount(0UL), MissCount(0UL) {}
+
+TFrameCache::~TFrameCache() {
+  assert(this);
+  for (auto &item : Lru) {
+    item.second->Release();
+  }
+}
+
+TFrameCache::TFrame *TFrameCache::TryAcquire(const void *owner, size_t frame_idx) {
+  assert(this);
+  lock_guard<mutex> lock(Mutex);
+  auto pos = Index.find(TKey(owner, frame_idx));
+  if (pos == Index.end()) {
+    ++MissCount;
+    return nullptr;
+  }
+  ++HitCount;
+  Lru.splice(Lru.begin(), Lru, pos->second);
+  TFrame *frame = pos->second->second;
+  frame->Acquire();
+  return frame;
+}
+
+TFrameCache::TFrame *TFrameCache::Insert(const void *owner, size_t frame_idx, TFrame *frame) {
+  assert(this);
+  assert(frame);
+  lock_guard<mutex> lock(Mutex);
+  const TKey key(owner, frame_idx);
+  auto pos = Index.find(key);
+  if (pos != Index.end()) {
+    frame->Release();
+    frame = pos->second->second;
+    frame->Acquire();
+    return frame;
+  }
+  if (frame->GetSize() > MaxBytes) {
+    /* it would only push everything else out, so don't bother keeping it */
+    return frame;
+  }
+  frame->Acquire();
+  Lru.emplace_front(key, frame);
+  Index.emplace(key, Lru.begin());
+  NumBytes += frame->GetSize();
+  Shrink();
+  return frame;
+}
+
+void TFrameCache::Purge(const void *owner) {
+  assert(this);
+  lock_guard<mutex> lock(Mutex);
+  for (auto iter = Lru.begin(); iter != Lru.end();) {
+    if (iter->first.first == owner) {
+      NumBytes -= iter->second->GetSize();
+      iter->second->Release();
+      Index.erase(iter->first);
+      iter = Lru.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+size_t TFrameCache::GetNumBytes() const {
+  assert(this);
+  lock_guard<mutex> lock(Mutex);
+  return NumBytes;
+}
+
+void TFrameCache::Shrink() {
+  assert(this);
+  while (NumBytes > MaxBytes && !Lru.empty()) {
+    auto &victim = Lru.back();
+    NumBytes -= victim.second->GetSize();
+    victim.second->Release();
+    Index.erase(victim.first);
+    Lru.pop_back();
+  }
+}
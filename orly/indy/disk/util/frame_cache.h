@@ -0,0 +1,175 @@
+/* <orly/indy/disk/util/frame_cache.h>
+
+   A cache of decompressed frames.
+
+   Compressed sections of a file are read in frames, each of which has to be inflated before it can be used.  The block cache holds
+   the frames as they are on disk; this cache holds them after decompression, so that a hot frame is inflated only once.  Frames
+   are reference counted, so a pinned frame survives being evicted from the cache until the last pin is released.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* An LRU cache of decompressed frames, bounded by the total number of bytes it holds. */
+        class TFrameCache {
+          NO_COPY(TFrameCache);
+          public:
+
+          /* A decompressed frame.  Starts with one reference, held by whoever made it. */
+          class TFrame {
+            NO_COPY(TFrame);
+            public:
+
+            /* A frame of the given number of bytes, to be filled in by the caller. */
+            explicit TFrame(size_t size);
+
+            /* Take another reference. */
+            void Acquire() {
+              assert(this);
+              ++RefCount;
+            }
+
+            /* Let go of a reference.  The last one out deletes the frame. */
+            void Release() {
+              assert(this);
+              if (--RefCount == 0UL) {
+                delete this;
+              }
+            }
+
+            /* The decompressed bytes. */
+            const char *GetData() const {
+              assert(this);
+              return Data;
+            }
+
+            /* The decompressed bytes, for filling in. */
+            char *GetData() {
+              assert(this);
+              return Data;
+            }
+
+            /* The number of decompressed bytes. */
+            size_t GetSize() const {
+              assert(this);
+              return Size;
+            }
+
+            private:
+
+            /* Use Release(). */
+            ~TFrame();
+
+            /* See accessors. */
+            std::atomic<size_t> RefCount;
+            size_t Size;
+            char *Data;
+
+          };  // TFrame
+
+          /* A cache holding at most the given number of bytes of frames. */
+          explicit TFrameCache(size_t max_bytes);
+
+          /* Releases the cache's references. */
+          ~TFrameCache();
+
+          /* The given frame of the given owner, with a reference taken for the caller, or null if we don't have it. */
+          TFrame *TryAcquire(const void *owner, size_t frame_idx);
+
+          /* Cache a frame the caller holds a reference to.  If another caller beat us to it, the caller's frame is released and the
+             cached one acquired in its place.  Either way, the caller ends up holding a reference to the frame returned. */
+          TFrame *Insert(const void *owner, size_t frame_idx, TFrame *frame);
+
+          /* Drop every frame of the given owner.  Owners must call this before they go away, so a new owner at the same address
+             doesn't find their frames. */
+          void Purge(const void *owner);
+
+          /* The number of lookups that found their frame since the last call, and the number that didn't. */
+          size_t ExchangeHitCount() {
+            assert(this);
+            return HitCount.exchange(0UL);
+          }
+          size_t ExchangeMissCount() {
+            assert(this);
+            return MissCount.exchange(0UL);
+          }
+
+          /* The number of bytes of frames we hold. */
+          size_t GetNumBytes() const;
+
+          private:
+
+          /* A frame is known by its owner and position within its owner. */
+          typedef std::pair<const void *, size_t> TKey;
+
+          /* Hashes a TKey. */
+          struct TKeyHasher {
+            size_t operator()(const TKey &key) const {
+              return std::hash<const void *>()(key.first) ^ (key.second * 0x9e3779b97f4a7c15UL);
+            }
+          };
+
+          /* Most recently used at the front. */
+          typedef std::list<std::pair<TKey, TFrame *>> TLru;
+
+          /* Evict from the back until we are within budget.  The caller holds the lock. */
+          void Shrink();
+
+          /* See constructor. */
+          const size_t MaxBytes;
+
+          /* Covers everything below. */
+          mutable std::mutex Mutex;
+
+          /* The frames, in LRU order. */
+          TLru Lru;
+
+          /* Where each frame lives in the LRU. */
+          std::unordered_map<TKey, TLru::iterator, TKeyHasher> Index;
+
+          /* The sum of the sizes of the frames in Lru. */
+          size_t NumBytes;
+
+          /* See Exchange...Count(). */
+          std::atomic<size_t> HitCount, MissCount;
+
+        };  // TFrameCache
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
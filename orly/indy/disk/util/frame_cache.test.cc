@@ -0,0 +1,106 @@
+/* <orly/indy/disk/util/frame_cache.test.cc>
+
+   Unit test for <orly/indy/disk/util/frame_cache.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/frame_cache.h>
+
+#include <cstring>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+/* A frame of the given size, filled with the given byte. */
+static TFrameCache::TFrame *MakeFrame(size_t size, char c) {
+  TFrameCache::TFrame *frame = new TFrameCache::TFrame(size);
+  memset(frame->GetData(), c, size);
+  return frame;
+}
+
+FIXTURE(HitAndMiss) {
+  TFrameCache cache(1024UL);
+  int owner;
+  EXPECT_FALSE(cache.TryAcquire(&owner, 0UL));
+  TFrameCache::TFrame *frame = cache.Insert(&owner, 0UL, MakeFrame(100UL, 'a'));
+  EXPECT_EQ(cache.GetNumBytes(), 100UL);
+  frame->Release();
+  frame = cache.TryAcquire(&owner, 0UL);
+  if (EXPECT_TRUE(frame)) {
+    EXPECT_EQ(frame->GetSize(), 100UL);
+    EXPECT_EQ(frame->GetData()[99], 'a');
+    frame->Release();
+  }
+  EXPECT_FALSE(cache.TryAcquire(&owner, 1UL));
+  EXPECT_EQ(cache.ExchangeHitCount(), 1UL);
+  EXPECT_EQ(cache.ExchangeMissCount(), 2UL);
+  EXPECT_EQ(cache.ExchangeHitCount(), 0UL);
+}
+
+FIXTURE(LostRace) {
+  TFrameCache cache(1024UL);
+  int owner;
+  TFrameCache::TFrame *first = cache.Insert(&owner, 0UL, MakeFrame(100UL, 'a'));
+  /* the second inserter is handed the frame which got there first */
+  TFrameCache::TFrame *second = cache.Insert(&owner, 0UL, MakeFrame(100UL, 'b'));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(second->GetData()[0], 'a');
+  EXPECT_EQ(cache.GetNumBytes(), 100UL);
+  first->Release();
+  second->Release();
+}
+
+FIXTURE(Eviction) {
+  TFrameCache cache(300UL);
+  int owner;
+  for (size_t i = 0; i < 3UL; ++i) {
+    cache.Insert(&owner, i, MakeFrame(100UL, 'a'))->Release();
+  }
+  /* touch frame 0 so frame 1 is the least recently used */
+  cache.TryAcquire(&owner, 0UL)->Release();
+  /* keep a pin on frame 3 to check it outlives its eviction */
+  TFrameCache::TFrame *pinned = cache.Insert(&owner, 3UL, MakeFrame(100UL, 'z'));
+  EXPECT_EQ(cache.GetNumBytes(), 300UL);
+  TFrameCache::TFrame *frame = cache.TryAcquire(&owner, 1UL);
+  EXPECT_FALSE(frame);
+  frame = cache.TryAcquire(&owner, 0UL);
+  if (EXPECT_TRUE(frame)) {
+    frame->Release();
+  }
+  /* a frame bigger than the whole cache is handed back without being cached */
+  frame = cache.Insert(&owner, 4UL, MakeFrame(400UL, 'b'));
+  EXPECT_EQ(cache.GetNumBytes(), 300UL);
+  frame->Release();
+  cache.Purge(&owner);
+  EXPECT_EQ(cache.GetNumBytes(), 0UL);
+  EXPECT_EQ(pinned->GetData()[0], 'z');
+  pinned->Release();
+}
+
+FIXTURE(PurgeByOwner) {
+  TFrameCache cache(1024UL);
+  int owner_a, owner_b;
+  cache.Insert(&owner_a, 0UL, MakeFrame(100UL, 'a'))->Release();
+  cache.Insert(&owner_b, 0UL, MakeFrame(100UL, 'b'))->Release();
+  cache.Purge(&owner_a);
+  EXPECT_FALSE(cache.TryAcquire(&owner_a, 0UL));
+  TFrameCache::TFrame *frame = cache.TryAcquire(&owner_b, 0UL);
+  if (EXPECT_TRUE(frame)) {
+    EXPECT_EQ(frame->GetData()[0], 'b');
+    frame->Release();
+  }
+}
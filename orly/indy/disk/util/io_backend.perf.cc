@@ -0,0 +1,141 @@
+/* <orly/indy/disk/util/io_backend.perf.cc>
+
+   Compares the disk controller backends by doing random page reads against a file-backed loop device.
+
+   ./io_backend.perf loop0 1024 200000 32
+   aio: 200000 reads, depth 32, iops = ..., p50 = ... us, p99 = ... us
+   io_uring: 200000 reads, depth 32, iops = ..., p50 = ... us, p99 = ... us
+
+   Setting up the loop device takes sudo.  Name io_uring_polled after the depth to try polled completion; a loop device can't be
+   polled, so expect it to fail unless the loop is swapped for an NVMe device with poll queues.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <base/mem_aligned_ptr.h>
+#include <orly/indy/disk/indy_util_reporter.h>
+#include <orly/indy/disk/loop_block_dev.h>
+#include <orly/indy/disk/util/volume_manager.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy::Disk;
+using namespace Orly::Indy::Disk::Util;
+
+/* The size of each read. */
+static constexpr size_t ReadSize = 4096UL;
+
+/* Do the given number of random reads through a controller using the given backend, keeping 'depth' of them in flight at a time.
+   Reports throughput and latency to stdout. */
+static void Run(TDiskController::TBackend backend, const string &loop_name, size_t size_mb, size_t num_reads, size_t depth) {
+  const string device_path = "/dev/" + loop_name;
+  const size_t num_pages = (size_mb * 1024UL * 1024UL) / ReadSize;
+  TDiskController controller(backend);
+  TPersistentDevice device(&controller, device_path.c_str(), loop_name.c_str(), ReadSize, ReadSize, num_pages, false, false);
+  unique_ptr<char> bufs = MemAlignedAlloc<char>(ReadSize, ReadSize * depth);
+  controller.RegisterBuffer(bufs.get(), ReadSize * depth);
+  thread runner(&TDiskController::QueueRunner, &controller, vector<TPersistentDevice *>{&device}, true, 0UL);
+  mt19937_64 engine(num_reads);
+  uniform_int_distribution<size_t> page_dist(0UL, num_pages - 1UL);
+  vector<double> latency_vec;
+  latency_vec.reserve(num_reads);
+  mutex mut;
+  condition_variable cond;
+  size_t num_errors = 0UL;
+  const auto start = chrono::steady_clock::now();
+  for (size_t num_issued = 0UL; num_issued < num_reads; ) {
+    const size_t wave = min(depth, num_reads - num_issued);
+    size_t num_finished = 0UL;
+    for (size_t i = 0; i < wave; ++i) {
+      const auto issued_at = chrono::steady_clock::now();
+      device.Read(HERE, FullPage, Source::System, bufs.get() + (i * ReadSize), page_dist(engine) * ReadSize, ReadSize, RealTime, false,
+                  [&, issued_at](TDiskResult result, const char *) {
+        const double latency = chrono::duration<double, micro>(chrono::steady_clock::now() - issued_at).count();
+        lock_guard<mutex> lock(mut);
+        latency_vec.push_back(latency);
+        if (result != Success) {
+          ++num_errors;
+        }
+        if (++num_finished == wave) {
+          cond.notify_one();
+        }
+      });
+    }
+    unique_lock<mutex> lock(mut);
+    cond.wait(lock, [&]() { return num_finished == wave; });
+    num_issued += wave;
+  }
+  const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  controller.Stop();
+  runner.join();
+  sort(latency_vec.begin(), latency_vec.end());
+  cout << TDiskController::GetBackendName(backend) << ": " << num_reads << " reads, depth " << depth
+       << ", iops = " << (num_reads / elapsed)
+       << ", p50 = " << latency_vec[latency_vec.size() / 2] << " us"
+       << ", p99 = " << latency_vec[(latency_vec.size() * 99UL) / 100UL] << " us";
+  if (num_errors) {
+    cout << ", errors = " << num_errors;
+  }
+  cout << endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 5) {
+    cerr << "usage: " << argv[0] << " <loop_name> <size_mb> <num_reads> <depth> [backend...]" << endl;
+    return EXIT_FAILURE;
+  }
+  const string loop_name = argv[1];
+  const size_t
+    size_mb   = atol(argv[2]),
+    num_reads = atol(argv[3]),
+    depth     = atol(argv[4]);
+  if (size_mb < 1 || num_reads < 1 || depth < 1 || depth > 32) {
+    cerr << "error: value(s) out of range" << endl;
+    return EXIT_FAILURE;
+  }
+  vector<TDiskController::TBackend> backend_vec;
+  try {
+    for (int i = 5; i < argc; ++i) {
+      backend_vec.push_back(TDiskController::ParseBackend(argv[i]));
+    }
+  } catch (const exception &ex) {
+    cerr << "error: " << ex.what() << endl;
+    return EXIT_FAILURE;
+  }
+  if (backend_vec.empty()) {
+    backend_vec = {TDiskController::TBackend::Aio, TDiskController::TBackend::IoUring};
+  }
+  TBlockDev block_dev("io_backend_perf", size_mb, loop_name.c_str());
+  TDiskController::TEvent::InitializeDiskEventPoolManager(depth * 4UL);
+  TDiskController::TEvent::LocalEventPool = new TThreadLocalGlobalPoolManager<TDiskController::TEvent>::TThreadLocalPool(
+      TDiskController::TEvent::DiskEventPoolManager.get());
+  for (auto backend : backend_vec) {
+    Run(backend, loop_name, size_mb, num_reads, depth);
+  }
+  delete TDiskController::TEvent::LocalEventPool;
+  TDiskController::TEvent::LocalEventPool = nullptr;
+  TDiskController::TEvent::FinalizeDiskEventPoolManager();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/* <orly/indy/disk/util/io_budget.cc>
+
+   Implements <orly/indy/disk/util/io_budget.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_budget.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace chrono;
+using namespace Orly::Indy::Disk::Util;
+
+constexpr TIoBudget::TClock::duration TIoBudget::BurstInterval;
+constexpr TIoBudget::TClock::duration TIoBudget::AdaptInterval;
+constexpr double TIoBudget::MinScale;
+constexpr double TIoBudget::ScaleStep;
+
+TIoBudget::TIoBudget(const TConfig &config, TClock::time_point now)
+    : Config(config),
+      Scale(1.0),
+      Bytes(config.BytesPerSec * duration<double>(BurstInterval).count()),
+      Ios(config.IosPerSec * duration<double>(BurstInterval).count()),
+      LastRefill(now),
+      NumReads(0UL),
+      NumSlowReads(0UL),
+      IntervalStart(now) {}
+
+bool TIoBudget::TryTake(size_t num_bytes, TClock::time_point now) {
+  assert(this);
+  if (!IsLimited()) {
+    return true;
+  }
+  Refill(now);
+  if ((Config.BytesPerSec && Bytes <= 0.0) || (Config.IosPerSec && Ios <= 0.0)) {
+    return false;
+  }
+  Bytes -= num_bytes;
+  Ios -= 1.0;
+  return true;
+}
+
+void TIoBudget::ObserveRead(TClock::duration latency, TClock::time_point now) {
+  assert(this);
+  if (!Config.ReadLatencyTarget.count()) {
+    return;
+  }
+  ++NumReads;
+  if (latency > Config.ReadLatencyTarget) {
+    ++NumSlowReads;
+  }
+  Refill(now);
+}
+
+void TIoBudget::Refill(TClock::time_point now) {
+  assert(this);
+  double scale = Scale.load(memory_order_relaxed);
+  if (Config.ReadLatencyTarget.count() && now - IntervalStart >= AdaptInterval) {
+    /* back off hard when the p99 is over, creep back otherwise */
+    scale = (NumSlowReads * 100UL > NumReads) ? max(MinScale, scale / 2.0) : min(1.0, scale + ScaleStep);
+    Scale.store(scale, memory_order_relaxed);
+    NumReads = 0UL;
+    NumSlowReads = 0UL;
+    IntervalStart = now;
+  }
+  if (now <= LastRefill) {
+    return;
+  }
+  const double elapsed = duration<double>(now - LastRefill).count();
+  const double burst = duration<double>(BurstInterval).count();
+  Bytes = min(Bytes + elapsed * Config.BytesPerSec * scale, burst * Config.BytesPerSec * scale);
+  Ios = min(Ios + elapsed * Config.IosPerSec * scale, burst * Config.IosPerSec * scale);
+  LastRefill = now;
+}
@@ -0,0 +1,133 @@
+/* <orly/indy/disk/util/io_budget.h>
+
+   A token bucket which paces background I/O against a device.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* Merges and flushes (everything below real time priority) draw on this budget of bytes and I/Os per second before the disk
+           controller lets them at the device.  Foreground reads never wait on it.
+
+           The budget refills continuously and holds at most BurstInterval's worth.  An I/O is let through whenever both buckets are
+           above zero, even if it then overdraws them, so an I/O larger than the burst still goes, and the debt is paid off before the
+           next.
+
+           Given a read latency target, we also watch foreground reads.  If more than 1 in 100 of them over an AdaptInterval took longer
+           than the target (that is, the p99 is over it), we halve the rates, down to MinScale of what was configured.  Otherwise we
+           win back ScaleStep of the configured rates per interval.
+
+           Only the queue runner which owns the device may call the non-const members. */
+        class TIoBudget {
+          NO_COPY(TIoBudget);
+          public:
+
+          /* The clock we measure against. */
+          using TClock = std::chrono::steady_clock;
+
+          /* How we're set up. */
+          struct TConfig {
+
+            /* Zeros mean no limit, and no adapting. */
+            TConfig(size_t bytes_per_sec = 0UL, size_t ios_per_sec = 0UL, std::chrono::microseconds read_latency_target = std::chrono::microseconds(0))
+                : BytesPerSec(bytes_per_sec), IosPerSec(ios_per_sec), ReadLatencyTarget(read_latency_target) {}
+
+            /* The most bytes and I/Os we let through per second.  Zero means no limit. */
+            size_t BytesPerSec;
+            size_t IosPerSec;
+
+            /* The foreground read latency we try to hold the p99 under.  Zero means we don't adapt. */
+            std::chrono::microseconds ReadLatencyTarget;
+
+          };  // TConfig
+
+          /* The most we let build up while nothing is asking. */
+          static constexpr TClock::duration BurstInterval = std::chrono::milliseconds(100);
+
+          /* How often we reconsider the scale. */
+          static constexpr TClock::duration AdaptInterval = std::chrono::milliseconds(100);
+
+          /* The least fraction of the configured rates we'll drop to, and how much we win back per interval. */
+          static constexpr double MinScale = 1.0 / 32.0;
+          static constexpr double ScaleStep = 1.0 / 16.0;
+
+          /* Starts out full. */
+          TIoBudget(const TConfig &config, TClock::time_point now = TClock::now());
+
+          /* True iff. there's any limit at all. */
+          bool IsLimited() const {
+            assert(this);
+            return Config.BytesPerSec || Config.IosPerSec;
+          }
+
+          /* The fraction of the configured rates we're allowing right now. */
+          double GetScale() const {
+            assert(this);
+            return Scale.load(std::memory_order_relaxed);
+          }
+
+          /* If the budget allows an I/O of the given size now, take it out and return true; otherwise return false. */
+          bool TryTake(size_t num_bytes, TClock::time_point now);
+
+          /* Tell us how long a foreground read took. */
+          void ObserveRead(TClock::duration latency, TClock::time_point now);
+
+          private:
+
+          /* Top the buckets up for the time since we last did, and reconsider the scale if an interval has gone by. */
+          void Refill(TClock::time_point now);
+
+          /* See TConfig. */
+          const TConfig Config;
+
+          /* See accessor.  Written only by the owner, but read from wherever we report. */
+          std::atomic<double> Scale;
+
+          /* What's left in each bucket.  Negative while paying off an overdraw. */
+          double Bytes;
+          double Ios;
+
+          /* When we last refilled. */
+          TClock::time_point LastRefill;
+
+          /* The reads seen in the current adapt interval, how many of them missed the target, and when the interval started. */
+          size_t NumReads;
+          size_t NumSlowReads;
+          TClock::time_point IntervalStart;
+
+        };  // TIoBudget
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,94 @@
+/* <orly/indy/disk/util/io_budget.test.cc>
+
+   Unit test for <orly/indy/disk/util/io_budget.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_budget.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace chrono;
+using namespace Orly::Indy::Disk::Util;
+
+using TClock = TIoBudget::TClock;
+
+FIXTURE(Unlimited) {
+  const auto start = TClock::now();
+  TIoBudget budget(TIoBudget::TConfig(), start);
+  EXPECT_FALSE(budget.IsLimited());
+  for (size_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(budget.TryTake(1UL << 20, start));
+  }
+}
+
+FIXTURE(Iops) {
+  const auto start = TClock::now();
+  /* 100 I/Os a second, so a burst of 10 */
+  TIoBudget budget(TIoBudget::TConfig(0UL, 100UL), start);
+  EXPECT_TRUE(budget.IsLimited());
+  size_t taken = 0UL;
+  for (; budget.TryTake(4096UL, start); ++taken);
+  EXPECT_EQ(taken, 10UL);
+  /* a hundredth of a second buys one more */
+  EXPECT_TRUE(budget.TryTake(4096UL, start + milliseconds(10)));
+  EXPECT_FALSE(budget.TryTake(4096UL, start + milliseconds(10)));
+  /* waiting a long time fills only up to the burst */
+  taken = 0UL;
+  for (; budget.TryTake(4096UL, start + seconds(10)); ++taken);
+  EXPECT_EQ(taken, 10UL);
+}
+
+FIXTURE(BytesOverdraw) {
+  const auto start = TClock::now();
+  /* 1MB a second, so a burst of 100KB */
+  TIoBudget budget(TIoBudget::TConfig(1000000UL, 0UL), start);
+  /* a big write still goes, but then we owe */
+  EXPECT_TRUE(budget.TryTake(300000UL, start));
+  EXPECT_FALSE(budget.TryTake(1UL, start));
+  EXPECT_FALSE(budget.TryTake(1UL, start + milliseconds(150)));
+  EXPECT_TRUE(budget.TryTake(1UL, start + milliseconds(250)));
+}
+
+FIXTURE(Adapts) {
+  auto now = TClock::now();
+  TIoBudget budget(TIoBudget::TConfig(0UL, 1000UL, microseconds(500)), now);
+  EXPECT_EQ(budget.GetScale(), 1.0);
+  /* 2 slow reads in 100 is a p99 over the target */
+  for (size_t i = 0; i < 100; ++i) {
+    budget.ObserveRead(i < 2 ? milliseconds(5) : microseconds(100), now);
+  }
+  now += TIoBudget::AdaptInterval;
+  budget.ObserveRead(microseconds(100), now);
+  EXPECT_EQ(budget.GetScale(), 0.5);
+  /* keep missing, and we bottom out */
+  for (size_t i = 0; i < 10; ++i) {
+    budget.ObserveRead(milliseconds(5), now);
+    now += TIoBudget::AdaptInterval;
+    budget.ObserveRead(milliseconds(5), now);
+  }
+  EXPECT_EQ(budget.GetScale(), TIoBudget::MinScale);
+  /* at 1/32 of 1000/s, a burst is just over 3 */
+  size_t taken = 0UL;
+  for (; budget.TryTake(4096UL, now); ++taken);
+  EXPECT_EQ(taken, 4UL);
+  /* recover once the reads are quick again */
+  for (size_t i = 0; i < 20; ++i) {
+    now += TIoBudget::AdaptInterval;
+    budget.ObserveRead(microseconds(100), now);
+  }
+  EXPECT_EQ(budget.GetScale(), 1.0);
+}
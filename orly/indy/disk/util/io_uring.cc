@@ -0,0 +1,171 @@
+/* <orly/indy/disk/util/io_uring.cc>
+
+   Implements <orly/indy/disk/util/io_uring.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_uring.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <util/error.h>
+
+using namespace std;
+using namespace Orly::Indy::Disk::Util;
+
+constexpr size_t TIoUring::MaxRegisteredBufferSize;
+
+/* Map one of the ring's regions, or throw. */
+static void *MapRing(int fd, size_t size, off_t offset) {
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (ptr == MAP_FAILED) {
+    const int err = errno;
+    syslog(LOG_ERR, "Error mapping io_uring region [%ld] of [%ld] bytes: [%s]", offset, size, strerror(err));
+    ::Util::ThrowSystemError(err);
+  }
+  return ptr;
+}
+
+TIoUring::TIoUring(size_t num_entries, bool polled)
+    : Polled(polled),
+      Fd(-1),
+      SqRing(MAP_FAILED),
+      SqRingSize(0UL),
+      CqRing(MAP_FAILED),
+      CqRingSize(0UL),
+      Sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+      SqesSize(0UL),
+      SqLocalTail(0U),
+      HasBuffers(false) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  if (polled) {
+    params.flags |= IORING_SETUP_IOPOLL;
+  }
+  try {
+    Fd = ::Util::IfLt0(static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(num_entries), &params)));
+    SqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+    CqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      SqRingSize = CqRingSize = max(SqRingSize, CqRingSize);
+    }
+    SqRing = MapRing(Fd, SqRingSize, IORING_OFF_SQ_RING);
+    CqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? SqRing : MapRing(Fd, CqRingSize, IORING_OFF_CQ_RING);
+    SqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    Sqes = static_cast<struct io_uring_sqe *>(MapRing(Fd, SqesSize, IORING_OFF_SQES));
+  } catch (const exception &ex) {
+    syslog(LOG_ERR, "Error setting up io_uring of [%ld] entries: [%s]", num_entries, ex.what());
+    Close();
+    throw;
+  }
+  char *sq = static_cast<char *>(SqRing);
+  SqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  SqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  SqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  SqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  NumSqEntries = params.sq_entries;
+  SqLocalTail = *SqTail;
+  char *cq = static_cast<char *>(CqRing);
+  CqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  CqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  CqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  Cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+TIoUring::~TIoUring() {
+  assert(this);
+  Close();
+}
+
+void TIoUring::Close() {
+  assert(this);
+  if (Sqes != MAP_FAILED) {
+    munmap(Sqes, SqesSize);
+  }
+  if (CqRing != MAP_FAILED && CqRing != SqRing) {
+    munmap(CqRing, CqRingSize);
+  }
+  if (SqRing != MAP_FAILED) {
+    munmap(SqRing, SqRingSize);
+  }
+  if (Fd >= 0) {
+    close(Fd);
+  }
+  Sqes = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+  CqRing = SqRing = MAP_FAILED;
+  Fd = -1;
+}
+
+size_t TIoUring::Submit(size_t min_complete) {
+  assert(this);
+  __atomic_store_n(SqTail, SqLocalTail, __ATOMIC_RELEASE);
+  /* Count from the kernel's head, not from the tail we published last time, so that whatever an earlier call left behind goes again. */
+  const unsigned to_submit = SqLocalTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+  if (!to_submit && !min_complete && !Polled) {
+    return 0UL;
+  }
+  /* a polled ring only finds completions when asked to look for them */
+  const unsigned flags = (min_complete || Polled) ? IORING_ENTER_GETEVENTS : 0U;
+  for (;;) {
+    const long ret = syscall(__NR_io_uring_enter, Fd, to_submit, static_cast<unsigned>(min_complete), flags, nullptr, 0UL);
+    if (ret >= 0) {
+      return ret;
+    }
+    const int err = errno;
+    switch (err) {
+      case EINTR: {
+        break;
+      }
+      case EAGAIN:
+      case EBUSY: {
+        /* The kernel is short of resources, or its completion queue is backed up.  Neither is fatal: the entries stay queued, and
+           once the caller has reaped what's waiting and come back around, they go again. */
+        return 0UL;
+      }
+      default: {
+        syslog(LOG_ERR, "Error in io_uring_enter; to_submit=[%u], min_complete=[%ld]: [%s]", to_submit, min_complete, strerror(err));
+        ::Util::ThrowSystemError(err);
+      }
+    }
+  }
+}
+
+bool TIoUring::RegisterBuffers(const vector<struct iovec> &iovec_vec) {
+  assert(this);
+  UnregisterBuffers();
+  if (iovec_vec.empty()) {
+    return true;
+  }
+  if (syscall(__NR_io_uring_register, Fd, IORING_REGISTER_BUFFERS, iovec_vec.data(), static_cast<unsigned>(iovec_vec.size())) < 0) {
+    syslog(LOG_WARNING, "Could not register [%ld] buffers with io_uring, falling back to unregistered I/O: [%s]", iovec_vec.size(), strerror(errno));
+    return false;
+  }
+  HasBuffers = true;
+  return true;
+}
+
+void TIoUring::UnregisterBuffers() {
+  assert(this);
+  if (HasBuffers) {
+    ::Util::IfLt0(syscall(__NR_io_uring_register, Fd, IORING_UNREGISTER_BUFFERS, nullptr, 0U));
+    HasBuffers = false;
+  }
+}
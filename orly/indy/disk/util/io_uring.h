@@ -0,0 +1,161 @@
+/* <orly/indy/disk/util/io_uring.h>
+
+   A thin wrapper around a Linux io_uring instance.
+
+   We talk to the kernel through the io_uring_setup, io_uring_enter and io_uring_register system calls directly, so there is no
+   library to link against.  The submission and completion queues are shared with the kernel through memory mapped from the ring's
+   file descriptor; we only make a system call to hand over a batch of submissions and / or to wait for completions.
+
+   A ring belongs to the one thread that drives it.  Nothing here is thread safe.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <base/class_traits.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    namespace Disk {
+
+      namespace Util {
+
+        /* An io_uring instance, with its queues mapped into our address space. */
+        class TIoUring {
+          NO_COPY(TIoUring);
+          public:
+
+          /* A ring with room for at least the given number of submissions.  If 'polled', we find completions by polling the device
+             rather than by waiting for an interrupt; every file used with the ring must then be opened O_DIRECT on a device which
+             supports polled I/O.  Throws if the kernel won't give us a ring. */
+          TIoUring(size_t num_entries, bool polled);
+
+          /* Unmaps the queues and closes the ring. */
+          ~TIoUring();
+
+          /* An empty submission queue entry for the caller to fill in, or null if the submission queue is full.  The entry goes to the
+             kernel on the next call to Submit(). */
+          struct io_uring_sqe *TryGetSqe() {
+            assert(this);
+            const unsigned head = __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+            if (SqLocalTail - head >= NumSqEntries) {
+              return nullptr;
+            }
+            const unsigned idx = SqLocalTail & *SqMask;
+            SqArray[idx] = idx;
+            ++SqLocalTail;
+            struct io_uring_sqe *sqe = &Sqes[idx];
+            *sqe = {};
+            return sqe;
+          }
+
+          /* Hand every entry gotten since the last call to the kernel, then wait until at least the given number of completions are
+             waiting to be reaped.  Both happen in a single system call.  Returns the number of entries the kernel took.  That may be
+             fewer than we had, or none at all if the kernel was too busy to take any (EAGAIN or EBUSY), in which case we don't wait
+             either.  Whatever the kernel didn't take stays queued and goes again on the next call, so reap and come back around. */
+          size_t Submit(size_t min_complete);
+
+          /* Call back for each completion waiting to be reaped, then retire them all.  Returns the number of completions seen. */
+          template <typename TCb>
+          size_t ForEachCompletion(const TCb &cb) {
+            assert(this);
+            unsigned head = *CqHead;
+            const unsigned tail = __atomic_load_n(CqTail, __ATOMIC_ACQUIRE);
+            size_t num_seen = 0UL;
+            for (; head != tail; ++head, ++num_seen) {
+              cb(Cqes[head & *CqMask]);
+            }
+            __atomic_store_n(CqHead, head, __ATOMIC_RELEASE);
+            return num_seen;
+          }
+
+          /* Register the given memory with the kernel, replacing anything registered before, so that fixed reads and writes into it
+             don't have to map it in on every I/O.  Returns false, having logged why, if the kernel wouldn't take it. */
+          bool RegisterBuffers(const std::vector<struct iovec> &iovec_vec);
+
+          /* Forget any memory registered with the kernel. */
+          void UnregisterBuffers();
+
+          /* True iff we find completions by polling. */
+          bool IsPolled() const {
+            assert(this);
+            return Polled;
+          }
+
+          /* The number of submission queue entries the kernel actually gave us; at least what was asked for. */
+          size_t GetNumEntries() const {
+            assert(this);
+            return NumSqEntries;
+          }
+
+          /* The most the kernel will register in one buffer. */
+          static constexpr size_t MaxRegisteredBufferSize = 1UL << 30;
+
+          private:
+
+          /* Unmap whatever we've mapped and close the ring, if it's open. */
+          void Close();
+
+          /* See IsPolled(). */
+          const bool Polled;
+
+          /* The ring's file descriptor. */
+          int Fd;
+
+          /* The mappings shared with the kernel.  If the kernel supports it, both queues share a single mapping. */
+          void *SqRing;
+          size_t SqRingSize;
+          void *CqRing;
+          size_t CqRingSize;
+
+          /* The submission queue. */
+          unsigned *SqHead;
+          unsigned *SqTail;
+          unsigned *SqMask;
+          unsigned *SqArray;
+          struct io_uring_sqe *Sqes;
+          size_t SqesSize;
+          unsigned NumSqEntries;
+
+          /* The tail of the submission queue as we see it, ahead of the kernel's until the next Submit(). */
+          unsigned SqLocalTail;
+
+          /* The completion queue. */
+          unsigned *CqHead;
+          unsigned *CqTail;
+          unsigned *CqMask;
+          struct io_uring_cqe *Cqes;
+
+          /* True iff we have buffers registered. */
+          bool HasBuffers;
+
+        };  // TIoUring
+
+      }  // Util
+
+    }  // Disk
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,152 @@
+/* <orly/indy/disk/util/io_uring.test.cc>
+
+   Unit test for <orly/indy/disk/util/io_uring.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/disk/util/io_uring.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include <unistd.h>
+
+#include <base/fd.h>
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy::Disk::Util;
+
+/* A ring, or null if this kernel doesn't do io_uring. */
+static unique_ptr<TIoUring> TryMakeRing(size_t num_entries) {
+  try {
+    return unique_ptr<TIoUring>(new TIoUring(num_entries, false));
+  } catch (const exception &) {
+    return nullptr;
+  }
+}
+
+/* A scratch file, already unlinked. */
+static TFd MakeScratchFile() {
+  char path[] = "/tmp/io_uring_test_XXXXXX";
+  TFd fd(mkstemp(path));
+  unlink(path);
+  return fd;
+}
+
+/* Submit the entries queued so far, wait for all of them, and check each one transferred the given number of bytes. */
+static void SubmitAndCheck(TIoUring &ring, size_t num_entries, int expected_res) {
+  ring.Submit(num_entries);
+  size_t num_seen = 0UL;
+  while (num_seen < num_entries) {
+    num_seen += ring.ForEachCompletion([expected_res](const struct io_uring_cqe &cqe) {
+      EXPECT_EQ(cqe.res, expected_res);
+    });
+  }
+  EXPECT_EQ(num_seen, num_entries);
+}
+
+FIXTURE(WriteThenRead) {
+  auto ring = TryMakeRing(8UL);
+  if (!ring) {
+    return;
+  }
+  EXPECT_GE(ring->GetNumEntries(), 8UL);
+  EXPECT_FALSE(ring->IsPolled());
+  TFd fd = MakeScratchFile();
+  char out[4][512], in[4][512];
+  for (size_t i = 0; i < 4; ++i) {
+    memset(out[i], 'a' + i, sizeof(out[i]));
+    struct io_uring_sqe *sqe = ring->TryGetSqe();
+    if (!EXPECT_TRUE(sqe)) {
+      return;
+    }
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(out[i]);
+    sqe->len = sizeof(out[i]);
+    sqe->off = i * sizeof(out[i]);
+  }
+  SubmitAndCheck(*ring, 4UL, 512);
+  for (size_t i = 0; i < 4; ++i) {
+    struct io_uring_sqe *sqe = ring->TryGetSqe();
+    if (!EXPECT_TRUE(sqe)) {
+      return;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(in[i]);
+    sqe->len = sizeof(in[i]);
+    sqe->off = i * sizeof(in[i]);
+  }
+  SubmitAndCheck(*ring, 4UL, 512);
+  EXPECT_FALSE(memcmp(in, out, sizeof(in)));
+}
+
+FIXTURE(Full) {
+  auto ring = TryMakeRing(4UL);
+  if (!ring) {
+    return;
+  }
+  const size_t num_entries = ring->GetNumEntries();
+  for (size_t i = 0; i < num_entries; ++i) {
+    struct io_uring_sqe *sqe = ring->TryGetSqe();
+    if (!EXPECT_TRUE(sqe)) {
+      return;
+    }
+    sqe->opcode = IORING_OP_NOP;
+  }
+  EXPECT_FALSE(ring->TryGetSqe());
+  SubmitAndCheck(*ring, num_entries, 0);
+  EXPECT_TRUE(ring->TryGetSqe());
+}
+
+FIXTURE(FixedBuffers) {
+  auto ring = TryMakeRing(8UL);
+  if (!ring) {
+    return;
+  }
+  const size_t page_size = getpagesize();
+  void *ptr = nullptr;
+  if (!EXPECT_FALSE(posix_memalign(&ptr, page_size, page_size * 2UL))) {
+    return;
+  }
+  unique_ptr<char, decltype(&free)> buf(static_cast<char *>(ptr), &free);
+  if (!ring->RegisterBuffers({iovec{buf.get(), page_size * 2UL}})) {
+    /* not allowed to pin memory here */
+    return;
+  }
+  TFd fd = MakeScratchFile();
+  memset(buf.get(), 'x', page_size);
+  struct io_uring_sqe *sqe = ring->TryGetSqe();
+  sqe->opcode = IORING_OP_WRITE_FIXED;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf.get());
+  sqe->len = page_size;
+  sqe->buf_index = 0;
+  SubmitAndCheck(*ring, 1UL, static_cast<int>(page_size));
+  sqe = ring->TryGetSqe();
+  sqe->opcode = IORING_OP_READ_FIXED;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf.get() + page_size);
+  sqe->len = page_size;
+  sqe->buf_index = 0;
+  SubmitAndCheck(*ring, 1UL, static_cast<int>(page_size));
+  EXPECT_FALSE(memcmp(buf.get(), buf.get() + page_size, page_size));
+  ring->UnregisterBuffers();
+}
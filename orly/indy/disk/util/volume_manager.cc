@@ -21,6 +21,7 @@
 #include <iostream> /* TODO GET RID OF */
 
 #include <linux/fs.h>
+#include <linux/ioprio.h>
 #include <math.h>
 #include <sys/ioctl.h>
 #include <sys/syscall.h>
@@ -29,6 +30,7 @@
 #include <base/sigma_calc.h>
 #include <base/zero.h>
 #include <orly/indy/disk/util/corruption_detector.h>
+#include <orly/indy/disk/util/io_uring.h>
 
 using namespace std;
 using namespace std::literals;
@@ -36,6 +38,10 @@ using namespace Base;
 using namespace Orly::Indy::Disk::Util;
 using namespace ::Util;
 
+constexpr size_t TDiskController::RealTimeNotToExceedDepth;
+constexpr size_t TDiskController::MediumNotToExceedDepth;
+constexpr size_t TDiskController::LowNotToExceedDepth;
+
 std::unique_ptr<Base::TThreadLocalGlobalPoolManager<TDiskController::TEvent>> TDiskController::TEvent::DiskEventPoolManager;
 __thread Base::TThreadLocalGlobalPoolManager<TDiskController::TEvent>::TThreadLocalPool *TDiskController::TEvent::LocalEventPool = nullptr;
 
@@ -47,8 +53,19 @@ namespace Orly {
 
       namespace Util {
 
-        void TDiskController::Report(std::stringstream &/*ss*/, double /*elapsed_time*/) const {
+        void TDiskController::Report(std::stringstream &ss, double elapsed_time) const {
           /* this is where we can report any controller or device specific metrics */
+          ss << "Disk Controller Backend = " << GetBackendName(Backend) << std::endl;
+          ss << "Disk Controller IOs / s = " << (NumIos.exchange(0UL) / elapsed_time) << std::endl;
+          ss << "Disk Controller Syscalls / s = " << (NumSyscalls.exchange(0UL) / elapsed_time) << std::endl;
+          ss << "Disk Controller Background IO Deferrals / s = " << (NumDeferred.exchange(0UL) / elapsed_time) << std::endl;
+          if (IoBudgetConfig.BytesPerSec || IoBudgetConfig.IosPerSec) {
+            double min_scale = 1.0;
+            for (TDeviceCollection::TCursor csr(&DeviceCollection); csr; ++csr) {
+              min_scale = std::min(min_scale, csr->IoBudget.GetScale());
+            }
+            ss << "Disk Controller Background IO Budget Scale = " << min_scale << std::endl;
+          }
         }
 
         /* TODO */
@@ -129,8 +146,15 @@ namespace Orly {
 
 }
 
-TDiskController::TDiskController()
-    : DeviceCollection(this)
+TDiskController::TDiskController(TBackend backend, const TIoBudget::TConfig &io_budget_config)
+    : Backend(backend),
+      IoBudgetConfig(io_budget_config),
+      DeviceCollection(this),
+      Stopping(false),
+      BufferGen(0UL),
+      NumIos(0UL),
+      NumSyscalls(0UL),
+      NumDeferred(0UL)
 #ifndef NDEBUG
     ,NextId(0UL)
 #endif
@@ -140,18 +164,41 @@ TDiskController::TDiskController()
 TDiskController::~TDiskController() {
 }
 
-void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core) {
+void TDiskController::RegisterBuffer(void *buf, size_t size) {
   assert(this);
-  const size_t max_aio_num = 64;
-  size_t inflight = 0UL;
+  assert(buf);
+  std::lock_guard<std::mutex> lock(BufferMutex);
+  BufferVec.push_back(iovec{buf, size});
+  ++BufferGen;
+}
 
-  io_context_t ctxp(0);
-  try {
-    IfWeird(io_setup(max_aio_num, &ctxp));
-  } catch (const std::exception &ex) {
-    syslog(LOG_ERR, "Error in io_setup: [%s]", ex.what());
-    throw;
+TDiskController::TBackend TDiskController::ParseBackend(const std::string &name) {
+  for (TBackend backend : {TBackend::Aio, TBackend::IoUring, TBackend::IoUringPolled}) {
+    if (name == GetBackendName(backend)) {
+      return backend;
+    }
+  }
+  syslog(LOG_ERR, "unknown disk backend [%s]", name.c_str());
+  throw std::invalid_argument("unknown disk backend");
+}
+
+const char *TDiskController::GetBackendName(TBackend backend) {
+  switch (backend) {
+    case TBackend::Aio: {
+      return "aio";
+    }
+    case TBackend::IoUring: {
+      return "io_uring";
+    }
+    case TBackend::IoUringPolled: {
+      return "io_uring_polled";
+    }
   }
+  throw std::logic_error("unhandled disk backend");
+}
+
+void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core) {
+  assert(this);
   cpu_set_t mask;
   CPU_ZERO(&mask);
   CPU_SET(core, &mask);
@@ -160,387 +207,582 @@ void TDiskController::QueueRunner(std::vector<TPersistentDevice *> device_vec, b
   if (!no_realtime) {
     booster.MakeKnown(SCHED_FIFO);
   }
-  const size_t rt_not_to_exceed_depth = 32UL;
-  const size_t medium_not_to_exceed_depth = 6UL;
-  const size_t low_not_to_exceed_depth = 2UL;
-  struct iocb *ioq[std::max(rt_not_to_exceed_depth, std::max(medium_not_to_exceed_depth, low_not_to_exceed_depth)) * device_vec.size()];
-  struct io_event *io_ev = 0;
-  io_ev = new struct io_event[max_aio_num];
   try {
-    memset(io_ev, 0, max_aio_num * sizeof(struct io_event));
-    size_t num_laps_without_work = 0UL;
-    const size_t laps_before_sleep = 5UL;
-    for (;;) {
-      ++num_laps_without_work;
-      if (num_laps_without_work > laps_before_sleep) {
-        this_thread::sleep_for(10000ns);
+    switch (Backend) {
+      case TBackend::Aio: {
+        RunAio(device_vec);
+        break;
       }
-      /* wait for a queue to be ready */
-      for (TPersistentDevice *ready_device : device_vec) {
-        TEvent *cur_tail = __sync_lock_test_and_set(&ready_device->IncomingEventQueue, nullptr);
-        if (cur_tail) {
-          num_laps_without_work = 0UL;
-          /* there were inbound events scheduled against this device. Process these events (which are in reverse order) and put them into their
-             Realtime / Medium / Low priority queues. */
-          TEvent *append_after_rt = ready_device->RealTimePrioEventQueue.TryGetLastMember();
-          TEvent *append_after_m = ready_device->MediumPrioEventQueue.TryGetLastMember();
-          TEvent *append_after_l = ready_device->LowPrioEventQueue.TryGetLastMember();
-          size_t num_dequeue = 0UL;
-          for (TEvent *cur_event = cur_tail; cur_event; cur_event = cur_event->NextEvent, ++num_dequeue) {
-            switch (cur_event->Iocb.aio_reqprio) {
-              case RealTimePriority: {
-                if (append_after_rt) {
-                  cur_event->DeviceMembership.Insert(&append_after_rt->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->RealTimePrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
-              case MediumPriority: {
-                if (append_after_m) {
-                  cur_event->DeviceMembership.Insert(&append_after_m->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->MediumPrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
-              case LowPriority: {
-                if (append_after_l) {
-                  cur_event->DeviceMembership.Insert(&append_after_l->DeviceMembership, InvCon::Fwd);
-                } else {
-                  cur_event->DeviceMembership.Insert(&ready_device->LowPrioEventQueue, InvCon::Rev);
-                }
-                break;
-              }
-            }
-          }
-        }
+      case TBackend::IoUring:
+      case TBackend::IoUringPolled: {
+        RunIoUring(device_vec);
+        break;
       }
-      size_t ioq_pos = 0UL;
-      for (TPersistentDevice *ready_device : device_vec) {
-        if (!ready_device->RealTimePrioEventQueue.IsEmpty() || !ready_device->MediumPrioEventQueue.IsEmpty() || !ready_device->LowPrioEventQueue.IsEmpty()) {
-          num_laps_without_work = 0UL;
-          size_t num_removed = 0UL;
-          size_t cur_inflight = ready_device->Inflight.load();
-          for (TEvent *member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < rt_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
-          }
-          for (TEvent *member = ready_device->MediumPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < medium_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->MediumPrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
+    }
+  } catch (const std::exception &ex) {
+    syslog(LOG_ERR, "QueueRunner caught error [%s]", ex.what());
+    throw;
+  }
+}
+
+size_t TDiskController::Dequeue(const std::vector<TPersistentDevice *> &device_vec, TEvent **ready, bool &found_work) {
+  assert(this);
+  /* wait for a queue to be ready */
+  for (TPersistentDevice *ready_device : device_vec) {
+    TEvent *cur_tail = __sync_lock_test_and_set(&ready_device->IncomingEventQueue, nullptr);
+    if (cur_tail) {
+      found_work = true;
+      /* there were inbound events scheduled against this device. Process these events (which are in reverse order) and put them into their
+         Realtime / Medium / Low priority queues. */
+      TEvent *append_after_rt = ready_device->RealTimePrioEventQueue.TryGetLastMember();
+      TEvent *append_after_m = ready_device->MediumPrioEventQueue.TryGetLastMember();
+      TEvent *append_after_l = ready_device->LowPrioEventQueue.TryGetLastMember();
+      size_t num_dequeue = 0UL;
+      for (TEvent *cur_event = cur_tail; cur_event; cur_event = cur_event->NextEvent, ++num_dequeue) {
+        switch (cur_event->Iocb.aio_reqprio) {
+          case RealTimePriority: {
+            if (append_after_rt) {
+              cur_event->DeviceMembership.Insert(&append_after_rt->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->RealTimePrioEventQueue, InvCon::Rev);
+            }
+            break;
           }
-          for (TEvent *member = ready_device->LowPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < low_not_to_exceed_depth/*num_removed < max_to_submit*/; member = ready_device->LowPrioEventQueue.TryGetFirstMember(), ++num_removed) {
-            ioq[ioq_pos] = &(member->Iocb);
-            ++ioq_pos;
-            member->DeviceMembership.Remove();
+          case MediumPriority: {
+            if (append_after_m) {
+              cur_event->DeviceMembership.Insert(&append_after_m->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->MediumPrioEventQueue, InvCon::Rev);
+            }
+            break;
           }
-          if (num_removed) {
-            ready_device->Inflight += num_removed;
-            #ifndef NDEBUG
-            /* register all these events in the outstanding set */ {
-              std::lock_guard<std::mutex> lock(OutstandingIdMutex);
-              for (size_t i = 0; i < num_removed; ++i) {
-                const size_t this_id = ++NextId;
-                reinterpret_cast<TEvent *>(ioq[i]->data)->RequestId = this_id;
-                OutstandingIdSet.insert(this_id);
-              }
+          case LowPriority: {
+            if (append_after_l) {
+              cur_event->DeviceMembership.Insert(&append_after_l->DeviceMembership, InvCon::Fwd);
+            } else {
+              cur_event->DeviceMembership.Insert(&ready_device->LowPrioEventQueue, InvCon::Rev);
             }
-            #endif
+            break;
           }
         }
       }
-
-      if (ioq_pos > 0) {
-        inflight += ioq_pos;
-        int ret = io_submit(ctxp, ioq_pos, ioq);
-        if (ret < 0) {
-          syslog(LOG_ERR, "Error in io_submit; nr=[%ld]", ioq_pos);
-          for (size_t nr = 0; nr < ioq_pos; ++nr) {
-            switch (ioq[nr]->aio_lio_opcode) {
-              case IO_CMD_PREAD: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREAD, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
-                break;
-              }
-              case IO_CMD_PWRITE: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITE, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
-                break;
-              }
-              case IO_CMD_FSYNC: {
-                throw;
-                break;
-              }
-              case IO_CMD_FDSYNC: {
-                throw;
-                break;
-              }
-              case IO_CMD_POLL: {
-                throw;
-                break;
-              }
-              case IO_CMD_NOOP: {
-                throw;
-                break;
-              }
-              case IO_CMD_PREADV: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREADV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
-                break;
-              }
-              case IO_CMD_PWRITEV: {
-                syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITEV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
-                break;
-              }
-            }
-          }
-          ThrowSystemError(-ret);
+    }
+  }
+  size_t ioq_pos = 0UL;
+  const auto now = TIoBudget::TClock::now();
+  for (TPersistentDevice *ready_device : device_vec) {
+    if (!ready_device->RealTimePrioEventQueue.IsEmpty() || !ready_device->MediumPrioEventQueue.IsEmpty() || !ready_device->LowPrioEventQueue.IsEmpty()) {
+      size_t num_removed = 0UL;
+      size_t cur_inflight = ready_device->Inflight.load();
+      /* medium and low priority events must also fit in the device's budget */
+      bool is_deferred = false;
+      auto try_take = [ready_device, now, &is_deferred](const TEvent *member) {
+        if (ready_device->IoBudget.TryTake(member->GetNumBytes(), now)) {
+          return true;
         }
-        if (ret != static_cast<int>(ioq_pos)) {
-          syslog(LOG_ERR, "io_submit did not sumbit as as many events as requested [%ld] vs. [%d]", ioq_pos, ret);
-          throw;
+        is_deferred = true;
+        return false;
+      };
+      for (TEvent *member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < RealTimeNotToExceedDepth; member = ready_device->RealTimePrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        ready[ioq_pos] = member;
+        ++ioq_pos;
+        member->DeviceMembership.Remove();
+      }
+      for (TEvent *member = ready_device->MediumPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < MediumNotToExceedDepth && try_take(member); member = ready_device->MediumPrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        ready[ioq_pos] = member;
+        ++ioq_pos;
+        member->DeviceMembership.Remove();
+      }
+      for (TEvent *member = ready_device->LowPrioEventQueue.TryGetFirstMember(); member && (cur_inflight + num_removed) < LowNotToExceedDepth && try_take(member); member = ready_device->LowPrioEventQueue.TryGetFirstMember(), ++num_removed) {
+        ready[ioq_pos] = member;
+        ++ioq_pos;
+        member->DeviceMembership.Remove();
+      }
+      /* if we sent nothing because the budget is spent, there's nothing to do until it refills, so let the runner nap */
+      if (is_deferred) {
+        ++NumDeferred;
+      }
+      if (num_removed || !is_deferred) {
+        found_work = true;
+      }
+      if (num_removed) {
+        ready_device->Inflight += num_removed;
+        #ifndef NDEBUG
+        /* register all these events in the outstanding set */ {
+          std::lock_guard<std::mutex> lock(OutstandingIdMutex);
+          for (size_t i = ioq_pos - num_removed; i < ioq_pos; ++i) {
+            const size_t this_id = ++NextId;
+            ready[i]->RequestId = this_id;
+            OutstandingIdSet.insert(this_id);
+          }
         }
+        #endif
       }
+    }
+  }
+  NumIos += ioq_pos;
+  return ioq_pos;
+}
 
-      if (inflight > 0) {
-        int num_popped = io_getevents(ctxp, 1, max_aio_num, io_ev, NULL);
-        if (num_popped > 0) {
-          inflight -= num_popped;
+void TDiskController::Complete(const TCompletion *completions, size_t num_completions) {
+  assert(this);
+  try {
+
+    #ifndef NDEBUG
+    /* check and remove all these events in the outstanding set */ {
+      std::lock_guard<std::mutex> lock(OutstandingIdMutex);
+      for (size_t i = 0; i < num_completions; ++i) {
+        const size_t request_id = completions[i].Event->RequestId;
+        auto pos = OutstandingIdSet.find(request_id);
+        if (pos == OutstandingIdSet.end()) {
+          syslog(LOG_ERR, "Completing request id [%ld] that was not outstanding.", request_id);
+          throw std::runtime_error("Completing request id that was not outstanding");
         }
-        try {
+        OutstandingIdSet.erase(pos);
+      }
+    }
+    #endif
 
-          #ifndef NDEBUG
-          /* check and remove all these events in the outstanding set */ {
-            std::lock_guard<std::mutex> lock(OutstandingIdMutex);
-            for (int i = 0; i < num_popped; ++i) {
-              TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-              const size_t request_id = compl_event->RequestId;
-              auto pos = OutstandingIdSet.find(request_id);
-              if (pos == OutstandingIdSet.end()) {
-                syslog(LOG_ERR, "Completing request id [%ld] that was not outstanding.", request_id);
-                throw std::runtime_error("Completing request id that was not outstanding");
+    const auto now = TIoBudget::TClock::now();
+    for (size_t i = 0; i < num_completions; ++i) {
+      TEvent *compl_event = completions[i].Event;
+      const struct iocb &io = compl_event->Iocb;
+      --compl_event->Device->Inflight;
+      if (io.aio_reqprio == RealTimePriority && (io.aio_lio_opcode == IO_CMD_PREAD || io.aio_lio_opcode == IO_CMD_PREADV)) {
+        compl_event->Device->IoBudget.ObserveRead(now - compl_event->QueuedAt, now);
+      }
+      try {
+        switch (compl_event->Kind) {
+          case TEvent::TriggeredRead: {
+            if (likely(completions[i].Res == io.u.c.nbytes && completions[i].Res2 == 0)) {
+              bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
+              if (likely(passed_corruption_check)) {
+                compl_event->TriggerOp->Callback(Success, "");
+              } else {
+                stringstream ss;
+                ss << compl_event->CodeLocation;
+                syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+                if (compl_event->AbortOnError) {
+                  abort();
+                }
+                compl_event->TriggerOp->Callback(Error, "Corrupt Data");
               }
-              OutstandingIdSet.erase(pos);
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->TriggerOp->Callback(Error, "Disk Error");
             }
+            break;
           }
-          #endif
-
-          for (int i = 0; i < num_popped; ++i) {
-            TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-            const struct iocb &io = compl_event->Iocb;
-            --compl_event->Device->Inflight;
-            try {
-              switch (compl_event->Kind) {
-                case TEvent::TriggeredRead: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
-                    if (likely(passed_corruption_check)) {
-                      compl_event->TriggerOp->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->TriggerOp->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerOp->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::TriggeredReadV: {
-                  long long offset = io_ev[i].obj->u.v.offset;
-                  int nr = io_ev[i].obj->u.v.nr;
-                  size_t expected_size = 0UL;
-                  for (int j = 0; j < nr; ++j) {
-                    expected_size += io_ev[i].obj->u.v.vec[j].iov_len;
-                  }
-                  if (likely(io_ev[i].res == expected_size && io_ev[i].res2 == 0)) {
-                    assert(io_ev[i].obj->aio_lio_opcode == IO_CMD_PREADV);
-                    assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
-                    bool passed_corruption_check = true;
-                    long long processed = 0UL;
-                    for (int n = 0; n < nr; ++n) {
-                      if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io_ev[i].obj->u.v.vec[n].iov_base, offset + processed, io_ev[i].obj->u.v.vec[n].iov_len))) {
-                        passed_corruption_check = false;
-                        break;
-                      }
-                      processed += io_ev[i].obj->u.v.vec[n].iov_len;
-                    }
-                    if (likely(passed_corruption_check)) {
-                      compl_event->TriggerVOp.Trigger->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->TriggerVOp.Trigger->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerVOp.Trigger->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::TriggeredWrite: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    compl_event->TriggerOp->Callback(Success, "");
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->TriggerOp->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackRead: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
-                    if (likely(passed_corruption_check)) {
-                      compl_event->CallbackOp(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->CallbackOp(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackOp(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackReadV: {
-                  long long offset = io_ev[i].obj->u.v.offset;
-                  int nr = io_ev[i].obj->u.v.nr;
-                  size_t expected_size = 0UL;
-                  for (int j = 0; j < nr; ++j) {
-                    expected_size += io_ev[i].obj->u.v.vec[j].iov_len;
-                  }
-                  if (likely(io_ev[i].res == expected_size && io_ev[i].res2 == 0)) {
-                    assert(io_ev[i].obj->aio_lio_opcode == IO_CMD_PREADV);
-                    assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
-                    bool passed_corruption_check = true;
-                    long long processed = 0UL;
-                    for (int n = 0; n < nr; ++n) {
-                      if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io_ev[i].obj->u.v.vec[n].iov_base, offset + processed, io_ev[i].obj->u.v.vec[n].iov_len))) {
-                        passed_corruption_check = false;
-                        break;
-                      }
-                      processed += io_ev[i].obj->u.v.vec[n].iov_len;
-                    }
-                    if (likely(passed_corruption_check)) {
-                      compl_event->CallbackVOp.GroupRequest->Callback(Success, "");
-                    } else {
-                      stringstream ss;
-                      ss << compl_event->CodeLocation;
-                      syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                      if (compl_event->AbortOnError) {
-                        abort();
-                      }
-                      compl_event->CallbackVOp.GroupRequest->Callback(Error, "Corrupt Data");
-                    }
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackVOp.GroupRequest->Callback(Error, "Disk Error");
-                  }
-                  break;
-                }
-                case TEvent::CallbackWrite: {
-                  if (likely(io_ev[i].res == io.u.c.nbytes && io_ev[i].res2 == 0)) {
-                    compl_event->CallbackOp(Success, "");
-                  } else {
-                    stringstream ss;
-                    ss << compl_event->CodeLocation;
-                    syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", io_ev[i].res, io_ev[i].res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
-                    if (compl_event->AbortOnError) {
-                      abort();
-                    }
-                    compl_event->CallbackOp(Error, "Disk Error");
-                  }
+          case TEvent::TriggeredReadV: {
+            long long offset = io.u.v.offset;
+            int nr = io.u.v.nr;
+            size_t expected_size = 0UL;
+            for (int j = 0; j < nr; ++j) {
+              expected_size += io.u.v.vec[j].iov_len;
+            }
+            if (likely(completions[i].Res == expected_size && completions[i].Res2 == 0)) {
+              assert(io.aio_lio_opcode == IO_CMD_PREADV);
+              assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
+              bool passed_corruption_check = true;
+              long long processed = 0UL;
+              for (int n = 0; n < nr; ++n) {
+                if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.v.vec[n].iov_base, offset + processed, io.u.v.vec[n].iov_len))) {
+                  passed_corruption_check = false;
                   break;
                 }
+                processed += io.u.v.vec[n].iov_len;
               }
-            } catch (const std::exception &ex) {
-              std::cerr << "Caught error while completing io : [" << compl_event->CodeLocation << "] Kind [";
-              switch(compl_event->Kind) {
-                case TEvent::TriggeredRead: {
-                  std::cerr << "TriggeredRead";
-                  break;
-                }
-                case TEvent::TriggeredReadV: {
-                  std::cerr << "TriggeredReadV";
-                  break;
-                }
-                case TEvent::TriggeredWrite: {
-                  std::cerr << "TriggeredWrite";
-                  break;
+              if (likely(passed_corruption_check)) {
+                compl_event->TriggerVOp.Trigger->Callback(Success, "");
+              } else {
+                stringstream ss;
+                ss << compl_event->CodeLocation;
+                syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+                if (compl_event->AbortOnError) {
+                  abort();
                 }
-                case TEvent::CallbackRead: {
-                  std::cerr << "CallbackRead";
-                  break;
+                compl_event->TriggerVOp.Trigger->Callback(Error, "Corrupt Data");
+              }
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->TriggerVOp.Trigger->Callback(Error, "Disk Error");
+            }
+            break;
+          }
+          case TEvent::TriggeredWrite: {
+            if (likely(completions[i].Res == io.u.c.nbytes && completions[i].Res2 == 0)) {
+              compl_event->TriggerOp->Callback(Success, "");
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->TriggerOp->Callback(Error, "Disk Error");
+            }
+            break;
+          }
+          case TEvent::CallbackRead: {
+            if (likely(completions[i].Res == io.u.c.nbytes && completions[i].Res2 == 0)) {
+              bool passed_corruption_check = compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.c.buf, io.u.c.offset, io.u.c.nbytes);
+              if (likely(passed_corruption_check)) {
+                compl_event->CallbackOp(Success, "");
+              } else {
+                stringstream ss;
+                ss << compl_event->CodeLocation;
+                syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+                if (compl_event->AbortOnError) {
+                  abort();
                 }
-                case TEvent::CallbackReadV: {
-                  std::cerr << "CallbackReadV";
+                compl_event->CallbackOp(Error, "Corrupt Data");
+              }
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->CallbackOp(Error, "Disk Error");
+            }
+            break;
+          }
+          case TEvent::CallbackReadV: {
+            long long offset = io.u.v.offset;
+            int nr = io.u.v.nr;
+            size_t expected_size = 0UL;
+            for (int j = 0; j < nr; ++j) {
+              expected_size += io.u.v.vec[j].iov_len;
+            }
+            if (likely(completions[i].Res == expected_size && completions[i].Res2 == 0)) {
+              assert(io.aio_lio_opcode == IO_CMD_PREADV);
+              assert(static_cast<size_t>(nr) == compl_event->TriggerVOp.IoVCnt);
+              bool passed_corruption_check = true;
+              long long processed = 0UL;
+              for (int n = 0; n < nr; ++n) {
+                if (unlikely(!compl_event->Device->CheckCorruptCheck(compl_event->BufKind, io.u.v.vec[n].iov_base, offset + processed, io.u.v.vec[n].iov_len))) {
+                  passed_corruption_check = false;
                   break;
                 }
-                case TEvent::CallbackWrite: {
-                  std::cerr << "CallbackWrite";
-                  break;
+                processed += io.u.v.vec[n].iov_len;
+              }
+              if (likely(passed_corruption_check)) {
+                compl_event->CallbackVOp.GroupRequest->Callback(Success, "");
+              } else {
+                stringstream ss;
+                ss << compl_event->CodeLocation;
+                syslog(LOG_ERR, "Corrupt data Reading @ [%lld] in device [%s] from [%s]", offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+                if (compl_event->AbortOnError) {
+                  abort();
                 }
+                compl_event->CallbackVOp.GroupRequest->Callback(Error, "Corrupt Data");
               }
-              std::cerr << "]" << std::endl;
-              throw;
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Reading @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->CallbackVOp.GroupRequest->Callback(Error, "Disk Error");
+            }
+            break;
+          }
+          case TEvent::CallbackWrite: {
+            if (likely(completions[i].Res == io.u.c.nbytes && completions[i].Res2 == 0)) {
+              compl_event->CallbackOp(Success, "");
+            } else {
+              stringstream ss;
+              ss << compl_event->CodeLocation;
+              syslog(LOG_ERR, "Disk Error res=[%ld], res2=[%ld] Writing @ [%lld] in device [%s] from [%s]", completions[i].Res, completions[i].Res2, io.u.c.offset, compl_event->Device->GetDevicePath(), ss.str().c_str());
+              if (compl_event->AbortOnError) {
+                abort();
+              }
+              compl_event->CallbackOp(Error, "Disk Error");
             }
+            break;
+          }
+        }
+      } catch (const std::exception &ex) {
+        std::cerr << "Caught error while completing io : [" << compl_event->CodeLocation << "] Kind [";
+        switch(compl_event->Kind) {
+          case TEvent::TriggeredRead: {
+            std::cerr << "TriggeredRead";
+            break;
+          }
+          case TEvent::TriggeredReadV: {
+            std::cerr << "TriggeredReadV";
+            break;
+          }
+          case TEvent::TriggeredWrite: {
+            std::cerr << "TriggeredWrite";
+            break;
+          }
+          case TEvent::CallbackRead: {
+            std::cerr << "CallbackRead";
+            break;
+          }
+          case TEvent::CallbackReadV: {
+            std::cerr << "CallbackReadV";
+            break;
           }
-          /* now that we're done completing all the events, reset them and give them back to their pool. */
-          for (int i = 0; i < num_popped; ++i) {
-            TEvent *compl_event = reinterpret_cast<TEvent *>(io_ev[i].data);
-            compl_event->Reset(true);
+          case TEvent::CallbackWrite: {
+            std::cerr << "CallbackWrite";
+            break;
           }
-        } catch (const std::exception &ex) {
-          syslog(LOG_ERR, "QueueRunner caught error while iterating over completion events");
-          throw;
         }
+        std::cerr << "]" << std::endl;
+        throw;
       }
     }
+    /* now that we're done completing all the events, reset them and give them back to their pool. */
+    for (size_t i = 0; i < num_completions; ++i) {
+      TEvent *compl_event = completions[i].Event;
+      compl_event->Reset(true);
+    }
   } catch (const std::exception &ex) {
-    syslog(LOG_ERR, "QueueRunner caught error [%s]", ex.what());
+    syslog(LOG_ERR, "QueueRunner caught error while iterating over completion events");
     throw;
-  } catch (...) {
+  }
+}
+
+void TDiskController::RunAio(const std::vector<TPersistentDevice *> &device_vec) {
+  assert(this);
+  const size_t max_aio_num = 64;
+  size_t inflight = 0UL;
+
+  io_context_t ctxp(0);
+  try {
+    IfWeird(io_setup(max_aio_num, &ctxp));
+  } catch (const std::exception &ex) {
+    syslog(LOG_ERR, "Error in io_setup: [%s]", ex.what());
     throw;
   }
+  TEvent *ready[RealTimeNotToExceedDepth * device_vec.size()];
+  struct iocb *ioq[RealTimeNotToExceedDepth * device_vec.size()];
+  struct io_event io_ev[max_aio_num];
+  TCompletion completions[max_aio_num];
+  memset(io_ev, 0, max_aio_num * sizeof(struct io_event));
+  size_t num_laps_without_work = 0UL;
+  const size_t laps_before_sleep = 5UL;
+  while (inflight || !Stopping) {
+    ++num_laps_without_work;
+    if (num_laps_without_work > laps_before_sleep) {
+      this_thread::sleep_for(10000ns);
+    }
+    bool found_work = false;
+    const size_t ioq_pos = Dequeue(device_vec, ready, found_work);
+    if (found_work) {
+      num_laps_without_work = 0UL;
+    }
+    for (size_t i = 0; i < ioq_pos; ++i) {
+      ioq[i] = &ready[i]->Iocb;
+    }
+
+    if (ioq_pos > 0) {
+      inflight += ioq_pos;
+      ++NumSyscalls;
+      int ret = io_submit(ctxp, ioq_pos, ioq);
+      if (ret < 0) {
+        syslog(LOG_ERR, "Error in io_submit; nr=[%ld]", ioq_pos);
+        for (size_t nr = 0; nr < ioq_pos; ++nr) {
+          switch (ioq[nr]->aio_lio_opcode) {
+            case IO_CMD_PREAD: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREAD, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
+              break;
+            }
+            case IO_CMD_PWRITE: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITE, offset=[%lld], nbytes=[%ld]", nr, ioq[nr]->u.c.offset, ioq[nr]->u.c.nbytes);
+              break;
+            }
+            case IO_CMD_FSYNC: {
+              throw;
+              break;
+            }
+            case IO_CMD_FDSYNC: {
+              throw;
+              break;
+            }
+            case IO_CMD_POLL: {
+              throw;
+              break;
+            }
+            case IO_CMD_NOOP: {
+              throw;
+              break;
+            }
+            case IO_CMD_PREADV: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PREADV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
+              break;
+            }
+            case IO_CMD_PWRITEV: {
+              syslog(LOG_INFO, "ioq[%ld] IO_CMD_PWRITEV, nr=[%d], offset=[%lld], size=[%ld]", nr, ioq[nr]->u.v.nr, ioq[nr]->u.v.offset, ioq[nr]->u.v.vec[0].iov_len);
+              break;
+            }
+          }
+        }
+        ThrowSystemError(-ret);
+      }
+      if (ret != static_cast<int>(ioq_pos)) {
+        syslog(LOG_ERR, "io_submit did not sumbit as as many events as requested [%ld] vs. [%d]", ioq_pos, ret);
+        throw;
+      }
+    }
+
+    if (inflight > 0) {
+      ++NumSyscalls;
+      int num_popped = io_getevents(ctxp, 1, max_aio_num, io_ev, NULL);
+      if (num_popped > 0) {
+        inflight -= num_popped;
+        for (int i = 0; i < num_popped; ++i) {
+          completions[i] = TCompletion{reinterpret_cast<TEvent *>(io_ev[i].data), io_ev[i].res, io_ev[i].res2};
+        }
+        Complete(completions, num_popped);
+      }
+    }
+  }
+  io_destroy(ctxp);
+}
+
+void TDiskController::RunIoUring(const std::vector<TPersistentDevice *> &device_vec) {
+  assert(this);
+  const bool polled = (Backend == TBackend::IoUringPolled);
+  std::unique_ptr<TIoUring> ring;
+  try {
+    ring = std::make_unique<TIoUring>(std::max(64UL, RealTimeNotToExceedDepth * device_vec.size()), polled);
+  } catch (const std::exception &ex) {
+    syslog(LOG_ERR, "Could not set up io_uring, falling back to aio: [%s]", ex.what());
+    RunAio(device_vec);
+    return;
+  }
+  const size_t max_ring_num = ring->GetNumEntries();
+  size_t inflight = 0UL;
+  TEvent *ready[RealTimeNotToExceedDepth * device_vec.size()];
+  TCompletion completions[max_ring_num];
+  /* the buffers the kernel has pinned for us, in the order it numbers them */
+  std::vector<struct iovec> registered_vec;
+  size_t registered_gen = 0UL;
+  size_t num_laps_without_work = 0UL;
+  const size_t laps_before_sleep = 5UL;
+  while (inflight || !Stopping) {
+    ++num_laps_without_work;
+    if (num_laps_without_work > laps_before_sleep) {
+      this_thread::sleep_for(10000ns);
+    }
+    /* the kernel won't swap out registered buffers under I/O in flight, so only pick up new ones when we're idle */
+    if (!inflight && registered_gen != BufferGen) {
+      std::vector<struct iovec> buffer_vec;
+      /* extra */ {
+        std::lock_guard<std::mutex> lock(BufferMutex);
+        registered_gen = BufferGen;
+        for (const auto &buffer : BufferVec) {
+          for (size_t offset = 0UL; offset < buffer.iov_len; offset += TIoUring::MaxRegisteredBufferSize) {
+            buffer_vec.push_back(iovec{static_cast<char *>(buffer.iov_base) + offset, std::min(TIoUring::MaxRegisteredBufferSize, buffer.iov_len - offset)});
+          }
+        }
+      }
+      registered_vec.clear();
+      if (ring->RegisterBuffers(buffer_vec)) {
+        registered_vec = std::move(buffer_vec);
+      }
+    }
+    bool found_work = false;
+    const size_t ioq_pos = Dequeue(device_vec, ready, found_work);
+    if (found_work) {
+      num_laps_without_work = 0UL;
+    }
+    for (size_t i = 0; i < ioq_pos; ++i) {
+      const struct iocb &io = ready[i]->Iocb;
+      struct io_uring_sqe *sqe = ring->TryGetSqe();
+      /* we never have more in flight than the depth limits allow, and the ring is at least that deep */
+      assert(sqe);
+      sqe->fd = io.aio_fildes;
+      sqe->user_data = reinterpret_cast<uint64_t>(ready[i]);
+      switch (io.aio_lio_opcode) {
+        case IO_CMD_PREAD:
+        case IO_CMD_PWRITE: {
+          const bool is_read = (io.aio_lio_opcode == IO_CMD_PREAD);
+          sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+          sqe->addr = reinterpret_cast<uint64_t>(io.u.c.buf);
+          sqe->len = io.u.c.nbytes;
+          sqe->off = io.u.c.offset;
+          const char *buf = static_cast<const char *>(io.u.c.buf);
+          for (size_t idx = 0; idx < registered_vec.size(); ++idx) {
+            const char *base = static_cast<const char *>(registered_vec[idx].iov_base);
+            if (buf >= base && buf + io.u.c.nbytes <= base + registered_vec[idx].iov_len) {
+              sqe->opcode = is_read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+              sqe->buf_index = idx;
+              break;
+            }
+          }
+          break;
+        }
+        case IO_CMD_PREADV: {
+          sqe->opcode = IORING_OP_READV;
+          sqe->addr = reinterpret_cast<uint64_t>(io.u.v.vec);
+          sqe->len = io.u.v.nr;
+          sqe->off = io.u.v.offset;
+          break;
+        }
+        case IO_CMD_PWRITEV: {
+          sqe->opcode = IORING_OP_WRITEV;
+          sqe->addr = reinterpret_cast<uint64_t>(io.u.v.vec);
+          sqe->len = io.u.v.nr;
+          sqe->off = io.u.v.offset;
+          break;
+        }
+        default: {
+          syslog(LOG_ERR, "io_uring backend got unsupported opcode [%d]", io.aio_lio_opcode);
+          throw std::logic_error("unsupported disk opcode");
+        }
+      }
+      /* real time I/O goes to the head of the best effort class; background I/O to its tail. */
+      switch (io.aio_reqprio) {
+        case RealTimePriority: {
+          sqe->ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 0);
+          break;
+        }
+        case MediumPriority: {
+          sqe->ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 4);
+          break;
+        }
+        case LowPriority: {
+          sqe->ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 7);
+          break;
+        }
+      }
+    }
+    /* counts entries still sitting in the submission queue, too; the ring resubmits them until the kernel takes them */
+    inflight += ioq_pos;
+    if (ioq_pos || inflight) {
+      /* submit the batch and wait for at least one completion in the same trip into the kernel */
+      ++NumSyscalls;
+      const size_t num_submitted = ring->Submit(inflight ? 1UL : 0UL);
+      size_t num_popped = 0UL;
+      ring->ForEachCompletion([&](const struct io_uring_cqe &cqe) {
+        /* a negative result is an errno, which the completion logic treats like any other short transfer */
+        completions[num_popped++] = TCompletion{reinterpret_cast<TEvent *>(cqe.user_data), static_cast<unsigned long>(static_cast<long>(cqe.res)), 0UL};
+      });
+      if (num_popped) {
+        inflight -= num_popped;
+        Complete(completions, num_popped);
+      } else if (!num_submitted) {
+        /* the kernel turned us away without taking or finishing anything, so give it a moment before we try again */
+        this_thread::sleep_for(10000ns);
+      }
+    }
+  }
 }
 
 void TDiskController::TEvent::Init(TPersistentDevice *device,
@@ -748,6 +990,8 @@ void TDiskController::TEvent::Reset(bool back_to_pool) {
       break;
     }
   }
+  /* there's nothing left to tear down, so make sure a second reset (say, by the destructor) doesn't try */
+  Kind = TriggeredRead;
   if (back_to_pool) {
     EventPool->Free(this);
   }
@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <limits>
+#include <mutex>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -48,6 +51,7 @@
 #include <orly/indy/disk/priority.h>
 #include <orly/indy/disk/result.h>
 #include <orly/indy/disk/util/device_util.h>
+#include <orly/indy/disk/util/io_budget.h>
 #include <util/error.h>
 
 namespace Orly {
@@ -355,7 +359,7 @@ namespace Orly {
             };
 
             /* TODO */
-            TEvent() : Device(nullptr), NextEvent(nullptr), DeviceMembership(this), EventPool(nullptr) {}
+            TEvent() : Device(nullptr), NextEvent(nullptr), DeviceMembership(this), EventPool(nullptr), Kind(TriggeredRead) {}
 
             /* TODO */
             ~TEvent();
@@ -448,6 +452,7 @@ namespace Orly {
               switch (priority) {
                 case RealTime: {
                   Iocb.aio_reqprio = RealTimePriority;
+                  QueuedAt = TIoBudget::TClock::now();
                   break;
                 }
                 case Medium: {
@@ -462,6 +467,24 @@ namespace Orly {
               Iocb.data = this;
             }
 
+            /* The number of bytes we move. */
+            inline size_t GetNumBytes() const {
+              assert(this);
+              switch (Iocb.aio_lio_opcode) {
+                case IO_CMD_PREADV:
+                case IO_CMD_PWRITEV: {
+                  size_t num_bytes = 0UL;
+                  for (int i = 0; i < Iocb.u.v.nr; ++i) {
+                    num_bytes += Iocb.u.v.vec[i].iov_len;
+                  }
+                  return num_bytes;
+                }
+                default: {
+                  return Iocb.u.c.nbytes;
+                }
+              }
+            }
+
             /* TODO */
             TPersistentDevice *Device;
 
@@ -487,6 +510,9 @@ namespace Orly {
             /* TODO */
             bool AbortOnError;
 
+            /* When a real time event was queued, so we can time it. */
+            TIoBudget::TClock::time_point QueuedAt;
+
             #ifndef NDEBUG
             /* TODO */
             size_t RequestId;
@@ -516,8 +542,16 @@ namespace Orly {
 
           };  // TEvent
 
-          /* TODO */
-          TDiskController();
+          /* The kernel interface a queue runner uses to get I/O to its devices.  IoUringPolled finds completions by polling the
+             device rather than waiting for an interrupt; it only makes sense on NVMe devices set up with poll queues. */
+          enum class TBackend {
+            Aio,
+            IoUring,
+            IoUringPolled
+          };
+
+          /* Every device we drive gets a background I/O budget made from the given config. */
+          explicit TDiskController(TBackend backend = TBackend::Aio, const TIoBudget::TConfig &io_budget_config = TIoBudget::TConfig());
 
           /* TODO */
           ~TDiskController();
@@ -528,22 +562,95 @@ namespace Orly {
             return &DeviceCollection;
           }
 
+          /* The backend our queue runners use. */
+          inline TBackend GetBackend() const {
+            assert(this);
+            return Backend;
+          }
+
+          /* What each device's background I/O budget is made from. */
+          inline const TIoBudget::TConfig &GetIoBudgetConfig() const {
+            assert(this);
+            return IoBudgetConfig;
+          }
+
           /* TODO */
           void QueueRunner(std::vector<TPersistentDevice *> device_vec, bool no_realtime, size_t core);
 
+          /* Ask every queue runner to return once it has nothing in flight. */
+          void Stop() {
+            assert(this);
+            Stopping = true;
+          }
+
+          /* Memory which I/O buffers will be carved out of for as long as we live, such as the pages of a cache.  Backends which can
+             pin memory up front (io_uring) do so, sparing the kernel from mapping these buffers in on every I/O. */
+          void RegisterBuffer(void *buf, size_t size);
+
           /* TODO */
           void Report(std::stringstream &ss, double elapsed_time) const;
 
+          /* The backend of the given name: "aio", "io_uring" or "io_uring_polled".  Throws if the name is unknown. */
+          static TBackend ParseBackend(const std::string &name);
+
+          /* The name of the given backend, as understood by ParseBackend(). */
+          static const char *GetBackendName(TBackend backend);
+
           private:
 
+          /* An event the kernel is done with, and how it went. */
+          struct TCompletion {
+            TEvent *Event;
+            unsigned long Res;
+            unsigned long Res2;
+          };
+
+          /* QueueRunner() for each backend. */
+          void RunAio(const std::vector<TPersistentDevice *> &device_vec);
+          void RunIoUring(const std::vector<TPersistentDevice *> &device_vec);
+
+          /* Move newly arrived events into their devices' priority queues, then take as many events off those queues as the depth
+             limits allow, storing them in 'ready'.  Returns the number of events taken.  Sets 'found_work' if there was anything
+             to look at. */
+          size_t Dequeue(const std::vector<TPersistentDevice *> &device_vec, TEvent **ready, bool &found_work);
+
+          /* Finish the given events, then give them back to their pools. */
+          void Complete(const TCompletion *completions, size_t num_completions);
+
           /* TODO */
           static constexpr int RealTimePriority = -2;
           static constexpr int MediumPriority = 2;
           static constexpr int LowPriority = 4;
 
+          /* The most events of each priority we allow in flight against a single device. */
+          static constexpr size_t RealTimeNotToExceedDepth = 32UL;
+          static constexpr size_t MediumNotToExceedDepth = 6UL;
+          static constexpr size_t LowNotToExceedDepth = 2UL;
+
+          /* See accessor. */
+          const TBackend Backend;
+
+          /* See accessor. */
+          const TIoBudget::TConfig IoBudgetConfig;
+
           /* TODO */
           mutable TDeviceCollection::TImpl DeviceCollection;
 
+          /* See Stop(). */
+          std::atomic<bool> Stopping;
+
+          /* The memory given to RegisterBuffer(), and a count of the times it has changed so queue runners know to pick it up. */
+          std::vector<struct iovec> BufferVec;
+          std::atomic<size_t> BufferGen;
+          std::mutex BufferMutex;
+
+          /* Reported, then reset, by Report(). */
+          mutable std::atomic<size_t> NumIos;
+          mutable std::atomic<size_t> NumSyscalls;
+
+          /* Reported, then reset, by Report().  The number of times a background event had to wait on its device's budget. */
+          mutable std::atomic<size_t> NumDeferred;
+
           #ifndef NDEBUG
           /* TODO */
           std::unordered_set<size_t> OutstandingIdSet;
@@ -791,7 +898,8 @@ namespace Orly {
                 DiscardSupport(false),
                 DiscardMaxBytes(0UL),
                 DiscardGranularity(0UL),
-                Inflight(0UL) {
+                Inflight(0UL),
+                IoBudget(controller->GetIoBudgetConfig()) {
             assert(Desc.Capacity % getpagesize() == 0);
             try {
               DiskFd = open(device_path, O_RDWR | O_DIRECT);
@@ -947,6 +1055,9 @@ namespace Orly {
           /* TODO */
           std::atomic<size_t> Inflight;
 
+          /* Paces our medium and low priority events.  Only our queue runner touches it. */
+          TIoBudget IoBudget;
+
           /* TODO */
           friend class TDiskController;
 
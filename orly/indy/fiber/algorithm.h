@@ -17,7 +17,11 @@
 #pragma once
 
 #include <algorithm>
+#include <exception>
+#include <functional>
+#include <memory>
 #include <type_traits>
+#include <vector>
 
 #include <orly/indy/fiber/fiber.h>
 #include <util/stl.h>
@@ -31,7 +35,7 @@ namespace Orly {
       /* TODO */
       template <
           typename TRandomAccessIterator,
-          typename TVal = typename Util::ForIter<TRandomAccessIterator>::TVal,
+          typename TVal = typename ::Util::ForIter<TRandomAccessIterator>::TVal,
           typename TComparator = std::less<TVal>>
       class TSubSortRunnable
           : public TRunnable {
@@ -78,7 +82,7 @@ namespace Orly {
       /* TODO */
       template <
           typename TRandomAccessIterator,
-          typename TVal = typename Util::ForIter<TRandomAccessIterator>::TVal,
+          typename TVal = typename ::Util::ForIter<TRandomAccessIterator>::TVal,
           typename TComparator = std::less<TVal>>
       class TInplaceMergeRunnable
           : public TRunnable {
@@ -131,7 +135,7 @@ namespace Orly {
       template <
           size_t ParallelThreshold,
           typename TRandomAccessIterator,
-          typename TVal = typename Util::ForIter<TRandomAccessIterator>::TVal,
+          typename TVal = typename ::Util::ForIter<TRandomAccessIterator>::TVal,
           typename TComparator = std::less<TVal>>
       void Sort(TRunnerPool &work_pool,
                 TRandomAccessIterator begin,
@@ -214,6 +218,98 @@ namespace Orly {
         }
       }
 
+      /* Runs one call of a ForEach(), as its own frame on the runner it was given. */
+      class TForEachRunnable
+          : public TRunnable {
+        NO_COPY(TForEachRunnable);
+        public:
+
+        /* Latches a frame to call func(idx) on the runner. */
+        TForEachRunnable(TRunner *runner,
+                         const std::function<void (size_t)> &func,
+                         size_t idx,
+                         TSafeSync &safe_sync)
+            : Func(func), Idx(idx), SafeSync(safe_sync) {
+          SafeSync.WaitForMore(1UL);
+          Frame = TFrame::LocalFramePool->Alloc();
+          try {
+            Frame->Latch(runner, this, static_cast<TRunnable::TFunc>(&TForEachRunnable::Run), true);
+          } catch (...) {
+            TFrame::LocalFramePool->Free(Frame);
+            SafeSync.Complete();
+            throw;
+          }
+        }
+
+        /* Only once the sync says we're done. */
+        ~TForEachRunnable() {
+          assert(this);
+          TFrame::LocalFramePool->Free(Frame);
+        }
+
+        /* Rethrow whatever the call threw, if anything. */
+        void RethrowIfFailed() const {
+          assert(this);
+          if (Error) {
+            std::rethrow_exception(Error);
+          }
+        }
+
+        private:
+
+        /* The frame's entry point. */
+        void Run() {
+          assert(this);
+          try {
+            Func(Idx);
+          } catch (...) {
+            Error = std::current_exception();
+          }
+          SafeSync.Complete();
+        }
+
+        /* The frame we run on. */
+        TFrame *Frame;
+
+        /* What to call, and with what. */
+        const std::function<void (size_t)> &Func;
+        const size_t Idx;
+
+        /* Told when we've finished. */
+        TSafeSync &SafeSync;
+
+        /* What the call threw, if anything. */
+        std::exception_ptr Error;
+
+      };  // TForEachRunnable
+
+      /* Calls func(0) through func(count - 1), each in its own frame, dealt round-robin across the given runners, and waits for all of
+         them.  If any of the calls throws, we rethrow the first such once they've all finished.  This must be called from a fiber.  Given
+         no runners, or only one call to make, we just make the calls here, in order. */
+      inline void ForEach(const std::vector<TRunner *> &runner_vec, size_t count, const std::function<void (size_t)> &func) {
+        if (runner_vec.empty() || count < 2UL) {
+          for (size_t i = 0; i < count; ++i) {
+            func(i);
+          }
+          return;
+        }
+        TSafeSync safe_sync;
+        std::vector<std::unique_ptr<TForEachRunnable>> runnable_vec;
+        runnable_vec.reserve(count);
+        try {
+          for (size_t i = 0; i < count; ++i) {
+            runnable_vec.emplace_back(new TForEachRunnable(runner_vec[i % runner_vec.size()], func, i, safe_sync));
+          }
+        } catch (...) {
+          safe_sync.Sync();
+          throw;
+        }
+        safe_sync.Sync();
+        for (const auto &runnable : runnable_vec) {
+          runnable->RethrowIfFailed();
+        }
+      }
+
     }  // Fiber
 
   }  // Indy
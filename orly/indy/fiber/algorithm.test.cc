@@ -19,6 +19,9 @@
 #include <orly/indy/fiber/algorithm.h>
 
 #include <algorithm>
+#include <atomic>
+#include <set>
+#include <stdexcept>
 #include <thread>
 
 #include <unistd.h>
@@ -187,3 +190,150 @@ FIXTURE(LargeParallelSort) {
   random_shuffle(input_data.begin(), input_data.end());
   TestSort(input_data, num_workers);
 }
+
+/* Calls ForEach() from a frame on its own runner, handing it the workers. */
+class TForEachTestRunnable
+    : public TRunnable {
+  NO_COPY(TForEachTestRunnable);
+  public:
+
+  TForEachTestRunnable(TRunner *runner,
+                       const std::vector<TRunner *> &worker_vec,
+                       size_t count,
+                       const std::function<void (size_t)> &func,
+                       std::mutex &mut,
+                       std::condition_variable &cond,
+                       bool &fin)
+    : WorkerVec(worker_vec),
+      Count(count),
+      Func(func),
+      Threw(false),
+      Mut(mut),
+      Cond(cond),
+      Fin(fin) {
+    Frame = TFrame::LocalFramePool->Alloc();
+    try {
+      Frame->Latch(runner, this, static_cast<TRunnable::TFunc>(&TForEachTestRunnable::RunMe));
+    } catch (...) {
+      TFrame::LocalFramePool->Free(Frame);
+      throw;
+    }
+  }
+
+  ~TForEachTestRunnable() {
+    TFrame::LocalFramePool->Free(Frame);
+  }
+
+  void RunMe() {
+    try {
+      ForEach(WorkerVec, Count, Func);
+    } catch (const std::exception &) {
+      Threw = true;
+    }
+    std::lock_guard<std::mutex> lock(Mut);
+    Fin = true;
+    Cond.notify_one();
+  }
+
+  bool GetThrew() const {
+    return Threw;
+  }
+
+  private:
+
+  TFrame *Frame;
+
+  const std::vector<TRunner *> &WorkerVec;
+
+  const size_t Count;
+
+  const std::function<void (size_t)> &Func;
+
+  bool Threw;
+
+  std::mutex &Mut;
+  std::condition_variable &Cond;
+  bool &Fin;
+
+};
+
+/* Runs ForEach() across the given number of workers and returns true iff. it threw. */
+static bool TestForEach(size_t num_workers, size_t count, const std::function<void (size_t)> &func) {
+  const size_t stack_size = 8 * 1024 * 1024;
+  TRunner::TRunnerCons runner_cons(1UL + num_workers);
+  TRunner runner(runner_cons);
+  std::vector<std::unique_ptr<TRunner>> worker_vec;
+  std::vector<TRunner *> worker_ptr_vec;
+  for (size_t i = 0; i < num_workers; ++i) {
+    worker_vec.emplace_back(new TRunner(runner_cons));
+    worker_ptr_vec.push_back(worker_vec.back().get());
+  }
+  TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *> *frame_pool_manager = new TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>(1UL + count, stack_size, &runner);
+  TFrame::LocalFramePool = new TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool(frame_pool_manager);
+  bool threw = false;
+  /* runnable's life span */ {
+    std::vector<std::unique_ptr<std::thread>> thread_vec;
+    for (auto &worker : worker_vec) {
+      thread_vec.emplace_back(new std::thread([&worker]() { worker->Run(); }));
+    }
+    auto launch_fiber_sched = [&]() {
+      if (!TFrame::LocalFramePool) {
+        TFrame::LocalFramePool = new TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool(frame_pool_manager);
+      }
+      runner.Run();
+      delete TFrame::LocalFramePool;
+    };
+    std::thread t1(launch_fiber_sched);
+    std::mutex mut;
+    std::condition_variable cond;
+    bool fin = false;
+    TForEachTestRunnable runnable(&runner, worker_ptr_vec, count, func, mut, cond, fin);
+    /* wait for it */ {
+      std::unique_lock<std::mutex> lock(mut);
+      while (!fin) {
+        cond.wait(lock);
+      }
+    }
+    threw = runnable.GetThrew();
+    runner.ShutDown();
+    t1.join();
+    for (auto &worker : worker_vec) {
+      worker->ShutDown();
+    }
+    for (auto &t : thread_vec) {
+      t->join();
+    }
+  }
+  delete TFrame::LocalFramePool;
+  TFrame::LocalFramePool = nullptr;
+  delete frame_pool_manager;
+  return threw;
+}
+
+FIXTURE(ForEach) {
+  const size_t count = 64UL;
+  std::vector<size_t> out(count, 0UL);
+  std::mutex thread_mut;
+  std::set<std::thread::id> thread_set;
+  EXPECT_FALSE(TestForEach(4UL, count, [&](size_t i) {
+    out[i] = i * 10;
+    std::lock_guard<std::mutex> lock(thread_mut);
+    thread_set.insert(std::this_thread::get_id());
+  }));
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_EQ(out[i], i * 10);
+  }
+  EXPECT_EQ(thread_set.size(), 4UL);
+}
+
+FIXTURE(ForEachRethrows) {
+  std::atomic<size_t> num_calls(0UL);
+  EXPECT_TRUE(TestForEach(3UL, 8UL, [&](size_t i) {
+    ++num_calls;
+    if (i == 5UL) {
+      throw std::runtime_error("boom");
+    }
+  }));
+  /* the others still all ran */
+  EXPECT_EQ(num_calls.load(), 8UL);
+}
@@ -25,11 +25,69 @@
 using namespace std::literals;
 using namespace Orly::Indy::Fiber;
 
+constexpr size_t TRunner::StealQueueSize;
+constexpr size_t TRunner::NoStealGroup;
+constexpr size_t TRunner::DefaultStealGroup;
+
 __thread TRunner *TRunner::LocalRunner = nullptr;
 __thread TFrame *TFrame::LocalFrame = nullptr;
 __thread Base::TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool *TFrame::LocalFramePool = nullptr;
 FiberLocal::TFiberLocal *FiberLocal::TFiberLocal::Root = nullptr;
 
+/********************************************************/
+/****************** CONTEXT SWITCH **********************/
+/********************************************************/
+
+/* The x86-64 ABI has a function preserve rbx, rbp, r12 through r15, the control bits of mxcsr and the x87 control word.  Everything
+   else is already the caller's problem by the time it calls us, so that's all a switch saves.  orly_fiber_switch() leaves them on the
+   stack it's switching away from, in the order create_fiber() lays out for a new fiber:
+
+     [sp + 0]  mxcsr (low 4 bytes), x87 control word (next 2)
+     [sp + 8]  r15, r14, r13, r12, rbx, rbp
+     [sp + 56] return address
+
+   orly_fiber_entry() marks the return address as undefined, so unwinders and debuggers know a fiber's stack ends there. */
+asm(
+    "  .text\n"
+    "  .globl orly_fiber_switch\n"
+    "  .type orly_fiber_switch, @function\n"
+    "  .align 16\n"
+    "orly_fiber_switch:\n"
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    "  .size orly_fiber_switch, .-orly_fiber_switch\n"
+    "\n"
+    "  .globl orly_fiber_entry\n"
+    "  .type orly_fiber_entry, @function\n"
+    "  .align 16\n"
+    "orly_fiber_entry:\n"
+    "  .cfi_startproc\n"
+    "  .cfi_undefined rip\n"
+    "  movq %r12, %rdi\n"
+    "  callq *%rbx\n"
+    "  ud2\n"
+    "  .cfi_endproc\n"
+    "  .size orly_fiber_entry, .-orly_fiber_entry\n");
+
 /********************************************************/
 /******************* EXTERN FIBER ***********************/
 /********************************************************/
@@ -114,6 +172,9 @@ void TRunner::Run() {
           for (TFrame *frame = cur_tail; frame; frame = next_frame) {
             assert(frame->InboundQueueNextFrame != frame);
             next_frame = frame->InboundQueueNextFrame;
+            if (TryPushStealable(frame)) {
+              continue;
+            }
             if (!frame->ComeBackRightAway) {
               frame->InboundQueueNextFrame = ReadyToRunQueue;
               ReadyToRunQueue = frame;
@@ -144,11 +205,14 @@ void TRunner::Run() {
                 for (TFrame *frame = cur_tail; frame; frame = next_frame) {
                   assert(frame->InboundQueueNextFrame != frame);
                   next_frame = frame->InboundQueueNextFrame;
+                  if (TryPushStealable(frame)) {
+                    continue;
+                  }
                   if (!frame->ComeBackRightAway) {
                     frame->InboundQueueNextFrame = ReadyToRunQueue;
                     ReadyToRunQueue = frame;
                     //frame->QueueMembership.Insert(&MyFrameQueue, InvCon::Rev);
-                    //_mm_prefetch(frame->MyFiber.jmp, _MM_HINT_T1);
+                    //_mm_prefetch(frame->MyFiber.sp, _MM_HINT_T1);
                   } else {
                     frame->InboundQueueNextFrame = rt_queue;
                     rt_queue = frame;
@@ -163,7 +227,7 @@ void TRunner::Run() {
                   ReadyToRunQueue = frame;
                   //frame->QueueMembership.Insert(&MyFrameQueue, InvCon::Rev);
                   #ifdef FAST_SWITCH
-                  _mm_prefetch(frame->MyFiber.jmp, _MM_HINT_T1);
+                  _mm_prefetch(frame->MyFiber.sp, _MM_HINT_T1);
                   #endif
                 }
                 rt_queue = nullptr;
@@ -172,10 +236,22 @@ void TRunner::Run() {
           }
         }
       }
+      if (!ReadyToRunQueue && StealQueue) {
+        /* nothing is pinned to us, so start one of our own stealable frames or, failing that, one of a peer's */
+        TFrame *frame = StealQueue->Pop();
+        if (!frame) {
+          frame = TrySteal();
+        }
+        if (frame) {
+          frame->InboundQueueNextFrame = nullptr;
+          ReadyToRunQueue = frame;
+        }
+      }
       if (ReadyToRunQueue) {
         laps_without_work = 0UL;
       } else {
         ++laps_without_work;
+        ++NumIdleLaps;
         if (laps_without_work >= laps_before_long_sleep) {
           std::this_thread::sleep_for(10000ns);
         } else if (laps_without_work >= laps_before_short_sleep) {
@@ -187,6 +263,8 @@ void TRunner::Run() {
           ReadyToRunQueue = frame->InboundQueueNextFrame;
           _mm_prefetch(reinterpret_cast<uint8_t *>(ReadyToRunQueue) + offsetof(TFrame, MyFiber), _MM_HINT_T0);
           fiber_t *sched_fib = &frame->GetFiber();
+          /* once it starts, the frame is ours */
+          frame->Stealable = false;
           TFrame::LocalFrame = frame;
           FreeFrame = nullptr;
           FreeFramePool = nullptr;
@@ -213,6 +291,9 @@ void TRunner::Run() {
           std::swap(ReadyToRunQueue, NewReadyToRunQueue);
           assert(ReadyToRunQueue);
           assert(!NewReadyToRunQueue);
+        } else if (StealQueue && (ReadyToRunQueue = StealQueue->Pop())) {
+          /* whatever our peers haven't taken yet, one at a time, so they can keep taking the rest */
+          ReadyToRunQueue->InboundQueueNextFrame = nullptr;
         } else {
           break;
         }
@@ -227,4 +308,22 @@ void TRunner::Run() {
   LocalRunner = nullptr;
 }
 
-#pragma GCC diagnostic pop
\ No newline at end of file
+#pragma GCC diagnostic pop
+
+TFrame *TRunner::TrySteal() {
+  assert(this);
+  assert(StealQueue);
+  /* start with the peer after us, so idle runners don't all pile onto the same victim */
+  for (size_t i = 1UL; i < TotalNumRunners; ++i) {
+    TRunner *peer = RunnerArray[(RunnerId + i) % TotalNumRunners];
+    if (peer && peer->StealGroup == StealGroup && peer->StealQueue && !peer->StealQueue->IsEmpty()) {
+      TFrame *frame = peer->StealQueue->Steal();
+      if (frame) {
+        ++NumSteals;
+        return frame;
+      }
+      ++NumFailedSteals;
+    }
+  }
+  return nullptr;
+}
\ No newline at end of file
@@ -26,12 +26,12 @@
 #include <unordered_set>
 
 
-#include <setjmp.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <syslog.h>
 #include <ucontext.h>
+#include <xmmintrin.h>
 
 #include <base/assert_true.h>
 #include <base/class_traits.h>
@@ -102,58 +102,53 @@ namespace Orly {
       #define FAST_SWITCH
 
       #ifdef FAST_SWITCH
-      /* TODO */
+      /* A fiber is its stack and the stack pointer it was last switched away from.  Everything else it needs to resume (its
+         callee-saved registers, the sse and x87 control words and where to return to) sits on top of the stack.  Unlike swapcontext,
+         we leave the signal mask alone, so a switch never enters the kernel. */
       struct fiber_t {
-        ucontext_t fib;
-        jmp_buf jmp;
+        void *sp;
         uint8_t *start_of_stack;
+        size_t stack_size;
       };
 
-      /* TODO */
-      struct fiber_ctx_t {
-        void (*fnc)(void *);
-        void *ctx;
-        jmp_buf *cur;
-        ucontext_t *prv;
-      };
+      /* Push the callee-saved registers onto the current stack, store the stack pointer at 'from_sp', then load 'to_sp' and pop the
+         registers saved there.  Returns when someone switches back to what we stored.  Defined in assembly in fiber.cc. */
+      extern "C" void orly_fiber_switch(void **from_sp, void *to_sp);
 
-      /* TODO */
-      static void fiber_start_fnc(void *p) {
-        fiber_ctx_t *ctx = reinterpret_cast<fiber_ctx_t *>(p);
-        void (*ufnc)(void *) = ctx->fnc;
-        void *uctx = ctx->ctx;
-        if (_setjmp(*ctx->cur) == 0) {
-          ucontext_t tmp;
-          swapcontext(&tmp, ctx->prv);
-        }
-        ufnc(uctx);
-      }
+      /* Where a new fiber begins: calls the function in rbx with the argument in r12, and never returns.  Defined in assembly in
+         fiber.cc. */
+      extern "C" void orly_fiber_entry();
 
       /* TODO */
       inline void create_fiber(fiber_t &fib, void(*ufnc)(void *), void *uctx, size_t stack_size) {
-        getcontext(&fib.fib);
         fib.start_of_stack = reinterpret_cast<uint8_t *>(malloc(stack_size));
         Util::IfLt0(mlock(fib.start_of_stack, stack_size));
         // init the fiber locals
         size_t bytes_of_loc = 0UL;
-        fib.fib.uc_stack.ss_sp = fib.start_of_stack;
         for (const auto *loc = FiberLocal::TFiberLocal::GetRoot(); loc; loc = loc->GetNext()) {
-          const size_t nbytes = loc->Init(fib.fib.uc_stack.ss_sp);
-          reinterpret_cast<uint8_t *&>(fib.fib.uc_stack.ss_sp) += nbytes;
-          bytes_of_loc += nbytes;
+          bytes_of_loc += loc->Init(fib.start_of_stack + bytes_of_loc);
         }
-        //printf("ss_sp=[%p], [%p]\n", fib.fib.uc_stack.ss_sp, reinterpret_cast<uint8_t *>(fib.fib.uc_stack.ss_sp) + stack_size);
-        fib.fib.uc_stack.ss_size = stack_size - bytes_of_loc;
-        fib.fib.uc_link = 0;
-        ucontext_t tmp;
-        fiber_ctx_t ctx = {ufnc, uctx, &fib.jmp, &tmp};
-        makecontext(&fib.fib, reinterpret_cast<void(*)()>(fiber_start_fnc), 1, &ctx);
-        swapcontext(&tmp, &fib.fib);
+        fib.stack_size = stack_size - bytes_of_loc;
+        /* lay out what orly_fiber_switch() pops, so the first switch to us returns into orly_fiber_entry() with the stack aligned as
+           if it had been called.  the fiber starts out with our control words. */
+        uint16_t fpu_control_word;
+        asm volatile("fnstcw %0" : "=m"(fpu_control_word));
+        const uintptr_t top_of_stack = (reinterpret_cast<uintptr_t>(fib.start_of_stack) + stack_size) & ~static_cast<uintptr_t>(15);
+        uint64_t *const frame = reinterpret_cast<uint64_t *>(top_of_stack) - 8;
+        frame[0] = _mm_getcsr() | (static_cast<uint64_t>(fpu_control_word) << 32);
+        frame[1] = 0UL;  // r15
+        frame[2] = 0UL;  // r14
+        frame[3] = 0UL;  // r13
+        frame[4] = reinterpret_cast<uint64_t>(uctx);  // r12
+        frame[5] = reinterpret_cast<uint64_t>(ufnc);  // rbx
+        frame[6] = 0UL;  // rbp
+        frame[7] = reinterpret_cast<uint64_t>(&orly_fiber_entry);
+        fib.sp = frame;
       }
 
       /* TODO */
       inline size_t get_stack_size(fiber_t &fib) {
-        return fib.fib.uc_stack.ss_size;
+        return fib.stack_size;
       }
 
       /* TODO */
@@ -165,9 +160,7 @@ namespace Orly {
 
       /* TODO */
       inline void switch_to_fiber(fiber_t &fib, fiber_t &prv) {
-        if (_setjmp(prv.jmp) == 0) {
-          _longjmp(fib.jmp, 1);
-        }
+        orly_fiber_switch(&prv.sp, fib.sp);
       }
 
       #else
@@ -206,6 +199,104 @@ namespace Orly {
       /* Forward Declaration */
       class TFrame;
 
+      /* A fixed-capacity Chase-Lev work-stealing deque of frames which have been scheduled but haven't started running yet.  The runner
+         which owns the queue pushes and pops at the bottom, LIFO, with no atomic read-modify-write unless it's racing a thief for the
+         last frame; other runners steal from the top, FIFO, with a single CAS each. */
+      class TStealQueue {
+        NO_COPY(TStealQueue);
+        public:
+
+        /* Room for 'max_size' frames, rounded up to a power of 2. */
+        TStealQueue(size_t max_size)
+            : Top(0L), Bottom(0L) {
+          size_t cap = 1UL;
+          while (cap < max_size) {
+            cap <<= 1;
+          }
+          Mask = cap - 1UL;
+          Buf = new std::atomic<TFrame *>[cap];
+          for (size_t i = 0; i < cap; ++i) {
+            Buf[i].store(nullptr, std::memory_order_relaxed);
+          }
+        }
+
+        /* TODO */
+        ~TStealQueue() {
+          assert(this);
+          delete[] Buf;
+        }
+
+        /* Owner only.  Push the frame onto the bottom.  Returns false, leaving the queue alone, if the queue is full. */
+        bool Push(TFrame *frame) {
+          assert(this);
+          assert(frame);
+          const int64_t b = Bottom.load(std::memory_order_relaxed);
+          const int64_t t = Top.load(std::memory_order_acquire);
+          if (static_cast<size_t>(b - t) > Mask) {
+            return false;
+          }
+          Buf[b & Mask].store(frame, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_release);
+          Bottom.store(b + 1, std::memory_order_relaxed);
+          return true;
+        }
+
+        /* Owner only.  Pop the most recently pushed frame from the bottom, or return null if there isn't one. */
+        TFrame *Pop() {
+          assert(this);
+          const int64_t b = Bottom.load(std::memory_order_relaxed) - 1;
+          Bottom.store(b, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          int64_t t = Top.load(std::memory_order_relaxed);
+          if (t > b) {
+            Bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+          }
+          TFrame *frame = Buf[b & Mask].load(std::memory_order_relaxed);
+          if (t == b) {
+            /* the last one; race any thieves for it */
+            if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+              frame = nullptr;
+            }
+            Bottom.store(b + 1, std::memory_order_relaxed);
+          }
+          return frame;
+        }
+
+        /* Any thread.  Take the least recently pushed frame from the top, or return null if the queue is empty or we lost a race for
+           the frame. */
+        TFrame *Steal() {
+          assert(this);
+          int64_t t = Top.load(std::memory_order_acquire);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          const int64_t b = Bottom.load(std::memory_order_acquire);
+          if (t >= b) {
+            return nullptr;
+          }
+          TFrame *frame = Buf[t & Mask].load(std::memory_order_relaxed);
+          return Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) ? frame : nullptr;
+        }
+
+        /* A racy guess at whether there is anything to steal. */
+        bool IsEmpty() const {
+          assert(this);
+          return Top.load(std::memory_order_relaxed) >= Bottom.load(std::memory_order_relaxed);
+        }
+
+        private:
+
+        /* Where thieves take from.  Kept away from Bottom so the owner and the thieves don't share a cache line. */
+        alignas(64) std::atomic<int64_t> Top;
+
+        /* Where the owner pushes and pops. */
+        alignas(64) std::atomic<int64_t> Bottom;
+
+        /* The ring of frames, and one less than its size. */
+        std::atomic<TFrame *> *Buf;
+        size_t Mask;
+
+      };  // TStealQueue
+
       /* TODO */
       class alignas(64) TRunner {
         NO_COPY(TRunner);
@@ -219,9 +310,12 @@ namespace Orly {
           NO_COPY(TRunnerCons);
           public:
 
-          /* TODO */
-          TRunnerCons(size_t num_runners)
-              : NumRunners(num_runners), NextId(0UL) {
+          /* If 'work_stealing', each runner made from us keeps its stealable frames in a TStealQueue, and idle runners steal from their
+             peers before going to sleep.  Frames that weren't latched as stealable stay on the runner they were scheduled to either way.
+             This puts every runner in DefaultStealGroup; to have only some runners steal, or only from each other, give each its group
+             when making it instead. */
+          TRunnerCons(size_t num_runners, bool work_stealing = false)
+              : NumRunners(num_runners), NextId(0UL), WorkStealing(work_stealing) {
             syslog(LOG_INFO, "TRunnerCons [%ld]", num_runners);
             RunnerArray = new TRunner *[num_runners];
             syslog(LOG_INFO, "TRunnerCons [%ld] A", num_runners);
@@ -258,6 +352,9 @@ namespace Orly {
           /* TODO */
           size_t NextId;
 
+          /* See the constructor. */
+          const bool WorkStealing;
+
           /* TODO */
           TRunner **RunnerArray;
 
@@ -265,12 +362,24 @@ namespace Orly {
 
         };  // TRunnerCons
 
-        TRunner(TRunnerCons &runner_cons) : TRunner(runner_cons.NumRunners, runner_cons.GetNewId(), runner_cons.RunnerArray) {
+        /* A runner's steal group says who it steals from.  Runners only steal from peers in the same group, and those in NoStealGroup
+           neither steal nor are stolen from.  Groups let a pool of runners doing one kind of work balance it among themselves without
+           picking up frames meant for the runners of another pool. */
+        static constexpr size_t NoStealGroup = 0UL;
+        static constexpr size_t DefaultStealGroup = 1UL;
+
+        /* TODO */
+        TRunner(TRunnerCons &runner_cons)
+            : TRunner(runner_cons, runner_cons.WorkStealing ? DefaultStealGroup : NoStealGroup) {}
+
+        /* A runner in the given steal group, whether or not the runner cons is work stealing. */
+        TRunner(TRunnerCons &runner_cons, size_t steal_group)
+            : TRunner(runner_cons.NumRunners, runner_cons.GetNewId(), runner_cons.RunnerArray, steal_group) {
           runner_cons.RunnerArray[RunnerId] = this;
         }
 
         /* TODO */
-        TRunner(size_t total_num_runners, size_t runner_id, TRunner **runner_array)
+        TRunner(size_t total_num_runners, size_t runner_id, TRunner **runner_array, size_t steal_group = NoStealGroup)
             : FreeFrame(nullptr),
               FreeFramePool(nullptr),
               //MyFrameQueue(this),
@@ -282,13 +391,14 @@ namespace Orly {
               FrameToMoveToForeignRunner(nullptr),
               TotalNumRunners(total_num_runners),
               RunnerId(runner_id),
-              RunnerArray(runner_array) {
+              RunnerArray(runner_array),
+              StealGroup(steal_group),
+              StealQueue((steal_group != NoStealGroup) ? new TStealQueue(StealQueueSize) : nullptr),
+              NumSteals(0UL),
+              NumFailedSteals(0UL),
+              NumIdleLaps(0UL) {
           assert(runner_id < total_num_runners);
-          #ifdef FAST_SWITCH
-          Base::Zero(MainFiber.fib);
-          #else
           Base::Zero(MainFiber);
-          #endif
           QueueArray = new TOutboundQueue[total_num_runners];
           for (size_t i = 0; i < total_num_runners; ++i) {
             QueueArray[i].Ptr = nullptr;
@@ -300,6 +410,31 @@ namespace Orly {
           assert(this);
           RunnerArray[RunnerId] = nullptr;
           delete[] QueueArray;
+          delete StealQueue;
+        }
+
+        /* True iff we steal from, and can be stolen from by, our peers. */
+        bool IsWorkStealing() const {
+          assert(this);
+          return StealQueue != nullptr;
+        }
+
+        /* The number of frames we've stolen from our peers since the last call. */
+        size_t ExchangeStealCount() {
+          assert(this);
+          return NumSteals.exchange(0UL);
+        }
+
+        /* The number of times since the last call we've found a peer with frames to spare, only to lose the race for them. */
+        size_t ExchangeFailedStealCount() {
+          assert(this);
+          return NumFailedSteals.exchange(0UL);
+        }
+
+        /* The number of times we've gone around the run loop without finding any work since the last call. */
+        size_t ExchangeIdleLapCount() {
+          assert(this);
+          return NumIdleLaps.exchange(0UL);
         }
 
         /* TODO */
@@ -345,6 +480,17 @@ namespace Orly {
 
         inline void ScheduleFrameSlow(TRunner *other_runner, TFrame *frame);
 
+        /* Owner only.  If the frame is stealable and we're work stealing, push it onto our steal queue and return true.  Otherwise
+           leave it to the caller to put the frame on one of our run queues. */
+        inline bool TryPushStealable(TFrame *frame);
+
+        /* Take a frame from the steal queue of one of the peers in our steal group, or return null if none of them has one to spare.
+           Defined in fiber.cc. */
+        TFrame *TrySteal();
+
+        /* The most frames a runner keeps where its peers can steal them.  Past this, stealable frames go on the run queues, pinned. */
+        static constexpr size_t StealQueueSize = 1024UL;
+
         /* TODO */
         //mutable TFrameQueue::TImpl MyFrameQueue;
         TFrame *ReadyToRunQueue;
@@ -371,6 +517,17 @@ namespace Orly {
 
         TRunner **RunnerArray;
 
+        /* See NoStealGroup. */
+        const size_t StealGroup;
+
+        /* Frames latched as stealable which haven't started running yet.  Null unless we're work stealing. */
+        TStealQueue *StealQueue;
+
+        /* See ExchangeStealCount(), ExchangeFailedStealCount() and ExchangeIdleLapCount(). */
+        std::atomic<size_t> NumSteals;
+        std::atomic<size_t> NumFailedSteals;
+        std::atomic<size_t> NumIdleLaps;
+
         /* Access to ComeBackSoon */
         friend class TFrame;
         friend class TFramePool;
@@ -425,9 +582,29 @@ namespace Orly {
           return WorkerCount;
         }
 
-        /* TODO */
+        /* TODO. The frame is latched as stealable, so if the runner cons is work stealing, whichever worker is idle first picks it up. */
         inline void Schedule(TFrame *frame, TRunnable *runnable, const TRunnable::TFunc &func);
 
+        /* The total of TRunner::ExchangeStealCount() across our workers. */
+        size_t ExchangeStealCount() {
+          assert(this);
+          size_t total = 0UL;
+          for (auto &runner : RunnerVec) {
+            total += runner->ExchangeStealCount();
+          }
+          return total;
+        }
+
+        /* The total of TRunner::ExchangeFailedStealCount() across our workers. */
+        size_t ExchangeFailedStealCount() {
+          assert(this);
+          size_t total = 0UL;
+          for (auto &runner : RunnerVec) {
+            total += runner->ExchangeFailedStealCount();
+          }
+          return total;
+        }
+
         private:
 
         /* TODO */
@@ -460,7 +637,8 @@ namespace Orly {
               Runnable(nullptr),
               //QueueMembership(this),
               InboundQueueNextFrame(nullptr),
-              ComeBackRightAway(false) {
+              ComeBackRightAway(false),
+              Stealable(false) {
           create_fiber(MyFiber, StartFrame, this, stack_size);
         }
 
@@ -472,14 +650,17 @@ namespace Orly {
           free_fiber(MyFiber);
         }
 
-        /* TODO */
-        inline void Latch(TRunner *runner, TRunnable *runnable, TRunnable::TFunc runnable_func) {
+        /* TODO. If 'stealable', and the runner is work stealing, then until the runnable starts, any idle runner in the runner's
+           steal group may take the frame and run it instead.  Only pass true when the runnable doesn't care which runner it starts on.
+           Once started, the frame is pinned like any other. */
+        inline void Latch(TRunner *runner, TRunnable *runnable, TRunnable::TFunc runnable_func, bool stealable = false) {
           //printf("TFrame [%p] Latch runnable [%p]\n", this, runnable);
           CheckFrameUnwound();
           assert(Runnable == nullptr);
           assert(RunnableFunc == nullptr);
           Runnable = runnable;
           RunnableFunc = runnable_func;
+          Stealable = stealable;
           runner->ScheduleFrame(this);
         }
 
@@ -614,6 +795,9 @@ namespace Orly {
         /* TODO */
         bool ComeBackRightAway;
 
+        /* True from a stealable Latch() until the frame starts running. */
+        bool Stealable;
+
         /* MyFiber */
         friend class TFramePool;
         friend class TRunner;
@@ -979,7 +1163,7 @@ namespace Orly {
       inline void TRunnerPool::Schedule(TFrame *frame, TRunnable *runnable, const TRunnable::TFunc &func) {
         size_t prev_assignment_count = std::atomic_fetch_add(&AssignPos, 1UL);
         TRunner *const chosen_runner = RunnerVec[prev_assignment_count % WorkerCount].get();
-        frame->Latch(chosen_runner, runnable, func);
+        frame->Latch(chosen_runner, runnable, func, true);
       }
 
       static inline void Yield() {
@@ -1062,11 +1246,20 @@ namespace Orly {
         } while (!__sync_bool_compare_and_swap(&outbound_queue, frame->InboundQueueNextFrame, frame));
       }
 
+      inline bool TRunner::TryPushStealable(TFrame *frame) {
+        assert(this);
+        assert(frame);
+        return StealQueue && frame->Stealable && !frame->ComeBackRightAway && StealQueue->Push(frame);
+      }
+
       inline void TRunner::ScheduleFrame(TFrame *frame) {
         assert(this);
         assert(frame);
         if (this == LocalRunner) {
           //printf("ScheduleFrame local\n");
+          if (TryPushStealable(frame)) {
+            return;
+          }
           if (!frame->ComeBackRightAway) {
             frame->InboundQueueNextFrame = NewReadyToRunQueue;
             NewReadyToRunQueue = frame;
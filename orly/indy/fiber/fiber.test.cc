@@ -18,8 +18,13 @@
 
 #include <orly/indy/fiber/fiber.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <iostream>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <unistd.h>
 
@@ -672,3 +677,193 @@ FIXTURE(Sem) {
   EXPECT_EQ(pos_counter, 5UL);
   EXPECT_EQ(accuracy_counter, 127UL);
 }
+
+/* A fiber which does nothing but switch straight back to the one that switched to it. */
+struct TPingPong {
+  fiber_t Main;
+  fiber_t Fiber;
+  size_t NumRounds;
+};
+
+static void PingPong(void *ptr) {
+  TPingPong *ping_pong = static_cast<TPingPong *>(ptr);
+  for (;;) {
+    ++(ping_pong->NumRounds);
+    switch_to_fiber(ping_pong->Main, ping_pong->Fiber);
+  }
+}
+
+FIXTURE(SwitchRate) {
+  const size_t num_rounds = 10000000UL;
+  const size_t stack_size = 64 * 1024;
+  TPingPong ping_pong;
+  Zero(ping_pong.Main);
+  ping_pong.NumRounds = 0UL;
+  create_fiber(ping_pong.Fiber, PingPong, &ping_pong, stack_size);
+  /* the fiber should see our floating point state, and leave it alone */
+  volatile double x = 1.0;
+  const auto start = chrono::steady_clock::now();
+  for (size_t i = 0; i < num_rounds; ++i) {
+    switch_to_fiber(ping_pong.Fiber, ping_pong.Main);
+    x = x * 1.0000001;
+  }
+  const double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(ping_pong.NumRounds, num_rounds);
+  EXPECT_GT(x, 1.0);
+  free_fiber(ping_pong.Fiber);
+  cout << "fiber switch: " << (elapsed / (num_rounds * 2)) << " ns" << endl;
+}
+
+FIXTURE(StealQueue) {
+  const size_t max_size = 4UL;
+  TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *> frame_pool_manager(max_size + 1UL, 64 * 1024, nullptr);
+  TFrame::LocalFramePool = new TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool(&frame_pool_manager);
+  TFrame *frames[max_size + 1UL];
+  for (auto &frame : frames) {
+    frame = TFrame::LocalFramePool->Alloc();
+  }
+  /* scope */ {
+    TStealQueue queue(max_size);
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_FALSE(queue.Pop());
+    EXPECT_FALSE(queue.Steal());
+    for (size_t i = 0; i < max_size; ++i) {
+      EXPECT_TRUE(queue.Push(frames[i]));
+    }
+    EXPECT_FALSE(queue.Push(frames[max_size]));
+    /* the owner works from the newest end, thieves from the oldest */
+    EXPECT_EQ(queue.Pop(), frames[3]);
+    EXPECT_EQ(queue.Steal(), frames[0]);
+    EXPECT_EQ(queue.Steal(), frames[1]);
+    EXPECT_EQ(queue.Pop(), frames[2]);
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_FALSE(queue.Pop());
+    EXPECT_FALSE(queue.Steal());
+    /* and it wraps */
+    for (size_t i = 0; i < max_size; ++i) {
+      EXPECT_TRUE(queue.Push(frames[i]));
+      EXPECT_EQ(queue.Steal(), frames[i]);
+    }
+  }
+  for (auto &frame : frames) {
+    TFrame::LocalFramePool->Free(frame);
+  }
+  delete TFrame::LocalFramePool;
+  TFrame::LocalFramePool = nullptr;
+}
+
+class TBusyRunnable
+    : public TRunnable {
+  NO_COPY(TBusyRunnable);
+  public:
+
+  TBusyRunnable(TRunner *runner, bool stealable, atomic<size_t> &num_finished)
+      : RanOn(nullptr), NumFinished(num_finished) {
+    Frame = TFrame::LocalFramePool->Alloc();
+    try {
+      Frame->Latch(runner, this, static_cast<TRunnable::TFunc>(&TBusyRunnable::Spin), stealable);
+    } catch (...) {
+      TFrame::LocalFramePool->Free(Frame);
+      throw;
+    }
+  }
+
+  ~TBusyRunnable() {
+    TFrame::LocalFramePool->Free(Frame);
+  }
+
+  void Spin() {
+    const auto until = chrono::steady_clock::now() + chrono::milliseconds(2);
+    while (chrono::steady_clock::now() < until);
+    RanOn = TRunner::LocalRunner;
+    ++NumFinished;
+  }
+
+  TRunner *RanOn;
+
+  private:
+
+  TFrame *Frame;
+
+  atomic<size_t> &NumFinished;
+
+};
+
+/* Latch a batch of busy frames onto the first of a few runners and return the number of them which ran somewhere else, and the
+   number of steals the runners counted.  Unless 'one_group', the first runner is in a steal group of its own. */
+static void RunLopsided(bool stealable, size_t &num_moved, size_t &num_steals, bool one_group = true) {
+  const size_t num_runners = 4UL;
+  const size_t num_frames = 64UL;
+  TRunner::TRunnerCons runner_cons(num_runners, true);
+  vector<unique_ptr<TRunner>> runners;
+  for (size_t i = 0; i < num_runners; ++i) {
+    if (one_group) {
+      runners.emplace_back(new TRunner(runner_cons));
+    } else {
+      runners.emplace_back(new TRunner(runner_cons, i ? TRunner::DefaultStealGroup + 1UL : TRunner::DefaultStealGroup));
+    }
+    EXPECT_TRUE(runners.back()->IsWorkStealing());
+  }
+  TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *> frame_pool_manager(num_frames, 64 * 1024, runners[0].get());
+  TFrame::LocalFramePool = new TThreadLocalGlobalPoolManager<TFrame, size_t, TRunner *>::TThreadLocalPool(&frame_pool_manager);
+  vector<thread> threads;
+  for (auto &runner : runners) {
+    threads.emplace_back([&runner]() {
+      runner->Run();
+    });
+  }
+  atomic<size_t> num_finished(0UL);
+  vector<unique_ptr<TBusyRunnable>> runnables;
+  for (size_t i = 0; i < num_frames; ++i) {
+    runnables.emplace_back(new TBusyRunnable(runners[0].get(), stealable, num_finished));
+  }
+  while (num_finished < num_frames) {
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+  for (auto &runner : runners) {
+    runner->ShutDown();
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  num_moved = 0UL;
+  for (auto &runnable : runnables) {
+    if (runnable->RanOn != runners[0].get()) {
+      ++num_moved;
+    }
+  }
+  num_steals = 0UL;
+  for (auto &runner : runners) {
+    num_steals += runner->ExchangeStealCount();
+    EXPECT_EQ(runner->ExchangeStealCount(), 0UL);
+    runner->ExchangeFailedStealCount();
+    EXPECT_EQ(runner->ExchangeFailedStealCount(), 0UL);
+  }
+  /* the thieves spent at least some of their time waiting */
+  EXPECT_GT(runners[1]->ExchangeIdleLapCount(), 0UL);
+  runnables.clear();
+  delete TFrame::LocalFramePool;
+  TFrame::LocalFramePool = nullptr;
+}
+
+FIXTURE(WorkStealing) {
+  size_t num_moved, num_steals;
+  RunLopsided(true, num_moved, num_steals);
+  EXPECT_GT(num_moved, 0UL);
+  EXPECT_EQ(num_moved, num_steals);
+  cout << "stole " << num_steals << " of 64 frames" << endl;
+}
+
+FIXTURE(WorkStealingLeavesPinnedFramesAlone) {
+  size_t num_moved, num_steals;
+  RunLopsided(false, num_moved, num_steals);
+  EXPECT_EQ(num_moved, 0UL);
+  EXPECT_EQ(num_steals, 0UL);
+}
+
+FIXTURE(WorkStealingStaysInGroup) {
+  size_t num_moved, num_steals;
+  RunLopsided(true, num_moved, num_steals, false);
+  EXPECT_EQ(num_moved, 0UL);
+  EXPECT_EQ(num_steals, 0UL);
+}
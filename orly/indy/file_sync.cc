@@ -18,12 +18,16 @@
 
 #include <orly/indy/file_sync.h>
 
+#include <memory>
+#include <vector>
+
 #include <io/recorder_and_player.h>
 #include <orly/indy/disk/indy_util_reporter.h>
 #include <orly/indy/disk/meta_rewriter.h>
 #include <orly/indy/disk/out_stream.h>
 #include <orly/indy/disk/read_file.h>
 #include <orly/indy/disk/util/snappy.h>
+#include <orly/indy/fiber/algorithm.h>
 
 using namespace Orly::Indy;
 using namespace Orly::Indy::Disk;
@@ -51,6 +55,8 @@ class TFileSyncReadFile
 
 const size_t TFileSync::CopyBufSize = LogicalBlockSize;
 
+const size_t TFileSync::MaxBufsInFlight = 16UL;
+
 void TFileSync::Write(Io::TBinaryOutputStream &stream) const {
   assert(this);
   assert(Type == TType::Source);
@@ -59,17 +65,27 @@ void TFileSync::Write(Io::TBinaryOutputStream &stream) const {
   stream << Context;
   stream << file_length;
   stream << sync_file.GetStartingBlockOffset();
-  TFileSyncReadFile::TInStream in_stream(HERE, Disk::Source::FileSync, Low, &sync_file, Engine->GetPageCache(), 0UL);
+  TFileSyncReadFile::TInStream in_stream(HERE, Disk::Source::FileSync, Low, &sync_file, Engine->GetPageCache(), 0UL, true);
   const size_t max_compressed = snappy::MaxCompressedLength(CopyBufSize);
-  char CopyBuf[max_compressed];
-  for (size_t i = 0; i < file_length; i+= CopyBufSize) {
-    assert(in_stream.GetOffset() == i);
-    const size_t to_copy = std::min(TFileSync::CopyBufSize, file_length - i);
-    TFileSyncReadFile::TSnappyInStream snappy_in_source(in_stream, to_copy);
-    Snappy::TRawSink raw_sink(CopyBuf, max_compressed);
-    size_t compressed_size = snappy::Compress(&snappy_in_source, &raw_sink);
-    stream << compressed_size;
-    stream.WriteExactly(CopyBuf, compressed_size);
+  /* read a window of buffers, compress them all at once, then send them in order */
+  const size_t num_bufs = std::min(MaxBufsInFlight, std::max(1UL, HelperRunnerVec.size() * 2UL));
+  std::unique_ptr<char[]> raw_bufs(new char[num_bufs * CopyBufSize]);
+  std::unique_ptr<char[]> compressed_bufs(new char[num_bufs * max_compressed]);
+  std::vector<size_t> raw_sizes(num_bufs), compressed_sizes(num_bufs);
+  for (size_t i = 0; i < file_length;) {
+    size_t num_read = 0UL;
+    for (; num_read < num_bufs && i < file_length; ++num_read, i += CopyBufSize) {
+      assert(in_stream.GetOffset() == i);
+      raw_sizes[num_read] = std::min(TFileSync::CopyBufSize, file_length - i);
+      in_stream.Read(raw_bufs.get() + num_read * CopyBufSize, raw_sizes[num_read]);
+    }
+    Fiber::ForEach(HelperRunnerVec, num_read, [&](size_t n) {
+      snappy::RawCompress(raw_bufs.get() + n * CopyBufSize, raw_sizes[n], compressed_bufs.get() + n * max_compressed, &compressed_sizes[n]);
+    });
+    for (size_t n = 0; n < num_read; ++n) {
+      stream << compressed_sizes[n];
+      stream.WriteExactly(compressed_bufs.get() + n * max_compressed, compressed_sizes[n]);
+    }
   }
 }
 
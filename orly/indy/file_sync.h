@@ -16,10 +16,13 @@
 
 #pragma once
 
+#include <vector>
+
 #include <base/uuid.h>
 #include <io/binary_input_only_stream.h>
 #include <io/binary_output_only_stream.h>
 #include <orly/indy/disk/util/engine.h>
+#include <orly/indy/fiber/fiber.h>
 #include <orly/indy/util/block_vec.h>
 
 namespace Orly {
@@ -33,9 +36,11 @@ namespace Orly {
       /* This constructor is used on the read end. We default construct before we call read. */
       TFileSync() : Type(Destination), Engine(nullptr), StartingBlockId(0UL), StartingBlockOffset(0UL), Context(0UL) {}
 
-      /* TODO */
-      TFileSync(Disk::Util::TEngine *engine, const Base::TUuid &file_id, size_t gen_id, size_t context)
-          : Type(Source), Engine(engine), FileId(file_id), GenId(gen_id), StartingBlockId(0UL), StartingBlockOffset(0UL), Context(context) {}
+      /* The write end.  If given helper runners, we compress several buffers at once across them. */
+      TFileSync(Disk::Util::TEngine *engine, const Base::TUuid &file_id, size_t gen_id, size_t context,
+                const std::vector<Fiber::TRunner *> &helper_runner_vec = std::vector<Fiber::TRunner *>())
+          : Type(Source), Engine(engine), FileId(file_id), GenId(gen_id), StartingBlockId(0UL), StartingBlockOffset(0UL), Context(context),
+            HelperRunnerVec(helper_runner_vec) {}
 
       /* TODO */
       ~TFileSync() {}
@@ -94,9 +99,15 @@ namespace Orly {
       /* TODO */
       size_t Context;
 
+      /* See constructor. */
+      std::vector<Fiber::TRunner *> HelperRunnerVec;
+
       /* TODO */
       static const size_t CopyBufSize;
 
+      /* The most buffers we read ahead and compress at once. */
+      static const size_t MaxBufsInFlight;
+
     };  // TFileSync
 
     /* Binary streamers for Orly::Indy::TFileSync */
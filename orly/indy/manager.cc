@@ -21,6 +21,7 @@
 #include <base/debug_log.h>
 #include <base/shutting_down.h>
 #include <orly/indy/file_sync.h>
+#include <orly/indy/resync_plan.h>
 #include <orly/server/meta_record.h>
 #include <util/time.h>
 
@@ -41,6 +42,12 @@ const TUuid TManager::MinId("00000000-0000-0000-0000-000000000000");
 const TUuid TManager::MaxId("FFFFFFFF-FFFF-FFFF-FFFF-FFFFFFFFFFFF");
 const TUuid TManager::SystemRepoId("AAAAAAAA-AAAA-AAAA-AAAA-AAAAAAAAAAAA");
 
+const size_t TManager::MaxReplicationBatchBytes = 4UL * 1024UL * 1024UL;
+
+const size_t TManager::MaxPendingPushes = 8UL;
+
+const size_t TManager::MaxSyncFilesInFlight = 4UL;
+
 RECORD_ELEM(TManager::TSavedRepoObj, bool                               , IsSafe);
 RECORD_ELEM(TManager::TSavedRepoObj, TManager::TSavedRepoObj::TRootPath , RootPath);
 RECORD_ELEM(TManager::TSavedRepoObj, TManager::TSavedRepoObj::TOptSeq   , LowestSequenceNumber);
@@ -291,13 +298,17 @@ void TManager::RunReplicationWork() {
 void TManager::RunReplicateTransaction() {
   assert(this);
   epoll_event event;
-  int timeout = -1;
   void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  /* batches we've pushed to the slave but haven't heard back about, oldest first */
+  deque<TPendingPush> pending_pushes;
   for (;;) {
     try {
       lock_guard<mutex> epoll_lock(ReplicationEpollLock);
+      /* while pushes are pending, don't wait on new work for longer than a replication delay */
+      const int timeout = pending_pushes.empty() ? -1 : static_cast<int>(ReplicationDelay.count());
+      int ret;
       for (;;) {
-        int ret = epoll_wait(ReplicationEpollFd, &event, 1, timeout);
+        ret = epoll_wait(ReplicationEpollFd, &event, 1, timeout);
         if (ret < 0 && errno == EINTR) {
           if (Base::IsShuttingDown()) {
             throw std::runtime_error("RunReplicateTransaction() Service Shutdown");
@@ -309,9 +320,17 @@ void TManager::RunReplicateTransaction() {
           break;
         }
       }
+      if (!ret) {
+        /* things have gone quiet, so settle up with the slave */
+        while (!pending_pushes.empty()) {
+          RetireOldestPush(pending_pushes, state_alloc);
+        }
+        continue;
+      }
       SleepUntil(ReplicationNextTime);
       ReplicationNextTime = chrono::steady_clock::now() + ReplicationDelay;
-      TReplicationStreamer replication_streamer;
+      /* each batch is the streamer we send and the items it carries */
+      vector<pair<unique_ptr<TReplicationStreamer>, unique_ptr<TReplicationQueue>>> batches;
       TState state_used;
       TReplicationQueue copy_queue;
       std::shared_ptr<TCommonContext> context;
@@ -336,33 +355,35 @@ void TManager::RunReplicateTransaction() {
               copy_queue.Swap(ReplicationQueue);
               assert(ReplicationQueue.IsEmpty());
             }  // release Replication lock
-            try {
-              size_t num_trans_to_replicate = 0UL;
-              for (TReplicationQueue::TItemCollection::TCursor csr(copy_queue.GetItemCollection()); csr; ++csr, ++num_trans_to_replicate) {
-                switch (csr->GetKind()) {
-                  case TReplicationQueue::TReplicationItem::Repo : {
-                    replication_streamer.PushRepo(*reinterpret_cast<TRepoReplication *>(&*csr));
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::Durable : {
-                    replication_streamer.PushDurable(*reinterpret_cast<TDurableReplication *>(&*csr));
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::Transaction : {
-                    replication_streamer.PushTransaction(dynamic_cast<TTransactionReplication *>(&*csr)->GetReplica());
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::IndexId : {
-                    replication_streamer.PushIndexId(*reinterpret_cast<TIndexIdReplication *>(&*csr));
-                    break;
-                  }
-                }
+            size_t num_trans_to_replicate = 0UL;
+            /* cut the queue, in order, into batches of bounded size */
+            for (auto item = copy_queue.GetItemCollection()->TryGetFirstMember(); item; item = copy_queue.GetItemCollection()->TryGetFirstMember(), ++num_trans_to_replicate) {
+              if (batches.empty() || batches.back().first->GetApproxSize() >= MaxReplicationBatchBytes) {
+                batches.emplace_back(make_unique<TReplicationStreamer>(), make_unique<TReplicationQueue>());
               }
-              if (num_trans_to_replicate > 10000UL) {
-                syslog(LOG_INFO, "Replicating [%ld] transactions", num_trans_to_replicate);
+              TReplicationStreamer &replication_streamer = *batches.back().first;
+              switch (item->GetKind()) {
+                case TReplicationQueue::TReplicationItem::Repo : {
+                  replication_streamer.PushRepo(*reinterpret_cast<TRepoReplication *>(item));
+                  break;
+                }
+                case TReplicationQueue::TReplicationItem::Durable : {
+                  replication_streamer.PushDurable(*reinterpret_cast<TDurableReplication *>(item));
+                  break;
+                }
+                case TReplicationQueue::TReplicationItem::Transaction : {
+                  replication_streamer.PushTransaction(dynamic_cast<TTransactionReplication *>(item)->GetReplica());
+                  break;
+                }
+                case TReplicationQueue::TReplicationItem::IndexId : {
+                  replication_streamer.PushIndexId(*reinterpret_cast<TIndexIdReplication *>(item));
+                  break;
+                }
               }
-            } catch (...) {
-              throw;
+              batches.back().second->Insert(item);
+            }
+            if (num_trans_to_replicate > 10000UL) {
+              syslog(LOG_INFO, "Replicating [%ld] transactions in [%ld] batches", num_trans_to_replicate, batches.size());
             }
             break;
           }
@@ -389,81 +410,19 @@ void TManager::RunReplicateTransaction() {
           break;
         }
         case Master : {
-          if (!replication_streamer.IsEmpty()) {
-            try {
-              Base::TTimer timer;
-              //auto future = context->Write<void>(TSlave::PushNotificationsId, replication_streamer);
-              auto future = context->Write<void>(TSlave::PushNotificationsId, replication_streamer);
-              timer.Stop();
-              if (timer.GetTotal() < 1s) {
-                syslog(LOG_INFO, "Write TSlave::PushNotificationsId took [%fs]", ToSecondsDouble(timer.GetTotal()));
-              }
-              assert(future);
-              future->Sync();  // wait for the future to complete
-              if (!static_cast<bool>(*future)) {
-                throw std::runtime_error("Future did not complete.");
-              }
-              /* now apply all the necessary replication notifications. */
-              for (TReplicationQueue::TItemCollection::TCursor csr(copy_queue.GetItemCollection()); csr; ++csr) {
-                switch (csr->GetKind()) {
-                  case TReplicationQueue::TReplicationItem::Repo : {
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::Durable : {
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::IndexId : {
-                    break;
-                  }
-                  case TReplicationQueue::TReplicationItem::Transaction : {
-                    for (const auto &mutation : reinterpret_cast<TTransactionReplication *>(&*csr)->GetReplica().GetMutationList()) {
-                      switch (mutation.GetKind()) {
-                        case L1::TTransaction::TReplica::TMutation::Pusher: {
-                          if (mutation.GetRepoId() == GlobalPovId) {
-                            Base::TUuid session_id;
-                            try {
-                              Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), session_id);
-                            } catch (const exception &ex) {
-                              syslog(LOG_ERR, "Exception while trying to access ession ID of update promoted to global: [%s]", ex.what());
-                            }
-                            Base::TUuid tracker_id;
-                            Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetId().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), tracker_id);
-                            //std::cout << "Calling UpdateReplicationNotificationCb() for global" << std::endl;
-                            UpdateReplicationNotificationCb(session_id, mutation.GetRepoId(), tracker_id);
-                          } else {
-                            Server::TMetaRecord meta_record;
-                            Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), meta_record);
-                            /* TODO : when we start merging updates we need to notify all update tracker ids. */
-                            Base::TUuid tracker_id;
-                            Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetId().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), tracker_id);
-                            for (const auto &item: meta_record.GetEntryByUpdateId()) {
-                              const auto &entry = item.second;
-                              //std::cout << "Calling UpdateReplicationNotificationCb() for private" << std::endl;
-                              UpdateReplicationNotificationCb(entry.GetSessionId(), mutation.GetRepoId(), tracker_id);
-                            }
-                          }
-                          break;
-                        }
-                        case L1::TTransaction::TReplica::TMutation::Popper: {
-                          break;
-                        }
-                        case L1::TTransaction::TReplica::TMutation::Failer: {
-                          break;
-                        }
-                        case L1::TTransaction::TReplica::TMutation::Pauser: {
-                          break;
-                        }
-                        case L1::TTransaction::TReplica::TMutation::UnPauser: {
-                          break;
-                        }
-                      }
-                    }
-                    break;
-                  }
-                }
-              }
-            } catch (const Rpc::TAnyFuture::TRemoteError &error) {
-              std::cout << "our future failed and we caught it : " << error.what() << std::endl;
+          /* send each batch without waiting on the ones before it; the slave applies them in order */
+          for (auto &batch : batches) {
+            Base::TTimer timer;
+            auto future = context->Write<void>(TSlave::PushNotificationsId, *batch.first);
+            timer.Stop();
+            if (timer.GetTotal() > 1s) {
+              syslog(LOG_INFO, "Write TSlave::PushNotificationsId took [%fs]", ToSecondsDouble(timer.GetTotal()));
+            }
+            assert(future);
+            pending_pushes.push_back(TPendingPush{future, move(batch.second)});
+            /* retire what's come back, and hold the slave to a bounded window */
+            while (!pending_pushes.empty() && (pending_pushes.size() > MaxPendingPushes || *pending_pushes.front().Future)) {
+              RetireOldestPush(pending_pushes, state_alloc);
             }
           }
           break;
@@ -494,6 +453,77 @@ void TManager::RunReplicateTransaction() {
   DEBUG_LOG("RunReplicateTransaction() Exiting");
 }
 
+void TManager::RetireOldestPush(deque<TPendingPush> &pending_pushes, void *state_alloc) {
+  assert(this);
+  assert(&pending_pushes);
+  assert(!pending_pushes.empty());
+  TPendingPush push = move(pending_pushes.front());
+  pending_pushes.pop_front();
+  try {
+    push.Future->Sync();  // wait for the future to complete
+    if (!static_cast<bool>(*push.Future)) {
+      throw std::runtime_error("Future did not complete.");
+    }
+    /* now let the sessions know their updates are replicated. */
+    for (TReplicationQueue::TItemCollection::TCursor csr(push.Queue->GetItemCollection()); csr; ++csr) {
+      switch (csr->GetKind()) {
+        case TReplicationQueue::TReplicationItem::Repo : {
+          break;
+        }
+        case TReplicationQueue::TReplicationItem::Durable : {
+          break;
+        }
+        case TReplicationQueue::TReplicationItem::IndexId : {
+          break;
+        }
+        case TReplicationQueue::TReplicationItem::Transaction : {
+          for (const auto &mutation : reinterpret_cast<TTransactionReplication *>(&*csr)->GetReplica().GetMutationList()) {
+            switch (mutation.GetKind()) {
+              case L1::TTransaction::TReplica::TMutation::Pusher: {
+                if (mutation.GetRepoId() == GlobalPovId) {
+                  /* updates promoted to global carry just the session behind each of the updates collapsed into them. */
+                  Server::TMetaRecord::TSessionIdByUpdateId session_id_by_update_id;
+                  try {
+                    Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), session_id_by_update_id);
+                  } catch (const exception &ex) {
+                    syslog(LOG_ERR, "Exception while trying to access session IDs of update promoted to global: [%s]", ex.what());
+                  }
+                  for (const auto &item: session_id_by_update_id) {
+                    UpdateReplicationNotificationCb(item.second, mutation.GetRepoId(), item.first);
+                  }
+                } else {
+                  Server::TMetaRecord meta_record;
+                  Sabot::ToNative(*Sabot::State::TAny::TWrapper(mutation.GetUpdate().GetMetadata().NewState(mutation.GetUpdate().GetSuprena().get(), state_alloc)), meta_record);
+                  /* an update collapsed from several keeps each one's id as the key of its entry. */
+                  for (const auto &item: meta_record.GetEntryByUpdateId()) {
+                    UpdateReplicationNotificationCb(item.second.GetSessionId(), mutation.GetRepoId(), item.first);
+                  }
+                }
+                break;
+              }
+              case L1::TTransaction::TReplica::TMutation::Popper: {
+                break;
+              }
+              case L1::TTransaction::TReplica::TMutation::Failer: {
+                break;
+              }
+              case L1::TTransaction::TReplica::TMutation::Pauser: {
+                break;
+              }
+              case L1::TTransaction::TReplica::TMutation::UnPauser: {
+                break;
+              }
+            }
+          }
+          break;
+        }
+      }
+    }
+  } catch (const Rpc::TAnyFuture::TRemoteError &error) {
+    std::cout << "our future failed and we caught it : " << error.what() << std::endl;
+  }
+}
+
 TManager::TMaster::TMaster(TManager *manager, const TFd &fd)
     : TMasterContext(fd), Manager(manager) {}
 
@@ -562,7 +592,7 @@ void TManager::AugmentViewMapWithDiskLayers(TMaster::TViewDef &view_def, const s
 
 TFileSync TManager::TMaster::SyncFile(const Base::TUuid &file_id, size_t gen_id, size_t context) {
   assert(this);
-  return TFileSync(Manager->GetEngine(), file_id, gen_id, context);
+  return TFileSync(Manager->GetEngine(), file_id, gen_id, context, Manager->GetMergeDiskRunners());
 }
 
 TManager::TSlave::TSlave(TManager *manager, const TFd &fd)
@@ -627,49 +657,70 @@ void TManager::TSlave::SyncInventory() {
 
 
     if (lowest && highest) {
-      //std::cout << "SetNextSequenceNumber [" << *lowest << "]" << std::endl;
-      repo->SetNextSequenceNumber(*lowest);
-      TSequenceNumber my_lowest = 0UL;
-      const Base::TOpt<TSequenceNumber> &high = repo->GetSequenceNumberLimit();
-      if (high) {
-        my_lowest = std::max(*lowest, *high);
-      }
-      assert(snap_next_id == my_lowest + 1);
-
-      auto view_future = Write<TMaster::TViewDef>(TMaster::GetViewId, repo_id);
-      assert(view_future);
-      TMaster::TViewDef view_def = **view_future;
-
-      if (view_def.size() && Manager->AllowFileSync) {
+      TMaster::TViewDef view_def;
+      if (Manager->AllowFileSync) {
+        auto view_future = Write<TMaster::TViewDef>(TMaster::GetViewId, repo_id);
+        assert(view_future);
+        view_def = **view_future;
         /* low, high, gen_id, num_keys */
         for (const auto &view_file : view_def) {
           syslog(LOG_INFO, "Can Sync [%ld -> %ld] from [%ld]", std::get<0>(view_file), std::get<1>(view_file), std::get<2>(view_file));
         }
-
-        /* do we need to fill in the front? if current low > first low from master disk view */
-        if (my_lowest > std::get<0>(view_def[0])) {
-          PullUpdateRange(repo_id, repo, my_lowest + 1, std::get<0>(view_def[0]) - 1);
+      }
+      /* skip whatever we kept from before we lost the master, and fetch only the rest */
+      const Base::TOpt<TSequenceNumber> &held_up_to = repo->GetSequenceNumberLimit();
+      const auto steps = PlanResync(view_def, *lowest, *highest, held_up_to, Manager->AllowFileSync);
+      if (held_up_to) {
+        syslog(LOG_INFO, "Resync holds up to [%ld] of [%ld -> %ld]; [%ld] steps to go", *held_up_to, *lowest, *highest, steps.size());
+      }
+      repo->SetNextSequenceNumber(steps.empty() ? *highest + 1UL : steps.front().Low);
+      size_t num_files = 0UL, num_keys_to_copy = 0UL;
+      for (const auto &step : steps) {
+        if (step.Kind == TResyncStep::CopyFile) {
+          ++num_files;
+          num_keys_to_copy += step.NumKeys;
         }
-        /* fill in the middle disk files */
-        TSequenceNumber highest_filled = 0UL;
-        for (const auto &view_file : view_def) {
-          if (std::get<0>(view_file) >= my_lowest && std::get<1>(view_file) <= *highest) {
-            highest_filled = std::max(highest_filled, std::get<1>(view_file));
-            syslog(LOG_INFO, "sync file [%ld] for [%ld -> %ld] with service [%p]", std::get<2>(view_file), std::get<0>(view_file), std::get<1>(view_file), Manager->GetEngine());
-            auto file_future = Write<TFileSync>(TMaster::SyncFileId, repo_id, std::get<2>(view_file), reinterpret_cast<size_t>(Manager->GetEngine()));
-            assert(file_future);
-            TFileSync file = **file_future;
-            repo->AddSyncedFileToRepo(file.GetStartingBlockId(), file.GetStartingBlockOffset(), file.GetFileLength(), std::get<0>(view_file), std::get<1>(view_file), std::get<3>(view_file));
-            repo->UseSequenceNumbers((std::get<1>(view_file) - std::get<0>(view_file)) + 1);
-            //std::cout << "UseSequenceNumbers[" << ((std::get<1>(view_file) - std::get<0>(view_file)) + 1) << "]" << std::endl;
+      }
+      /* keep up to MaxSyncFilesInFlight files requested ahead of the one we're on, so the master streams them back to back */
+      std::deque<std::shared_ptr<Rpc::TFuture<TFileSync>>> file_futures;
+      size_t next_to_request = 0UL;
+      auto request_files = [&]() {
+        for (; next_to_request < steps.size() && file_futures.size() < MaxSyncFilesInFlight; ++next_to_request) {
+          const TResyncStep &ahead = steps[next_to_request];
+          if (ahead.Kind == TResyncStep::CopyFile) {
+            syslog(LOG_INFO, "sync file [%ld] for [%ld -> %ld] with service [%p]", ahead.GenId, ahead.Low, ahead.High, Manager->GetEngine());
+            file_futures.push_back(Write<TFileSync>(TMaster::SyncFileId, repo_id, ahead.GenId, reinterpret_cast<size_t>(Manager->GetEngine())));
+            assert(file_futures.back());
           }
         }
-        /* do we need to fill the end? if highest > highest_filled */
-        if (*highest > highest_filled) {
-          PullUpdateRange(repo_id, repo, highest_filled + 1, *highest);
+      };
+      Base::TTimer timer;
+      size_t num_files_copied = 0UL, num_keys_copied = 0UL, num_bytes_copied = 0UL;
+      for (const auto &step : steps) {
+        switch (step.Kind) {
+          case TResyncStep::CopyFile: {
+            request_files();
+            assert(!file_futures.empty());
+            TFileSync file = **file_futures.front();
+            file_futures.pop_front();
+            request_files();
+            repo->AddSyncedFileToRepo(file.GetStartingBlockId(), file.GetStartingBlockOffset(), file.GetFileLength(), step.Low, step.High, step.NumKeys);
+            repo->UseSequenceNumbers((step.High - step.Low) + 1);
+            ++num_files_copied;
+            num_keys_copied += step.NumKeys;
+            num_bytes_copied += file.GetFileLength();
+            const double elapsed = ToSecondsDouble(timer.GetElapsed());
+            const double eta = num_keys_copied ? elapsed * (num_keys_to_copy - num_keys_copied) / num_keys_copied : 0.0;
+            syslog(LOG_INFO, "File sync progress: [%ld / %ld] files, [%ld / %ld] keys, [%ld] MB at [%f] MB/s; ETA [%fs]",
+                   num_files_copied, num_files, num_keys_copied, num_keys_to_copy, num_bytes_copied >> 20,
+                   elapsed > 0.0 ? (num_bytes_copied >> 20) / elapsed : 0.0, eta);
+            break;
+          }
+          case TResyncStep::PullUpdates: {
+            PullUpdateRange(repo_id, repo, step.Low, step.High);
+            break;
+          }
         }
-      } else {
-        PullUpdateRange(repo_id, repo, *lowest, *highest);
       }
     }
     //std::cout << "SetNextSequenceNumber [" << next_id << "]" << std::endl;
@@ -1285,14 +1336,16 @@ void TManager::SaveRepo(TRepo *base_repo) {
   }
 }
 
-void TManager::SaveIndexNamespaceMapping(const Base::TUuid &index_id, const std::string &namespace_name) {
+void TManager::SaveIndexNamespaceMapping(const Base::TUuid &index_id, const std::string &namespace_name, const Indy::TKey &val) {
   void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
   /* Perform transaction on System repo to save this mapping */ {
     TSuprena arena;
     auto transaction = NewTransaction();
-    auto update = TUpdate::NewUpdate(TUpdate::TOpByKey{ {
-      TIndexKey(SystemIDNSIndexId, TKey(make_tuple(index_id), &arena, state_alloc)),
-      TKey(namespace_name, &arena, state_alloc)} }, TKey(), TKey(TUuid(TUuid::Twister), &arena, state_alloc));
+    auto update = TUpdate::NewUpdate(TUpdate::TOpByKey{
+      { TIndexKey(SystemIDNSIndexId, TKey(make_tuple(index_id), &arena, state_alloc)),
+        TKey(namespace_name, &arena, state_alloc) },
+      { TIndexKey(SystemIDTypeIndexId, TKey(make_tuple(index_id), &arena, state_alloc)),
+        TKey(&arena, state_alloc, val) } }, TKey(), TKey(TUuid(TUuid::Twister), &arena, state_alloc));
     transaction->Push(SystemRepo, update);
     transaction->Prepare();
     transaction->CommitAction();
@@ -1315,6 +1368,27 @@ std::unordered_map<Base::TUuid, std::string> TManager::GetIndexNamespaceMapping(
   return ret;
 }
 
+void TManager::ForEachSavedIndex(const TIndexCb &cb) {
+  const auto pkg_key_mapping = GetIndexNamespaceMapping();
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  TSuprena arena;
+  auto view = make_unique<Indy::TRepo::TView>(SystemRepo);
+  auto walker_ptr = SystemRepo->NewPresentWalker(view, TIndexKey(SystemIDTypeIndexId, TKey(make_tuple(Native::TFree<Base::TUuid>()), &arena, state_alloc)), true);
+  for (auto &walker = *walker_ptr; walker; ++walker) {
+    std::tuple<Base::TUuid> index_id_tuple;
+    Sabot::ToNative(*Sabot::State::TAny::TWrapper((*walker).Key.NewState((*walker).KeyArena, state_alloc)), index_id_tuple);
+    auto pos = pkg_key_mapping.find(std::get<0>(index_id_tuple));
+    if (pos == pkg_key_mapping.end()) {
+      /* we always save the namespace with the type, so this is a lost mapping, and the index's data would go with it */
+      stringstream ss;
+      ss << std::get<0>(index_id_tuple);
+      syslog(LOG_ERR, "Could not find package namespace for index id [%s]\n", ss.str().c_str());
+      abort();
+    }
+    cb(pos->first, pos->second, TKey((*walker).Op, (*walker).OpArena));
+  }
+}
+
 void TManager::OnSlaveJoin(const Base::TFd &fd) {
   assert(Indy::Fiber::TRunner::LocalRunner);
   Indy::Fiber::TRunner *orig_slow_runner = Indy::Fiber::TRunner::LocalRunner;
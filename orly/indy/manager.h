@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <deque>
 #include <mutex>
 #include <thread>
 
@@ -38,6 +39,9 @@ namespace Orly {
     const Base::TUuid SystemRepoIndexId("9D3DAB7C-2D75-452C-8200-30180FF584F1");
     /* The index id of the system repo space used to store index namespace mappings */
     const Base::TUuid SystemIDNSIndexId("9154D7AE-FA10-42D5-9A10-AC68664B0092");
+    /* The index id of the system repo space used to store the value type of each index, so we can restore the index map at startup
+       without opening every data file. */
+    const Base::TUuid SystemIDTypeIndexId("D132BBBD-5903-4428-A877-C702018299DC");
 
     /* TODO */
     class TManager
@@ -524,12 +528,17 @@ namespace Orly {
       /* TODO */
       virtual void SaveRepo(TRepo *base_repo) override;
 
-      /* TODO */
-      void SaveIndexNamespaceMapping(const Base::TUuid &index_id, const std::string &namespace_name);
+      /* Save the namespace and value type (by way of a value of that type) of the given index. */
+      void SaveIndexNamespaceMapping(const Base::TUuid &index_id, const std::string &namespace_name, const Indy::TKey &val);
 
       /* TODO */
       std::unordered_map<Base::TUuid, std::string> GetIndexNamespaceMapping();
 
+      /* Call back for each index we've saved both a namespace and a value type for.  Indices saved before we kept their types are
+         skipped; the caller has to find those out from the data files and save them again.  A type saved without a namespace means
+         the mapping is lost, which we log and abort on, as we do for an index on disk with no namespace. */
+      void ForEachSavedIndex(const TIndexCb &cb);
+
       /* TODO */
       void OnSlaveJoin(const Base::TFd &fd);
 
@@ -562,6 +571,29 @@ namespace Orly {
       /* TODO */
       virtual void DeleteDurableReplication(TDurableReplication *durable_replication) NO_THROW override;
 
+      /* A batch we've pushed to the slave but haven't heard back about, and the items it carries. */
+      struct TPendingPush {
+
+        /* Completes when the slave has applied the batch. */
+        std::shared_ptr<Rpc::TFuture<void>> Future;
+
+        /* The items in the batch, kept until then so we can notify their sessions. */
+        std::unique_ptr<TReplicationQueue> Queue;
+
+      };  // TPendingPush
+
+      /* The most we pack into one push to the slave before starting another, measured before compression. */
+      static const size_t MaxReplicationBatchBytes;
+
+      /* The most pushes we let go unacknowledged before we wait on the oldest. */
+      static const size_t MaxPendingPushes;
+
+      /* The most files a resyncing slave asks for ahead of the one it's installing. */
+      static const size_t MaxSyncFilesInFlight;
+
+      /* Wait for the slave to acknowledge the oldest pending push, then notify the sessions whose updates it carried. */
+      void RetireOldestPush(std::deque<TPendingPush> &pending_pushes, void *state_alloc);
+
       /* TODO */
       void Demote();
 
@@ -114,6 +114,8 @@ TManager::TRepo::TRepo(TManager *manager, const TUuid &repo_id, const TTtl &ttl,
       Manager(manager),
       Status(status),
       Id(repo_id),
+      BytesIngested(0UL),
+      BytesWritten(0UL),
       MergeMemMembership(this),
       MergeDiskMembership(this) {
   auto now = steady_clock::now();
@@ -186,6 +188,32 @@ std::unique_ptr<Orly::Indy::TUpdateWalker> TManager::TRepo::NewUpdateWalkerFile(
   throw;
 }
 
+void TManager::TRepo::AddBytesWritten(size_t bytes, bool is_ingest) {
+  assert(this);
+  if (is_ingest) {
+    BytesIngested += bytes;
+    Manager->BytesIngested += bytes;
+  }
+  BytesWritten += bytes;
+  Manager->BytesWritten += bytes;
+}
+
+vector<Orly::Indy::TCompactionPlanner::TLayer> TManager::TRepo::GetCompactionLayers(TMapping *mapping) {
+  assert(mapping);
+  vector<Orly::Indy::TCompactionPlanner::TLayer> layers;
+  for (TMapping::TEntryCollection::TCursor csr(mapping->GetEntryCollection()); csr; ++csr) {
+    const TDataLayer *layer = csr->GetLayer();
+    const bool is_disk = layer->GetKind() == TDataLayer::Disk;
+    layers.push_back({layer->GetSize(), is_disk, is_disk && !layer->GetMarkedTaken()});
+  }
+  return layers;
+}
+
+bool TManager::TRepo::HasMergeDiskWork(TMapping *mapping) const {
+  assert(this);
+  return static_cast<bool>(Manager->GetCompactionPlanner().Plan(GetCompactionLayers(mapping)));
+}
+
 void TManager::TRepo::MakeDirty() {
   if (!DirtyPtr) {
     DirtyPtr = Manager->Open<TRepo>(GetId());
@@ -209,7 +237,8 @@ TManager::TManager(Disk::Util::TEngine *engine,
                    const std::vector<size_t> &merge_mem_cores,
                    const std::vector<size_t> &merge_disk_cores,
                    bool /*create_new*/)
-    :
+    : BytesIngested(0UL),
+      BytesWritten(0UL),
       Scheduler(scheduler),
       ShuttingDown(false),
       AllowTailing(allow_tailing),
@@ -223,6 +252,7 @@ TManager::TManager(Disk::Util::TEngine *engine,
       MaxCacheSize(max_repo_cache_size),
       Engine(engine),
       TempFileConsolThresh(temp_file_consol_thresh),
+      ArenaCodec(Disk::TArenaCodec::None),
       MergeMemCores(merge_mem_cores),
       MergeDiskCores(merge_disk_cores),
       TetrisManager(nullptr),
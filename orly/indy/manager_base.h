@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 
@@ -28,6 +29,8 @@
 #include <base/uuid.h>
 #include <inv_con/unordered_list.h>
 #include <inv_con/unordered_multimap.h>
+#include <orly/indy/compaction_planner.h>
+#include <orly/indy/disk/arena_frame.h>
 #include <orly/indy/disk/util/engine.h>
 #include <orly/indy/disk/utilization_reporter.h>
 #include <orly/indy/fiber/fiber.h>
@@ -369,6 +372,12 @@ namespace Orly {
           /* TODO */
           inline bool IsTailingAllowed() const;
 
+          /* Bytes of data file we've written flushing memory layers (or taken from a master), which is what we've ingested. */
+          inline size_t GetBytesIngested() const;
+
+          /* Bytes of data file we've written in all: flushes, merges and tails.  Over GetBytesIngested(), our write amplification. */
+          inline size_t GetBytesWritten() const;
+
           protected:
 
           /* Forward Declarations. */
@@ -666,6 +675,16 @@ namespace Orly {
           /* TODO */
           inline void RemoveFromClosedBuffer();
 
+          /* Count a data file we've written, with the manager's totals as well as our own.  If 'is_ingest', the file is new data
+             rather than the result of a merge. */
+          void AddBytesWritten(size_t bytes, bool is_ingest);
+
+          /* Describe the layers of the given mapping, oldest to newest, for the compaction planner. */
+          static std::vector<TCompactionPlanner::TLayer> GetCompactionLayers(TMapping *mapping);
+
+          /* True iff. the compaction planner would find a merge to do in the given mapping. */
+          bool HasMergeDiskWork(TMapping *mapping) const;
+
           /* TODO */
           mutable TMappingCollection::TImpl MappingCollection;
 
@@ -693,6 +712,10 @@ namespace Orly {
           /* TODO */
           Base::TUuid Id;
 
+          /* See accessors. */
+          std::atomic<size_t> BytesIngested;
+          std::atomic<size_t> BytesWritten;
+
           /* TODO */
           TQueueMembership::TImpl MergeMemMembership;
           TQueueMembership::TImpl MergeDiskMembership;
@@ -716,6 +739,24 @@ namespace Orly {
         /* TODO */
         inline size_t GetTempFileConsolThresh() const;
 
+        /* Decides which disk layers of a repo get merged. */
+        inline const TCompactionPlanner &GetCompactionPlanner() const;
+
+        /* Call before any merges start. */
+        inline void SetCompactionPlanner(const TCompactionPlanner &compaction_planner);
+
+        /* The runners a disk merge may spread its work across. */
+        inline const std::vector<Fiber::TRunner *> &GetMergeDiskRunners() const;
+
+        /* Call before any merges start. */
+        inline void SetMergeDiskRunners(const std::vector<Fiber::TRunner *> &merge_disk_runners);
+
+        /* How the arenas of the data files we write, whether flushed from memory or merged, are stored.  None unless set. */
+        inline Disk::TArenaCodec GetArenaCodec() const;
+
+        /* Call before any flushes or merges start. */
+        inline void SetArenaCodec(Disk::TArenaCodec arena_codec);
+
         /* TODO */
         void CompactOpemMap();
 
@@ -779,6 +820,10 @@ namespace Orly {
         Base::TSigmaCalc MergeDiskAverageKeysCalc;
         std::mutex MergeDiskCPULock;
 
+        /* The sums of TRepo::GetBytesIngested() and TRepo::GetBytesWritten() over every repo, since we started. */
+        std::atomic<size_t> BytesIngested;
+        std::atomic<size_t> BytesWritten;
+
         protected:
 
         /* TODO */
@@ -957,6 +1002,15 @@ namespace Orly {
         /* TODO */
         size_t TempFileConsolThresh;
 
+        /* See accessor. */
+        TCompactionPlanner CompactionPlanner;
+
+        /* See accessor. */
+        std::vector<Fiber::TRunner *> MergeDiskRunners;
+
+        /* See accessor. */
+        Disk::TArenaCodec ArenaCodec;
+
         /* TODO */
         const std::vector<size_t> &MergeMemCores;
 
@@ -994,6 +1048,16 @@ namespace Orly {
         return Manager->AllowTailing;
       }
 
+      inline size_t TManager::TRepo::GetBytesIngested() const {
+        assert(this);
+        return BytesIngested;
+      }
+
+      inline size_t TManager::TRepo::GetBytesWritten() const {
+        assert(this);
+        return BytesWritten;
+      }
+
       inline void TManager::TRepo::TMapping::Incr() {
         assert(this);
         assert(!(this != RepoMembership.TryGetCollection()->TryGetLastMember() && RefCount == 0));
@@ -1094,6 +1158,36 @@ namespace Orly {
         return TempFileConsolThresh;
       }
 
+      inline const TCompactionPlanner &TManager::GetCompactionPlanner() const {
+        assert(this);
+        return CompactionPlanner;
+      }
+
+      inline void TManager::SetCompactionPlanner(const TCompactionPlanner &compaction_planner) {
+        assert(this);
+        CompactionPlanner = compaction_planner;
+      }
+
+      inline const std::vector<Fiber::TRunner *> &TManager::GetMergeDiskRunners() const {
+        assert(this);
+        return MergeDiskRunners;
+      }
+
+      inline void TManager::SetMergeDiskRunners(const std::vector<Fiber::TRunner *> &merge_disk_runners) {
+        assert(this);
+        MergeDiskRunners = merge_disk_runners;
+      }
+
+      inline Disk::TArenaCodec TManager::GetArenaCodec() const {
+        assert(this);
+        return ArenaCodec;
+      }
+
+      inline void TManager::SetArenaCodec(Disk::TArenaCodec arena_codec) {
+        assert(this);
+        ArenaCodec = arena_codec;
+      }
+
       /*
        *  Definitions of TPtr<> members.
        */
@@ -30,6 +30,9 @@ TMemoryLayer::TMemoryLayer(L0::TManager *manager)
 
 TMemoryLayer::~TMemoryLayer() {
   assert(this);
+  /* Unlink the entries in one pass before the updates take them with them; otherwise each entry would search the index for
+     its predecessors on the way out. */
+  EntryCollection.RemoveEachMember();
   UpdateCollection.DeleteEachMember();
   EntryCollection.DeleteEachMember();
 }
@@ -68,12 +71,18 @@ std::unique_ptr<Orly::Indy::TUpdateWalker> TMemoryLayer::NewUpdateWalker(TSequen
   return make_unique<TUpdateWalker>(this, from);
 }
 
+/* The entry in the given membership, or null if there is none. */
+static const TUpdate::TEntry *TryGetEntry(const TMemoryLayer::TEntryCollection::TTypedMembership *membership) {
+  return membership ? membership->GetMember() : nullptr;
+}
+
 TMemoryLayer::TMatchPresentWalker::TMatchPresentWalker(const TMemoryLayer *layer,
                                                        const TIndexKey &key)
     : Orly::Indy::TPresentWalker(Match),
       Layer(layer),
       Key(key),
-      Csr(Layer->GetEntryCollection()),
+      Csr(Layer->TrySeekEntry(key)),
+      End(TryGetEntry(Layer->TrySeekEntry(key, true))),
       Valid(true),
       Cached(false),
       PassedMatch(false) {
@@ -109,7 +118,7 @@ void TMemoryLayer::TMatchPresentWalker::Refresh() const {
     void *key_state_alloc = alloca(Sabot::State::GetMaxStateSize() * 2);
     void *search_state_alloc = reinterpret_cast<uint8_t *>(key_state_alloc) + Sabot::State::GetMaxStateSize();
     Sabot::State::TAny::TWrapper key_state(Key.GetKey().GetCore().NewState(Key.GetKey().GetArena(), key_state_alloc));
-    for (;Csr; ++Csr) {
+    for (;Csr && &*Csr != End; ++Csr) {
       Cached = true;
       Atom::TComparison index_id_comp = Atom::CompareOrdered(Key.GetIndexId(), Csr->GetIndexKey().GetIndexId());
       switch (index_id_comp) {
@@ -122,10 +131,8 @@ void TMemoryLayer::TMatchPresentWalker::Refresh() const {
           Sabot::TMatchResult result = MatchPrefixState(*key_state, *cur_state);
           switch (result) {
             case Sabot::TMatchResult::NoMatch: {
-              if (PassedMatch) {
-                Valid = false;
-                return;
-              }
+              /* A free field ahead of a defined one lets non-matching entries sit among the matching ones, so keep looking
+                 until we're past the defined prefix. */
               break;
             }
             case Sabot::TMatchResult::PrefixMatch: {
@@ -163,7 +170,7 @@ TMemoryLayer::TRangePresentWalker::TRangePresentWalker(const TMemoryLayer *layer
       Layer(layer),
       From(from),
       To(to),
-      Csr(Layer->GetEntryCollection()),
+      Csr(Layer->TrySeekEntry(from)),
       Valid(true), Cached(false), PassedMatch(false) {
   assert(From.GetIndexId() == To.GetIndexId());
   Refresh();
@@ -219,7 +226,7 @@ void TMemoryLayer::TRangePresentWalker::Refresh() const {
             if (Atom::IsGe(comp)) {
               PassedMatch = true;
               Sabot::State::TAny::TWrapper to_state(To.GetKey().GetCore().NewState(To.GetKey().GetArena(), key_state_alloc_3));
-              Atom::TComparison comp = OrderStates(*cur_state, *key_state);
+              Atom::TComparison comp = OrderStates(*cur_state, *to_state);
               if (Atom::IsGt(comp)) {
                 Valid = false;
                 return;
@@ -297,6 +304,46 @@ void TMemoryLayer::TUpdateWalker::Refresh() {
   }
 }
 
+TMemoryLayer::TEntryCollection::TTypedMembership *TMemoryLayer::TrySeekEntry(const TIndexKey &key, bool past_prefix) const {
+  assert(this);
+  const Base::TUuid &index_id = key.GetIndexId();
+  const Atom::TCore &key_core = key.GetKey().GetCore();
+  Atom::TCore::TArena *const key_arena = key.GetKey().GetArena();
+  assert(key_core.IsTuple());
+  void *pin_alloc = alloca(sizeof(Atom::TCore::TArena::TFinalPin) * 2);
+  void *entry_pin_alloc = reinterpret_cast<uint8_t *>(pin_alloc) + sizeof(Atom::TCore::TArena::TFinalPin);
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize() * 2);
+  void *entry_state_alloc = reinterpret_cast<uint8_t *>(state_alloc) + Sabot::State::GetMaxStateSize();
+  Atom::TCore::TArena::TFinalPin::TWrapper key_pin(key_arena->Pin(*key_core.TryGetOffset(),
+                                                                  sizeof(Atom::TCore::TNote) + (sizeof(Atom::TCore) * *key_core.TryGetElemCount()),
+                                                                  pin_alloc));
+  const Atom::TCore *key_start, *key_limit;
+  key_pin->GetNote()->Get(key_start, key_limit);
+  const size_t num_defined = key_pin->GetNote()->GetTupleNumNonFree();
+  /* An entry is before the key if it's in a lesser index, or if its first 'num_defined' fields order before the key's.
+     This agrees with the order of the entry collection, as tuples order lexicographically.
+     When seeking past the prefix, an entry whose first 'num_defined' fields equal the key's is before it as well. */
+  return EntryCollection.TryGetFirstMembershipNotBefore([&](const TUpdate::TEntry &entry, const TUpdate::TEntry::TEntryKey &) {
+    Atom::TComparison comp = Atom::CompareOrdered(entry.GetIndexKey().GetIndexId(), index_id);
+    if (Atom::IsEq(comp) && num_defined) {
+      const Atom::TCore &entry_core = entry.GetKey().GetCore();
+      Atom::TCore::TArena *const entry_arena = entry.GetKey().GetArena();
+      Atom::TCore::TArena::TFinalPin::TWrapper entry_pin(entry_arena->Pin(*entry_core.TryGetOffset(),
+                                                                          sizeof(Atom::TCore::TNote) + (sizeof(Atom::TCore) * *entry_core.TryGetElemCount()),
+                                                                          entry_pin_alloc));
+      const Atom::TCore *entry_start, *entry_limit;
+      entry_pin->GetNote()->Get(entry_start, entry_limit);
+      for (size_t i = 0; i < num_defined && entry_start + i < entry_limit && Atom::IsEq(comp); ++i) {
+        if (!entry_start[i].TryQuickOrderComparison(entry_arena, key_start[i], key_arena, comp)) {
+          comp = Sabot::OrderStates(*Sabot::State::TAny::TWrapper(entry_start[i].NewState(entry_arena, entry_state_alloc)),
+                                    *Sabot::State::TAny::TWrapper(key_start[i].NewState(key_arena, state_alloc)));
+        }
+      }
+    }
+    return past_prefix ? Atom::IsLe(comp) : Atom::IsLt(comp);
+  });
+}
+
 void TMemoryLayer::ImporterAppendUpdate(TUpdate *update) {
   assert(this);
   assert(update);
@@ -20,6 +20,7 @@
 
 #include <base/class_traits.h>
 #include <inv_con/ordered_list.h>
+#include <inv_con/skip_list.h>
 #include <orly/indy/manager_base.h>
 #include <orly/indy/update.h>
 #include <orly/sabot/all.h>
@@ -47,7 +48,9 @@ namespace Orly {
 
       /* TODO */
       typedef InvCon::OrderedList::TCollection<TMemoryLayer, TUpdate, TSequenceNumber> TUpdateCollection;
-      typedef InvCon::OrderedList::TCollection<TMemoryLayer, TUpdate::TEntry, TUpdate::TEntry::TEntryKey> TEntryCollection;
+
+      /* Entries are indexed by a skip list so that inserts and walker seeks are O(log n) rather than a walk of the whole layer. */
+      typedef InvCon::SkipList::TCollection<TMemoryLayer, TUpdate::TEntry, TUpdate::TEntry::TEntryKey> TEntryCollection;
 
       /* TODO */
       TMemoryLayer(L0::TManager *manager);
@@ -125,6 +128,11 @@ namespace Orly {
         /* TODO */
         mutable TMemoryLayer::TEntryCollection::TCursor Csr;
 
+        /* The first entry past every one which could match, or null if that's the end of the layer.  A free field before a
+           defined one means entries which don't match can be mixed in among those which do, so we can't stop at the first
+           one that doesn't. */
+        const TUpdate::TEntry *const End;
+
         /* TODO */
         mutable bool Valid;
 
@@ -239,6 +247,11 @@ namespace Orly {
       /* TODO */
       inline virtual TKind GetKind() const;
 
+      /* The first entry which could match the given key, or null if there is none.
+         If the key is partially free, we seek on the defined prefix of the key.
+         If past_prefix, we seek instead to the first entry whose defined prefix orders after the key's. */
+      TEntryCollection::TTypedMembership *TrySeekEntry(const TIndexKey &key, bool past_prefix = false) const;
+
       /* TODO */
       void ImporterAppendUpdate(TUpdate *update);
 
@@ -152,6 +152,120 @@ FIXTURE(Free) {
   }
 }
 
+FIXTURE(FreeInMiddle) {
+  TMemoryLayer mem_layer(nullptr);
+  Base::TUuid idx(Base::TUuid::Twister);
+  Base::TUuid other_idx(Base::TUuid::Twister);
+  TSuprena arena;
+  TSequenceNumber seq_num = 0UL;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  /* insert data */ {
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 0L, 1L, 9L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 1L, 5L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 1L, 9L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 2L, 9L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 3L, 7L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 3L, 9L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 1L, 4L, 11L);
+    Insert(mem_layer, ++seq_num, idx, static_cast<int64_t>(rand()), 2L, 1L, 9L);
+    Insert(mem_layer, ++seq_num, other_idx, static_cast<int64_t>(rand()), 1L, 5L, 9L);
+  }
+  /* <[1L , free(int64_t), 9L]> */ {
+    TIndexKey search_key(idx, TKey(make_tuple(1L, Native::TFree<int64_t>(), 9L), &arena, state_alloc));
+    auto walker_ptr = mem_layer.NewPresentWalker(search_key);
+    auto &walker = *walker_ptr;
+    vector<int64_t> expected = { 1L, 2L, 3L };
+    for (int64_t mid : expected) {
+      if (!EXPECT_TRUE(walker)) {
+        break;
+      }
+      const TPresentWalker::TItem &item = *walker;
+      EXPECT_EQ(TKey(item.Key, item.KeyArena), TKey(make_tuple(1L, mid, 9L), &arena, state_alloc));
+      ++walker;
+    }
+    EXPECT_FALSE(walker);
+  }
+  /* <[1L , free(int64_t), 6L]> */ {
+    TIndexKey search_key(idx, TKey(make_tuple(1L, Native::TFree<int64_t>(), 6L), &arena, state_alloc));
+    auto walker_ptr = mem_layer.NewPresentWalker(search_key);
+    EXPECT_FALSE(*walker_ptr);
+  }
+  /* <[free(int64_t), 1L, 9L]> */ {
+    TIndexKey search_key(idx, TKey(make_tuple(Native::TFree<int64_t>(), 1L, 9L), &arena, state_alloc));
+    auto walker_ptr = mem_layer.NewPresentWalker(search_key);
+    auto &walker = *walker_ptr;
+    vector<int64_t> expected = { 0L, 1L, 2L };
+    for (int64_t first : expected) {
+      if (!EXPECT_TRUE(walker)) {
+        break;
+      }
+      const TPresentWalker::TItem &item = *walker;
+      EXPECT_EQ(TKey(item.Key, item.KeyArena), TKey(make_tuple(first, 1L, 9L), &arena, state_alloc));
+      ++walker;
+    }
+    EXPECT_FALSE(walker);
+  }
+}
+
+FIXTURE(Seek) {
+  TMemoryLayer mem_layer(nullptr);
+  Base::TUuid lo_idx(Base::TUuid::Twister), hi_idx(Base::TUuid::Twister);
+  if (lo_idx > hi_idx) {
+    swap(lo_idx, hi_idx);
+  }
+  TSuprena arena;
+  TSequenceNumber seq_num = 0UL;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  const int64_t num_keys = 500L;
+  /* insert the even keys of both indexes in a scrambled order, and overwrite every tenth one */ {
+    for (int64_t i = 0; i < num_keys; ++i) {
+      int64_t key = ((i * 7919L) % num_keys) * 2L;
+      Insert(mem_layer, ++seq_num, lo_idx, key, key);
+      Insert(mem_layer, ++seq_num, hi_idx, -key, key);
+    }
+    for (int64_t key = 0; key < num_keys * 2L; key += 20L) {
+      Insert(mem_layer, ++seq_num, lo_idx, key + 1L, key);
+    }
+  }
+  /* the entry collection is in order */ {
+    size_t count = 0UL;
+    const TUpdate::TEntry *prev = nullptr;
+    for (TMemoryLayer::TEntryCollection::TCursor csr(mem_layer.GetEntryCollection()); csr; ++csr, ++count) {
+      if (prev) {
+        EXPECT_TRUE(prev->GetIndexKey() < csr->GetIndexKey() ||
+                    (prev->GetIndexKey() == csr->GetIndexKey() && prev->GetSequenceNumber() > csr->GetSequenceNumber()));
+      }
+      prev = &*csr;
+    }
+    EXPECT_EQ(count, mem_layer.GetSize());
+  }
+  /* match walks find the newest version of present keys and nothing for absent ones */ {
+    for (int64_t key = -1L; key <= num_keys * 2L; ++key) {
+      TIndexKey search_key(lo_idx, TKey(make_tuple(key), &arena, state_alloc));
+      auto walker_ptr = mem_layer.NewPresentWalker(search_key);
+      auto &walker = *walker_ptr;
+      if (key >= 0L && key < num_keys * 2L && key % 2L == 0L) {
+        if (EXPECT_TRUE(walker)) {
+          EXPECT_EQ(TKey((*walker).Key, (*walker).KeyArena), TKey(make_tuple(key), &arena, state_alloc));
+          EXPECT_EQ(TKey((*walker).Op, (*walker).OpArena), TKey(key % 20L ? key : key + 1L, &arena, state_alloc));
+        }
+      } else {
+        EXPECT_FALSE(walker);
+      }
+    }
+  }
+  /* range walks start at the first key in range and stay within their index */ {
+    TIndexKey from(hi_idx, TKey(make_tuple(101L), &arena, state_alloc)), to(hi_idx, TKey(make_tuple(120L), &arena, state_alloc));
+    auto walker_ptr = mem_layer.NewPresentWalker(from, to);
+    int64_t expected = 102L;
+    for (auto &walker = *walker_ptr; walker; ++walker, expected += 2L) {
+      EXPECT_EQ(TKey((*walker).Key, (*walker).KeyArena), TKey(make_tuple(expected), &arena, state_alloc));
+      EXPECT_EQ(TKey((*walker).Op, (*walker).OpArena), TKey(-expected, &arena, state_alloc));
+    }
+    EXPECT_EQ(expected, 122L);
+  }
+}
+
 #if 0
 FIXTURE(Range) {
   TMemoryLayer layer(nullptr);
@@ -0,0 +1,169 @@
+/* <orly/indy/memory_layer.test.manual.cc>
+
+   Microbenchmark for inserts and seeks in <orly/indy/memory_layer.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/memory_layer.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <base/class_traits.h>
+#include <base/timer.h>
+#include <inv_con/ordered_list.h>
+#include <inv_con/skip_list.h>
+#include <orly/indy/update.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Atom;
+using namespace Orly::Indy;
+
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::Pool(sizeof(TRepo::TMapping), "Repo Mapping");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TMapping::TEntry::Pool(sizeof(TRepo::TMapping::TEntry), "Repo Mapping Entry");
+Orly::Indy::Util::TPool L0::TManager::TRepo::TDataLayer::Pool(sizeof(TMemoryLayer), "Data Layer");
+
+Orly::Indy::Util::TPool TUpdate::Pool(sizeof(TUpdate), "Update", 400004UL);
+Orly::Indy::Util::TPool TUpdate::TEntry::Pool(sizeof(TUpdate::TEntry), "Entry", 400004UL);
+
+/* Shuffled keys [0, num_keys). */
+static vector<int64_t> MakeKeys(size_t num_keys) {
+  vector<int64_t> keys;
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<int64_t>(i));
+  }
+  shuffle(keys.begin(), keys.end(), mt19937_64(num_keys));
+  return keys;
+}
+
+static void Insert(TMemoryLayer &mem_layer, TSequenceNumber seq_num, const Base::TUuid &idx_id, int64_t key) {
+  Atom::TSuprena arena;
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  std::shared_ptr<TUpdate> update(TUpdate::NewUpdate(TUpdate::TOpByKey{
+    { TIndexKey(idx_id, TKey(std::make_tuple(key), &arena, state_alloc)), TKey(key, &arena, state_alloc)}
+    }, TKey(&arena), TKey(Base::TUuid(Base::TUuid::Best), &arena, state_alloc)));
+  update->SetSequenceNumber(seq_num);
+  mem_layer.Insert(TUpdate::CopyUpdate(update.get(), state_alloc));
+}
+
+/* Inserts into and point lookups against a memory layer of growing size.
+   With the entry index the per-op cost should grow with log(n), not n. */
+FIXTURE(MemoryLayer) {
+  for (size_t num_keys : { 1000UL, 10000UL, 100000UL }) {
+    const vector<int64_t> keys = MakeKeys(num_keys);
+    TMemoryLayer mem_layer(nullptr);
+    Base::TUuid idx_id(Base::TUuid::Twister);
+    TSequenceNumber seq_num = 0UL;
+    Base::TTimer insert_timer;
+    for (int64_t key : keys) {
+      Insert(mem_layer, ++seq_num, idx_id, key);
+    }
+    insert_timer.Stop();
+    TSuprena arena;
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    size_t found = 0UL;
+    Base::TTimer lookup_timer;
+    for (int64_t key : keys) {
+      TIndexKey search_key(idx_id, TKey(make_tuple(key), &arena, state_alloc));
+      found += *mem_layer.NewPresentWalker(search_key) ? 1UL : 0UL;
+    }
+    lookup_timer.Stop();
+    EXPECT_EQ(found, num_keys);
+    printf("memory layer, n = [%ld]: insert = [%f us/op], lookup = [%f us/op]\n",
+           num_keys,
+           chrono::duration_cast<chrono::duration<double, micro>>(insert_timer.GetTotal()).count() / num_keys,
+           chrono::duration_cast<chrono::duration<double, micro>>(lookup_timer.GetTotal()).count() / num_keys);
+  }
+}
+
+class TTeam;
+
+/* A member of both kinds of ordered collection, so we can compare the linear list against the skip list. */
+class TPlayer {
+  NO_COPY(TPlayer);
+  public:
+
+  typedef InvCon::OrderedList::TMembership<TPlayer, TTeam, int64_t> TListMembership;
+  typedef InvCon::SkipList::TMembership<TPlayer, TTeam, int64_t> TSkipMembership;
+
+  TPlayer(int64_t number)
+      : ListMembership(this, number), SkipMembership(this, number) {}
+
+  TListMembership::TImpl ListMembership;
+
+  TSkipMembership::TImpl SkipMembership;
+
+};  // TPlayer
+
+class TTeam {
+  NO_COPY(TTeam);
+  public:
+
+  typedef InvCon::OrderedList::TCollection<TTeam, TPlayer, int64_t> TListCollection;
+  typedef InvCon::SkipList::TCollection<TTeam, TPlayer, int64_t> TSkipCollection;
+
+  TTeam()
+      : ListCollection(this), SkipCollection(this) {}
+
+  mutable TListCollection::TImpl ListCollection;
+
+  mutable TSkipCollection::TImpl SkipCollection;
+
+};  // TTeam
+
+/* The same random inserts and lookups against the list the memory layer used to keep and the skip list it keeps now. */
+FIXTURE(OrderedListVsSkipList) {
+  for (size_t num_keys : { 1000UL, 10000UL, 20000UL }) {
+    const vector<int64_t> keys = MakeKeys(num_keys);
+    vector<unique_ptr<TPlayer>> players;
+    for (int64_t key : keys) {
+      players.emplace_back(new TPlayer(key));
+    }
+    TTeam team;
+    Base::TTimer list_insert_timer;
+    for (auto &player : players) {
+      player->ListMembership.ReverseInsert(&team.ListCollection);
+    }
+    list_insert_timer.Stop();
+    Base::TTimer skip_insert_timer;
+    for (auto &player : players) {
+      player->SkipMembership.ReverseInsert(&team.SkipCollection);
+    }
+    skip_insert_timer.Stop();
+    size_t list_found = 0UL, skip_found = 0UL;
+    Base::TTimer list_lookup_timer;
+    for (int64_t key : keys) {
+      list_found += team.ListCollection.TryGetFirstMember(key) ? 1UL : 0UL;
+    }
+    list_lookup_timer.Stop();
+    Base::TTimer skip_lookup_timer;
+    for (int64_t key : keys) {
+      skip_found += team.SkipCollection.TryGetFirstMember(key) ? 1UL : 0UL;
+    }
+    skip_lookup_timer.Stop();
+    EXPECT_EQ(list_found, num_keys);
+    EXPECT_EQ(skip_found, num_keys);
+    auto per_op = [num_keys](const Base::TTimer &timer) {
+      return chrono::duration_cast<chrono::duration<double, micro>>(timer.GetTotal()).count() / num_keys;
+    };
+    printf("n = [%ld]: ordered list insert = [%f us/op], lookup = [%f us/op]; skip list insert = [%f us/op], lookup = [%f us/op]\n",
+           num_keys, per_op(list_insert_timer), per_op(list_lookup_timer), per_op(skip_insert_timer), per_op(skip_lookup_timer));
+  }
+}
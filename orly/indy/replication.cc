@@ -18,7 +18,12 @@
 
 #include <orly/indy/replication.h>
 
+#include <snappy.h>
+
 #include <base/debug_log.h>
+#include <io/binary_input_only_stream.h>
+#include <io/binary_output_only_stream.h>
+#include <io/recorder_and_player.h>
 
 using namespace std;
 using namespace Base;
@@ -82,10 +87,18 @@ TReplicationStreamer::~TReplicationStreamer() {}
 
 void TReplicationStreamer::Write(Io::TBinaryOutputStream &strm) const {
   assert(this);
-  IndexIdBuilder.Write(strm);
-  RepoBuilder.Write(strm);
-  DurableBuilder.Write(strm);
-  TransactionBuilder.Write(strm);
+  auto recorder = make_shared<Io::TRecorder>();
+  /* flush the builders into the recorder */ {
+    Io::TBinaryOutputOnlyStream raw_strm(recorder);
+    IndexIdBuilder.Write(raw_strm);
+    RepoBuilder.Write(raw_strm);
+    DurableBuilder.Write(raw_strm);
+    TransactionBuilder.Write(raw_strm);
+  }
+  string raw, compressed;
+  recorder->CopyOut(raw);
+  snappy::Compress(raw.data(), raw.size(), &compressed);
+  strm << raw.size() << compressed;
 }
 
 void TReplicationStreamer::Read(Io::TBinaryInputStream &strm) {
@@ -94,10 +107,27 @@ void TReplicationStreamer::Read(Io::TBinaryInputStream &strm) {
   assert(!RepoVector);
   assert(!DurableVector);
   assert(!TransactionVector);
-  IndexIdVector = make_unique<TCoreVector>(strm);
-  RepoVector = make_unique<TCoreVector>(strm);
-  DurableVector = make_unique<TCoreVector>(strm);
-  TransactionVector = make_unique<TCoreVector>(strm);
+  size_t raw_size;
+  string compressed;
+  strm >> raw_size >> compressed;
+  string raw;
+  if (!snappy::Uncompress(compressed.data(), compressed.size(), &raw) || raw.size() != raw_size) {
+    throw runtime_error("Corrupted compressed replication stream");
+  }
+  Io::TBinaryInputOnlyStream raw_strm(make_shared<Io::TPlayer>(make_shared<Io::TRecorder>(raw)));
+  IndexIdVector = make_unique<TCoreVector>(raw_strm);
+  RepoVector = make_unique<TCoreVector>(raw_strm);
+  DurableVector = make_unique<TCoreVector>(raw_strm);
+  TransactionVector = make_unique<TCoreVector>(raw_strm);
+}
+
+size_t TReplicationStreamer::GetApproxSize() const {
+  assert(this);
+  size_t size = 0UL;
+  for (const TCoreVectorBuilder *builder : {&IndexIdBuilder, &RepoBuilder, &DurableBuilder, &TransactionBuilder}) {
+    size += builder->GetNumArenaBytes() + builder->GetCores().size() * sizeof(TCore);
+  }
+  return size;
 }
 
 void TReplicationStreamer::PushIndexId(const TIndexIdReplication &index_id) {
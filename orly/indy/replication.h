@@ -418,6 +418,8 @@ namespace Orly {
 
     };  // TTransactionReplication
 
+    /* One batch of the steady-state replication stream.  On the wire, the four core vectors go out as a single snappy-compressed
+       blob preceded by its uncompressed size. */
     class TReplicationStreamer {
       public:
 
@@ -433,6 +435,9 @@ namespace Orly {
       /* TODO */
       void Read(Io::TBinaryInputStream &stream);
 
+      /* Roughly how many bytes we'd write before compression.  Used to bound the size of a batch. */
+      size_t GetApproxSize() const;
+
       /* TODO */
       void PushIndexId(const TIndexIdReplication &index_replica);
 
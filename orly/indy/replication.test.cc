@@ -0,0 +1,89 @@
+/* <orly/indy/replication.test.cc>
+
+   Unit test for <orly/indy/replication.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/replication.h>
+
+#include <memory>
+#include <string>
+
+#include <io/binary_input_only_stream.h>
+#include <io/binary_output_only_stream.h>
+#include <io/recorder_and_player.h>
+#include <orly/sabot/to_native.h>
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Io;
+using namespace Orly;
+using namespace Orly::Indy;
+
+Orly::Indy::Util::TPool L1::TTransaction::TMutation::Pool(max(max(sizeof(L1::TTransaction::TPusher), sizeof(L1::TTransaction::TPopper)), sizeof(L1::TTransaction::TStatusChanger)), "Transaction::TMutation", 100UL);
+Orly::Indy::Util::TPool L1::TTransaction::Pool(sizeof(L1::TTransaction), "Transaction", 100UL);
+
+FIXTURE(CompressedRoundTrip) {
+  static const size_t NumDurables = 1000UL;
+  const string serialized_obj(200UL, 'x');
+  TReplicationStreamer out;
+  for (size_t i = 0; i < NumDurables; ++i) {
+    TDurableReplication durable(TUuid(TUuid::Best), TTtl(i), serialized_obj);
+    out.PushDurable(durable);
+  }
+  EXPECT_FALSE(out.IsEmpty());
+  auto recorder = make_shared<TRecorder>();
+  /* stream it out */ {
+    TBinaryOutputOnlyStream strm(recorder);
+    strm << out;
+  }
+  string wire;
+  recorder->CopyOut(wire);
+  /* the repeated objects squeeze down to well under what we started with */
+  EXPECT_LT(wire.size(), out.GetApproxSize() / 2);
+  TReplicationStreamer in;
+  TBinaryInputOnlyStream strm(make_shared<TPlayer>(recorder));
+  strm >> in;
+  EXPECT_TRUE(in.GetIndexIdVec().GetCores().empty());
+  EXPECT_TRUE(in.GetRepoVec().GetCores().empty());
+  EXPECT_TRUE(in.GetTransactionVec().GetCores().empty());
+  const auto &durable_vec = in.GetDurableVec();
+  if (EXPECT_EQ(durable_vec.GetCores().size(), NumDurables * 3)) {
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    string obj;
+    Sabot::ToNative(*Sabot::State::TAny::TWrapper(durable_vec.GetCores()[NumDurables * 3 - 1].NewState(durable_vec.GetArena(), state_alloc)), obj);
+    EXPECT_EQ(obj, serialized_obj);
+  }
+}
+
+FIXTURE(CorruptStream) {
+  TReplicationStreamer out;
+  TDurableReplication durable(TUuid(TUuid::Best), TTtl(1), "hello");
+  out.PushDurable(durable);
+  auto recorder = make_shared<TRecorder>();
+  /* stream it out */ {
+    TBinaryOutputOnlyStream strm(recorder);
+    strm << out;
+  }
+  string wire;
+  recorder->CopyOut(wire);
+  /* claim a different uncompressed size */
+  ++wire[0];
+  TReplicationStreamer in;
+  TBinaryInputOnlyStream strm(make_shared<TPlayer>(make_shared<TRecorder>(wire)));
+  auto read = [&in, &strm]() { strm >> in; };
+  EXPECT_THROW_FUNC(runtime_error, read);
+}
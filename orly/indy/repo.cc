@@ -76,7 +76,7 @@ void TRepo::AddImportLayer(TMemoryLayer *mem_layer, Base::TEventSemaphore &sem,
   } else {
     new_layer = mem_layer;
   }
-  size_t total_layers = 0UL;
+  bool has_merge_disk_work = false;
   sem.Pop();
   /* acquire Mapping lock */ {
     std::lock_guard<std::mutex> lock(MappingLock);
@@ -86,11 +86,10 @@ void TRepo::AddImportLayer(TMemoryLayer *mem_layer, Base::TEventSemaphore &sem,
       TMapping *new_mapping = new TMapping(this);
       assert(cur_mapping);
       for (TMapping::TEntryCollection::TCursor cur_csr(cur_mapping->GetEntryCollection()); cur_csr; ++cur_csr) {
-        ++total_layers;
         new TMapping::TEntry(new_mapping, cur_csr->GetLayer());
       }
       new TMapping::TEntry(new_mapping, new_layer);
-      ++total_layers;
+      has_merge_disk_work = HasMergeDiskWork(new_mapping);
       cur_mapping->Decr();
     } catch (...) {
       cur_mapping->Decr();
@@ -101,7 +100,7 @@ void TRepo::AddImportLayer(TMemoryLayer *mem_layer, Base::TEventSemaphore &sem,
     Manager->GetTetrisManager()->Join((*ParentRepo)->GetId(), GetId());
     InTetris = true;
   }
-  if (total_layers >= 3) {
+  if (has_merge_disk_work) {
     EnqueueMergeDisk();
   }
 }
@@ -113,7 +112,7 @@ void TRepo::AddFileToRepo(size_t gen_id, TSequenceNumber saved_low_seq, TSequenc
     std::lock_guard<std::mutex> lock(DataLock);
     new_disk = new TDiskLayer(Manager, this, gen_id, num_keys, saved_low_seq, saved_high_seq);
   }  // release DataLayer lock
-  size_t total_layers = 0UL;
+  bool has_merge_disk_work = false;
   /* acquire Mapping lock */ {
     std::lock_guard<std::mutex> lock(MappingLock);
     TMapping *cur_mapping = MappingCollection.TryGetLastMember();
@@ -122,18 +121,17 @@ void TRepo::AddFileToRepo(size_t gen_id, TSequenceNumber saved_low_seq, TSequenc
       TMapping *new_mapping = new TMapping(this);
       assert(cur_mapping);
       for (TMapping::TEntryCollection::TCursor cur_csr(cur_mapping->GetEntryCollection()); cur_csr; ++cur_csr) {
-        ++total_layers;
         new TMapping::TEntry(new_mapping, cur_csr->GetLayer());
       }
       new TMapping::TEntry(new_mapping, new_disk);
-      ++total_layers;
+      has_merge_disk_work = HasMergeDiskWork(new_mapping);
       cur_mapping->Decr();
     } catch (...) {
       cur_mapping->Decr();
       throw;
     }
   }
-  if (total_layers >= 3) {
+  if (has_merge_disk_work) {
     EnqueueMergeDisk();
   }
 }
@@ -596,7 +594,7 @@ void TRepo::StepMergeMem() {
             std::lock_guard<std::mutex> lock(MappingLock);
             TMapping *cur_mapping = MappingCollection.TryGetLastMember();
             cur_mapping->Incr();
-            size_t total_disk_layers = 0U;
+            bool has_merge_disk_work = false;
             try {
               TMapping *new_mapping = new TMapping(this);
               assert(cur_mapping);
@@ -613,9 +611,6 @@ void TRepo::StepMergeMem() {
                 }
                 if (!found) {
                   new TMapping::TEntry(new_mapping, cur_csr->GetLayer());
-                  if (cur_csr->GetLayer()->GetKind() == TDataLayer::Disk && !cur_csr->GetLayer()->GetMarkedTaken()) {
-                    ++total_disk_layers;
-                  }
                 }
               }
               if (new_mem) {
@@ -635,14 +630,13 @@ void TRepo::StepMergeMem() {
                 DEBUG_LOG("We cleaned away everything, not adding anything to the mapping");
                 /* we've cleaned away everything */
               }
-              total_disk_layers += new_disk ? 1UL : 0UL;
+              has_merge_disk_work = new_disk && HasMergeDiskWork(new_mapping);
               cur_mapping->Decr();
             } catch (...) {
               cur_mapping->Decr();
               throw;
             }
-            /* TODO: only enqueue if we are likely to be able to merge files of the same generation. */
-            if (total_disk_layers >= 3) {
+            if (has_merge_disk_work) {
               EnqueueMergeDisk();
             }
           }
@@ -1059,7 +1053,7 @@ void TSafeRepo::StepTail(size_t block_slots_available) {
             assert(new_merge_disk);
             /* acquire Mapping lock */ {
               std::lock_guard<std::mutex> lock(MappingLock);
-              size_t total_disk_layers = 0U;
+              bool has_merge_disk_work = false;
               TMapping *cur_mapping = MappingCollection.TryGetLastMember();
               cur_mapping->Incr();
               try {
@@ -1074,13 +1068,10 @@ void TSafeRepo::StepTail(size_t block_slots_available) {
                   }
                   if (!found) {
                     new TMapping::TEntry(new_mapping, cur_csr->GetLayer());
-                    if (cur_csr->GetLayer()->GetKind() == TDataLayer::Disk) {
-                      ++total_disk_layers;
-                    }
                   }
                 }
                 new TMapping::TEntry(new_mapping, new_merge_disk);
-                ++total_disk_layers;
+                has_merge_disk_work = HasMergeDiskWork(new_mapping);
                 cur_mapping->Decr();
               } catch (const std::exception &ex) {
                 syslog(LOG_EMERG, "StepTail [1161] caught error [%s]", ex.what());
@@ -1091,8 +1082,7 @@ void TSafeRepo::StepTail(size_t block_slots_available) {
                 cur_mapping->Decr();
                 throw;
               }
-              /* TODO: only enqueue if we are likely to be able to merge files of the same generation. */
-              if (total_disk_layers >= 3) {
+              if (has_merge_disk_work) {
                 EnqueueMergeDisk();
               }
             }
@@ -1128,35 +1118,26 @@ void TSafeRepo::StepMergeDisk(size_t block_slots_available) {
         size_t num_keys = 0U;
         TSequenceNumber lowest_seq = numeric_limits<uint64_t>::max(), highest_seq = 0UL;
         try {
-          //std::map<size_t, std::vector<TDiskLayer *>> gen_to_gen_id_map;
           /* acquire Merge lock */ {
             std::lock_guard<std::mutex> lock(MergeLock);
-            for (TMapping::TEntryCollection::TCursor csr(mapping->GetEntryCollection()); csr; ++csr) {
-              TDataLayer *lhs_layer = csr->GetLayer();
-              TDataLayer *rhs_layer = csr->TryGetNextMember() ? csr->TryGetNextMember()->GetLayer() : nullptr;
-              /* if i'm a disk layer, so is my neighbor on the right, neither of us are marked as taken, and i'm in the same or lower gen set than my neigbor */
-              if ((lhs_layer && rhs_layer)  // i have a neighbor
-                  && (lhs_layer->GetKind() == TDataLayer::TKind::Disk)  // I'm a disk layer
-                  && (rhs_layer->GetKind() == TDataLayer::TKind::Disk)  // my neighbor is a disk layer
-                  && (!lhs_layer->GetMarkedTaken())  // I'm not marked taken
-                  && (!rhs_layer->GetMarkedTaken())  // my neighbor is not marked taken
-                  && (Disk::Util::SuggestGeneration(lhs_layer->GetSize()) <= Disk::Util::SuggestGeneration(rhs_layer->GetSize()))  // in in the same or lower gen set than my neighbor
-                  ) {
-                lowest_seq = std::min(lowest_seq, lhs_layer->GetLowestSeq());
-                highest_seq = std::max(highest_seq, lhs_layer->GetHighestSeq());
-                num_keys += lhs_layer->GetSize();
-                gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(lhs_layer));
-                gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(lhs_layer)->GetGenId());
-                lhs_layer->MarkTaken();
-                lowest_seq = std::min(lowest_seq, rhs_layer->GetLowestSeq());
-                highest_seq = std::max(highest_seq, rhs_layer->GetHighestSeq());
-                num_keys += rhs_layer->GetSize();
-                gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(rhs_layer));
-                gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(rhs_layer)->GetGenId());
-                rhs_layer->MarkTaken();
-                EnqueueMergeDisk();
-                break;
+            auto plan = Manager->GetCompactionPlanner().Plan(GetCompactionLayers(mapping));
+            if (plan) {
+              size_t pos = 0UL;
+              for (TMapping::TEntryCollection::TCursor csr(mapping->GetEntryCollection()); csr && pos < plan->End; ++csr, ++pos) {
+                if (pos >= plan->Begin) {
+                  TDataLayer *layer = csr->GetLayer();
+                  assert(layer->GetKind() == TDataLayer::TKind::Disk);
+                  assert(!layer->GetMarkedTaken());
+                  lowest_seq = std::min(lowest_seq, layer->GetLowestSeq());
+                  highest_seq = std::max(highest_seq, layer->GetHighestSeq());
+                  num_keys += layer->GetSize();
+                  gen_layer_vec.push_back(reinterpret_cast<TDiskLayer *>(layer));
+                  gen_id_vec.push_back(reinterpret_cast<TDiskLayer *>(layer)->GetGenId());
+                  layer->MarkTaken();
+                }
               }
+              /* another merger may find a merge among what we've left */
+              EnqueueMergeDisk();
             }
           }  // release Merge lock
           if (gen_id_vec.size() > 0) {
@@ -1182,7 +1163,7 @@ void TSafeRepo::StepMergeDisk(size_t block_slots_available) {
             assert(gen_layer_vec.size() == gen_id_vec.size());
             /* acquire Mapping lock */ {
               std::lock_guard<std::mutex> lock(MappingLock);
-              size_t total_disk_layers = 0U;
+              bool has_merge_disk_work = false;
               TMapping *cur_mapping = MappingCollection.TryGetLastMember();
               cur_mapping->Incr();
               try {
@@ -1200,13 +1181,10 @@ void TSafeRepo::StepMergeDisk(size_t block_slots_available) {
                   }
                   if (!found) {
                     new TMapping::TEntry(new_mapping, cur_csr->GetLayer());
-                    if (cur_csr->GetLayer()->GetKind() == TDataLayer::Disk) {
-                      ++total_disk_layers;
-                    }
                   }
                 }
                 new TMapping::TEntry(new_mapping, new_merge_disk);
-                ++total_disk_layers;
+                has_merge_disk_work = HasMergeDiskWork(new_mapping);
                 cur_mapping->Decr();
               } catch (const std::exception &ex) {
                 syslog(LOG_EMERG, "StepMergeDisk [1161] caught error [%s]", ex.what());
@@ -1217,8 +1195,7 @@ void TSafeRepo::StepMergeDisk(size_t block_slots_available) {
                 cur_mapping->Decr();
                 throw;
               }
-              /* TODO: only enqueue if we are likely to be able to merge files of the same generation. */
-              if (total_disk_layers >= 3) {
+              if (has_merge_disk_work) {
                 EnqueueMergeDisk();
               }
             }
@@ -1256,6 +1233,7 @@ size_t TSafeRepo::AddSyncedFileToRepo(size_t starting_block_id,
     Manager->GetEngine()->InsertFile(GetId(), TFileObj::TKind::DataFile, gen_id, starting_block_id, starting_block_offset, file_length, num_keys, low_saved, high_saved, trigger);
     trigger.Wait();
   }
+  AddBytesWritten(file_length, true);
   AddFileToRepo(gen_id, low_saved, high_saved, num_keys);
   return gen_id;
 }
@@ -1328,7 +1306,8 @@ size_t TSafeRepo::MergeFiles(const std::vector<size_t> &gen_id_vec,
   size_t gen_id = GetNextGenId();
   bool my_can_tail = can_tail && !static_cast<bool>(GetParentRepo()) && IsTailingAllowed();
   bool my_can_tail_tombstone = my_can_tail && can_tail_tombstone && (gen_id_vec.size() == 1);
-  TMergeDataFile merge_data_file(Manager->GetEngine(), storage_speed, GetId(), gen_id_vec, GetId(), gen_id, release_up_to, Low, max_block_cache_read_slots_allowed, temp_file_consol_thresh, my_can_tail, my_can_tail_tombstone);
+  TMergeDataFile merge_data_file(Manager->GetEngine(), storage_speed, GetId(), gen_id_vec, GetId(), gen_id, release_up_to, Low, max_block_cache_read_slots_allowed, temp_file_consol_thresh, my_can_tail, my_can_tail_tombstone, Manager->GetMergeDiskRunners(), Manager->GetArenaCodec());
+  AddBytesWritten(merge_data_file.GetFileLength(), false);
   out_num_keys = merge_data_file.GetNumKeys();
   out_saved_low_seq = merge_data_file.GetLowestSequence();
   out_saved_high_seq = merge_data_file.GetHighestSequence();
@@ -1374,9 +1353,9 @@ void TSafeRepo::RemoveFile(size_t gen_id) {
         Disk::Util::LogicalBlockSize,
         Disk::Util::PhysicalBlockSize,
         Disk::Util::CheckedPage>::Cache->Get(Manager->GetEngine(), repo_id, gen_id);
-      for (const auto &index_pair : my_read_file->GetIndexByIdMap()) {
-        Disk::TLocalWalkerCache::Cache->Clear(repo_id, gen_id, index_pair.first);
-      }
+      my_read_file->ForEachIndex([&repo_id, gen_id](const Base::TUuid &index_id, size_t) {
+        Disk::TLocalWalkerCache::Cache->Clear(repo_id, gen_id, index_id);
+      });
       Disk::TLocalReadFileCache<Disk::Util::LogicalPageSize,
         Disk::Util::LogicalBlockSize,
         Disk::Util::PhysicalBlockSize,
@@ -1407,7 +1386,8 @@ size_t TSafeRepo::WriteFile(TMemoryLayer *memory_layer,
                             size_t &out_num_keys,
                             TSequenceNumber release_up_to) {
   size_t gen_id = GetNextGenId();
-  TDataFile data_file(Manager->GetEngine(), storage_speed, memory_layer, GetId(), gen_id, Manager->GetTempFileConsolThresh(), release_up_to, Medium/*, !static_cast<bool>(GetParentRepo())*/);
+  TDataFile data_file(Manager->GetEngine(), storage_speed, memory_layer, GetId(), gen_id, Manager->GetTempFileConsolThresh(), release_up_to, Medium, Manager->GetArenaCodec()/*, !static_cast<bool>(GetParentRepo())*/);
+  AddBytesWritten(data_file.GetFileLength(), true);
   out_num_keys = data_file.GetNumKeys();
   out_saved_low_seq = data_file.GetLowestSequence();
   out_saved_high_seq = data_file.GetHighestSequence();
@@ -0,0 +1,66 @@
+/* <orly/indy/resync_plan.cc>
+
+   Implements <orly/indy/resync_plan.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/resync_plan.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy;
+
+vector<TResyncStep> Orly::Indy::PlanResync(const vector<tuple<TSequenceNumber, TSequenceNumber, size_t, size_t>> &master_files,
+                                           TSequenceNumber lowest,
+                                           TSequenceNumber highest,
+                                           const TOpt<TSequenceNumber> &held_up_to,
+                                           bool allow_file_sync) {
+  assert(&master_files);
+  assert(&held_up_to);
+  vector<TResyncStep> steps;
+  /* the first sequence number the slave is missing */
+  TSequenceNumber next = held_up_to ? max(lowest, *held_up_to + 1UL) : lowest;
+  if (allow_file_sync) {
+    for (const auto &file : master_files) {
+      const TSequenceNumber file_low = get<0>(file), file_high = get<1>(file);
+      assert(file_low <= file_high);
+      if (file_high > highest) {
+        break;
+      }
+      if (file_high < next) {
+        /* the slave has all of it already */
+        continue;
+      }
+      if (file_low < next) {
+        /* the slave has the front of it; pull the rest */
+        steps.push_back(TResyncStep{TResyncStep::PullUpdates, next, file_high, 0UL, 0UL});
+      } else {
+        if (file_low > next) {
+          steps.push_back(TResyncStep{TResyncStep::PullUpdates, next, file_low - 1UL, 0UL, 0UL});
+        }
+        steps.push_back(TResyncStep{TResyncStep::CopyFile, file_low, file_high, get<2>(file), get<3>(file)});
+      }
+      next = file_high + 1UL;
+    }
+  }
+  /* the tail, which lives in the master's memory layers or in files we couldn't copy */
+  if (next <= highest) {
+    steps.push_back(TResyncStep{TResyncStep::PullUpdates, next, highest, 0UL, 0UL});
+  }
+  return steps;
+}
@@ -0,0 +1,69 @@
+/* <orly/indy/resync_plan.h>
+
+   Works out what a slave has to fetch to catch up with its master.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+#include <base/opt.h>
+#include <orly/indy/sequence_number.h>
+
+namespace Orly {
+
+  namespace Indy {
+
+    /* One thing a resyncing slave does, in sequence number order. */
+    struct TResyncStep {
+
+      /* Copy a whole generation file from the master, or pull a range of updates by walking the master's view. */
+      enum TKind {
+        CopyFile,
+        PullUpdates
+      };
+
+      /* See TKind. */
+      TKind Kind;
+
+      /* The inclusive range of sequence numbers this step fills in. */
+      TSequenceNumber Low;
+      TSequenceNumber High;
+
+      /* The master's file to copy, and its number of keys.  Only meaningful for CopyFile. */
+      size_t GenId;
+      size_t NumKeys;
+
+    };  // TResyncStep
+
+    /* The steps which take a slave repo from holding every update up to held_up_to (or nothing at all, if it's unknown) to holding
+       the master's [lowest, highest].  The master's disk files are (low seq, high seq, gen id, num keys), sorted by low seq, as in
+       TMasterContext::TViewDef.
+
+       Whatever the slave already holds is skipped, whether it's in the slave's own files or not.  Master files which lie wholly in
+       the gap are copied, when allowed; anything else, including the part of a file the slave partly holds and the master's memory
+       layers beyond its last file, is pulled as updates. */
+    std::vector<TResyncStep> PlanResync(const std::vector<std::tuple<TSequenceNumber, TSequenceNumber, size_t, size_t>> &master_files,
+                                        TSequenceNumber lowest,
+                                        TSequenceNumber highest,
+                                        const Base::TOpt<TSequenceNumber> &held_up_to,
+                                        bool allow_file_sync);
+
+  }  // Indy
+
+}  // Orly
@@ -0,0 +1,90 @@
+/* <orly/indy/resync_plan.test.cc>
+
+   Unit test for <orly/indy/resync_plan.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/indy/resync_plan.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly::Indy;
+
+/* low, high, gen id, num keys */
+static const vector<tuple<TSequenceNumber, TSequenceNumber, size_t, size_t>> Files{
+  make_tuple(1UL, 100UL, 7UL, 1000UL),
+  make_tuple(101UL, 200UL, 8UL, 1000UL),
+  make_tuple(201UL, 300UL, 9UL, 1000UL)
+};
+
+static bool IsCopy(const TResyncStep &step, size_t gen_id) {
+  return step.Kind == TResyncStep::CopyFile && step.GenId == gen_id;
+}
+
+static bool IsPull(const TResyncStep &step, TSequenceNumber low, TSequenceNumber high) {
+  return step.Kind == TResyncStep::PullUpdates && step.Low == low && step.High == high;
+}
+
+FIXTURE(FromScratch) {
+  auto steps = PlanResync(Files, 1UL, 350UL, TOpt<TSequenceNumber>(), true);
+  if (EXPECT_EQ(steps.size(), 4UL)) {
+    EXPECT_TRUE(IsCopy(steps[0], 7UL));
+    EXPECT_TRUE(IsCopy(steps[1], 8UL));
+    EXPECT_TRUE(IsCopy(steps[2], 9UL));
+    EXPECT_TRUE(IsPull(steps[3], 301UL, 350UL));
+  }
+}
+
+FIXTURE(SkipsWhatTheSlaveHolds) {
+  /* held up to the end of a file */
+  auto steps = PlanResync(Files, 1UL, 350UL, 200UL, true);
+  if (EXPECT_EQ(steps.size(), 2UL)) {
+    EXPECT_TRUE(IsCopy(steps[0], 9UL));
+    EXPECT_TRUE(IsPull(steps[1], 301UL, 350UL));
+  }
+  /* held part way into a file */
+  steps = PlanResync(Files, 1UL, 350UL, 150UL, true);
+  if (EXPECT_EQ(steps.size(), 3UL)) {
+    EXPECT_TRUE(IsPull(steps[0], 151UL, 200UL));
+    EXPECT_TRUE(IsCopy(steps[1], 9UL));
+    EXPECT_TRUE(IsPull(steps[2], 301UL, 350UL));
+  }
+  /* held everything */
+  EXPECT_TRUE(PlanResync(Files, 1UL, 350UL, 350UL, true).empty());
+}
+
+FIXTURE(Gaps) {
+  /* the master has popped the front and its first file starts late */
+  auto steps = PlanResync({make_tuple(151UL, 300UL, 9UL, 10UL)}, 120UL, 300UL, 50UL, true);
+  if (EXPECT_EQ(steps.size(), 2UL)) {
+    EXPECT_TRUE(IsPull(steps[0], 120UL, 150UL));
+    EXPECT_TRUE(IsCopy(steps[1], 9UL));
+  }
+  /* a file past what we're syncing */
+  steps = PlanResync(Files, 1UL, 250UL, 100UL, true);
+  if (EXPECT_EQ(steps.size(), 2UL)) {
+    EXPECT_TRUE(IsCopy(steps[0], 8UL));
+    EXPECT_TRUE(IsPull(steps[1], 201UL, 250UL));
+  }
+}
+
+FIXTURE(NoFileSync) {
+  auto steps = PlanResync(Files, 1UL, 350UL, 150UL, false);
+  if (EXPECT_EQ(steps.size(), 1UL)) {
+    EXPECT_TRUE(IsPull(steps[0], 151UL, 350UL));
+  }
+}
@@ -20,6 +20,7 @@
 
 #include <base/class_traits.h>
 #include <inv_con/ordered_list.h>
+#include <inv_con/skip_list.h>
 #include <orly/atom/kit2.h>
 #include <orly/atom/suprena.h>
 #include <orly/indy/key.h>
@@ -162,7 +163,7 @@ namespace Orly {
 
         /* TODO */
         typedef InvCon::OrderedList::TMembership<TEntry, TUpdate, TKey> TUpdateMembership;
-        typedef InvCon::OrderedList::TMembership<TEntry, TMemoryLayer, TEntryKey> TMemoryLayerMembership;
+        typedef InvCon::SkipList::TMembership<TEntry, TMemoryLayer, TEntryKey> TMemoryLayerMembership;
 
         /* TODO */
         TEntry(TUpdate *update, const TIndexKey &key, const TKey &op, void *state_alloc);
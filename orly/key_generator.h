@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
 
 #include <base/likely.h>
@@ -105,14 +106,14 @@ namespace Orly {
 
       /* TODO */
       TCursor(TKeyGenerator::TPtr &ptr)
-          : Cached(false), Valid(false), Item(0),
+          : Cached(false), Valid(false), Item(0), Remaining(ptr->Limit),
             /*Iter(&ptr->GetContext(), ptr->GetStart()),*/
             Iter(ptr->PackageContext->NewKeyCursor(&ptr->GetContext(), ptr->GetStart())),
             Ptr(ptr) {}
 
       /* TODO */
       TCursor(const TKeyGenerator::TPtr &ptr)
-          : Cached(false), Valid(false), Item(0),
+          : Cached(false), Valid(false), Item(0), Remaining(ptr->Limit),
             /* Iter(&ptr->GetContext(), ptr->GetStart()), */
             Iter(ptr->PackageContext->NewKeyCursor(&ptr->GetContext(), ptr->GetStart())),
             Ptr(ptr) {}
@@ -125,6 +126,7 @@ namespace Orly {
           : Cached(that.Cached),
             Valid(that.Valid),
             Item(std::move(that.Item)),
+            Remaining(that.Remaining),
             Iter(std::move(that.Iter)),
             Ptr(std::move(that.Ptr)) {
         that.Item = 0;
@@ -155,8 +157,15 @@ namespace Orly {
       /* TODO */
       Base::TIter<TVal> &operator++() {
         assert(this);
-        ++(*Iter);
-        Cached = false;
+        assert(Remaining);
+        /* Once we've handed out as many keys as we're allowed, don't step the walkers below us again. */
+        if (--Remaining) {
+          ++(*Iter);
+          Cached = false;
+        } else {
+          Cached = true;
+          Valid = false;
+        }
         return *this;
       }
 
@@ -167,7 +176,7 @@ namespace Orly {
         assert(this);
         if (!Cached) {
           Cached = true;
-          if (static_cast<bool>(*Iter)) {
+          if (Remaining && static_cast<bool>(*Iter)) {
             void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
             if (Item) {
               *Item = Sabot::AsNative<TRet>(*Sabot::State::TAny::TWrapper((*Iter)->GetState(state_alloc)));
@@ -190,6 +199,9 @@ namespace Orly {
       /* TODO */
       mutable TRet *Item;
 
+      /* The number of keys we may still hand out, counting the current one. */
+      size_t Remaining;
+
       /* TODO */
       mutable std::unique_ptr<Orly::TKeyCursor> Iter;
 
@@ -225,11 +237,16 @@ namespace Orly {
       return MakeHolder(new TCursor(this->shared_from_this()));
     }
 
-    /* TODO */
-    TKeyGenerator(L0::TPackageContext *package_context, TContextBase &ctx,  const Sabot::State::TAny *start, const Base::TUuid &index_id)
+    /* The limit we use when there isn't one. */
+    static constexpr size_t NoLimit = std::numeric_limits<size_t>::max();
+
+    /* A cursor yields at most limit keys, and stops walking the index once it has, so a 'take' over a big prefix only reads as
+       many keys as it takes. */
+    TKeyGenerator(L0::TPackageContext *package_context, TContextBase &ctx,  const Sabot::State::TAny *start, const Base::TUuid &index_id, size_t limit = NoLimit)
         : PackageContext(package_context),
           Ctx(ctx),
-          Start(index_id, Indy::TKey(Ctx.GetArena(), start)) {}
+          Start(index_id, Indy::TKey(Ctx.GetArena(), start)),
+          Limit(limit) {}
 
     private:
 
@@ -242,6 +259,9 @@ namespace Orly {
     /* TODO */
     const Indy::TIndexKey Start;
 
+    /* See constructor. */
+    const size_t Limit;
+
   };  // TKeyGenerator
 
   namespace Var {
@@ -22,6 +22,7 @@
 
 #include <orly/mynde/binary_protocol.h>
 #include <orly/mynde/protocol.h>
+#include <orly/mynde/response_batch.h>
 
 #include <base/not_implemented.h>
 #include <io/endian.h>
@@ -81,11 +82,22 @@ TOut &Orly::Mynde::operator<<(TOut &out, const TResponseHeader &that) {
   tmp.Cas = SwapEnds(tmp.Cas);
 
   out.WriteShallow(tmp);
-  out.Flush();
 
   return out;
 }
 
+TResponseBatch &Orly::Mynde::operator<<(TResponseBatch &batch, const TResponseHeader &that) {
+  TResponseHeader tmp(that);
+  tmp.KeyLength = SwapEnds(tmp.KeyLength);
+  tmp.Status = SwapEnds(tmp.Status);
+  tmp.TotalBodyLength = SwapEnds(tmp.TotalBodyLength);
+  //NOTE: Opaque is explicitly skipped
+  tmp.Cas = SwapEnds(tmp.Cas);
+  batch.WriteShallow(tmp);
+
+  return batch;
+}
+
 TRequest::TRequest(TIn &in) : Flags({false,false}), Opaque(0), Cas(0) {
   TRequestHeader header;
   in >> header;
@@ -47,6 +47,8 @@
 namespace Orly {
 namespace Mynde {
 
+class TResponseBatch;
+
 //Raw response codes
 enum TResponseStatus {
   NoError = 0x0000,
@@ -141,6 +143,7 @@ struct [[gnu::packed]] TResponseHeader {
 //NOTE: These don't do any validation
 Strm::Bin::TIn &operator>>(Strm::Bin::TIn &in, TResponseHeader &that);
 Strm::Bin::TOut &operator<<(Strm::Bin::TOut &out, const TResponseHeader &that);
+TResponseBatch &operator<<(TResponseBatch &batch, const TResponseHeader &that);
 
 static_assert(sizeof(TResponseHeader) == 24, "According to the binary protocol specification");
 
@@ -0,0 +1,111 @@
+/* <orly/mynde/response_batch.cc>
+
+   Implements <orly/mynde/response_batch.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/mynde/response_batch.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <util/error.h>
+#include <util/io.h>
+
+using namespace std;
+using namespace Orly::Mynde;
+
+/* Write as much of the given vector as the fd will take in one go, returning the number of bytes written. */
+static size_t WriteVecAtMost(int fd, struct iovec *iov, size_t count, bool &is_socket) {
+  for (;;) {
+    ssize_t ret;
+    if (is_socket) {
+      struct msghdr msg = {};
+      msg.msg_iov = iov;
+      msg.msg_iovlen = count;
+      ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+      if (ret < 0 && errno == ENOTSOCK) {
+        is_socket = false;
+        continue;
+      }
+    } else {
+      ret = writev(fd, iov, static_cast<int>(count));
+    }
+    if (ret >= 0) {
+      return ret;
+    }
+    if (errno != EINTR) {
+      Util::ThrowSystemError(errno);
+    }
+  }
+}
+
+void TResponseBatch::Write(const void *data, size_t size) {
+  assert(this);
+  assert(data || !size);
+  if (!size) {
+    return;
+  }
+  if (Pieces.empty() || Pieces.back().Value) {
+    Pieces.push_back({nullptr, Scratch.size(), 0UL});
+  }
+  Scratch.append(static_cast<const char *>(data), size);
+  Pieces.back().Size += size;
+  Size += size;
+}
+
+void TResponseBatch::Write(Native::TBlob &&value) {
+  assert(this);
+  if (value.empty()) {
+    return;
+  }
+  Values.push_back(move(value));
+  Pieces.push_back({&Values.back(), 0UL, Values.back().size()});
+  Size += Values.back().size();
+}
+
+void TResponseBatch::Flush(int fd) {
+  assert(this);
+  vector<struct iovec> iov_vec;
+  iov_vec.reserve(Pieces.size());
+  for (const auto &piece : Pieces) {
+    const void *base = piece.Value ? static_cast<const void *>(piece.Value->data()) : static_cast<const void *>(Scratch.data() + piece.Offset);
+    iov_vec.push_back({const_cast<void *>(base), piece.Size});
+  }
+  bool is_socket = true;
+  struct iovec *iov = iov_vec.data(), *end = iov + iov_vec.size();
+  while (iov < end) {
+    size_t actual_size = WriteVecAtMost(fd, iov, min<size_t>(end - iov, IOV_MAX), is_socket);
+    if (!actual_size) {
+      throw Util::TUnexpectedEnd();
+    }
+    /* skip what went out whole, then trim what went out in part */
+    for (; iov < end && actual_size >= iov->iov_len; ++iov) {
+      actual_size -= iov->iov_len;
+    }
+    if (actual_size) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + actual_size;
+      iov->iov_len -= actual_size;
+    }
+  }
+  Pieces.clear();
+  Scratch.clear();
+  Values.clear();
+  Size = 0UL;
+}
@@ -0,0 +1,104 @@
+/* <orly/mynde/response_batch.h>
+
+   A batch of memcache responses, gathered up so they can go to the client in one vectored write.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <base/class_traits.h>
+#include <orly/native/defs.h>
+
+namespace Orly {
+
+  namespace Mynde {
+
+    /* Headers and other small pieces are copied into a scratch buffer; values are moved in whole, so they are never copied.  Flush()
+       hands the lot to the kernel with writev(), so a batch of responses costs one system call rather than one (or two) apiece. */
+    class TResponseBatch {
+      NO_COPY(TResponseBatch);
+      public:
+
+      /* Empty. */
+      TResponseBatch()
+          : Size(0UL) {}
+
+      /* Copy the given bytes onto the end of the batch. */
+      void Write(const void *data, size_t size);
+
+      /* Copy the given string onto the end of the batch. */
+      void Write(const std::string &that) {
+        assert(this);
+        Write(that.data(), that.size());
+      }
+
+      /* Copy the given structure onto the end of the batch, verbatim. */
+      template <typename TThat>
+      void WriteShallow(const TThat &that) {
+        assert(this);
+        Write(&that, sizeof(that));
+      }
+
+      /* Move the given value onto the end of the batch. */
+      void Write(Native::TBlob &&value);
+
+      /* True iff. there's nothing waiting to be flushed. */
+      bool IsEmpty() const {
+        assert(this);
+        return !Size;
+      }
+
+      /* The number of bytes waiting to be flushed. */
+      size_t GetSize() const {
+        assert(this);
+        return Size;
+      }
+
+      /* Write everything in the batch to the given fd, then empty the batch.  If the fd is a socket, we won't raise SIGPIPE.  Throws
+         if the fd won't take it all. */
+      void Flush(int fd);
+
+      private:
+
+      /* A span of bytes to write.  If Value is null, the span is in Scratch, starting at Offset; otherwise, it's the whole of Value. */
+      struct TPiece {
+        const Native::TBlob *Value;
+        size_t Offset;
+        size_t Size;
+      };
+
+      /* The pieces, in the order they're to be written. */
+      std::vector<TPiece> Pieces;
+
+      /* Copies of the small pieces, back to back. */
+      std::string Scratch;
+
+      /* The values we've been given.  A deque, so they don't move as it grows. */
+      std::deque<Native::TBlob> Values;
+
+      /* See GetSize(). */
+      size_t Size;
+
+    };  // TResponseBatch
+
+  }  // Mynde
+
+}  // Orly
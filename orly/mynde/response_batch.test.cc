@@ -0,0 +1,68 @@
+/* <orly/mynde/response_batch.test.cc>
+
+   Unit test for <orly/mynde/response_batch.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/mynde/response_batch.h>
+
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+
+#include <base/fd.h>
+#include <util/io.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Mynde;
+
+FIXTURE(ManyPieces) {
+  int fds[2];
+  if (!EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0)) {
+    return;
+  }
+  TFd read_end(fds[0]), write_end(fds[1]);
+  /* more pieces than one writev() will take, and more bytes than the socket will buffer */
+  TResponseBatch batch;
+  string expected;
+  for (size_t i = 0; i < 3000; ++i) {
+    const string hdr = "hdr " + to_string(i) + ";";
+    batch.Write(hdr);
+    expected += hdr;
+    Native::TBlob value(i % 7 == 0 ? 0 : 100 + i, static_cast<uint8_t>('a' + (i % 26)));
+    expected.append(value.begin(), value.end());
+    batch.Write(move(value));
+  }
+  EXPECT_EQ(batch.GetSize(), expected.size());
+  string actual(expected.size(), '\0');
+  thread reader([&]() {
+    Util::ReadExactly(read_end, &actual[0], actual.size());
+  });
+  batch.Flush(write_end);
+  reader.join();
+  EXPECT_TRUE(batch.IsEmpty());
+  EXPECT_TRUE(actual == expected);
+  /* and it's good to go again */
+  batch.Write("again", 5);
+  batch.Flush(write_end);
+  char again[5];
+  Util::ReadExactly(read_end, again, sizeof(again));
+  EXPECT_EQ(string(again, sizeof(again)), "again");
+}
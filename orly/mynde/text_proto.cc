@@ -0,0 +1,147 @@
+/* <orly/mynde/text_proto.cc>
+
+   Implements <orly/mynde/text_proto.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/mynde/text_proto.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <orly/mynde/response_batch.h>
+#include <strm/bin/in.h>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Mynde;
+
+constexpr size_t TTextRequest::MaxLineSize;
+constexpr size_t TTextRequest::MaxKeySize;
+constexpr size_t TTextRequest::MaxValueSize;
+
+// Reads up to and including the next newline, and returns the line without it (or the \r before it).
+static string ReadLine(Strm::Bin::TIn &in) {
+  string line;
+  for (;;) {
+    const uint8_t *start, *limit;
+    in.Peek(start, limit);
+    const uint8_t *newline = find(start, limit, '\n');
+    const size_t size = (newline < limit) ? (newline - start + 1) : (limit - start);
+    if (line.size() + size > TTextRequest::MaxLineSize) {
+      throw invalid_argument("line too long");
+    }
+    const size_t old_size = line.size();
+    line.resize(old_size + size);
+    in.Read(&line[old_size], size);
+    if (newline < limit) {
+      break;
+    }
+  }
+  line.pop_back();
+  if (!line.empty() && line.back() == '\r') {
+    line.pop_back();
+  }
+  return line;
+}
+
+// Splits the line on runs of spaces.
+static vector<string> Tokenize(const string &line) {
+  vector<string> tokens;
+  for (size_t pos = 0; pos < line.size();) {
+    size_t end = line.find(' ', pos);
+    if (end == string::npos) {
+      end = line.size();
+    }
+    if (end > pos) {
+      tokens.emplace_back(line, pos, end - pos);
+    }
+    pos = end + 1;
+  }
+  return tokens;
+}
+
+// Parses a decimal integer which must lie in [min, max].
+static int64_t ParseInt(const string &token, int64_t min, int64_t max, const char *what) {
+  size_t used = 0;
+  int64_t val;
+  try {
+    val = stoll(token, &used);
+  } catch (const exception &) {
+    used = 0;
+  }
+  if (!used || used != token.size() || val < min || val > max) {
+    throw invalid_argument(string("bad ") + what);
+  }
+  return val;
+}
+
+static Native::TBlob ParseKey(const string &token) {
+  if (token.size() > TTextRequest::MaxKeySize) {
+    throw invalid_argument("key too long");
+  }
+  return Native::TBlob(reinterpret_cast<const uint8_t *>(token.data()), token.size());
+}
+
+TTextRequest::TTextRequest(Strm::Bin::TIn &in)
+    : Command(TCommand::Unknown), Flags(0), Expiration(0), NoReply(false) {
+  auto tokens = Tokenize(ReadLine(in));
+  if (tokens.empty()) {
+    return;
+  }
+  const string &name = tokens[0];
+  if (name == "get" || name == "gets") {
+    if (tokens.size() < 2) {
+      throw invalid_argument("get needs a key");
+    }
+    Command = (name == "get") ? TCommand::Get : TCommand::Gets;
+    Keys.reserve(tokens.size() - 1);
+    for (size_t i = 1; i < tokens.size(); ++i) {
+      Keys.push_back(ParseKey(tokens[i]));
+    }
+  } else if (name == "set") {
+    // set <key> <flags> <exptime> <bytes> [noreply]
+    if (tokens.size() < 5 || tokens.size() > 6 || (tokens.size() == 6 && tokens[5] != "noreply")) {
+      throw invalid_argument("bad command line format");
+    }
+    Command = TCommand::Set;
+    Keys.push_back(ParseKey(tokens[1]));
+    Flags = ParseInt(tokens[2], 0, numeric_limits<uint32_t>::max(), "flags");
+    Expiration = ParseInt(tokens[3], numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), "exptime");
+    const size_t size = ParseInt(tokens[4], 0, MaxValueSize, "data length");
+    NoReply = tokens.size() == 6;
+    Value.resize(size);
+    in.Read(&Value[0], size);
+    char end[2];
+    in.Read(end, sizeof(end));
+    if (end[0] != '\r' || end[1] != '\n') {
+      throw invalid_argument("bad data chunk");
+    }
+  } else if (name == "version" && tokens.size() == 1) {
+    Command = TCommand::Version;
+  } else if (name == "quit" && tokens.size() == 1) {
+    Command = TCommand::Quit;
+  }
+}
+
+void Orly::Mynde::WriteTextValue(TResponseBatch &batch, const Native::TBlob &key, uint32_t flags, Native::TBlob &&value, bool with_cas) {
+  batch.Write("VALUE ", 6);
+  batch.Write(key.data(), key.size());
+  // NOTE: We don't support cas, but say 1 to match what a binary set hands back.
+  batch.Write(" " + to_string(flags) + " " + to_string(value.size()) + (with_cas ? " 1\r\n" : "\r\n"));
+  batch.Write(move(value));
+  batch.Write("\r\n", 2);
+}
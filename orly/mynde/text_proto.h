@@ -16,31 +16,100 @@
    See the License for the specific language governing permissions and
    limitations under the License. */
 
-#include <orly/mynde/proto.h>
+#pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include <base/class_traits.h>
+#include <orly/native/defs.h>
+
+namespace Strm {
+  namespace Bin {
+    class TIn;
+  }
+}
 
 namespace Orly {
   namespace Mynde {
 
-    class TIn;
+    class TResponseBatch;
 
-    class TToken {
+    /* A request in the text protocol: a command line, followed by a data block if the command stores something.  We understand
+       get, gets, set, version and quit. */
+    class TTextRequest {
+      NO_COPY(TTextRequest);
       public:
-      enum class TKind {
-        Word,
-        EndLine,
-        Integer,
-        Error  // Something illegal
+
+      enum class TCommand {
+        Get,
+        Gets,
+        Set,
+        Version,
+        Quit,
+        Unknown  // The client should be told ERROR
       };
 
-      // Reads in a token
-      TToken(TIn &in);
+      // Longest command line we'll take.  Room for a get of a couple of hundred maximal keys.
+      static constexpr size_t MaxLineSize = 65536;
+
+      // Longest key the protocol allows.
+      static constexpr size_t MaxKeySize = 250;
+
+      // Largest data block we'll take.
+      static constexpr size_t MaxValueSize = 1024 * 1024;
+
+      // Reads the next request. Throws std::invalid_argument if the request is malformed, after which the state of the stream is
+      // unknown.
+      TTextRequest(Strm::Bin::TIn &in);
+
+      TCommand GetCommand() const {
+        assert(this);
+        return Command;
+      }
+
+      // The keys to get, or the one key to set.
+      const std::vector<Native::TBlob> &GetKeys() const {
+        assert(this);
+        return Keys;
+      }
+
+      uint32_t GetFlags() const {
+        assert(this);
+        return Flags;
+      }
+
+      int32_t GetExpiration() const {
+        assert(this);
+        return Expiration;
+      }
+
+      // The data block of a set. Non-const so it can be moved from.
+      Native::TBlob &GetValue() {
+        assert(this);
+        return Value;
+      }
+
+      // True iff. the client asked us not to reply to a set.
+      bool IsNoReply() const {
+        assert(this);
+        return NoReply;
+      }
 
       private:
-      TKind Kind;
-      std::string Value;
+
+      TCommand Command;
+      std::vector<Native::TBlob> Keys;
+      uint32_t Flags;
+      int32_t Expiration;
+      Native::TBlob Value;
+      bool NoReply;
     };
 
+    // Writes the response line and data block for one hit of a get (or gets, if 'with_cas'). The caller ends the lot with END.
+    void WriteTextValue(TResponseBatch &batch, const Native::TBlob &key, uint32_t flags, Native::TBlob &&value, bool with_cas);
+
   }  // Mynde
-}  // Orly
\ No newline at end of file
+}  // Orly
@@ -0,0 +1,113 @@
+/* <orly/mynde/text_proto.test.cc>
+
+   Unit test for <orly/mynde/text_proto.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/mynde/text_proto.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include <base/fd.h>
+#include <orly/mynde/response_batch.h>
+#include <strm/bin/in.h>
+#include <strm/mem/static_in.h>
+#include <util/io.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Base;
+using namespace Orly;
+using namespace Orly::Mynde;
+
+static Native::TBlob Blob(const char *that) {
+  return Native::TBlob(reinterpret_cast<const uint8_t *>(that), strlen(that));
+}
+
+FIXTURE(MultiGet) {
+  Strm::Mem::TStaticIn mem("get a bb ccc\r\ngets  d\r\n");
+  Strm::Bin::TIn in(&mem);
+  TTextRequest get(in);
+  EXPECT_TRUE(get.GetCommand() == TTextRequest::TCommand::Get);
+  if (EXPECT_EQ(get.GetKeys().size(), 3U)) {
+    EXPECT_TRUE(get.GetKeys()[0] == Blob("a"));
+    EXPECT_TRUE(get.GetKeys()[1] == Blob("bb"));
+    EXPECT_TRUE(get.GetKeys()[2] == Blob("ccc"));
+  }
+  EXPECT_TRUE(in.HasBuffered());
+  TTextRequest gets(in);
+  EXPECT_TRUE(gets.GetCommand() == TTextRequest::TCommand::Gets);
+  if (EXPECT_EQ(gets.GetKeys().size(), 1U)) {
+    EXPECT_TRUE(gets.GetKeys()[0] == Blob("d"));
+  }
+  EXPECT_FALSE(in.HasBuffered());
+}
+
+FIXTURE(Set) {
+  Strm::Mem::TStaticIn mem("set k 42 0 5\r\nhe\r\no\r\nset k2 7 100 0 noreply\r\n\r\nversion\nbogus\r\nquit\r\n");
+  Strm::Bin::TIn in(&mem);
+  TTextRequest set(in);
+  EXPECT_TRUE(set.GetCommand() == TTextRequest::TCommand::Set);
+  EXPECT_TRUE(set.GetKeys()[0] == Blob("k"));
+  EXPECT_EQ(set.GetFlags(), 42U);
+  EXPECT_EQ(set.GetExpiration(), 0);
+  EXPECT_TRUE(set.GetValue() == Blob("he\r\no"));
+  EXPECT_FALSE(set.IsNoReply());
+  TTextRequest set_2(in);
+  EXPECT_TRUE(set_2.GetCommand() == TTextRequest::TCommand::Set);
+  EXPECT_EQ(set_2.GetExpiration(), 100);
+  EXPECT_TRUE(set_2.GetValue().empty());
+  EXPECT_TRUE(set_2.IsNoReply());
+  EXPECT_TRUE(TTextRequest(in).GetCommand() == TTextRequest::TCommand::Version);
+  EXPECT_TRUE(TTextRequest(in).GetCommand() == TTextRequest::TCommand::Unknown);
+  EXPECT_TRUE(TTextRequest(in).GetCommand() == TTextRequest::TCommand::Quit);
+}
+
+FIXTURE(Malformed) {
+  for (const char *bad : {"get\r\n", "set k x 0 1\r\na\r\n", "set k 1 0 1\r\nab\r\n", "set k 1 0 1 yes\r\na\r\n"}) {
+    Strm::Mem::TStaticIn mem(bad);
+    Strm::Bin::TIn in(&mem);
+    auto read = [&in]() { TTextRequest req(in); };
+    EXPECT_THROW_FUNC(invalid_argument, read);
+  }
+  string long_key = "get " + string(TTextRequest::MaxKeySize + 1, 'k') + "\r\n";
+  Strm::Mem::TStaticIn mem(long_key);
+  Strm::Bin::TIn in(&mem);
+  auto read = [&in]() { TTextRequest req(in); };
+  EXPECT_THROW_FUNC(invalid_argument, read);
+}
+
+FIXTURE(WriteValues) {
+  int fds[2];
+  if (!EXPECT_EQ(pipe(fds), 0)) {
+    return;
+  }
+  TFd read_end(fds[0]), write_end(fds[1]);
+  TResponseBatch batch;
+  WriteTextValue(batch, Blob("a"), 3, Blob("xyz"), false);
+  WriteTextValue(batch, Blob("bb"), 0, Native::TBlob(), true);
+  batch.Write("END\r\n", 5);
+  const string expected = "VALUE a 3 3\r\nxyz\r\nVALUE bb 0 0 1\r\n\r\nEND\r\n";
+  EXPECT_EQ(batch.GetSize(), expected.size());
+  batch.Flush(write_end);
+  EXPECT_TRUE(batch.IsEmpty());
+  string actual(expected.size(), '\0');
+  Util::ReadExactly(read_end, &actual[0], actual.size());
+  EXPECT_EQ(actual, expected);
+}
@@ -19,7 +19,15 @@
 #include <orly/mynde/value.h>
 
 #include <orly/native/record.h>
+#include <orly/sabot/to_native.h>
 
 
 RECORD_ELEM(Orly::Mynde::TValue, Orly::Native::TBlob, Value);
 RECORD_ELEM(Orly::Mynde::TValue, uint32_t, Flags);
+RECORD_ELEM(Orly::Mynde::TValue, uint32_t, ExpiresAt);
+
+void Orly::Mynde::ReadValue(const Sabot::State::TAny &state, TValue &value) {
+  /* ToNative() fills in only the fields the record has */
+  value.ExpiresAt = 0;
+  Sabot::ToNative(state, value);
+}
@@ -23,8 +23,9 @@
 #include <tuple>
 
 #include <orly/native/defs.h>
+#include <orly/sabot/state.h>
 
-/* Contains the value (a Native::TBlob), and the flags (a 32 bit uint) */
+/* Contains the value (a Native::TBlob), the flags (a 32 bit uint), and when the value expires */
 
 namespace Orly {
    namespace Mynde {
@@ -34,7 +35,35 @@ namespace Orly {
       struct TValue {
          Native::TBlob Value;
          uint32_t Flags;
+
+         /* Seconds since the epoch at which the value stops being visible, or 0 if it never does.  Values stored before we kept this
+            don't have it at all; see ReadValue(). */
+         uint32_t ExpiresAt;
       };
 
+      /* Fills in the value from the given stored one.  A record written before ExpiresAt existed lacks that field, and so reads as
+         never expiring, rather than as whatever the value held before. */
+      void ReadValue(const Sabot::State::TAny &state, TValue &value);
+
+      /* Memcache takes an exptime longer than this (30 days) to be seconds since the epoch rather than seconds from now. */
+      static constexpr int64_t MaxRelativeExpiration = 60 * 60 * 24 * 30;
+
+      /* The ExpiresAt for a value stored at 'now' (seconds since the epoch) with the given memcache exptime.  A negative exptime
+         means the value is expired already. */
+      inline uint32_t GetExpiresAt(int64_t exptime, int64_t now) {
+         if (exptime < 0) {
+            return 1;
+         }
+         if (exptime == 0 || exptime > MaxRelativeExpiration) {
+            return exptime;
+         }
+         return now + exptime;
+      }
+
+      /* True iff. the value has expired as of 'now' (seconds since the epoch). */
+      inline bool IsExpired(const TValue &value, int64_t now) {
+         return value.ExpiresAt && value.ExpiresAt <= now;
+      }
+
    } // Mynde
 } // Orly
@@ -0,0 +1,80 @@
+/* <orly/mynde/value.test.cc>
+
+   Unit test for <orly/mynde/value.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/mynde/value.h>
+
+#include <orly/native/record.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly;
+using namespace Orly::Mynde;
+
+/* A value as we stored it before we kept ExpiresAt. */
+struct TOldValue {
+  Native::TBlob Value;
+  uint32_t Flags;
+};
+
+RECORD_ELEM(TOldValue, Native::TBlob, Value);
+RECORD_ELEM(TOldValue, uint32_t, Flags);
+
+FIXTURE(GetExpiresAt) {
+  const int64_t now = 1400000000;
+  /* zero is forever */
+  EXPECT_EQ(GetExpiresAt(0, now), 0U);
+  /* up to 30 days is relative */
+  EXPECT_EQ(GetExpiresAt(10, now), now + 10);
+  EXPECT_EQ(GetExpiresAt(MaxRelativeExpiration, now), now + MaxRelativeExpiration);
+  /* past that, absolute */
+  EXPECT_EQ(GetExpiresAt(MaxRelativeExpiration + 1, now), MaxRelativeExpiration + 1);
+  EXPECT_EQ(GetExpiresAt(now + 5, now), now + 5);
+  /* negative is already gone */
+  EXPECT_TRUE(GetExpiresAt(-1, now) <= now);
+}
+
+FIXTURE(IsExpired) {
+  const int64_t now = 1400000000;
+  TValue value{Native::TBlob(), 0, 0};
+  EXPECT_FALSE(IsExpired(value, now));
+  value.ExpiresAt = GetExpiresAt(10, now);
+  EXPECT_FALSE(IsExpired(value, now));
+  EXPECT_FALSE(IsExpired(value, now + 9));
+  EXPECT_TRUE(IsExpired(value, now + 10));
+  value.ExpiresAt = GetExpiresAt(-1, now);
+  EXPECT_TRUE(IsExpired(value, now));
+  value.ExpiresAt = GetExpiresAt(MaxRelativeExpiration + 1, now);
+  EXPECT_TRUE(IsExpired(value, now));
+}
+
+FIXTURE(ReadValue) {
+  void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+  const int64_t now = 1400000000;
+  TValue value{Native::TBlob(), 7, GetExpiresAt(10, now)};
+  TValue out{Native::TBlob(), 0, 1};
+  ReadValue(*Sabot::State::TAny::TWrapper(Native::State::New(value, state_alloc)), out);
+  EXPECT_EQ(out.Flags, 7U);
+  EXPECT_EQ(out.ExpiresAt, value.ExpiresAt);
+  /* an old record reads as never expiring, whatever we read into */
+  TOldValue old_value{Native::TBlob(), 9};
+  ReadValue(*Sabot::State::TAny::TWrapper(Native::State::New(old_value, state_alloc)), out);
+  EXPECT_EQ(out.Flags, 9U);
+  EXPECT_EQ(out.ExpiresAt, 0U);
+  EXPECT_FALSE(IsExpired(out, now));
+}
@@ -37,6 +37,7 @@ class TCompilerConfig : public Base::TCmd {
         InfoReport(false),
         MachineForm(false),
         OutputDir(Util::GetCwd()),
+        PruneCacheDays(0),
         SemanticOnly(false),
         SkipTests(false),
         VerboseTests(false) {
@@ -52,6 +53,8 @@ class TCompilerConfig : public Base::TCmd {
       Param(&TCompilerConfig::DebugOutput, "debug_output", Optional, "debug\0d\0", "Compile the orly package in debug mode.");
       Param(&TCompilerConfig::MachineForm, "machine_form", Optional, "machine-form\0m\0", "Print out machine readable progress.");
       Param(&TCompilerConfig::OutputDir, "output_directory", Optional, "output\0o\0", "The directory to write output to.");
+      Param(&TCompilerConfig::PruneCacheDays, "prune_cache_days", Optional, "prune-cache-days\0",
+          "After compiling, remove cached objects which no build has used in this many days.  Zero (the default) keeps them all.");
       Param(&TCompilerConfig::SemanticOnly, "semantic_only", Optional, "semantic-only\0", "Don't actually produce output, just syntactically and semantically validate the program.");
       Param(&TCompilerConfig::SkipTests, "skip_tests", Optional, "skip-tests\0", "Don't run tests after compiling.");
       Param(&TCompilerConfig::VerboseTests, "verbose_tests", Optional, "v\0",
@@ -83,6 +86,7 @@ class TCompilerConfig : public Base::TCmd {
   bool InfoReport;
   bool MachineForm;
   std::string OutputDir;
+  size_t PruneCacheDays;
   bool SemanticOnly;
   std::string Source;
   bool SkipTests;
@@ -149,5 +153,14 @@ int CompileCode(const TCompilerConfig &cmd) {
 int main(int argc, char **argv) {
   TCompilerConfig config(argc, argv);
 
-  return CompileCode(config);
+  int result = CompileCode(config);
+  /* the build is done with the cache by now, so this is a safe time to tidy it */
+  if (config.PruneCacheDays && !config.SemanticOnly) {
+    try {
+      Compiler::PruneCache(config.OutputDir, chrono::hours(24 * config.PruneCacheDays));
+    } catch (const exception &ex) {
+      cerr << "error pruning cache: " << ex.what() << endl;
+    }
+  }
+  return result;
 }
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 //To get the flux TContext
 #include <orly/spa/flux_capacitor/api.h>
 #include <base/chrono.h>
@@ -101,6 +103,14 @@ namespace Orly {
         return std::make_shared<const TKeyGenerator<TRet>>(this, ctx, Sabot::State::TAny::TWrapper(Native::State::New(start, state_alloc)).get(), index_id);
       }
 
+      /* As above, but yielding at most the first limit keys, as for 'take'.  A limit less than one yields none. */
+      template <typename TRet, typename... TArgs>
+      std::shared_ptr<const TKeyGenerator<TRet>> New(TContextBase &ctx, const Base::TUuid &index_id, const std::tuple<TArgs...> &start, int64_t limit) {
+        void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+        return std::make_shared<const TKeyGenerator<TRet>>(
+            this, ctx, Sabot::State::TAny::TWrapper(Native::State::New(start, state_alloc)).get(), index_id, static_cast<size_t>(std::max<int64_t>(limit, 0)));
+      }
+
       /* Get the FluxCapacitor::TContext. Used by things like KeyGenerators and reading values out of the database. */
       virtual Orly::TContextBase &GetFlux() = 0;
 
@@ -0,0 +1,35 @@
+/* <orly/package/runtime.h>
+
+   Everything the code generated for a package needs from the runtime.  Generated code includes this first and only this from
+   the runtime, so the compiler can build it once as a precompiled header and reuse it for every package.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+
+#include <base/uuid.h>
+#include <orly/package/api.h>
+#include <orly/package/rt.h>
+#include <orly/rt.h>
+#include <orly/rt/containers.h>
+#include <orly/rt/obj.h>
+#include <orly/shared_enum.h>
+#include <orly/type/impl.h>
+#include <orly/type/obj.h>
+#include <orly/var/impl.h>
+#include <orly/var/mutation.h>
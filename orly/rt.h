@@ -25,6 +25,7 @@
 #include <orly/rt/generator.h>
 #include <orly/rt/mutable.h>
 #include <orly/rt/opt.h>
+#include <orly/rt/pipe.h>
 #include <orly/rt/runtime_error.h>
 #include <orly/rt/shortest_path.h>
 #include <orly/rt/string.h>
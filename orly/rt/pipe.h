@@ -0,0 +1,485 @@
+/* <orly/rt/pipe.h>
+
+   Chains of filter, map, take, skip and while fused into a single generator.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <base/class_traits.h>
+#include <base/iter.h>
+#include <orly/rt/generator.h>
+#include <orly/rt/opt.h>
+
+namespace Orly {
+
+  namespace Rt {
+
+    namespace Pipe {
+
+      /* Each of the generators in <orly/rt/generator.h> pulls from the one below it through a virtual cursor, so a chain of n
+         stages costs n virtual calls per item at every step.  When the code generator can see the whole chain, it builds a pipe
+         instead: a stage type which holds the stage below it by value, all the way down to a TSource.  None of the stage cursors
+         are virtual, so the compiler can inline the whole chain into the single cursor which Run() hands out.  An item then
+         costs one virtual call into the source and one out of the pipe, however many stages it goes through.
+
+         Every stage's TCursor provides:
+
+           explicit operator bool() const  -- true iff. there is a current item
+           const TItem &operator*() const  -- the current item
+           void Advance()                  -- on to the next item; only call this while there is a current item
+
+         A stage cursor refers back to its stage, so the stage must outlive it.  TPipeGenerator's cursor sees to that. */
+
+      /* The bottom of a pipe: a generator we can't see into. */
+      template <typename TItem_>
+      class TSource {
+        public:
+
+        typedef TItem_ TItem;
+
+        typedef typename TGenerator<TItem>::TPtr TGenPtr;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TSource &source)
+              : Iter(source.Generator->NewCursor()) {}
+
+          explicit operator bool() const {
+            assert(this);
+            return Iter;
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            return *Iter;
+          }
+
+          void Advance() {
+            assert(this);
+            ++Iter;
+          }
+
+          private:
+
+          Base::TIterHolder<const TItem> Iter;
+
+        };  // TCursor
+
+        explicit TSource(const TGenPtr &generator)
+            : Generator(generator) {}
+
+        private:
+
+        TGenPtr Generator;
+
+      };  // TSource<TItem_>
+
+      /* Passes along only the items for which the predicate is true. */
+      template <typename TInner>
+      class TFilter {
+        public:
+
+        typedef typename TInner::TItem TItem;
+
+        typedef std::function<bool (const TItem &)> TFunc;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TFilter &filter)
+              : Filter(filter), Inner(filter.Inner) {
+            Skip();
+          }
+
+          explicit operator bool() const {
+            assert(this);
+            return static_cast<bool>(Inner);
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            return *Inner;
+          }
+
+          void Advance() {
+            assert(this);
+            Inner.Advance();
+            Skip();
+          }
+
+          private:
+
+          /* Move along until we're on an item which passes, or we're out of items. */
+          void Skip() {
+            assert(this);
+            for (; Inner && !Filter.Func(*Inner); Inner.Advance());
+          }
+
+          const TFilter &Filter;
+
+          typename TInner::TCursor Inner;
+
+        };  // TCursor
+
+        TFilter(const TFunc &func, TInner &&inner)
+            : Func(func), Inner(std::move(inner)) {}
+
+        private:
+
+        TFunc Func;
+
+        TInner Inner;
+
+      };  // TFilter<TInner>
+
+      /* Passes along the result of a function applied to each item.  The result is computed only if someone looks at it. */
+      template <typename TRes, typename TInner>
+      class TMap {
+        public:
+
+        typedef TRes TItem;
+
+        typedef std::function<TRes (const typename TInner::TItem &)> TFunc;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TMap &map)
+              : Map(map), Inner(map.Inner) {}
+
+          explicit operator bool() const {
+            assert(this);
+            return static_cast<bool>(Inner);
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            if (!Item.IsKnown()) {
+              Item.MakeKnown(Map.Func(*Inner));
+            }
+            return Item.GetVal();
+          }
+
+          void Advance() {
+            assert(this);
+            Item.Reset();
+            Inner.Advance();
+          }
+
+          private:
+
+          const TMap &Map;
+
+          typename TInner::TCursor Inner;
+
+          /* The result for the current item, if we've computed it yet. */
+          mutable TOpt<TRes> Item;
+
+        };  // TCursor
+
+        TMap(const TFunc &func, TInner &&inner)
+            : Func(func), Inner(std::move(inner)) {}
+
+        private:
+
+        TFunc Func;
+
+        TInner Inner;
+
+      };  // TMap<TRes, TInner>
+
+      /* Passes along at most the first so many items.  Once we've passed the last one, we don't pull any more from below. */
+      template <typename TInner>
+      class TTake {
+        public:
+
+        typedef typename TInner::TItem TItem;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TTake &take)
+              : Inner(take.Inner), Remaining(take.Count) {}
+
+          explicit operator bool() const {
+            assert(this);
+            return Remaining > 0 && Inner;
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            return *Inner;
+          }
+
+          void Advance() {
+            assert(this);
+            if (--Remaining > 0) {
+              Inner.Advance();
+            }
+          }
+
+          private:
+
+          typename TInner::TCursor Inner;
+
+          int64_t Remaining;
+
+        };  // TCursor
+
+        TTake(int64_t count, TInner &&inner)
+            : Count(count), Inner(std::move(inner)) {}
+
+        private:
+
+        int64_t Count;
+
+        TInner Inner;
+
+      };  // TTake<TInner>
+
+      /* Passes along all but the first so many items. */
+      template <typename TInner>
+      class TSkip {
+        public:
+
+        typedef typename TInner::TItem TItem;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TSkip &skip)
+              : Inner(skip.Inner) {
+            for (int64_t i = 0; i < skip.Count && Inner; ++i) {
+              Inner.Advance();
+            }
+          }
+
+          explicit operator bool() const {
+            assert(this);
+            return static_cast<bool>(Inner);
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            return *Inner;
+          }
+
+          void Advance() {
+            assert(this);
+            Inner.Advance();
+          }
+
+          private:
+
+          typename TInner::TCursor Inner;
+
+        };  // TCursor
+
+        TSkip(int64_t count, TInner &&inner)
+            : Count(count), Inner(std::move(inner)) {}
+
+        private:
+
+        int64_t Count;
+
+        TInner Inner;
+
+      };  // TSkip<TInner>
+
+      /* Passes along items up to, but not including, the first for which the predicate is false. */
+      template <typename TInner>
+      class TWhile {
+        public:
+
+        typedef typename TInner::TItem TItem;
+
+        typedef std::function<bool (const TItem &)> TFunc;
+
+        class TCursor {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TWhile &while_)
+              : While(while_), Inner(while_.Inner) {
+            Check();
+          }
+
+          explicit operator bool() const {
+            assert(this);
+            return Valid;
+          }
+
+          const TItem &operator*() const {
+            assert(this);
+            return *Inner;
+          }
+
+          void Advance() {
+            assert(this);
+            Inner.Advance();
+            Check();
+          }
+
+          private:
+
+          /* Test the current item, once. */
+          void Check() {
+            assert(this);
+            Valid = Inner && While.Func(*Inner);
+          }
+
+          const TWhile &While;
+
+          typename TInner::TCursor Inner;
+
+          /* True iff. we're on an item and it passed. */
+          bool Valid;
+
+        };  // TCursor
+
+        TWhile(const TFunc &func, TInner &&inner)
+            : Func(func), Inner(std::move(inner)) {}
+
+        private:
+
+        TFunc Func;
+
+        TInner Inner;
+
+      };  // TWhile<TInner>
+
+      /* A generator which runs a whole pipe.  Its cursor is the only virtual layer between the consumer and the source. */
+      template <typename TPipe>
+      class TPipeGenerator
+          : public TGenerator<typename TPipe::TItem>, public std::enable_shared_from_this<TPipeGenerator<TPipe>> {
+        NO_COPY(TPipeGenerator);
+        public:
+
+        typedef std::shared_ptr<const TPipeGenerator> TPtr;
+
+        typedef const typename TPipe::TItem TItem;
+
+        class TCursor final : public Base::TIter<TItem> {
+          NO_COPY(TCursor);
+          public:
+
+          explicit TCursor(const TPtr &ptr)
+              : Ptr(ptr), Cursor(ptr->Pipe) {}
+
+          virtual operator bool() const override {
+            assert(this);
+            return static_cast<bool>(Cursor);
+          }
+
+          virtual TItem &operator*() const override {
+            assert(this);
+            if (!Cursor) {
+              throw TPastEndError(HERE);
+            }
+            return *Cursor;
+          }
+
+          virtual TCursor &operator++() override {
+            assert(this);
+            if (!Cursor) {
+              throw TPastEndError(HERE);
+            }
+            Cursor.Advance();
+            return *this;
+          }
+
+          private:
+
+          /* Keeps the pipe, and so the stages our cursor refers to, alive. */
+          TPtr Ptr;
+
+          typename TPipe::TCursor Cursor;
+
+        };  // TCursor
+
+        static TPtr New(TPipe &&pipe) {
+          return TPtr(new TPipeGenerator(std::move(pipe)));
+        }
+
+        virtual Base::TIterHolder<TItem> NewCursor() const override {
+          assert(this);
+          return Base::MakeHolder(new TCursor(this->shared_from_this()));
+        }
+
+        private:
+
+        explicit TPipeGenerator(TPipe &&pipe)
+            : Pipe(std::move(pipe)) {}
+
+        TPipe Pipe;
+
+      };  // TPipeGenerator<TPipe>
+
+      /* Start a pipe from the given generator. */
+      template <typename TItem>
+      TSource<TItem> Source(const typename TGenerator<TItem>::TPtr &generator) {
+        return TSource<TItem>(generator);
+      }
+
+      /* Add a stage to the top of a pipe. */
+      template <typename TInner>
+      TFilter<TInner> Filter(const typename TFilter<TInner>::TFunc &func, TInner &&inner) {
+        return TFilter<TInner>(func, std::move(inner));
+      }
+
+      template <typename TRes, typename TInner>
+      TMap<TRes, TInner> Map(const typename TMap<TRes, TInner>::TFunc &func, TInner &&inner) {
+        return TMap<TRes, TInner>(func, std::move(inner));
+      }
+
+      template <typename TInner>
+      TTake<TInner> Take(int64_t count, TInner &&inner) {
+        return TTake<TInner>(count, std::move(inner));
+      }
+
+      template <typename TInner>
+      TSkip<TInner> Skip(int64_t count, TInner &&inner) {
+        return TSkip<TInner>(count, std::move(inner));
+      }
+
+      template <typename TInner>
+      TWhile<TInner> While(const typename TWhile<TInner>::TFunc &func, TInner &&inner) {
+        return TWhile<TInner>(func, std::move(inner));
+      }
+
+      /* Wrap a finished pipe up as a generator. */
+      template <typename TPipe>
+      typename TPipeGenerator<TPipe>::TPtr Run(TPipe &&pipe) {
+        return TPipeGenerator<TPipe>::New(std::move(pipe));
+      }
+
+    }  // Pipe
+
+  }  // Rt
+
+}  // Orly
@@ -0,0 +1,113 @@
+/* <orly/rt/pipe.test.cc>
+
+   Unit test for <orly/rt/pipe.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/rt/pipe.h>
+
+#include <string>
+#include <vector>
+
+#include <orly/rt/runtime_error.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Rt;
+
+static TGenerator<int64_t>::TPtr Range(int64_t start, int64_t limit) {
+  return TRangeGenerator::New(start, limit, false);
+}
+
+template <typename TItem>
+static vector<TItem> Drain(const typename TGenerator<TItem>::TPtr &gen) {
+  vector<TItem> out;
+  for (auto it = gen->NewCursor(); it; ++it) {
+    out.push_back(*it);
+  }
+  return out;
+}
+
+FIXTURE(Source) {
+  auto gen = Pipe::Run(Pipe::Source<int64_t>(Range(1, 5)));
+  EXPECT_TRUE(Drain<int64_t>(gen) == vector<int64_t>({1, 2, 3, 4}));
+  /* each cursor starts over */
+  EXPECT_TRUE(Drain<int64_t>(gen) == vector<int64_t>({1, 2, 3, 4}));
+}
+
+FIXTURE(FilterMap) {
+  auto gen = Pipe::Run(
+      Pipe::Map<string>(
+          [](const int64_t &val) { return to_string(val * 10); },
+          Pipe::Filter(
+              [](const int64_t &val) { return val % 2 == 0; },
+              Pipe::Source<int64_t>(Range(0, 7)))));
+  EXPECT_TRUE(Drain<string>(gen) == vector<string>({"0", "20", "40", "60"}));
+}
+
+FIXTURE(MapOnlyWhenLooked) {
+  size_t calls = 0;
+  auto gen = Pipe::Run(
+      Pipe::Take(
+          2,
+          Pipe::Skip(
+              3,
+              Pipe::Map<int64_t>(
+                  [&calls](const int64_t &val) { ++calls; return val * val; },
+                  Pipe::Source<int64_t>(Range(0, 100))))));
+  EXPECT_TRUE(Drain<int64_t>(gen) == vector<int64_t>({9, 16}));
+  EXPECT_EQ(calls, 2UL);
+}
+
+FIXTURE(TakeStopsPulling) {
+  size_t tests = 0;
+  auto gen = Pipe::Run(
+      Pipe::Take(
+          3,
+          Pipe::Filter(
+              [&tests](const int64_t &) { ++tests; return true; },
+              Pipe::Source<int64_t>(Range(0, 100)))));
+  EXPECT_TRUE(Drain<int64_t>(gen) == vector<int64_t>({0, 1, 2}));
+  EXPECT_EQ(tests, 3UL);
+  EXPECT_TRUE(Drain<int64_t>(Pipe::Run(Pipe::Take(0, Pipe::Source<int64_t>(Range(0, 100))))).empty());
+  EXPECT_TRUE(Drain<int64_t>(Pipe::Run(Pipe::Take(10, Pipe::Source<int64_t>(Range(0, 3))))) == vector<int64_t>({0, 1, 2}));
+}
+
+FIXTURE(Skip) {
+  EXPECT_TRUE(Drain<int64_t>(Pipe::Run(Pipe::Skip(2, Pipe::Source<int64_t>(Range(0, 5))))) == vector<int64_t>({2, 3, 4}));
+  EXPECT_TRUE(Drain<int64_t>(Pipe::Run(Pipe::Skip(10, Pipe::Source<int64_t>(Range(0, 5))))).empty());
+}
+
+FIXTURE(While) {
+  size_t tests = 0;
+  auto gen = Pipe::Run(
+      Pipe::While(
+          [&tests](const int64_t &val) { ++tests; return val < 3; },
+          Pipe::Source<int64_t>(Range(0, 100))));
+  EXPECT_TRUE(Drain<int64_t>(gen) == vector<int64_t>({0, 1, 2}));
+  /* once per item, including the one that stopped us */
+  EXPECT_EQ(tests, 4UL);
+}
+
+FIXTURE(PastEnd) {
+  auto gen = Pipe::Run(Pipe::Take(1, Pipe::Source<int64_t>(Range(0, 100))));
+  auto it = gen->NewCursor();
+  EXPECT_EQ(*it, 0);
+  ++it;
+  EXPECT_FALSE(it);
+  auto advance = [&it]() { ++it; };
+  EXPECT_THROW_FUNC(TPastEndError, advance);
+}
@@ -18,7 +18,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <vector>
 
 #include <orly/rt/generator.h>
 
@@ -51,6 +54,74 @@ namespace Orly {
       return std::move(start);
     }
 
+    /* Kernels for the reductions the code generator recognizes over sequences of int or real.  Each gives just what Reduce()
+       would with the same body, but without a std::function call per item.  When the sequence comes straight from a list, we
+       run over the list's own storage, in loops simple enough for the compiler to vectorize. */
+
+    /* Call func on each item of the sequence. */
+    template <typename TVal, typename TFunc>
+    void ForEachItem(const typename TGenerator<TVal>::TPtr &gen, const TFunc &func) {
+      auto stl = dynamic_cast<const TStlGenerator<std::vector<TVal>> *>(gen.get());
+      if (stl) {
+        for (const TVal &val: stl->GetContainer()) {
+          func(val);
+        }
+      } else {
+        for (auto it = gen->NewCursor(); it; ++it) {
+          func(*it);
+        }
+      }
+    }
+
+    /* 'carry + that'.  Ints are summed in unsigned lanes, which wrap just as the carry would, and which the compiler is free
+       to add up in any order.  Reals are summed strictly in order, so we round just as Reduce() would. */
+    template <typename TVal>
+    typename std::enable_if<std::is_integral<TVal>::value, TVal>::type
+    ReduceSum(const typename TGenerator<TVal>::TPtr &gen, TVal start) {
+      typedef typename std::make_unsigned<TVal>::type TLane;
+      TLane sum = static_cast<TLane>(start);
+      ForEachItem<TVal>(gen, [&sum](const TVal &val) { sum += static_cast<TLane>(val); });
+      return static_cast<TVal>(sum);
+    }
+
+    template <typename TVal>
+    typename std::enable_if<!std::is_integral<TVal>::value, TVal>::type
+    ReduceSum(const typename TGenerator<TVal>::TPtr &gen, TVal start) {
+      ForEachItem<TVal>(gen, [&start](const TVal &val) { start += val; });
+      return start;
+    }
+
+    /* 'carry + step', where step is a constant int, so 'carry + 1' counts the items. */
+    template <typename TVal>
+    TVal ReduceCount(const typename TGenerator<TVal>::TPtr &gen, TVal start, TVal step) {
+      static_assert(std::is_integral<TVal>::value, "only ints count exactly");
+      typedef typename std::make_unsigned<TVal>::type TLane;
+      auto stl = dynamic_cast<const TStlGenerator<std::vector<TVal>> *>(gen.get());
+      TLane count = 0;
+      if (stl) {
+        count = stl->GetContainer().size();
+      } else {
+        for (auto it = gen->NewCursor(); it; ++it, ++count);
+      }
+      return static_cast<TVal>(static_cast<TLane>(start) + count * static_cast<TLane>(step));
+    }
+
+    /* 'carry if compare(carry, that) else that', as in a running min or max. */
+    template <typename TVal, typename TCompare>
+    TVal ReduceKeepCarry(const typename TGenerator<TVal>::TPtr &gen, TVal start) {
+      TCompare compare;
+      ForEachItem<TVal>(gen, [&start, &compare](const TVal &val) { start = compare(start, val) ? start : val; });
+      return start;
+    }
+
+    /* 'that if compare(that, carry) else carry', as in a running min or max. */
+    template <typename TVal, typename TCompare>
+    TVal ReduceTakeThat(const typename TGenerator<TVal>::TPtr &gen, TVal start) {
+      TCompare compare;
+      ForEachItem<TVal>(gen, [&start, &compare](const TVal &val) { start = compare(val, start) ? val : start; });
+      return start;
+    }
+
   } // Rt
 
 } // Orly
\ No newline at end of file
@@ -0,0 +1,67 @@
+/* <orly/rt/reduce.test.cc>
+
+   Unit test for <orly/rt/reduce.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <orly/rt/reduce.h>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <orly/rt/pipe.h>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace Orly::Rt;
+
+static TGenerator<int64_t>::TPtr Ints(const vector<int64_t> &vals) {
+  return TStlGenerator<vector<int64_t>>::New(vals);
+}
+
+/* The same items, but not straight from a list. */
+static TGenerator<int64_t>::TPtr Piped(const vector<int64_t> &vals) {
+  return Pipe::Run(Pipe::Source<int64_t>(Ints(vals)));
+}
+
+static const vector<int64_t> Vals = {5, -3, 12, 7, -8, 0, 4};
+
+FIXTURE(Sum) {
+  const TReduceFunc<int64_t, int64_t> sum = [](const int64_t &carry, const int64_t &that) { return carry + that; };
+  EXPECT_EQ(ReduceSum<int64_t>(Ints(Vals), 100), Reduce(Ints(Vals), sum, int64_t(100)));
+  EXPECT_EQ(ReduceSum<int64_t>(Piped(Vals), 100), 117);
+  EXPECT_EQ(ReduceSum<int64_t>(Ints({}), 100), 100);
+  /* wraps just as the carry would */
+  EXPECT_EQ(ReduceSum<int64_t>(Ints({numeric_limits<int64_t>::max(), 1}), 0), numeric_limits<int64_t>::min());
+  const vector<double> reals = {0.1, 0.2, 0.3, 1e16, -1e16};
+  const TReduceFunc<double, double> real_sum = [](const double &carry, const double &that) { return carry + that; };
+  auto gen = TStlGenerator<vector<double>>::New(reals);
+  EXPECT_EQ(ReduceSum<double>(gen, 0.0), Reduce(gen, real_sum, 0.0));
+}
+
+FIXTURE(Count) {
+  EXPECT_EQ(ReduceCount<int64_t>(Ints(Vals), 0, 1), 7);
+  EXPECT_EQ(ReduceCount<int64_t>(Piped(Vals), 10, 2), 24);
+}
+
+FIXTURE(MinMax) {
+  EXPECT_EQ((ReduceKeepCarry<int64_t, less<int64_t>>(Ints(Vals), 100)), -8);
+  EXPECT_EQ((ReduceKeepCarry<int64_t, greater<int64_t>>(Piped(Vals), -100)), 12);
+  EXPECT_EQ((ReduceTakeThat<int64_t, less<int64_t>>(Piped(Vals), 100)), -8);
+  EXPECT_EQ((ReduceTakeThat<int64_t, greater_equal<int64_t>>(Ints(Vals), 0)), 12);
+  EXPECT_EQ((ReduceTakeThat<int64_t, less<int64_t>>(Ints({}), 42)), 42);
+}
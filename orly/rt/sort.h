@@ -19,6 +19,10 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
 #include <vector>
 
 #include <base/class_traits.h>
@@ -49,6 +53,70 @@ namespace Orly {
                            : TOpt<std::vector<TVal>>();
     }
 
+    /* Maps a value onto an unsigned key whose order is the value's natural order, for the radix sort below. */
+    inline uint64_t GetRadixKey(int64_t val) {
+      return static_cast<uint64_t>(val) ^ (uint64_t(1) << 63);
+    }
+
+    inline uint64_t GetRadixKey(double val) {
+      uint64_t bits;
+      memcpy(&bits, &val, sizeof(bits));
+      return (bits & (uint64_t(1) << 63)) ? ~bits : (bits | (uint64_t(1) << 63));
+    }
+
+    /* Sorts in place into ascending order, by an LSD radix sort on 8-bit digits of GetRadixKey().  A pass in which every key has
+       the same digit is skipped, so keys over a narrow range cost only a few passes. */
+    template <typename TVal>
+    void RadixSort(std::vector<TVal> &val) {
+      std::vector<TVal> tmp(val.size());
+      for (size_t shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const TVal &elem: val) {
+          ++counts[(GetRadixKey(elem) >> shift) & 0xFF];
+        }
+        if (counts[(GetRadixKey(val.front()) >> shift) & 0xFF] == val.size()) {
+          continue;
+        }
+        size_t pos = 0;
+        for (size_t &count: counts) {
+          size_t next = pos + count;
+          count = pos;
+          pos = next;
+        }
+        for (const TVal &elem: val) {
+          tmp[counts[(GetRadixKey(elem) >> shift) & 0xFF]++] = elem;
+        }
+        val.swap(tmp);
+      }
+    }
+
+    /* Sorts a list of int or real by '<' (or, if not ascending, by '>'), as Sort() would given a comparator of 'lhs < rhs'.  We
+       take the list by value, so when it's a temporary we sort it in place rather than copy it.  Big lists go by RadixSort(),
+       small ones by std::sort. */
+    template <typename TVal>
+    std::vector<TVal> SortNatural(std::vector<TVal> val, bool ascending) {
+      static_assert(std::is_same<TVal, int64_t>::value || std::is_same<TVal, double>::value, "no radix key for this type");
+      static const size_t RadixMin = 1024;
+      if (val.size() >= RadixMin) {
+        RadixSort(val);
+        if (!ascending) {
+          std::reverse(val.begin(), val.end());
+        }
+      } else if (ascending) {
+        std::sort(val.begin(), val.end());
+      } else {
+        std::sort(val.begin(), val.end(), std::greater<TVal>());
+      }
+      return val;
+    }
+
+    /* As above, for an optional list. */
+    template <typename TVal>
+    TOpt<std::vector<TVal>> SortNatural(const TOpt<std::vector<TVal>> &val, bool ascending) {
+      return val.IsKnown() ? TOpt<std::vector<TVal>>(SortNatural(val.GetVal(), ascending))
+                           : TOpt<std::vector<TVal>>();
+    }
+
   }  // Rt
 
 }  // Orly
\ No newline at end of file
@@ -67,3 +67,33 @@ FIXTURE(SortOnOptEmpty) {
 FIXTURE(SortOnOptNonEmpty) {
   EXPECT_TRUE(Sort(opt_li, lt).GetVal() == sorted_li);
 }
+
+FIXTURE(SortNatural) {
+  EXPECT_TRUE(SortNatural<int64_t>(empty_li, true) == empty_li);
+  EXPECT_TRUE(SortNatural<int64_t>(li, true) == sorted_li);
+  EXPECT_TRUE(SortNatural<int64_t>(li, false) == vector<int64_t>({3, 2, 1}));
+  EXPECT_TRUE(SortNatural<int64_t>(unknown_li, true).IsUnknown());
+  EXPECT_TRUE(SortNatural<int64_t>(opt_li, true).GetVal() == sorted_li);
+}
+
+FIXTURE(SortNaturalRadix) {
+  /* big enough to go by radix, with negatives, and a narrow range so some passes are skipped */
+  vector<int64_t> ints;
+  for (int64_t i = 0; i < 5000; ++i) {
+    ints.push_back((i * 7919) % 3001 - 1500);
+  }
+  vector<int64_t> expected_ints(ints);
+  sort(expected_ints.begin(), expected_ints.end());
+  EXPECT_TRUE(SortNatural(ints, true) == expected_ints);
+  reverse(expected_ints.begin(), expected_ints.end());
+  EXPECT_TRUE(SortNatural(ints, false) == expected_ints);
+  vector<double> reals;
+  for (int64_t i = 0; i < 5000; ++i) {
+    reals.push_back(((i * 7919) % 3001 - 1500) / 7.0);
+  }
+  reals.push_back(-1e300);
+  reals.push_back(1e300);
+  vector<double> expected_reals(reals);
+  sort(expected_reals.begin(), expected_reals.end());
+  EXPECT_TRUE(SortNatural(reals, true) == expected_reals);
+}
@@ -35,9 +35,24 @@ RECORD_ELEM(TMetaRecord::TEntry, uint32_t, RandomSeed);
 /* Metadata for TMetaRecord. */
 RECORD_ELEM(TMetaRecord, TMetaRecord::TEntryByUpdateId, EntryByUpdateId);
 
+void TMetaRecord::Absorb(const TMetaRecord &that) {
+  assert(this);
+  assert(&that);
+  EntryByUpdateId.insert(that.EntryByUpdateId.begin(), that.EntryByUpdateId.end());
+}
+
 const TMetaRecord::TEntry &TMetaRecord::GetEntry(const TUuid &id) const {
   assert(this);
   auto iter = EntryByUpdateId.find(id);
   assert(iter != EntryByUpdateId.end());
   return iter->second;
 }
+
+TMetaRecord::TSessionIdByUpdateId TMetaRecord::GetSessionIdByUpdateId() const {
+  assert(this);
+  TSessionIdByUpdateId session_id_by_update_id;
+  for (const auto &item: EntryByUpdateId) {
+    session_id_by_update_id.insert(make_pair(item.first, item.second.GetSessionId()));
+  }
+  return session_id_by_update_id;
+}
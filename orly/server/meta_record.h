@@ -130,6 +130,10 @@ namespace Orly {
       /* TODO */
       using TEntryByUpdateId = std::map<Base::TUuid, TEntry>;
 
+      /* What an update promoted into the global pov carries in place of the whole record: the session behind each of the updates
+         collapsed into it.  Nothing promotes out of the global pov, so the rest of each entry is dead weight there. */
+      using TSessionIdByUpdateId = std::map<Base::TUuid, Base::TUuid>;
+
       /* TODO */
       TMetaRecord() {}
 
@@ -138,6 +142,9 @@ namespace Orly {
         EntryByUpdateId.insert(std::make_pair(update_id, std::forward<TEntry>(entry)));
       }
 
+      /* Take a copy of each of the entries in the given record, keeping ours where the update ids collide. */
+      void Absorb(const TMetaRecord &that);
+
       /* TODO */
       const TEntry &GetEntry(const Base::TUuid &id) const;
 
@@ -147,6 +154,9 @@ namespace Orly {
         return EntryByUpdateId;
       }
 
+      /* See TSessionIdByUpdateId. */
+      TSessionIdByUpdateId GetSessionIdByUpdateId() const;
+
       private:
 
       /* TODO */
@@ -20,6 +20,7 @@
 
 #include <vector>
 
+#include <orly/indy/fiber/algorithm.h>
 #include <orly/mynde/protocol.h> // For Mynde::PackageName
 #include <orly/notification/pov_failure.h>
 #include <orly/notification/update_progress.h>
@@ -32,17 +33,21 @@ using namespace Orly::Indy;
 using namespace Orly::Server;
 using namespace ::Util;
 
+const size_t TRepoTetrisManager::TPlayer::MaxCollapsedUpdates = 64UL;
+
 TRepoTetrisManager::TRepoTetrisManager(
     TScheduler *scheduler,
     Fiber::TRunner::TRunnerCons &runner_cons,
     Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *> *frame_pool_manager,
     const std::function<void (Indy::Fiber::TRunner *)> &runner_setup_cb,
+    size_t num_helper_runners,
+    size_t helper_steal_group,
     bool is_master,
     Indy::TManager *repo_manager,
     Package::TManager *package_manager,
     Durable::TManager *durable_manager,
     bool log_assertion_failures)
-    : TTetrisManager(scheduler, runner_cons, frame_pool_manager, runner_setup_cb, is_master),
+    : TTetrisManager(scheduler, runner_cons, frame_pool_manager, runner_setup_cb, num_helper_runners, helper_steal_group, is_master),
       PushCount(0UL),
       PopCount(0UL),
       FailCount(0UL),
@@ -77,34 +82,39 @@ TRepoTetrisManager::TPlayer::~TPlayer() {
 }
 
 TRepoTetrisManager::TPlayer::TChild::TChild(TPlayer *player, const TUuid &child_pov_id)
-    : Player(player), Age(0), FailureCount(0) {
+    : Player(player), Age(0), FailureCount(0), Passed(false) {
   Repo = player->RepoTetrisManager->RepoManager->ForceGetRepo(child_pov_id);
 }
 
-bool TRepoTetrisManager::TPlayer::TChild::Play(
-    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context) {
+bool TRepoTetrisManager::TPlayer::TChild::HasAssertions() const {
   assert(this);
-  assert(transaction);
-  bool success = TestAssertions(context);
-  if (success) {
-    /* swap the metadata with just the session ids if we're pushing to global */
-    if (Player->Repo->GetId() == TSession::GlobalPovId) {
-      void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-      if (FuncHolderByUpdateId.size() == 1) {
-        /* we're storing just a single session id. */
-        PeekedUpdate->SetMetadata(Indy::TKey(MetaRecord.GetEntry(FuncHolderByUpdateId.begin()->first).GetSessionId(), &PeekedUpdate->GetSuprena(), state_alloc));
-      } else {
-        throw std::runtime_error("We don't currently support collapsed updates.");
-      }
+  for (const auto &item: MetaRecord.GetEntryByUpdateId()) {
+    if (!item.second.GetExpectedPredicateResults().empty()) {
+      return true;
     }
-    transaction->Push(Player->Repo, PeekedUpdate);
-    transaction->Pop(Repo);
-    ++(Player->RepoTetrisManager->PushCount);
-    ++(Player->RepoTetrisManager->PopCount);
+  }
+  return false;
+}
+
+void TRepoTetrisManager::TPlayer::TChild::Test() {
+  assert(this);
+  Atom::TSuprena arena;
+  ReadSet = Indy::TContext::TReadSet();
+  Indy::TContext context(Player->Repo, &arena);
+  context.SetReadSet(&ReadSet);
+  Passed = TestAssertions(context);
+}
+
+void TRepoTetrisManager::TPlayer::TChild::Fail(
+    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction) {
+  assert(this);
+  assert(transaction);
+  assert(!Passed);
+  ++FailureCount;
+  if (FailureCount >= 10) {
+    transaction->Fail(Repo);
     for (const auto &item: FuncHolderByUpdateId) {
       const auto &entry = MetaRecord.GetEntry(item.first);
-
-      //In the case of Mynde, the notification behavior is special.
       if (entry.GetPackageFqName() == Mynde::PackageName) {
         if (entry.GetMethodName() != "set") {
           throw std::runtime_error("Only memcachememcache.set is supported at this point in time.");
@@ -113,35 +123,40 @@ bool TRepoTetrisManager::TPlayer::TChild::Play(
       }
       auto session = Player->RepoTetrisManager->DurableManager->Open<TSession>(entry.GetSessionId());
       if (session) {
-        session->InsertNotification(Notification::TUpdateProgress::New(Player->Repo->GetId(), item.first, Notification::TUpdateProgress::Accepted));
+        session->InsertNotification(Notification::TPovFailure::New(Repo->GetId()));
       }
     }
+    ++(Player->RepoTetrisManager->FailCount);
+    stringstream ss;
+    ss << Repo->GetId();
+    syslog(LOG_INFO, "Failing Repo [%s]", ss.str().c_str());
     Flush();
-  } else {
-    ++FailureCount;
-    if (FailureCount >= 10) {
-      transaction->Fail(Repo);
-      for (const auto &item: FuncHolderByUpdateId) {
-        const auto &entry = MetaRecord.GetEntry(item.first);
-        if (entry.GetPackageFqName() == Mynde::PackageName) {
-          if (entry.GetMethodName() != "set") {
-            throw std::runtime_error("Only memcachememcache.set is supported at this point in time.");
-          }
-          continue;
-        }
-        auto session = Player->RepoTetrisManager->DurableManager->Open<TSession>(entry.GetSessionId());
-        if (session) {
-          session->InsertNotification(Notification::TPovFailure::New(Repo->GetId()));
-        }
+  }
+}
+
+void TRepoTetrisManager::TPlayer::TChild::Promote(
+    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction) {
+  assert(this);
+  assert(transaction);
+  assert(PeekedUpdate);
+  transaction->Pop(Repo);
+  ++(Player->RepoTetrisManager->PopCount);
+  for (const auto &item: FuncHolderByUpdateId) {
+    const auto &entry = MetaRecord.GetEntry(item.first);
+
+    //In the case of Mynde, the notification behavior is special.
+    if (entry.GetPackageFqName() == Mynde::PackageName) {
+      if (entry.GetMethodName() != "set") {
+        throw std::runtime_error("Only memcachememcache.set is supported at this point in time.");
       }
-      ++(Player->RepoTetrisManager->FailCount);
-      stringstream ss;
-      ss << Repo->GetId();
-      syslog(LOG_INFO, "Failing Repo [%s]", ss.str().c_str());
-      Flush();
+      continue;
+    }
+    auto session = Player->RepoTetrisManager->DurableManager->Open<TSession>(entry.GetSessionId());
+    if (session) {
+      session->InsertNotification(Notification::TUpdateProgress::New(Player->Repo->GetId(), item.first, Notification::TUpdateProgress::Accepted));
     }
   }
-  return success;
+  Flush();
 }
 
 bool TRepoTetrisManager::TPlayer::TChild::Refresh(const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction) {
@@ -299,7 +314,6 @@ void TRepoTetrisManager::TPlayer::OnUnpause() {
 void TRepoTetrisManager::TPlayer::Play() {
   assert(this);
   Base::TCPUTimer snapshot_timer, sort_timer, play_timer, commit_timer;
-  Atom::TSuprena my_arena;
   try {
     /* Begin a transaction and make a vector of all our children who are ready to participate in it. */
     unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> transaction = RepoTetrisManager->RepoManager->NewTransaction();
@@ -320,15 +334,50 @@ void TRepoTetrisManager::TPlayer::Play() {
     sort_timer.Start();
     sort(children.begin(), children.end(), TChild::SortsBefore);
     sort_timer.Stop();
-    /* Give each child a chance to play.  At most one will be permitted to promote (for now), but any number might fail
-       due to age. */
+    /* Test the assertions of the children who have any, all at once across our helper runners.  Each test reads from its own
+       context on our repo as it stands now. */
     play_timer.Start();
-    Indy::TContext context(Repo, &my_arena);
+    if (children.size() > MaxCollapsedUpdates) {
+      children.resize(MaxCollapsedUpdates);
+    }
+    vector<TChild *> to_test;
     for (TChild *child: children) {
-      if (child->Play(transaction, context)) {
-        break;
+      if (child->HasAssertions()) {
+        to_test.push_back(child);
+      }
+    }
+    Indy::Fiber::ForEach(RepoTetrisManager->GetHelperRunners(), to_test.size(), [&to_test](size_t idx) {
+      to_test[idx]->Test();
+    });
+    /* Now, in order, collapse those who passed into a single update to our repo.  If a child's test read a key written by a child
+       ahead of it in this round, the test is stale, pass or fail, so that child waits for the next round. */
+    vector<TChild *> promoted;
+    vector<const Indy::TIndexKey *> written;
+    for (TChild *child: children) {
+      if (child->HasAssertions()) {
+        bool is_stale = false;
+        for (const Indy::TIndexKey *key: written) {
+          if (child->MayHaveRead(*key)) {
+            is_stale = true;
+            break;
+          }
+        }
+        if (is_stale) {
+          continue;
+        }
+        if (!child->HasPassed()) {
+          child->Fail(transaction);
+          continue;
+        }
+      }
+      promoted.push_back(child);
+      for (Indy::TUpdate::TEntryCollection::TCursor csr(child->GetPeekedUpdate()->GetEntryCollection()); csr; ++csr) {
+        written.push_back(&csr->GetIndexKey());
       }
     }
+    if (!promoted.empty()) {
+      PushCollapsed(transaction, promoted);
+    }
     play_timer.Stop();
     /* Commit. */
     transaction->Prepare();
@@ -348,6 +397,48 @@ void TRepoTetrisManager::TPlayer::Play() {
   RepoTetrisManager->TetrisCommitCPUTime.Push(ToSecondsDouble(commit_timer.GetTotal()));
 }
 
+void TRepoTetrisManager::TPlayer::PushCollapsed(
+    const unique_ptr<Indy::L1::TTransaction, function<void (Indy::L1::TTransaction *)>> &transaction,
+    const vector<TChild *> &children) {
+  assert(this);
+  assert(transaction);
+  assert(!children.empty());
+  void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+  void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+  Atom::TSuprena arena;
+  const bool is_global = Repo->GetId() == TSession::GlobalPovId;
+  shared_ptr<Indy::TUpdate> update;
+  if (children.size() == 1UL) {
+    /* nothing to collapse; push the child's own update */
+    update = children.front()->GetPeekedUpdate();
+    if (is_global) {
+      update->SetMetadata(Indy::TKey(children.front()->GetMetaRecord().GetSessionIdByUpdateId(), &arena, state_alloc_1));
+    }
+  } else {
+    /* Later children overwrite the ops of earlier ones, just as if each had been pushed in turn.  The keys and ops still live in
+       the children's updates, which they hold until we call Promote(), below. */
+    Indy::TUpdate::TOpByKey op_by_key;
+    TMetaRecord meta_record;
+    for (TChild *child: children) {
+      const auto &peeked_update = child->GetPeekedUpdate();
+      for (Indy::TUpdate::TEntryCollection::TCursor csr(peeked_update->GetEntryCollection()); csr; ++csr) {
+        op_by_key[csr->GetIndexKey()] = Indy::TKey(csr->GetOp(), &peeked_update->GetSuprena());
+      }
+      meta_record.Absorb(child->GetMetaRecord());
+    }
+    Indy::TKey metadata = is_global
+        ? Indy::TKey(meta_record.GetSessionIdByUpdateId(), &arena, state_alloc_1)
+        : Indy::TKey(meta_record, &arena, state_alloc_1);
+    /* each collapsed update keeps its own id in the metadata, so the sessions can still track them */
+    update = Indy::TUpdate::NewUpdate(op_by_key, metadata, Indy::TKey(TUuid(TUuid::Twister), &arena, state_alloc_2));
+  }
+  transaction->Push(Repo, update);
+  ++(RepoTetrisManager->PushCount);
+  for (TChild *child: children) {
+    child->Promote(transaction);
+  }
+}
+
 TTetrisManager::TPlayer *TRepoTetrisManager::NewPlayer(const TUuid &parent_pov_id, const TUuid &child_pov_id, bool is_paused, bool is_master) {
   assert(this);
   return new TPlayer(this, parent_pov_id, child_pov_id, is_paused, is_master);
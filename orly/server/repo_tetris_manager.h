@@ -22,6 +22,7 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <orly/indy/context.h>
@@ -46,6 +47,8 @@ namespace Orly {
           Indy::Fiber::TRunner::TRunnerCons &runner_cons,
           Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *> *frame_pool_manager,
           const std::function<void (Indy::Fiber::TRunner *)> &runner_setup_cb,
+          size_t num_helper_runners,
+          size_t helper_steal_group,
           bool is_master,
           Indy::TManager *repo_manager,
           Package::TManager *package_manager,
@@ -91,9 +94,43 @@ namespace Orly {
           /* TODO */
           TChild(TPlayer *player, const Base::TUuid &child_pov_id);
 
-          /* TODO */
-          bool Play(
-              const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction, Indy::TContext &context);
+          /* The update we've peeked and are waiting to promote, if any. */
+          const std::shared_ptr<Indy::TUpdate> &GetPeekedUpdate() const {
+            assert(this);
+            return PeekedUpdate;
+          }
+
+          /* The metadata of our peeked update. */
+          const TMetaRecord &GetMetaRecord() const {
+            assert(this);
+            return MetaRecord;
+          }
+
+          /* True iff. our peeked update has predicate results it expects when it lands. */
+          bool HasAssertions() const;
+
+          /* Test our assertions against a context of our own on the parent, keeping the outcome and what the test read.  This touches
+             nothing outside of us but the parent's repo, so the player may test any number of children at once on its helper runners. */
+          void Test();
+
+          /* True iff. our last Test() passed. */
+          bool HasPassed() const {
+            assert(this);
+            return Passed;
+          }
+
+          /* True iff. our last Test() may have read the given key.  If so, and the key has been written since, the test is stale. */
+          bool MayHaveRead(const Indy::TIndexKey &key) const {
+            assert(this);
+            return ReadSet.MayHaveRead(key);
+          }
+
+          /* Our last Test() failed.  Count it, and if we've failed too often, fail our pov. */
+          void Fail(const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction);
+
+          /* Our peeked update has been pushed to the parent, perhaps collapsed with others.  Pop it from our pov, let the sessions
+             know, and forget it. */
+          void Promote(const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction);
 
           /* TODO */
           bool Refresh(const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction);
@@ -118,6 +155,10 @@ namespace Orly {
           /* The number of times we have tested our assertions and failed. */
           size_t FailureCount;
 
+          /* The outcome of our last Test(), and what it read. */
+          bool Passed;
+          Indy::TContext::TReadSet ReadSet;
+
           /* The repo which backs up this child pov. */
           Indy::L0::TManager::TPtr<Indy::TRepo> Repo;
 
@@ -147,6 +188,15 @@ namespace Orly {
         /* See TRepoTetrisManager::TPlayer. */
         virtual void Play() override;
 
+        /* Push the updates of the given children to our repo as a single update and promote each of them. */
+        void PushCollapsed(
+            const std::unique_ptr<Indy::L1::TTransaction, std::function<void (Indy::L1::TTransaction *)>> &transaction,
+            const std::vector<TChild *> &children);
+
+        /* The most child updates we'll collapse into one in a single round.  This is also the most children we'll consider, and so test,
+           in a round. */
+        static const size_t MaxCollapsedUpdates;
+
         /* Our manager.  Never null. */
         TRepoTetrisManager *RepoTetrisManager;
 
@@ -29,13 +29,18 @@
 #include <io/binary_input_only_stream.h>
 #include <io/binary_io_stream.h>
 #include <io/device.h>
+#include <io/endian.h>
 #include <orly/atom/core_vector.h>
 #include <orly/indy/disk/durable_manager.h>
 #include <orly/mynde/binary_protocol.h>
 #include <orly/mynde/protocol.h>
+#include <orly/mynde/response_batch.h>
+#include <orly/mynde/text_proto.h>
 #include <orly/mynde/value.h>
 #include <orly/protocol.h>
 #include <orly/sabot/to_native.h>
+#include <server/counter.h>
+#include <server/latency_histogram.h>
 #include <strm/fd.h>
 #include <strm/bin/in.h>
 #include <strm/bin/out.h>
@@ -65,6 +70,10 @@ static const size_t BlockSize = Disk::Util::PhysicalBlockSize;
 //static const size_t StackSize = 8 * 1024 * 1024;
 static const size_t StackSize = 1 * 1024 * 1024;
 
+/* Under --work_stealing, the disk merge runners steal only from one another, and so do the tetris helper runners. */
+static const size_t MergeDiskStealGroup = 1UL;
+static const size_t TetrisHelperStealGroup = 2UL;
+
 Orly::Indy::Util::TLocklessPool Disk::TDurableManager::TMapping::Pool(sizeof(Disk::TDurableManager::TMapping), "Durable Mapping");
 Orly::Indy::Util::TLocklessPool Disk::TDurableManager::TMapping::TEntry::Pool(sizeof(Disk::TDurableManager::TMapping::TEntry), "Durable Mapping Entry");
 Orly::Indy::Util::TPool Disk::TDurableManager::TDurableLayer::Pool(std::max(sizeof(Disk::TDurableManager::TMemSlushLayer), sizeof(Disk::TDurableManager::TDiskOrderedLayer)), "Durable Layer");
@@ -116,6 +125,14 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
     &TCmd::MemcachePortNumber, "memcache_port_number", Optional, "memcache_port_number\0",
       "The port on which the server listens for Memcache protocol clients."
   );
+  Param(
+    &TCmd::MemcacheSweepInterval, "memcache_sweep_interval", Optional, "memcache_sweep_interval\0",
+      "The minimum number of milliseconds between sweeps for expired memcache keys."
+  );
+  Param(
+    &TCmd::MemcacheSweepBatchSize, "memcache_sweep_batch_size", Optional, "memcache_sweep_batch_size\0",
+      "The most expired memcache keys to tombstone in one update."
+  );
   Param(
       &TCmd::SlavePortNumber, "slave_port_number", Optional, "slave_port_number\0spn\0",
       "The port on which the server listens for a slave."
@@ -196,6 +213,18 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
       &TCmd::MergeDiskInterval, "merge_disk_interval", Optional, "merge_disk_interval\0",
       "The minimum number of milliseconds between merges of disk layers of a specific size category, in a specific repo."
   );
+  Param(
+      &TCmd::CompactionMinWidth, "compaction_min_width", Optional, "compaction_min_width\0",
+      "The fewest disk layers of one size tier to merge together."
+  );
+  Param(
+      &TCmd::CompactionMaxWidth, "compaction_max_width", Optional, "compaction_max_width\0",
+      "The most disk layers to merge at once."
+  );
+  Param(
+      &TCmd::CompactionMaxReadLayers, "compaction_max_read_layers", Optional, "compaction_max_read_layers\0",
+      "The most disk layers a repo can have before they are merged regardless of size tier."
+  );
   Param(
       &TCmd::ReplicationInterval, "replication_interval", Optional, "replication_interval\0",
       "The minimum number of milliseconds between replication batches sent to the slave."
@@ -224,6 +253,14 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
       &TCmd::NumWsThreads, "num_ws_threads", Optional, "num_ws_threads\0",
       "The number of threads to use to answer websocket requests."
   );
+  Param(
+      &TCmd::NumTetrisThreads, "num_tetris_threads", Optional, "num_tetris_threads\0",
+      "The number of threads testing tetris assertions alongside the one playing tetris. 0 means test them all on that one."
+  );
+  Param(
+      &TCmd::WorkStealing, "work_stealing", Optional, "work_stealing\0",
+      "Turn on / off work stealing among the disk merge threads, and separately among the tetris helper threads."
+  );
   Param(
       &TCmd::MaxRepoCacheSize, "max_repo_cache_size", Optional, "max_repo_cache_size\0",
       "The maximum number of unused repos that can be held in memory."
@@ -284,6 +321,30 @@ TServer::TCmd::TMeta::TMeta(const char *desc)
       &TCmd::NoRealtime, "no_realtime", Optional, "no_realtime\0",
       "Do not use realtime thread priorities (realtime priorities require root privileges)."
   );
+  Param(
+      &TCmd::DiskBackend, "disk_backend", Optional, "disk_backend\0",
+      "The kernel interface for disk I/O: aio, io_uring, or io_uring_polled (NVMe devices with poll queues only)."
+  );
+  Param(
+      &TCmd::CachePolicy, "cache_policy", Optional, "cache_policy\0",
+      "The replacement policy of the page and block caches: lru, or 2q to keep scans from flushing the working set."
+  );
+  Param(
+      &TCmd::ArenaCodec, "arena_codec", Optional, "arena_codec\0",
+      "How the arenas of newly written data files are stored: none, or snappy to trade CPU on flush, merge and cold reads for disk space."
+  );
+  Param(
+      &TCmd::BackgroundIoMBPerSec, "background_io_mb_per_sec", Optional, "background_io_mb_per_sec\0",
+      "The most MB/s of merge and flush I/O to let at each device. 0 means no limit."
+  );
+  Param(
+      &TCmd::BackgroundIops, "background_iops", Optional, "background_iops\0",
+      "The most merge and flush I/Os per second to let at each device. 0 means no limit."
+  );
+  Param(
+      &TCmd::ReadLatencyTargetUs, "read_latency_target_us", Optional, "read_latency_target_us\0",
+      "The p99 foreground read latency, in microseconds, to hold each device under by scaling back its background I/O budget. 0 means don't adapt."
+  );
   Param(
       &TCmd::DoFsync, "do_fsync", Optional, "do_fsync\0",
       "Turn on / off use of fsync on disk writes that change server state."
@@ -369,8 +430,6 @@ class TIndexIdReader
 
   virtual ~TIndexIdReader() {}
 
-  using TReadFile::GetIndexByIdMap;
-
   using TReadFile::TIndexFile;
 };
 
@@ -379,6 +438,8 @@ TServer::TCmd::TCmd()
       WsPortNumber(8082),
       EnableMemcache(false),
       MemcachePortNumber(11211), // Memcache default port number
+      MemcacheSweepInterval(60000),
+      MemcacheSweepBatchSize(10000),
       SlavePortNumber(DefaultSlavePortNumber),
       ConnectionBacklog(5000),
       DurableCacheSize(10000),
@@ -398,12 +459,17 @@ TServer::TCmd::TCmd()
       ReplicationSyncBufMB(32),
       MergeMemInterval(40),
       MergeDiskInterval(10),
+      CompactionMinWidth(Indy::TCompactionPlanner::DefaultMinWidth),
+      CompactionMaxWidth(Indy::TCompactionPlanner::DefaultMaxWidth),
+      CompactionMaxReadLayers(Indy::TCompactionPlanner::DefaultMaxReadLayers),
       ReplicationInterval(100),
       DurableWriteInterval(40),
       DurableMergeInterval(10),
       NumMemMergeThreads(3),
       NumDiskMergeThreads(8),
       NumWsThreads(4),
+      NumTetrisThreads(4),
+      WorkStealing(false),
       MaxRepoCacheSize(10000),
       NumFiberFrames(1000UL),
       NumDiskEvents(10000UL),
@@ -411,6 +477,12 @@ TServer::TCmd::TCmd()
       AllowTailing(true),
       AllowFileSync(true),
       NoRealtime(false),
+      DiskBackend("aio"),
+      CachePolicy("lru"),
+      ArenaCodec("none"),
+      BackgroundIoMBPerSec(0UL),
+      BackgroundIops(0UL),
+      ReadLatencyTargetUs(0UL),
       DoFsync(true),
       LogAssertionFailures(true),
       DurableMappingPoolSize(1000UL),
@@ -647,6 +719,14 @@ TServer::TCmd::TCmd()
   }
 }
 
+bool TServer::TCmd::CheckArgs(const TMeta::TMessageConsumer &cb) {
+  assert(this);
+  if (!MemcacheSweepBatchSize && !cb("memcache_sweep_batch_size must be at least 1")) {
+    return false;
+  }
+  return Base::TLog::TCmd::CheckArgs(cb);
+}
+
 TServer::TServer(TScheduler *scheduler, const TCmd &cmd)
     : TSession::TServer(cmd.SlowCoreVec.size() +
                         cmd.FastCoreVec.size() +
@@ -676,7 +756,8 @@ TServer::TServer(TScheduler *scheduler, const TCmd &cmd)
       PackageManager(cmd.PackageDirectory),
       Scheduler(scheduler),
       Cmd(cmd),
-      HousecleaningTimer(chrono::milliseconds(cmd.HousecleaningInterval)) {
+      HousecleaningTimer(chrono::milliseconds(cmd.HousecleaningInterval)),
+      MemcacheSweepTimer(chrono::milliseconds(cmd.MemcacheSweepInterval)) {
   InitalizeFramePoolManager(Cmd.NumFiberFrames, StackSize, &BGFastRunner);
   Disk::Util::TDiskController::TEvent::InitializeDiskEventPoolManager(Cmd.NumDiskEvents);
   using TLocalReadFileCache = Orly::Indy::Disk::TLocalReadFileCache<Orly::Indy::Disk::Util::LogicalPageSize,
@@ -844,7 +925,7 @@ void TServer::Init() {
       bool is_new = ret.second;
       if (is_new) {
         assert(RepoManager);
-        RepoManager->SaveIndexNamespaceMapping(idx_id, pkg_key);
+        RepoManager->SaveIndexNamespaceMapping(idx_id, pkg_key, ret.first->first.GetVal());
         IndexIdSet.insert(idx_id);
         stringstream ss;
         ss << "Replicating index [" << idx_id << "] " << pkg_key << " <- ";
@@ -885,7 +966,10 @@ void TServer::Init() {
           8 /* num block lru */,
           Cmd.FileServiceAppendLogMB,
           Cmd.Create,
-          Cmd.NoRealtime);
+          Cmd.NoRealtime,
+          Disk::Util::TDiskController::ParseBackend(Cmd.DiskBackend),
+          Disk::Util::ParseCachePolicy(Cmd.CachePolicy),
+          Disk::Util::TIoBudget::TConfig(Cmd.BackgroundIoMBPerSec * 1024UL * 1024UL, Cmd.BackgroundIops, chrono::microseconds(Cmd.ReadLatencyTargetUs)));
       engine_ptr = DiskEngine->GetEngine();
     }
     assert(engine_ptr);
@@ -939,6 +1023,8 @@ void TServer::Init() {
                                                     Cmd.MemMergeCoreVec,
                                                     Cmd.DiskMergeCoreVec,
                                                     Cmd.Create);
+    RepoManager->SetCompactionPlanner(Indy::TCompactionPlanner(Cmd.CompactionMinWidth, Cmd.CompactionMaxWidth, Cmd.CompactionMaxReadLayers));
+    RepoManager->SetArenaCodec(Disk::ParseArenaCodec(Cmd.ArenaCodec));
     auto global_ttl = TTtl::max();
     GlobalRepo = RepoManager->GetRepo(TSession::GlobalPovId,
                                       global_ttl,
@@ -950,64 +1036,101 @@ void TServer::Init() {
     void *val_type_alloc = alloca(Sabot::Type::GetMaxTypeSize());
 
     /* figure out what index ids we currently support */ {
+      /* Everything we've saved an index type for comes back in one walk of the system repo.  Only indices saved before we kept their
+         types need us to open the data files and look at their first keys. */
       std::unordered_map<Base::TUuid, std::string> pkg_key_mapping;
-      Indy::Fiber::TJumpRunnable idns_jumper([this, &pkg_key_mapping] {
+      Indy::Fiber::TJumpRunnable idns_jumper([this, val_type_alloc, &pkg_key_mapping] {
           pkg_key_mapping = RepoManager->GetIndexNamespaceMapping();
+          std::lock_guard<std::mutex> lock(IndexMapMutex);
+          RepoManager->ForEachSavedIndex([this, val_type_alloc](const Base::TUuid &idx_id, const std::string &pkg_key, const Indy::TKey &val) {
+            Sabot::Type::TAny::TWrapper val_type_wrapper(val.GetCore().GetType(val.GetArena(), val_type_alloc));
+            auto ret = IndexByIndexId.emplace(
+                TIndexType(string(pkg_key), TKey(Atom::TCore(&IndexMapArena, *val_type_wrapper), &IndexMapArena)),
+                idx_id);
+            if (ret.second) {
+              IndexIdSet.insert(idx_id);
+              stringstream ss;
+              ss << "Restoring index [" << idx_id << "] " << pkg_key << " <- ";
+              val_type_wrapper->Accept(Sabot::TTypeDumper(ss));
+              syslog(LOG_INFO, "%s\n", ss.str().c_str());
+            }
+          });
       });
       idns_jumper(FramePoolManager.get(), &BGFastRunner);
-      //auto pkg_key_mapping = RepoManager->GetIndexNamespaceMapping();
-      std::lock_guard<std::mutex> lock(IndexMapMutex);
-      engine_ptr->ForEachFile([engine_ptr, this, key_type_alloc, val_type_alloc, &pkg_key_mapping](const Base::TUuid &file_uid,
-                                                                                                   const Indy::Disk::TFileObj &file_obj) {
-        if (file_uid != Indy::TManager::SystemRepoId) {
-          switch (file_obj.Kind) {
-            case Indy::Disk::TFileObj::TKind::DataFile: {
-              TIndexIdReader reader(engine_ptr, file_uid, Indy::Disk::RealTime, file_obj.GenId, file_obj.StartingBlockId, file_obj.StartingBlockOffset, file_obj.FileSize);
-              auto main_arena = make_unique<TIndexIdReader::TArena>(&reader, engine_ptr->GetCache<TIndexIdReader::PhysicalCachePageSize>(), Orly::Indy::Disk::RealTime);
-              const auto &index_map = reader.GetIndexByIdMap();
-              for (const auto &idx_pair : index_map) {
-                const auto &idx_file = idx_pair.second;
-                auto index_arena = make_unique<TIndexIdReader::TArena>(idx_file.get(), engine_ptr->GetCache<TIndexIdReader::PhysicalCachePageSize>(), Orly::Indy::Disk::RealTime);
-                TIndexIdReader::TIndexFile::TKeyCursor csr(idx_file.get());
-                if (csr) {
-                  TKey key((*csr).Key, index_arena.get());
-                  TKey val((*csr).Value, main_arena.get());
-
-                  //const string &pkg_key = Sabot::AsNative<string>(*Sabot::State::TAny::TWrapper(key.GetState(key_type_alloc)));
-                  auto pkg_key_pos = pkg_key_mapping.find(idx_pair.first);
-                  if (pkg_key_pos == pkg_key_mapping.end()) {
+      std::unordered_set<Base::TUuid> unsaved_index_id_set;
+      /* acquire IndexMap lock */ {
+        std::lock_guard<std::mutex> lock(IndexMapMutex);
+        for (const auto &pkg_key_pair : pkg_key_mapping) {
+          if (IndexIdSet.find(pkg_key_pair.first) == IndexIdSet.end()) {
+            unsaved_index_id_set.insert(pkg_key_pair.first);
+          }
+        }
+      }  // release IndexMap lock
+      if (!unsaved_index_id_set.empty()) {
+        std::vector<std::pair<Base::TUuid, const TIndexType *>> to_save_vec;
+        std::lock_guard<std::mutex> lock(IndexMapMutex);
+        engine_ptr->ForEachFile([engine_ptr, this, key_type_alloc, val_type_alloc, &pkg_key_mapping, &unsaved_index_id_set, &to_save_vec](
+            const Base::TUuid &file_uid, const Indy::Disk::TFileObj &file_obj) {
+          if (file_uid != Indy::TManager::SystemRepoId) {
+            switch (file_obj.Kind) {
+              case Indy::Disk::TFileObj::TKind::DataFile: {
+                TIndexIdReader reader(engine_ptr, file_uid, Indy::Disk::RealTime, file_obj.GenId, file_obj.StartingBlockId, file_obj.StartingBlockOffset, file_obj.FileSize);
+                auto main_arena = make_unique<TIndexIdReader::TArena>(&reader, engine_ptr->GetCache<TIndexIdReader::PhysicalCachePageSize>(), Orly::Indy::Disk::RealTime);
+                reader.ForEachIndex([&](const Base::TUuid &idx_id, size_t) {
+                  if (pkg_key_mapping.find(idx_id) == pkg_key_mapping.end()) {
                     stringstream ss;
-                    ss << idx_pair.first;
+                    ss << idx_id;
                     syslog(LOG_ERR, "Could not find package namespace for index id [%s]\n", ss.str().c_str());
                     abort();
                   }
-                  const string &pkg_key = pkg_key_pos->second;
-
-                  Sabot::Type::TAny::TWrapper key_type_wrapper(key.GetCore().GetType(index_arena.get(), key_type_alloc));
-                  Sabot::Type::TAny::TWrapper val_type_wrapper(val.GetCore().GetType(main_arena.get(), val_type_alloc));
-
-                  auto ret = IndexByIndexId.emplace(
-                      TIndexType(string(pkg_key), TKey(Atom::TCore(&IndexMapArena, *val_type_wrapper), &IndexMapArena)),
-                      idx_pair.first);
-                  bool is_new = ret.second;
-                  if (is_new) {
-                    IndexIdSet.insert(idx_pair.first);
-                    stringstream ss;
-                    ss << "Loading index [" << idx_pair.first << "] " << pkg_key << " <- ";
-                    val_type_wrapper->Accept(Sabot::TTypeDumper(ss));
-                    syslog(LOG_INFO, "%s\n", ss.str().c_str());
+                  if (unsaved_index_id_set.find(idx_id) == unsaved_index_id_set.end()) {
+                    return;
                   }
-                }
+                  TIndexIdReader::TIndexFile *idx_file = reader.TryGetIndexFile(idx_id);
+                  assert(idx_file);
+                  auto index_arena = make_unique<TIndexIdReader::TArena>(idx_file, engine_ptr->GetCache<TIndexIdReader::PhysicalCachePageSize>(), Orly::Indy::Disk::RealTime);
+                  TIndexIdReader::TIndexFile::TKeyCursor csr(idx_file);
+                  if (csr) {
+                    TKey key((*csr).Key, index_arena.get());
+                    TKey val((*csr).Value, main_arena.get());
+
+                    //const string &pkg_key = Sabot::AsNative<string>(*Sabot::State::TAny::TWrapper(key.GetState(key_type_alloc)));
+                    const string &pkg_key = pkg_key_mapping.find(idx_id)->second;
+
+                    Sabot::Type::TAny::TWrapper key_type_wrapper(key.GetCore().GetType(index_arena.get(), key_type_alloc));
+                    Sabot::Type::TAny::TWrapper val_type_wrapper(val.GetCore().GetType(main_arena.get(), val_type_alloc));
+
+                    auto ret = IndexByIndexId.emplace(
+                        TIndexType(string(pkg_key), TKey(Atom::TCore(&IndexMapArena, *val_type_wrapper), &IndexMapArena)),
+                        idx_id);
+                    bool is_new = ret.second;
+                    if (is_new) {
+                      IndexIdSet.insert(idx_id);
+                      to_save_vec.emplace_back(idx_id, &ret.first->first);
+                      stringstream ss;
+                      ss << "Loading index [" << idx_id << "] " << pkg_key << " <- ";
+                      val_type_wrapper->Accept(Sabot::TTypeDumper(ss));
+                      syslog(LOG_INFO, "%s\n", ss.str().c_str());
+                    }
+                  }
+                });
+                break;
+              }
+              case Indy::Disk::TFileObj::TKind::DurableFile: {
+                break;
               }
-              break;
-            }
-            case Indy::Disk::TFileObj::TKind::DurableFile: {
-              break;
             }
           }
-        }
-        return true;
-      });
+          return true;
+        });
+        /* save the types we had to dig out, so the next start doesn't have to */
+        Indy::Fiber::TJumpRunnable save_jumper([this, &to_save_vec] {
+            for (const auto &to_save : to_save_vec) {
+              RepoManager->SaveIndexNamespaceMapping(to_save.first, to_save.second->GetPackageKey(), to_save.second->GetVal());
+            }
+        });
+        save_jumper(FramePoolManager.get(), &BGFastRunner);
+      }
     }
 
     /* TODO : durable manager does not support create=false */
@@ -1053,7 +1176,7 @@ void TServer::Init() {
       Disk::TLocalWalkerCache::Cache = new Disk::TLocalWalkerCache();
     };
 
-    TetrisManager = new TRepoTetrisManager(Scheduler, RunnerCons, FramePoolManager.get(), tetris_runner_setup_cb, (RepoState == Orly::Indy::TManager::Solo), RepoManager.get(), &PackageManager, DurableManager.get(), Cmd.LogAssertionFailures);
+    TetrisManager = new TRepoTetrisManager(Scheduler, RunnerCons, FramePoolManager.get(), tetris_runner_setup_cb, Cmd.NumTetrisThreads, Cmd.WorkStealing ? TetrisHelperStealGroup : Fiber::TRunner::NoStealGroup, (RepoState == Orly::Indy::TManager::Solo), RepoManager.get(), &PackageManager, DurableManager.get(), Cmd.LogAssertionFailures);
     RepoManager->SetTetrisManager(TetrisManager);
     /* schedule everything the repo manager needs */ {
       /* Read() from master / slave */ {
@@ -1115,11 +1238,16 @@ void TServer::Init() {
         MergeMemFrameVec.emplace_back(frame);
         //Scheduler->Schedule(bind(&Orly::Indy::L0::TManager::RunMergeMem, RepoManager.get()));
       }
-      /* Merge multiple disk files of a specific size category, in the same safe repo. */
+      /* Merge multiple disk files of a specific size category, in the same safe repo.  Each merge may also farm work out to the other
+         merge runners, so they all have to be known before any merge starts. */
+      std::vector<Fiber::TRunner *> merge_disk_runners;
       for (size_t i = 0; i < Cmd.NumDiskMergeThreads; ++i) {
-        MergeDiskRunnerVec.emplace_back(new Fiber::TRunner(RunnerCons));
-        Fiber::TRunner *cur_runner = MergeDiskRunnerVec.back().get();
-        Scheduler->Schedule(std::bind(Fiber::LaunchSlowFiberSched, cur_runner, FramePoolManager.get()));
+        MergeDiskRunnerVec.emplace_back(new Fiber::TRunner(RunnerCons, Cmd.WorkStealing ? MergeDiskStealGroup : Fiber::TRunner::NoStealGroup));
+        merge_disk_runners.push_back(MergeDiskRunnerVec.back().get());
+        Scheduler->Schedule(std::bind(Fiber::LaunchSlowFiberSched, merge_disk_runners.back(), FramePoolManager.get()));
+      }
+      RepoManager->SetMergeDiskRunners(merge_disk_runners);
+      for (Fiber::TRunner *cur_runner : merge_disk_runners) {
         Fiber::TFrame *frame = Fiber::TFrame::LocalFramePool->Alloc();
         try {
           frame->Latch(cur_runner, static_cast<Orly::Indy::L0::TManager *>(RepoManager.get()), static_cast<Fiber::TRunnable::TFunc>(&Orly::Indy::L0::TManager::RunMergeDisk));
@@ -1147,7 +1275,7 @@ void TServer::Init() {
         if (ret.second) {
           /* TODO: clean up the index_id_replication obj... refactor this logic into a function */
           assert(RepoManager);
-          RepoManager->SaveIndexNamespaceMapping(Mynde::MemcachedIndexUuid, pkg_key);
+          RepoManager->SaveIndexNamespaceMapping(Mynde::MemcachedIndexUuid, pkg_key, ret.first->first.GetVal());
           RepoManager->Enqueue(
               new TIndexIdReplication(Mynde::MemcachedIndexUuid, pkg_key, TKey(val_core, &IndexMapArena)));
           IndexIdSet.insert(Mynde::MemcachedIndexUuid);
@@ -1186,6 +1314,7 @@ void TServer::Init() {
         IfLt0(listen(MemcacheSocket, Cmd.ConnectionBacklog));
       }
       Scheduler->Schedule(bind(&TServer::AcceptClientConnections, this, true));
+      Scheduler->Schedule(bind(&TServer::SweepMemcache, this));
     }
 
     Scheduler->Schedule(bind(&TServer::CleanHouse, this));
@@ -1809,7 +1938,7 @@ string TServer::ImportCoreVector(const string &file_pattern,
                     } else {
                       /* TODO: replicate index id */
                       assert(Server->RepoManager);
-                      Server->RepoManager->SaveIndexNamespaceMapping(index_id, pkg_key);
+                      Server->RepoManager->SaveIndexNamespaceMapping(index_id, pkg_key, new_ret.first->first.GetVal());
                       index_id_remapper.emplace(index_id, index_id);
                       Server->IndexIdSet.insert(index_id);
 
@@ -2137,7 +2266,7 @@ void TServer::InstallPackage(const vector<string> &package_name, uint64_t versio
       } else {
         /* TODO: clean up the index_id_replication obj... refactor this logic into a function */
         assert(RepoManager);
-        RepoManager->SaveIndexNamespaceMapping(addr_pair.first, pkg_key);
+        RepoManager->SaveIndexNamespaceMapping(addr_pair.first, pkg_key, ret.first->first.GetVal());
         RepoManager->Enqueue(new TIndexIdReplication(addr_pair.first, pkg_key, TKey(val_core, &IndexMapArena)));
         IndexIdSet.insert(addr_pair.first);
       }
@@ -2260,6 +2389,20 @@ void TServer::ServeClient(TFd &fd, const TAddress &client_address) {
 template<uint64_t Length>
 constexpr uint64_t GetArrayLen(const char(&)[Length]) { return Length; }
 
+/* Memcache requests served, by kind.  A get batch is a run of gets the client sent back to back, which we answer from one context. */
+SERVER_COUNTER(MemcacheGets);
+SERVER_COUNTER(MemcacheGetHits);
+SERVER_COUNTER(MemcacheGetBatches);
+SERVER_COUNTER(MemcacheSets);
+
+/* Expired memcache keys tombstoned by the sweeper, and the updates it took to do it. */
+SERVER_COUNTER(MemcacheKeysSwept);
+SERVER_COUNTER(MemcacheSweepUpdates);
+
+/* Time spent in the repo per memcache get (one key) and set. */
+SERVER_LATENCY_HISTOGRAM(MemcacheGetLatency);
+SERVER_LATENCY_HISTOGRAM(MemcacheSetLatency);
+
 void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_address) {
   assert(this);
   assert(&fd_original);
@@ -2299,194 +2442,321 @@ void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_addr
   // TODO: Switch to a tri state that lives on the stack
   std::unique_ptr<Indy::TContext> context;
 
-  // TODO: Detect protocol here (binary or text). Currently we only support binary.
-  // Our input and output streams
-  // TODO: We want TRequest to genericize the binary and text streams to one thing.
-  // NOTE: We there should be no virtual calls in doing so.
+  // Our input stream, and the responses waiting to go back out.
+  // NOTE: Responses pile up in the batch while the client has more requests waiting for us, then go out in one vectored write.
   Strm::Bin::TIn in(&strm);
-  Strm::Bin::TOut out(&strm);
+  Mynde::TResponseBatch batch;
+  const int fd = strm.GetFd();
+
+  // Look up every one of the given keys against the current context, switching to a fast runner once for the lot rather than once
+  // per key. Each key which is set gets its value in the same position in 'values' and true in 'found'.
+  std::vector<Mynde::TValue> values;
+  std::vector<bool> found;
+  auto get_all = [&](const std::vector<Native::TBlob> &keys) {
+    values.clear();
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+    size_t prev_assignment_count = std::atomic_fetch_add(&SlowAssignmentCounter, 1UL);
+    Indy::Fiber::TSwitchToRunner switch_to_runner(FastRunnerVec[prev_assignment_count % FastRunnerVec.size()].get());
+    if (!context) {
+      context = make_unique<Indy::TContext>(repo, &context_arena);
+    }
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    const int64_t now = system_clock::to_time_t(system_clock::now());
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      // TODO: We don't have any reason to go from atom -> Sabot
+      // TODO: The IndexKey has more stuff in it than we need / care about.
+      Mynde::TKey key{keys[i]};
+      Indy::TIndexKey indy_index_key(
+          Mynde::MemcachedIndexUuid,
+          Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc))));
+      auto response_value = context->TryGet(indy_index_key);
+      if (response_value) {
+        Mynde::ReadValue(*Sabot::State::TAny::TWrapper(response_value->GetState(state_alloc)), values[i]);
+        // NOTE: An expired value reads as a miss until the sweeper gets around to tombstoning it.
+        found[i] = !Mynde::IsExpired(values[i], now);
+      }
+      const auto stop = steady_clock::now();
+      MemcacheGetLatency.Record(stop - start);
+      start = stop;
+    }
+    MemcacheGets.Increment(keys.size());
+    MemcacheGetHits.Increment(count(found.begin(), found.end(), true));
+    MemcacheGetBatches.Increment();
+  };
+
+  // Store the value under the key in a transaction of its own, on a fast runner. Our context is stale after this.
+  auto set = [&](const Native::TBlob &key_blob, Mynde::TValue &&value) {
+    const auto start = steady_clock::now();
+    size_t prev_assignment_count = std::atomic_fetch_add(&SlowAssignmentCounter, 1UL);
+    Indy::Fiber::TSwitchToRunner switch_to_runner(FastRunnerVec[prev_assignment_count % FastRunnerVec.size()].get());
+    Mynde::TKey key{key_blob};
+
+    auto transaction = RepoManager->NewTransaction();
+    TUuid update_id(TUuid::Twister);
+
+    // TODO: The package_fq_name should be a constant somewhere.
+    // TODO: That we have to feed a package name and method name here seems like it might cause trouble later.
+    TMetaRecord meta_record(update_id,
+                            TMetaRecord::TEntry(session->GetId(),
+                                                session->GetUserId(),
+                                                Orly::Mynde::PackageName,
+                                                "set",
+                                                {},
+                                                {},
+                                                Base::Chrono::CreateTimePnt(2014, 3, 23, 0, 0, 0, 0, 0),
+                                                0));
+
+    void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
+    void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+    void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+    void *state_alloc_3 = alloca(Sabot::State::GetMaxStateSize());
+    auto update = Indy::TUpdate::NewUpdate(
+        TUpdate::TOpByKey{
+            {Indy::TIndexKey(
+                 Mynde::MemcachedIndexUuid,
+                 Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc)))),
+             Indy::TKey(&context_arena,
+                        Sabot::State::TAny::TWrapper(Native::State::New(value, state_alloc_1))), }},
+        Indy::TKey(meta_record, &context_arena, state_alloc_2),
+        Indy::TKey(update_id, &context_arena, state_alloc_3));
+    transaction->Push(repo, update);
+    transaction->Prepare();
+    transaction->CommitAction();
+    context.reset();
+    MemcacheSets.Increment();
+    MemcacheSetLatency.Record(steady_clock::now() - start);
+  };
+
+  // The keys of the gets in the current batch.
+  std::vector<Native::TBlob> keys;
 
   try {
     // TODO: Detect and handle eof without an exception?
 
     if (in.Peek() != Mynde::BinaryMagicRequest) {
-      const char err_msg[] = "SERVER_ERROR text protocol is not supported.\r\n";
-      out.Write(err_msg, GetArrayLen(err_msg));
+      /* text protocol */
+      std::vector<std::unique_ptr<Mynde::TTextRequest>> get_vec;
+      std::unique_ptr<Mynde::TTextRequest> req;
+      for (bool quit = false; !quit;) {
+        try {
+          if (!req) {
+            req.reset(new Mynde::TTextRequest(in));
+          }
+          if (req->GetCommand() == Mynde::TTextRequest::TCommand::Get || req->GetCommand() == Mynde::TTextRequest::TCommand::Gets) {
+            // Gather up every get the client has already sent, so they can all be answered from one context.
+            get_vec.clear();
+            keys.clear();
+            do {
+              keys.insert(keys.end(), req->GetKeys().begin(), req->GetKeys().end());
+              get_vec.push_back(move(req));
+              if (!in.HasBuffered()) {
+                break;
+              }
+              req.reset(new Mynde::TTextRequest(in));
+            } while (req->GetCommand() == Mynde::TTextRequest::TCommand::Get ||
+                     req->GetCommand() == Mynde::TTextRequest::TCommand::Gets);
+            get_all(keys);
+            size_t key_idx = 0;
+            for (const auto &get : get_vec) {
+              for (const auto &key : get->GetKeys()) {
+                if (found[key_idx]) {
+                  Mynde::WriteTextValue(batch, key, values[key_idx].Flags, move(values[key_idx].Value),
+                                        get->GetCommand() == Mynde::TTextRequest::TCommand::Gets);
+                }
+                ++key_idx;
+              }
+              batch.Write("END\r\n", 5);
+            }
+            // A text client has no way to ask for a consistent series of gets, so each batch sees the latest.
+            context.reset();
+          }
+          if (req) {
+            switch (req->GetCommand()) {
+              case Mynde::TTextRequest::TCommand::Get:
+              case Mynde::TTextRequest::TCommand::Gets: {
+                assert(false);
+                break;
+              }
+              case Mynde::TTextRequest::TCommand::Set: {
+                set(req->GetKeys()[0],
+                    Mynde::TValue{move(req->GetValue()),
+                                  req->GetFlags(),
+                                  Mynde::GetExpiresAt(req->GetExpiration(), system_clock::to_time_t(system_clock::now()))});
+                if (!req->IsNoReply()) {
+                  batch.Write("STORED\r\n", 8);
+                }
+                break;
+              }
+              case Mynde::TTextRequest::TCommand::Version: {
+                batch.Write("VERSION orly\r\n");
+                break;
+              }
+              case Mynde::TTextRequest::TCommand::Quit: {
+                quit = true;
+                break;
+              }
+              case Mynde::TTextRequest::TCommand::Unknown: {
+                batch.Write("ERROR\r\n", 7);
+                break;
+              }
+            }
+            req.reset();
+          }
+        } catch (const std::invalid_argument &ex) {
+          // We can't tell where the next request starts, so this ends the connection.
+          batch.Write(string("CLIENT_ERROR ") + ex.what() + "\r\n");
+          quit = true;
+        }
+        if (quit || !in.HasBuffered()) {
+          batch.Flush(fd);
+        }
+      }
       return;
     }
 
     bool Quit = false;
 
+    // Gets read in behind the current batch, waiting for the next lap.
+    std::vector<std::unique_ptr<Mynde::TRequest>> get_vec;
+    std::unique_ptr<Mynde::TRequest> req;
+
     // Loop processing requets until we hit eof or explicitly get an exit command.
     // TODO: Detect and handle eof without an exception?
     while(!Quit) {
       // TODO: We should probably wait for notifications from indy somewhere...
-      // NOTE: We make this on the heap so that we can pass it to the response generation thread
-      // We do the two threads because the protocol states that pending unread responses shouldn't block requests from
-      // being read / handled
-      Mynde::TRequest req(in);
-
-      size_t prev_assignment_count = std::atomic_fetch_add(&SlowAssignmentCounter, 1UL);
-      auto switch_to_runner =
-          make_unique<Indy::Fiber::TSwitchToRunner>(FastRunnerVec[prev_assignment_count % FastRunnerVec.size()].get());
-      // TODO: Build up the response in this. Call 'fire' when the whole response is built.
-      // TResponseBuilder resp(req);
-
-      if (req.GetFlags().Key && req.GetOpcode() != Mynde::TRequest::TOpcode::Get) {
-        // TODO: This needs to be a binary error message....
-        const char err_msg[] = "SERVER_ERROR Only Get is allowed to return the key (GetK, GetKQ).\r\n";
-        out.Write(err_msg, GetArrayLen(err_msg));
-        return;  // Closes the RAII connection
+      if (!req) {
+        req.reset(new Mynde::TRequest(in));
       }
 
-      Mynde::TResponseHeader hdr;
-      Zero(hdr);
-      hdr.Magic = Mynde::BinaryMagicResponse;
-      hdr.Opcode = req.GetBinaryOpcode();
-      hdr.Opaque = req.GetOpaque();
-
-
-      // TODO: Genericize memcache key -> indy key conversion (Make it a function)
-      switch (req.GetOpcode()) {
-        case Mynde::TRequest::TOpcode::Get: {
-          if (!context) {
-            context = make_unique<Indy::TContext>(repo, &context_arena);
-          }
-
+      if (req->GetOpcode() == Mynde::TRequest::TOpcode::Get) {
+        // Gather up every get the client has already sent (typically a run of GetQ / GetKQ ending in a NoOp), so they can all be
+        // answered from one context.
+        get_vec.clear();
+        keys.clear();
+        do {
           // TODO: Change keys and values to be start, limit based rather than doing this std::string marshalling
-          Mynde::TKey key{{req.GetKey().GetData(), req.GetKey().GetSize()}};
-
-          // Perform the Get
-          // TODO: We don't have any reason to go from atom -> Sabot
-          // TODO: The IndexKey has more stuff in it than we need / care about.
-          void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-          Indy::TIndexKey indy_index_key(
-              Mynde::MemcachedIndexUuid,
-              Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc))));
-          if (req.GetFlags().Key) {
-            hdr.KeyLength = req.GetKey().GetSize();
+          keys.emplace_back(req->GetKey().GetData(), req->GetKey().GetSize());
+          get_vec.push_back(move(req));
+          if (!in.HasBuffered()) {
+            break;
           }
-          if (!context->Exists(indy_index_key)) {
-            syslog(LOG_INFO, "Get of unset key %s", std::get<0>(key).c_str());
-            hdr.Status = Mynde::TResponseStatus::KeyNotFound;
-            switch_to_runner.reset();
-            hdr.TotalBodyLength = hdr.KeyLength + 9;
-            if (!req.GetFlags().Quiet) {
-              out << hdr;
-              if (req.GetFlags().Key) {
-                out << req.GetKey();
-              }
+          req.reset(new Mynde::TRequest(in));
+        } while (req->GetOpcode() == Mynde::TRequest::TOpcode::Get);
+        get_all(keys);
+        for (size_t i = 0; i < get_vec.size(); ++i) {
+          const Mynde::TRequest &get = *get_vec[i];
+          Mynde::TResponseHeader hdr;
+          Zero(hdr);
+          hdr.Magic = Mynde::BinaryMagicResponse;
+          hdr.Opcode = get.GetBinaryOpcode();
+          hdr.Opaque = get.GetOpaque();
+          if (get.GetFlags().Key) {
+            hdr.KeyLength = get.GetKey().GetSize();
+          }
+          if (!found[i]) {
+            if (!get.GetFlags().Quiet) {
               const char err_msg[] = "Not found";
               static_assert(GetArrayLen(err_msg) == 10, "Value is longer than expected...");
-              out.Write(err_msg, GetArrayLen(err_msg)-1);
+              hdr.Status = Mynde::TResponseStatus::KeyNotFound;
+              hdr.TotalBodyLength = hdr.KeyLength + 9;
+              batch << hdr;
+              if (get.GetFlags().Key) {
+                batch.Write(get.GetKey().GetData(), get.GetKey().GetSize());
+              }
+              batch.Write(err_msg, GetArrayLen(err_msg) - 1);
             }
           } else {
-            Indy::TKey response_value = (*context)[indy_index_key];
-            syslog(LOG_INFO, "Get of set key %s", std::get<0>(key).c_str());
-            Mynde::TValue value;
-            ToNative(*Sabot::State::TAny::TWrapper(response_value.GetState(state_alloc)), value);
+            Mynde::TValue &value = values[i];
             static_assert(sizeof(value.Flags) == 4, "Sanity check the flags are indeed 4 bytes.");
             hdr.ExtrasLength = 4;
             hdr.TotalBodyLength = value.Value.size() + 4 + hdr.KeyLength;
-
-            switch_to_runner.reset();
-            out << hdr;
-            out.WriteShallow(value.Flags);
-            if (req.GetFlags().Key) {
-              out << req.GetKey();
+            batch << hdr;
+            batch.WriteShallow(SwapEnds(value.Flags));
+            if (get.GetFlags().Key) {
+              batch.Write(get.GetKey().GetData(), get.GetKey().GetSize());
             }
-            out.Write(value.Value.c_str(), value.Value.size());
+            batch.Write(move(value.Value));
           }
-          break;
         }
-        case Mynde::TRequest::TOpcode::Set: {
+      }
 
-          // First 4 bytes are flags
-          uint32_t Flags = *(req.GetExtras().GetData());
+      if (req) {
+        if (req->GetFlags().Key && req->GetOpcode() != Mynde::TRequest::TOpcode::Get) {
+          // TODO: This needs to be a binary error message....
+          batch.Write("SERVER_ERROR Only Get is allowed to return the key (GetK, GetKQ).\r\n");
+          batch.Flush(fd);
+          return;  // Closes the RAII connection
+        }
 
-          // Second 4 bytes are expiration
-          uint32_t Expiration = *(req.GetExtras().GetData() + 4);
+        Mynde::TResponseHeader hdr;
+        Zero(hdr);
+        hdr.Magic = Mynde::BinaryMagicResponse;
+        hdr.Opcode = req->GetBinaryOpcode();
+        hdr.Opaque = req->GetOpaque();
 
-          // We currently only allow keys which have no timeout / are persistent
-          if (Expiration != 0) {
-            // TODO: Return a proper binary error
-            // TODO: Throw an exception to close out the server ina  well logged way
-            const char err_msg[] = "SERVER_ERROR Only keys without an expiration are allowed (Expiration = 0)";
-            out.Write(err_msg, GetArrayLen(err_msg));
-            return;
+        // TODO: Genericize memcache key -> indy key conversion (Make it a function)
+        switch (req->GetOpcode()) {
+          case Mynde::TRequest::TOpcode::Get: {
+            assert(false);
+            break;
           }
+          case Mynde::TRequest::TOpcode::Set: {
+
+            if (req->GetExtras().GetSize() != 8) {
+              // TODO: Return a proper binary error
+              batch.Write("SERVER_ERROR Set takes 8 bytes of extras (flags and expiration).\r\n");
+              batch.Flush(fd);
+              return;  // Closes the RAII connection
+            }
+
+            // First 4 bytes are flags, second 4 bytes are expiration, both in network byte order.
+            uint32_t Flags, Expiration;
+            memcpy(&Flags, req->GetExtras().GetData(), sizeof(Flags));
+            memcpy(&Expiration, req->GetExtras().GetData() + 4, sizeof(Expiration));
+            Flags = SwapEnds(Flags);
+            Expiration = SwapEnds(Expiration);
+
+            set(Native::TBlob(req->GetKey().GetData(), req->GetKey().GetSize()),
+                Mynde::TValue{{req->GetValue().GetData(), req->GetValue().GetSize()},
+                              Flags,
+                              Mynde::GetExpiresAt(Expiration, system_clock::to_time_t(system_clock::now()))});
 
-          Mynde::TKey key{{req.GetKey().GetData(), req.GetKey().GetSize()}};
-          Mynde::TValue value{{req.GetValue().GetData(), req.GetValue().GetSize()}, Flags};
-
-          syslog(LOG_INFO, "Set %s: %d %s", std::get<0>(key).c_str(), Flags, value.Value.c_str());
-
-          auto transaction = RepoManager->NewTransaction();
-          TUuid update_id(TUuid::Twister);
-
-          // TODO: The package_fq_name should be a constant somewhere.
-          // TODO: That we have to feed a package name and method name here seems like it might cause trouble later.
-          TMetaRecord meta_record(update_id,
-                                  TMetaRecord::TEntry(session->GetId(),
-                                                      session->GetUserId(),
-                                                      Orly::Mynde::PackageName,
-                                                      "set",
-                                                      {},
-                                                      {},
-                                                      Base::Chrono::CreateTimePnt(2014, 3, 23, 0, 0, 0, 0, 0),
-                                                      0));
-
-          void *state_alloc = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
-          void *state_alloc_3 = alloca(Sabot::State::GetMaxStateSize());
-          auto update = Indy::TUpdate::NewUpdate(
-              TUpdate::TOpByKey{
-                  {Indy::TIndexKey(
-                       Mynde::MemcachedIndexUuid,
-                       Indy::TKey(&context_arena, Sabot::State::TAny::TWrapper(Native::State::New(key, state_alloc)))),
-                   Indy::TKey(&context_arena,
-                              Sabot::State::TAny::TWrapper(Native::State::New(value, state_alloc_1))), }},
-              Indy::TKey(meta_record, &context_arena, state_alloc_2),
-              Indy::TKey(update_id, &context_arena, state_alloc_3));
-          transaction->Push(repo, update);
-          transaction->Prepare();
-          transaction->CommitAction();
-
-          switch_to_runner.reset();
-
-          //NOTE: We don't support cas, but we set the flag to 1 so that we pass some tests.
-          hdr.Cas = 1;
-
-          // TODO: This is a horrible place for this to live / refactor massively...
-          if (!req.GetFlags().Quiet) {
-            out << hdr;
+            //NOTE: We don't support cas, but we set the flag to 1 so that we pass some tests.
+            hdr.Cas = 1;
+
+            // TODO: This is a horrible place for this to live / refactor massively...
+            if (!req->GetFlags().Quiet) {
+              batch << hdr;
+            }
+            break;
           }
-          context.reset();
-          break;
-        }
-        case Mynde::TRequest::TOpcode::NoOp: {
-          syslog(LOG_INFO, "Noop, %02X", hdr.Opcode);
-          context.reset();
-          out << hdr;
-          break;
-        }
-        case Mynde::TRequest::TOpcode::Quit: {
-          Quit = true;
+          case Mynde::TRequest::TOpcode::NoOp: {
+            context.reset();
+            batch << hdr;
+            break;
+          }
+          case Mynde::TRequest::TOpcode::Quit: {
+            Quit = true;
 
-          if(!req.GetFlags().Quiet) {
-            out << hdr;
+            if(!req->GetFlags().Quiet) {
+              batch << hdr;
+            }
+            break;
+          }
+          default: {
+            syslog(LOG_INFO, "Memcache not implemented opcode: %02X", req->GetBinaryOpcode());
+            NOT_IMPLEMENTED();
           }
-          break;
-        }
-        default: {
-          syslog(LOG_INFO, "Memcache not implemented opcode: %02X", req.GetBinaryOpcode());
-          NOT_IMPLEMENTED();
         }
+        req.reset();
       }
 
-      //Flush output / force everything to be written.
-      out.Flush();
+      // Send everything we owe the client once it's waiting on us, rather than after every request.
+      if (Quit || !in.HasBuffered()) {
+        batch.Flush(fd);
+      }
     }
   } catch (const Strm::TPastEnd &ex) {
     // eof. Just exit / close sockets / destruct all our RAII things.
@@ -2496,6 +2766,107 @@ void TServer::ServeMemcacheClient(TFd &&fd_original, const TAddress &client_addr
   }
 }
 
+void TServer::SweepMemcache() {
+  assert(this);
+  for (;;) {
+    MemcacheSweepTimer.Pop();
+    try {
+      Indy::Fiber::TJumpRunnable sweeper(bind(&TServer::SweepExpiredMemcacheKeys, this));
+      sweeper(FramePoolManager.get(), &BGFastRunner);
+    } catch (const std::exception &ex) {
+      syslog(LOG_ERR, "memcache sweeper caught exception [%s]", ex.what());
+    }
+  }
+}
+
+void TServer::SweepExpiredMemcacheKeys() {
+  assert(this);
+  /* TCmd::CheckArgs() sees to this. */
+  assert(Cmd.MemcacheSweepBatchSize);
+  /* The number of keys we look at between yields to the rest of the runner's fibers. */
+  const size_t keys_per_lap = 256UL;
+  const int64_t now = system_clock::to_time_t(system_clock::now());
+  const auto &repo = GetGlobalRepo();
+  void *state_alloc_1 = alloca(Sabot::State::GetMaxStateSize());
+  void *state_alloc_2 = alloca(Sabot::State::GetMaxStateSize());
+  void *state_alloc_3 = alloca(Sabot::State::GetMaxStateSize());
+  /* True iff. the given key, as the given context sees it, holds a value which has expired. */
+  auto is_expired = [&](Indy::TContext &context, const Indy::TKey &key) {
+    auto response_value = context.TryGet(Indy::TIndexKey(Mynde::MemcachedIndexUuid, key));
+    if (!response_value) {
+      return false;
+    }
+    Mynde::TValue value;
+    Mynde::ReadValue(*Sabot::State::TAny::TWrapper(response_value->GetState(state_alloc_2)), value);
+    return Mynde::IsExpired(value, now);
+  };
+  /* Tombstone those of the given keys which are still expired, all in one update, so a sweep costs a handful of large writes
+     rather than one per key.  The scan saw these keys a while ago, so we read each one again, in a context of our own, and
+     leave alone any which a set has since given a live value.  There's no conditional update to lean on, so a set which lands
+     between this second read and our commit is still lost with the tombstone; for a cache, that's a miss. */
+  auto tombstone = [&](const std::vector<Indy::TKey> &candidates, Atom::TSuprena &arena) {
+    TUpdate::TOpByKey op_by_key;
+    /* read again */ {
+      Indy::TContext context(repo, &arena);
+      for (const auto &key : candidates) {
+        if (is_expired(context, key)) {
+          op_by_key[Indy::TIndexKey(Mynde::MemcachedIndexUuid, key)] =
+              Indy::TKey(Native::TTombstone::Tombstone, &arena, state_alloc_1);
+        }
+      }
+    }
+    if (op_by_key.empty()) {
+      return;
+    }
+    /* We write straight into the global repo, so our metadata takes the shape of any other update promoted there: just the session
+       behind the update, which here is nobody's but the global pov's own. */
+    TUuid update_id(TUuid::Twister);
+    TMetaRecord::TSessionIdByUpdateId session_id_by_update_id{{update_id, TSession::GlobalPovId}};
+    auto transaction = RepoManager->NewTransaction();
+    transaction->Push(repo, Indy::TUpdate::NewUpdate(op_by_key,
+                                                     Indy::TKey(session_id_by_update_id, &arena, state_alloc_2),
+                                                     Indy::TKey(update_id, &arena, state_alloc_3)));
+    transaction->Prepare();
+    transaction->CommitAction();
+    MemcacheKeysSwept.Increment(op_by_key.size());
+    MemcacheSweepUpdates.Increment();
+  };
+  /* The scan's arena lives as long as the scan does.  Each batch gets an arena of its own, dropped once the batch is written, so
+     a sweep holds at most one batch's worth of keys however many have expired. */
+  Atom::TSuprena scan_arena;
+  std::unique_ptr<Atom::TSuprena> batch_arena(new Atom::TSuprena());
+  std::vector<Indy::TKey> batch;
+  batch.reserve(Cmd.MemcacheSweepBatchSize);
+  auto flush = [&]() {
+    tombstone(batch, *batch_arena);
+    batch.clear();
+    batch_arena.reset(new Atom::TSuprena());
+    Indy::Fiber::YieldSlow();
+  };
+  Indy::TContext context(repo, &scan_arena);
+  Indy::TIndexKey pattern(Mynde::MemcachedIndexUuid,
+                          Indy::TKey(make_tuple(Native::TFree<Native::TBlob>()), &scan_arena, state_alloc_1));
+  size_t keys_this_lap = 0UL;
+  for (Indy::TContext::TKeyCursor csr(&context, pattern); csr; ++csr) {
+    if (is_expired(context, *csr)) {
+      batch.emplace_back(batch_arena.get(), state_alloc_3, *csr);
+      if (batch.size() == Cmd.MemcacheSweepBatchSize) {
+        flush();
+        keys_this_lap = 0UL;
+        continue;
+      }
+    }
+    /* We're background work; let the runner's other fibers go first. */
+    if (++keys_this_lap == keys_per_lap) {
+      keys_this_lap = 0UL;
+      Indy::Fiber::YieldSlow();
+    }
+  }
+  if (!batch.empty()) {
+    flush();
+  }
+}
+
 void TServer::StateChangeCb(Orly::Indy::TManager::TState state) {
   assert(this);
   string from;
@@ -2799,6 +3170,14 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
 
   ss << "MergeDisk Step CPU (s) = " << ToSecondsDouble(merge_disk_step_cpu) / elapsed_time << endl;
 
+  /* write amplification */ {
+    const size_t bytes_ingested = Server->GetRepoManager()->BytesIngested;
+    const size_t bytes_written = Server->GetRepoManager()->BytesWritten;
+    ss << "Bytes Ingested = " << bytes_ingested << endl;
+    ss << "Bytes Written = " << bytes_written << endl;
+    ss << "Write Amplification = " << (bytes_ingested ? static_cast<double>(bytes_written) / bytes_ingested : 0.0) << endl;
+  }
+
   size_t tetris_push_count = Server->TetrisManager->PushCount.exchange(0UL);
   size_t tetris_pop_count = Server->TetrisManager->PopCount.exchange(0UL);
   size_t tetris_fail_count = Server->TetrisManager->FailCount.exchange(0UL);
@@ -2808,6 +3187,43 @@ void TIndyReporter::AddReport(std::stringstream &ss) const {
   ss << "Tetris Fail Transactions / s = " << (tetris_fail_count / elapsed_time) << endl;
   ss << "Tetris Rounds / s = " << (tetris_round_count / elapsed_time) << endl;
 
+  /* work stealing */ {
+    size_t merge_disk_steal_count = 0UL, merge_disk_failed_steal_count = 0UL;
+    for (const auto &runner : Server->MergeDiskRunnerVec) {
+      merge_disk_steal_count += runner->ExchangeStealCount();
+      merge_disk_failed_steal_count += runner->ExchangeFailedStealCount();
+    }
+    const size_t tetris_helper_steal_count = Server->TetrisManager->ExchangeHelperStealCount();
+    const size_t tetris_helper_failed_steal_count = Server->TetrisManager->ExchangeHelperFailedStealCount();
+    ss << "Merge Disk Steals / s = " << (merge_disk_steal_count / elapsed_time) << endl;
+    ss << "Merge Disk Failed Steals / s = " << (merge_disk_failed_steal_count / elapsed_time) << endl;
+    ss << "Tetris Helper Steals / s = " << (tetris_helper_steal_count / elapsed_time) << endl;
+    ss << "Tetris Helper Failed Steals / s = " << (tetris_helper_failed_steal_count / elapsed_time) << endl;
+  }
+
+  size_t key_filter_negative_count = Disk::ExchangeKeyFilterNegativeCount();
+  size_t key_filter_false_positive_count = Disk::ExchangeKeyFilterFalsePositiveCount();
+  ss << "Key Filter Negatives / s = " << (key_filter_negative_count / elapsed_time) << endl;
+  ss << "Key Filter False Positives / s = " << (key_filter_false_positive_count / elapsed_time) << endl;
+
+  size_t arena_frame_hit_count = Disk::ArenaFrameCache.ExchangeHitCount();
+  size_t arena_frame_miss_count = Disk::ArenaFrameCache.ExchangeMissCount();
+  ss << "Arena Frame Cache Hits / s = " << (arena_frame_hit_count / elapsed_time) << endl;
+  ss << "Arena Frame Cache Misses / s = " << (arena_frame_miss_count / elapsed_time) << endl;
+  ss << "Arena Frame Cache Bytes = " << Disk::ArenaFrameCache.GetNumBytes() << endl;
+
+  ss << "Cache Policy = " << Disk::Util::GetCachePolicyName(engine->GetPageCache()->GetPolicy()) << endl;
+  size_t page_cache_hit_count = engine->GetPageCache()->ExchangeHitCount();
+  size_t page_cache_miss_count = engine->GetPageCache()->ExchangeMissCount();
+  ss << "Page Cache Hits / s = " << (page_cache_hit_count / elapsed_time) << endl;
+  ss << "Page Cache Misses / s = " << (page_cache_miss_count / elapsed_time) << endl;
+  ss << "Page Cache Hit Ratio = " << (page_cache_hit_count ? static_cast<double>(page_cache_hit_count) / (page_cache_hit_count + page_cache_miss_count) : 0.0) << endl;
+  size_t block_cache_hit_count = engine->GetBlockCache()->ExchangeHitCount();
+  size_t block_cache_miss_count = engine->GetBlockCache()->ExchangeMissCount();
+  ss << "Block Cache Hits / s = " << (block_cache_hit_count / elapsed_time) << endl;
+  ss << "Block Cache Misses / s = " << (block_cache_miss_count / elapsed_time) << endl;
+  ss << "Block Cache Hit Ratio = " << (block_cache_hit_count ? static_cast<double>(block_cache_hit_count) / (block_cache_hit_count + block_cache_miss_count) : 0.0) << endl;
+
   size_t tetris_timer_count = 0UL;
   double
     tetris_snapshot_min = 0.0,
@@ -2908,6 +3324,10 @@ if (try_read_count) {
   if (Server->DiskEngine) {
     Server->DiskEngine->Report(ss, elapsed_time);
   }
+  ::Server::TCounter::Sample();
+  for (const ::Server::TCounter *counter = ::Server::TCounter::GetFirstCounter(); counter; counter = counter->GetNextCounter()) {
+    ss << counter->GetName() << " = " << counter->GetCount() << endl;
+  }
 }
 
 TServer::TConnection::TConnectionRunnable::TConnectionRunnable(Fiber::TRunner *runner, const std::shared_ptr<const Rpc::TAnyRequest> &request)
@@ -186,6 +186,12 @@ namespace Orly {
         /* The port on which TServer::MemcacheSocket listens for clients. */
         in_port_t MemcachePortNumber;
 
+        /* The minimum number of milliseconds between sweeps for expired memcache keys. */
+        size_t MemcacheSweepInterval;
+
+        /* The most expired memcache keys to tombstone in one update. */
+        size_t MemcacheSweepBatchSize;
+
         /* The port on which TServer::WaitForSlave listens for a slave. */
         in_port_t SlavePortNumber;
 
@@ -246,6 +252,15 @@ namespace Orly {
         /* TODO */
         size_t MergeDiskInterval;
 
+        /* The fewest disk layers of one size tier we'll merge together.  See Indy::TCompactionPlanner. */
+        size_t CompactionMinWidth;
+
+        /* The most disk layers we'll merge at once. */
+        size_t CompactionMaxWidth;
+
+        /* The most disk layers a repo can have before we merge regardless of tier. */
+        size_t CompactionMaxReadLayers;
+
         /* TODO */
         size_t ReplicationInterval;
 
@@ -267,6 +282,12 @@ namespace Orly {
         /* The number of threads to use for answering websocket requests. */
         size_t NumWsThreads;
 
+        /* The number of threads testing tetris assertions alongside the one playing tetris. */
+        size_t NumTetrisThreads;
+
+        /* If true, the disk merge threads steal work from one another when idle, and so do the tetris helper threads. */
+        bool WorkStealing;
+
         /* TODO */
         size_t MaxRepoCacheSize;
 
@@ -304,6 +325,22 @@ namespace Orly {
            priorities require root privileges). */
         bool NoRealtime;
 
+        /* The kernel interface the disk controllers use for I/O: "aio", "io_uring" or "io_uring_polled". */
+        std::string DiskBackend;
+
+        /* The replacement policy of the page and block caches: "lru" or "2q". */
+        std::string CachePolicy;
+
+        /* How the arenas of the data files we write are stored: "none" or "snappy". */
+        std::string ArenaCodec;
+
+        /* The budget each device gives merge and flush I/O, in MB/s and I/Os per second.  Zero means no limit. */
+        size_t BackgroundIoMBPerSec;
+        size_t BackgroundIops;
+
+        /* If non-zero, the p99 foreground read latency each device scales its background budget back to hold under. */
+        size_t ReadLatencyTargetUs;
+
         /* Controls whether fsync is used when writing to disk */
         bool DoFsync;
 
@@ -360,6 +397,9 @@ namespace Orly {
         /* Construct with defaults. */
         TCmd();
 
+        /* Rejects settings which would leave the server unable to run, such as a memcache sweep batch size of zero. */
+        virtual bool CheckArgs(const TMeta::TMessageConsumer &cb) override;
+
       };  // TServer::TCmd
 
       /* Launches background tasks using the given scheduler and takes its arguments from the cmd object. */
@@ -702,6 +742,13 @@ namespace Orly {
       /* Performs housecleaning operations at a rate regulated by HousecleaningTimer. */
       void CleanHouse();
 
+      /* Sweeps for expired memcache keys at a rate regulated by MemcacheSweepTimer.  The sweeping itself is done by
+         SweepExpiredMemcacheKeys() on BGFastRunner. */
+      void SweepMemcache();
+
+      /* Tombstones every memcache key in the global repo whose value has expired.  Must run in a fiber. */
+      void SweepExpiredMemcacheKeys();
+
       /* Ignore me! */
       std::string Echo(const std::string &msg);
 
@@ -801,6 +848,9 @@ namespace Orly {
       /* The timer waited for by CleanHouse(). */
       Base::TTimerFd HousecleaningTimer;
 
+      /* The timer waited for by SweepMemcache(). */
+      Base::TTimerFd MemcacheSweepTimer;
+
       /* The socket on which AcceptClientConnections() listens. */
       Base::TFd MainSocket;
 
@@ -253,6 +253,8 @@ TTetrisManager::TTetrisManager(Base::TScheduler *scheduler,
                                Orly::Indy::Fiber::TRunner::TRunnerCons &runner_cons,
                                Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *> *frame_pool_manager,
                                const std::function<void (Indy::Fiber::TRunner *)> &runner_setup_cb,
+                               size_t num_helper_runners,
+                               size_t helper_steal_group,
                                bool is_master)
     : Scheduler(scheduler), FiberScheduler(runner_cons), IsMaster(is_master) {
   assert(scheduler);
@@ -270,6 +272,22 @@ TTetrisManager::TTetrisManager(Base::TScheduler *scheduler,
   };
   FiberThread = std::make_unique<std::thread>(std::bind(launch_sched, &FiberScheduler, frame_pool_manager));
   setup_is_complete.Pop();
+  /* The helpers each keep their own frame pool.  We set them up one at a time, as the setup callback needn't be thread-safe. */
+  auto launch_helper = [runner_setup_cb, &setup_is_complete](Fiber::TRunner *runner,
+                                                             Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *> *frame_pool_manager) {
+    auto *frame_pool = new Base::TThreadLocalGlobalPoolManager<Fiber::TFrame, size_t, Fiber::TRunner *>::TThreadLocalPool(frame_pool_manager);
+    Fiber::TFrame::LocalFramePool = frame_pool;
+    runner_setup_cb(runner);
+    setup_is_complete.Push();
+    runner->Run();
+    delete frame_pool;
+  };
+  for (size_t i = 0; i < num_helper_runners; ++i) {
+    HelperRunnerVec.emplace_back(new Fiber::TRunner(runner_cons, helper_steal_group));
+    HelperRunners.push_back(HelperRunnerVec.back().get());
+    HelperThreadVec.emplace_back(std::make_unique<std::thread>(std::bind(launch_helper, HelperRunners.back(), frame_pool_manager)));
+    setup_is_complete.Pop();
+  }
 }
 
 TTetrisManager::~TTetrisManager() {
@@ -279,6 +297,12 @@ TTetrisManager::~TTetrisManager() {
   assert(FiberThread);
   assert(FiberThread->get_id() != std::this_thread::get_id());
   FiberThread->join();
+  for (auto &runner: HelperRunnerVec) {
+    runner->ShutDown();
+  }
+  for (auto &thread: HelperThreadVec) {
+    thread->join();
+  }
 }
 
 void TTetrisManager::StopAllPlayers() {
@@ -302,3 +326,21 @@ void TTetrisManager::BecomeMaster() {
     item.second->BecomeMaster();
   }
 }
+
+size_t TTetrisManager::ExchangeHelperStealCount() {
+  assert(this);
+  size_t total = 0UL;
+  for (auto &runner : HelperRunnerVec) {
+    total += runner->ExchangeStealCount();
+  }
+  return total;
+}
+
+size_t TTetrisManager::ExchangeHelperFailedStealCount() {
+  assert(this);
+  size_t total = 0UL;
+  for (auto &runner : HelperRunnerVec) {
+    total += runner->ExchangeFailedStealCount();
+  }
+  return total;
+}
@@ -22,6 +22,7 @@
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <base/class_traits.h>
 #include <base/event_semaphore.h>
@@ -63,6 +64,10 @@ namespace Orly {
       /* TODO */
       void BecomeMaster();
 
+      /* The totals of TRunner::ExchangeStealCount() and ExchangeFailedStealCount() across our helper runners. */
+      size_t ExchangeHelperStealCount();
+      size_t ExchangeHelperFailedStealCount();
+
       protected:
 
       /* The base class for all players of the tetris. */
@@ -170,11 +175,14 @@ namespace Orly {
 
       };  // TTetrisManager::TPlayer
 
-      /* Caches the pointer to the scheduler. */
+      /* Caches the pointer to the scheduler.  Besides the runner the players play on, we start the given number of helper runners the
+         players may farm work out to, all in the given steal group.  Each runner is set up with the given callback on its own thread. */
       TTetrisManager(Base::TScheduler *scheduler,
                      Indy::Fiber::TRunner::TRunnerCons &runner_cons,
                      Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *> *frame_pool_manager,
                      const std::function<void (Indy::Fiber::TRunner *)> &runner_setup_cb,
+                     size_t num_helper_runners,
+                     size_t helper_steal_group,
                      bool is_master);
 
       /* You must call StopAllPlayers() in the destructor of your derived tetris manager or this destructor will fail. */
@@ -191,6 +199,12 @@ namespace Orly {
         return Scheduler;
       }
 
+      /* The runners, other than the one they play on, our players may farm work out to.  Possibly empty. */
+      const std::vector<Indy::Fiber::TRunner *> &GetHelperRunners() const {
+        assert(this);
+        return HelperRunners;
+      }
+
       private:
 
       /* The scheduler we use when creating indy contexts. */
@@ -201,6 +215,11 @@ namespace Orly {
       std::unique_ptr<std::thread> FiberThread;
       Base::TThreadLocalGlobalPoolManager<Indy::Fiber::TFrame, size_t, Indy::Fiber::TRunner *>::TThreadLocalPool *FramePool;
 
+      /* See accessor.  Each runs on its own thread. */
+      std::vector<std::unique_ptr<Indy::Fiber::TRunner>> HelperRunnerVec;
+      std::vector<Indy::Fiber::TRunner *> HelperRunners;
+      std::vector<std::unique_ptr<std::thread>> HelperThreadVec;
+
       /* Covers 'Players' and 'PausedSet', below. */
       //mutable std::mutex Mutex;
       mutable Indy::Fiber::TFiberLock FiberMutex;
@@ -0,0 +1,37 @@
+/* <server/latency_histogram.cc>
+
+   Implements <server/latency_histogram.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <server/latency_histogram.h>
+
+using namespace std;
+using namespace Base;
+using namespace Server;
+
+constexpr size_t TLatencyHistogram::NumBuckets;
+
+TLatencyHistogram::TLatencyHistogram(const TCodeLocation &code_location, const char *name)
+    : Name(name) {
+  assert(name);
+  for (size_t i = 0; i < NumBuckets - 1; ++i) {
+    CounterNames[i] = string(name) + "_lt_" + to_string(1UL << i) + "us";
+  }
+  CounterNames[NumBuckets - 1] = string(name) + "_ge_" + to_string(1UL << (NumBuckets - 2)) + "us";
+  for (size_t i = 0; i < NumBuckets; ++i) {
+    Counters[i].reset(new TCounter(code_location, CounterNames[i].c_str()));
+  }
+}
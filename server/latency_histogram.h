@@ -0,0 +1,104 @@
+/* <server/latency_histogram.h>
+
+   A latency histogram built out of counters, so it shows up in health reports alongside them.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <base/class_traits.h>
+#include <base/code_location.h>
+#include <server/counter.h>
+
+/* A macro to simplify declaring histograms. */
+#define SERVER_LATENCY_HISTOGRAM(name) static ::Server::TLatencyHistogram name(HERE, #name);
+
+namespace Server {
+
+  /* Counts how long an operation took, in power-of-2 buckets of microseconds.
+
+     Bucket 0 counts the operations which took less than 1 us, and bucket i counts the ones which took at least 2^(i-1) us but less
+     than 2^i us.  The last bucket takes everything slower.  Each bucket is a TCounter of its own, named after the histogram and the
+     bucket's bound (for example, "MemcacheGetLatency_lt_16us" or "MemcacheGetLatency_ge_4194304us"), so it is sampled, reset and
+     listed just like any other counter.
+
+     Declare histograms in your static data segment, as you would counters:
+
+        SERVER_LATENCY_HISTOGRAM(RequestLatency);
+
+        void Serve() {
+          auto start = std::chrono::steady_clock::now();
+          ... serve the request ...
+          RequestLatency.Record(std::chrono::steady_clock::now() - start);
+        } */
+  class TLatencyHistogram {
+    NO_COPY(TLatencyHistogram);
+    public:
+
+    /* The number of buckets; enough to tell apart anything up to a few seconds. */
+    static constexpr size_t NumBuckets = 24;
+
+    /* Construct with all counts zero.  The given name should point to a string in the data segment, as we do not copy it. */
+    TLatencyHistogram(const Base::TCodeLocation &code_location, const char *name);
+
+    /* The counter for the given bucket. */
+    const TCounter &GetCounter(size_t bucket) const {
+      assert(this);
+      assert(bucket < NumBuckets);
+      return *Counters[bucket];
+    }
+
+    /* The name of this histogram. Never null. */
+    const char *GetName() const {
+      assert(this);
+      return Name;
+    }
+
+    /* Count an operation which took the given time. */
+    void Record(std::chrono::nanoseconds elapsed) {
+      assert(this);
+      Counters[GetBucket(elapsed)]->Increment();
+    }
+
+    /* The bucket which counts an operation which took the given time. */
+    static size_t GetBucket(std::chrono::nanoseconds elapsed) {
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+      if (us <= 0) {
+        return 0;
+      }
+      const size_t bucket = 64 - __builtin_clzll(us);
+      return bucket < NumBuckets ? bucket : NumBuckets - 1;
+    }
+
+    private:
+
+    /* See accessor. */
+    const char *Name;
+
+    /* The names of our counters, which must outlive them. */
+    std::string CounterNames[NumBuckets];
+
+    /* Our counters, one per bucket. */
+    std::unique_ptr<TCounter> Counters[NumBuckets];
+
+  };  // TLatencyHistogram
+
+}  // Server
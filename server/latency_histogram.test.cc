@@ -0,0 +1,62 @@
+/* <server/latency_histogram.test.cc>
+
+   Unit test for <server/latency_histogram.h>.
+
+   Copyright 2010-2014 OrlyAtomics, Inc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+#include <server/latency_histogram.h>
+
+#include <cstring>
+
+#include <test/kit.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace Server;
+
+SERVER_LATENCY_HISTOGRAM(Latency);
+
+FIXTURE(Buckets) {
+  EXPECT_EQ(TLatencyHistogram::GetBucket(nanoseconds(0)), 0U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(nanoseconds(999)), 0U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(microseconds(1)), 1U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(microseconds(2)), 2U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(microseconds(3)), 2U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(microseconds(4)), 3U);
+  EXPECT_EQ(TLatencyHistogram::GetBucket(hours(1)), TLatencyHistogram::NumBuckets - 1);
+  EXPECT_FALSE(strcmp(Latency.GetCounter(0).GetName(), "Latency_lt_1us"));
+  EXPECT_FALSE(strcmp(Latency.GetCounter(4).GetName(), "Latency_lt_16us"));
+  EXPECT_FALSE(strcmp(Latency.GetCounter(TLatencyHistogram::NumBuckets - 1).GetName(), "Latency_ge_4194304us"));
+}
+
+FIXTURE(Record) {
+  TCounter::Reset();
+  Latency.Record(nanoseconds(10));
+  Latency.Record(microseconds(5));
+  Latency.Record(microseconds(6));
+  Latency.Record(seconds(100));
+  TCounter::Sample();
+  EXPECT_EQ(Latency.GetCounter(0).GetCount(), 1U);
+  EXPECT_EQ(Latency.GetCounter(3).GetCount(), 2U);
+  EXPECT_EQ(Latency.GetCounter(TLatencyHistogram::NumBuckets - 1).GetCount(), 1U);
+  /* they're on the list with every other counter */
+  size_t num_ours = 0;
+  for (const TCounter *counter = TCounter::GetFirstCounter(); counter; counter = counter->GetNextCounter()) {
+    if (!strncmp(counter->GetName(), "Latency_", 8)) {
+      ++num_ours;
+    }
+  }
+  EXPECT_EQ(num_ours, TLatencyHistogram::NumBuckets);
+}
@@ -40,7 +40,7 @@ namespace Strm {
     TFd(Base::TFd &&fd) : Fd(std::move(fd)) {}
 
     /* Get the underlying fd (To perform OS operations on it, for instance) */
-    const TFd &GetFd() const {
+    const Base::TFd &GetFd() const {
       assert(this);
       return Fd;
     }
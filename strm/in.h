@@ -90,6 +90,13 @@ namespace Strm {
         return !AtEnd;
       }
 
+      /* True iff. there is data we can consume without cycling our
+         producer; that is, without blocking on an open-ended one. */
+      bool HasBuffered() const {
+        assert(this);
+        return Cursor < Limit;
+      }
+
       protected:
 
       /* Attach to the given producer, which must be non-null.  The producer